@@ -1904,6 +1904,39 @@ pixel.
 
 DECLARE_REFLECTION_STRUCT(PixelModification);
 
+DOCUMENT("The history of modifications to one pixel, as part of a pixel history over a region.");
+struct PixelHistoryResult
+{
+  DOCUMENT("");
+  PixelHistoryResult() = default;
+  PixelHistoryResult(const PixelHistoryResult &) = default;
+  PixelHistoryResult &operator=(const PixelHistoryResult &) = default;
+
+  bool operator==(const PixelHistoryResult &o) const
+  {
+    return x == o.x && y == o.y && history == o.history;
+  }
+  bool operator<(const PixelHistoryResult &o) const
+  {
+    if(!(y == o.y))
+      return y < o.y;
+    if(!(x == o.x))
+      return x < o.x;
+    if(!(history == o.history))
+      return history < o.history;
+    return false;
+  }
+  DOCUMENT("The x co-ordinate of the pixel.");
+  uint32_t x = 0;
+  DOCUMENT("The y co-ordinate of the pixel.");
+  uint32_t y = 0;
+
+  DOCUMENT("The pixel history events for this pixel, as a list of :class:`PixelModification`.");
+  rdcarray<PixelModification> history;
+};
+
+DECLARE_REFLECTION_STRUCT(PixelHistoryResult);
+
 DOCUMENT("Contains the bytes and metadata describing a thumbnail.");
 struct Thumbnail
 {
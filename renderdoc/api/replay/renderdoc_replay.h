@@ -457,6 +457,25 @@ function must be called from another thread.
 )");
   virtual void SetFrameEvent(uint32_t eventId, bool force) = 0;
 
+  DOCUMENT(R"(Declare a range of events that following calls will be limited to, such as a single
+render pass that an analysis script is interested in.
+
+The state immediately before the first event in the range is snapshotted once. Moving to any event
+inside the range then restores that snapshot and only replays the events from the start of the
+range, rather than replaying the frame from its beginning. Moving to an event outside the range
+still works as normal.
+
+Setting up the range replays the frame and copies the contents of every resource the frame uses, so
+this is only worthwhile when many events in the range will be visited. The snapshot is taken again
+whenever a resource is replaced or a replacement is removed. Not all APIs support this, in which
+case it has no effect.
+
+:param int startEventId: The first :data:`eventId <APIEvent.eventId>` in the range, or 0 to remove
+  any range that was previously set.
+:param int endEventId: The last :data:`eventId <APIEvent.eventId>` in the range, inclusive.
+)");
+  virtual void SetReplayRange(uint32_t startEventId, uint32_t endEventId) = 0;
+
   DOCUMENT(R"(Retrieve the current :class:`D3D11State` pipeline state.
 
 The return value will be ``None`` if the capture is not using the D3D11 API.
@@ -824,12 +843,45 @@ bucket when the pixel values are divided between ``minval`` and ``maxval``.
   type. If set to :data:`CompType.Typeless` then no cast is applied, otherwise where allowed the
   texture data will be reinterpreted - e.g. from unsigned integers to floats, or to unsigned
   normalised values.
-:return: The list of pixel history events.
+:return: The list of pixel history events. If :data:`APIProperties.pixelHistory` is ``False`` pixel
+  history isn't supported and the list is empty.
 :rtype: ``list`` of :class:`PixelModification`
 )");
   virtual rdcarray<PixelModification> PixelHistory(ResourceId texture, uint32_t x, uint32_t y,
                                                    const Subresource &sub, CompType typeCast) = 0;
 
+  DOCUMENT(R"(Retrieve the history of modifications to every pixel in a rectangular region of the
+selected texture.
+
+This gives the same results as calling :meth:`PixelHistory` for each pixel in turn, but where
+possible the work is shared between pixels so that a whole region costs far fewer replays than
+querying each pixel individually.
+
+.. note::
+  X and Y co-ordinates are always considered to be top-left, even on GL, as with
+  :meth:`PixelHistory`.
+
+:param ResourceId texture: The texture to search for modifications.
+:param int x: The x co-ordinate of the top-left of the region.
+:param int y: The y co-ordinate of the top-left of the region.
+:param int width: The width of the region.
+:param int height: The height of the region.
+:param Subresource sub: The subresource within this texture to use.
+:param CompType typeCast: If possible interpret the texture with this type instead of its normal
+  type. If set to :data:`CompType.Typeless` then no cast is applied, otherwise where allowed the
+  texture data will be reinterpreted - e.g. from unsigned integers to floats, or to unsigned
+  normalised values.
+:return: The pixel history of each pixel in the region that lies within the texture, in row-major
+  order. At most 4096 pixels are returned, larger regions are truncated to the rows that fit. If
+  :data:`APIProperties.pixelHistory` is ``False`` pixel history isn't supported and the list is
+  empty.
+:rtype: ``list`` of :class:`PixelHistoryResult`
+)");
+  virtual rdcarray<PixelHistoryResult> PixelHistoryRegion(ResourceId texture, uint32_t x,
+                                                          uint32_t y, uint32_t width,
+                                                          uint32_t height, const Subresource &sub,
+                                                          CompType typeCast) = 0;
+
   DOCUMENT(R"(Retrieve a debugging trace from running a vertex shader.
 
 :param int vertid: The vertex ID as a 0-based index up to the number of vertices in the draw.
@@ -864,6 +916,19 @@ bucket when the pixel values are divided between ``minval`` and ``maxval``.
   virtual ShaderDebugTrace *DebugPixel(uint32_t x, uint32_t y, uint32_t sample,
                                        uint32_t primitive) = 0;
 
+  DOCUMENT(R"(Retrieve debugging traces for a batch of pixels in the current event.
+
+This is equivalent to calling :meth:`DebugPixel` once for each entry, but allows the replay and any
+setup work to be shared between all of the pixels, which can be substantially faster when many
+pixels need to be debugged at once.
+
+:param List[DebugPixelInputs] pixels: The pixels to debug.
+:return: The resulting traces, one for each entry in :paramref:`DebugPixels.pixels` and in the same
+  order. Each trace must be destroyed with :meth:`FreeTrace`.
+:rtype: ``list`` of :class:`ShaderDebugTrace`
+)");
+  virtual rdcarray<ShaderDebugTrace *> DebugPixels(const rdcarray<DebugPixelInputs> &pixels) = 0;
+
   DOCUMENT(R"(Retrieve a debugging trace from running a compute thread.
 
 :param groupid: A list containing the 3D workgroup index.
@@ -1424,6 +1489,33 @@ representation back to native RDC.
   virtual ReplayStatus Convert(const char *filename, const char *filetype, const SDFile *file,
                                RENDERDOC_ProgressCallback progress) = 0;
 
+  DOCUMENT(R"(Saves a copy of the currently loaded capture with its large sections moved out into a
+content-addressed blob store, leaving only a reference to each one in the new capture. Sections with
+identical contents are only stored once, no matter how many captures they appear in.
+
+The blob store must be available to open the packed capture. Either point the
+``Capture.BlobStorePath`` setting at it, or unpack the capture with :meth:`UnpackSections`.
+
+:param str filename: The filename to save to.
+:param str blobStore: The directory to use as the blob store. It will be created if necessary.
+:param int minBlobSize: The size in bytes, as stored on disk, of the smallest section to move into
+  the blob store.
+:return: The status of the operation, whether it succeeded or failed (and how it failed).
+:rtype: ReplayStatus
+)");
+  virtual ReplayStatus PackSections(const char *filename, const char *blobStore,
+                                    uint64_t minBlobSize) = 0;
+
+  DOCUMENT(R"(Saves a copy of the currently loaded capture with every section that was moved into a
+blob store by :meth:`PackSections` stored back in the capture, so it can be opened on its own.
+
+:param str filename: The filename to save to.
+:param str blobStore: The directory used as the blob store when the capture was packed.
+:return: The status of the operation, whether it succeeded or failed (and how it failed).
+:rtype: ReplayStatus
+)");
+  virtual ReplayStatus UnpackSections(const char *filename, const char *blobStore) = 0;
+
   DOCUMENT(R"(Returns the human-readable error string for the last error received.
 
 The error string is not reset by calling this function so it's safe to call multiple times. However
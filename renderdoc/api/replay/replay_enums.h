@@ -3841,6 +3841,22 @@ DOCUMENT(R"(A set of flags describing the properties of a section in a renderdoc
 .. data:: ZstdCompressed
 
   This section is compressed with Zstd on disk.
+
+.. data:: SeekIndexed
+
+  This compressed section has an index of seek points stored after the compressed data, allowing
+  reads to begin at any offset without decompressing everything before it.
+
+.. data:: ZstdDictionary
+
+  This Zstd compressed section begins with a dictionary built from its contents, which every page is
+  compressed against. This lets each independently compressed page take advantage of data that
+  repeats across the whole section.
+
+.. data:: BlobReference
+
+  This section's data isn't stored in the capture itself, only a reference to a blob in a shared
+  content-addressed blob store that holds it. The other flags describe the data in the blob.
 )");
 enum class SectionFlags : uint32_t
 {
@@ -3848,6 +3864,9 @@ enum class SectionFlags : uint32_t
   ASCIIStored = 0x1,
   LZ4Compressed = 0x2,
   ZstdCompressed = 0x4,
+  SeekIndexed = 0x8,
+  ZstdDictionary = 0x10,
+  BlobReference = 0x20,
 };
 
 BITMASK_OPERATORS(SectionFlags);
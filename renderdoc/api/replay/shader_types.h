@@ -789,6 +789,51 @@ corresponds to
 
 DECLARE_REFLECTION_STRUCT(ShaderDebugTrace);
 
+DOCUMENT(R"(The parameters identifying one pixel to debug, as part of a batched pixel debug. See
+:meth:`ReplayController.DebugPixels`.
+)");
+struct DebugPixelInputs
+{
+  DOCUMENT("");
+  DebugPixelInputs() = default;
+  DebugPixelInputs(const DebugPixelInputs &) = default;
+  DebugPixelInputs &operator=(const DebugPixelInputs &) = default;
+
+  bool operator==(const DebugPixelInputs &o) const
+  {
+    return x == o.x && y == o.y && sample == o.sample && primitive == o.primitive;
+  }
+  bool operator<(const DebugPixelInputs &o) const
+  {
+    if(!(y == o.y))
+      return y < o.y;
+    if(!(x == o.x))
+      return x < o.x;
+    if(!(sample == o.sample))
+      return sample < o.sample;
+    if(!(primitive == o.primitive))
+      return primitive < o.primitive;
+    return false;
+  }
+  DOCUMENT("The x co-ordinate of the pixel.");
+  uint32_t x = 0;
+  DOCUMENT("The y co-ordinate of the pixel.");
+  uint32_t y = 0;
+  DOCUMENT(R"(The multi-sampled sample. Ignored if non-multisampled texture.
+
+If set to :data:`ReplayController.NoPreference` then the first sample is debugged.
+)");
+  uint32_t sample = ~0U;
+  DOCUMENT(R"(Debug the pixel from this primitive if there's ambiguity.
+
+If set to :data:`ReplayController.NoPreference` then a random fragment writing to the given
+co-ordinate is debugged.
+)");
+  uint32_t primitive = ~0U;
+};
+
+DECLARE_REFLECTION_STRUCT(DebugPixelInputs);
+
 DOCUMENT(R"(The information describing an input or output signature element describing the interface
 between shader stages.
 
@@ -32,6 +32,36 @@
 #include "resourceid.h"
 #include "stringise.h"
 
+#if !defined(SWIG)
+// structured objects are allocated in a dll safe way through their own functions, since internally
+// they may come from an arena instead of a plain heap allocation.
+extern "C" RENDERDOC_API void RENDERDOC_CC RENDERDOC_FreeSDObjectMem(void *mem);
+typedef void(RENDERDOC_CC *pRENDERDOC_FreeSDObjectMem)(void *mem);
+
+extern "C" RENDERDOC_API void *RENDERDOC_CC RENDERDOC_AllocSDObjectMem(uint64_t sz);
+typedef void *(RENDERDOC_CC *pRENDERDOC_AllocSDObjectMem)(uint64_t sz);
+#endif
+
+// internal storage owned by an SDFile for the objects built into it and their interned names.
+struct SDFileStorage;
+
+#if !defined(SWIG)
+extern "C" RENDERDOC_API void RENDERDOC_CC RENDERDOC_FreeSDFileStorage(SDFileStorage *storage);
+typedef void(RENDERDOC_CC *pRENDERDOC_FreeSDFileStorage)(SDFileStorage *storage);
+
+extern "C" RENDERDOC_API bool RENDERDOC_CC RENDERDOC_IsInternedSDString(const char *str);
+typedef bool(RENDERDOC_CC *pRENDERDOC_IsInternedSDString)(const char *str);
+
+// names interned in an SDFile only live as long as the file, so a copy of an object needs its own
+// copy of them. Literal names can be shared.
+inline rdcinflexiblestr CopySDName(const rdcinflexiblestr &name)
+{
+  if(RENDERDOC_IsInternedSDString(name.c_str()))
+    return rdcstr(name.c_str());
+  return name;
+}
+#endif
+
 DOCUMENT(R"(The basic irreducible type of an object. Every other more complex type is built on these.
 
 .. data:: Chunk
@@ -396,6 +426,15 @@ struct LazyArrayData
   size_t elemSize;
   LazyGenerator generator;
 };
+
+using LazyChildrenGenerator = std::function<void(SDObject *)>;
+
+struct LazyChildrenData
+{
+  LazyChildrenGenerator generator;
+  LazyChildrenGenerator releaser;
+  bool populated;
+};
 #endif
 
 DOCUMENT(R"(Defines a single structured object. Structured objects are defined recursively and one
@@ -469,8 +508,10 @@ struct SDObject
 
   /////////////////////////////////////////////////////////////////
   // memory management, in a dll safe way
-  void *operator new(size_t sz) { return SDObject::alloc(sz); }
-  void operator delete(void *p) { SDObject::dealloc(p); }
+  void *operator new(size_t sz) { return RENDERDOC_AllocSDObjectMem(sz); }
+  void operator delete(void *p) { RENDERDOC_FreeSDObjectMem(p); }
+  void *operator new(size_t, void *ptr) { return ptr; }
+  void operator delete(void *p, void *) {}
   void *operator new[](size_t count) = delete;
   void operator delete[](void *p) = delete;
 
@@ -479,6 +520,7 @@ struct SDObject
     data.basic.u = 0;
     m_Parent = NULL;
     m_Lazy = NULL;
+    m_LazyChildren = NULL;
   }
 #if !defined(SWIG)
   SDObject(rdcinflexiblestr &&n, rdcinflexiblestr &&t) : name(std::move(n)), type(std::move(t))
@@ -486,6 +528,7 @@ struct SDObject
     data.basic.u = 0;
     m_Parent = NULL;
     m_Lazy = NULL;
+    m_LazyChildren = NULL;
   }
 #endif
 
@@ -496,6 +539,7 @@ struct SDObject
 
     // delete the lazy array data if we used it (rare)
     DeleteLazyGenerator();
+    DeleteLazyChildren();
 
     m_Parent = NULL;
   }
@@ -504,15 +548,13 @@ struct SDObject
   SDObject *Duplicate() const
   {
     SDObject *ret = new SDObject();
-    ret->name = name;
+    ret->name = CopySDName(name);
     ret->type = type;
+    ret->type.name = CopySDName(type.name);
     ret->data.basic = data.basic;
     ret->data.str = data.str;
 
-    if(m_Lazy)
-    {
-      PopulateAllChildren();
-    }
+    PopulateAllChildren();
 
     ret->data.children.resize(data.children.size());
     for(size_t i = 0; i < data.children.size(); i++)
@@ -549,7 +591,7 @@ recursively through children.
     {
       ret = false;
     }
-    else if(data.children.size() != o->data.children.size())
+    else if(NumChildren() != o->NumChildren())
     {
       ret = false;
     }
@@ -589,7 +631,7 @@ returned.
 )");
   inline SDObject *FindChild(const rdcstr &childName)
   {
-    for(size_t i = 0; i < data.children.size(); i++)
+    for(size_t i = 0; i < NumChildren(); i++)
       if(GetChild(i)->name == childName)
         return GetChild(i);
     return NULL;
@@ -604,7 +646,7 @@ returned.
 )");
   inline SDObject *GetChild(size_t index)
   {
-    if(index < data.children.size())
+    if(index < NumChildren())
     {
       PopulateChild(index);
       return data.children[index];
@@ -624,14 +666,14 @@ returned.
   // const versions of FindChild/GetChild
   inline const SDObject *FindChild(const rdcstr &childName) const
   {
-    for(size_t i = 0; i < data.children.size(); i++)
+    for(size_t i = 0; i < NumChildren(); i++)
       if(GetChild(i)->name == childName)
         return GetChild(i);
     return NULL;
   }
   inline const SDObject *GetChild(size_t index) const
   {
-    if(index < data.children.size())
+    if(index < NumChildren())
     {
       PopulateChild(index);
       return data.children[index];
@@ -647,7 +689,7 @@ returned.
 )");
   inline void RemoveChild(size_t index)
   {
-    if(index < data.children.size())
+    if(index < NumChildren())
     {
       // we really shouldn't be deleting individually from a lazy array but just in case we are,
       // fully evaluate it first.
@@ -665,6 +707,7 @@ returned.
     data.children.clear();
 
     DeleteLazyGenerator();
+    DeleteLazyChildren();
   }
 
   DOCUMENT(R"(Get the number of child objects.
@@ -672,23 +715,31 @@ returned.
 :return: The number of children this object contains.
 :rtype: ``int``
 )");
-  inline size_t NumChildren() const { return data.children.size(); }
+  inline size_t NumChildren() const
+  {
+    PopulateLazyChildren();
+    return data.children.size();
+  }
 #if !defined(SWIG)
   // these are for C++ iteration so not defined when SWIG is generating interfaces
   inline SDObjectIt<const SDObject> begin() const { return SDObjectIt<const SDObject>(this, 0); }
   inline SDObjectIt<const SDObject> end() const
   {
-    return SDObjectIt<const SDObject>(this, data.children.size());
+    return SDObjectIt<const SDObject>(this, NumChildren());
   }
   inline SDObjectIt<SDObject> begin() { return SDObjectIt<SDObject>(this, 0); }
-  inline SDObjectIt<SDObject> end() { return SDObjectIt<SDObject>(this, data.children.size()); }
+  inline SDObjectIt<SDObject> end() { return SDObjectIt<SDObject>(this, NumChildren()); }
 #endif
 
 #if !defined(SWIG)
   // this interface is 'more advanced' and is intended for C++ code manipulating structured data.
   // reserve a number of children up front, useful when constructing an array to avoid repeated
   // allocations.
-  void ReserveChildren(size_t num) { data.children.reserve(num); }
+  void ReserveChildren(size_t num)
+  {
+    PopulateLazyChildren();
+    data.children.reserve(num);
+  }
   // add a new child without duplicating it, and take ownership of it. Returns the child back
   // immediately for easy chaining.
   SDObject *AddAndOwnChild(SDObject *child)
@@ -731,6 +782,57 @@ returned.
     memcpy(m_Lazy->data, arrayData, sz);
     data.children.resize((size_t)arrayCount);
   }
+
+  // generate all of the children on demand the first time they're needed, e.g. for chunks which are
+  // only structurised when they're looked at. The generator is called on every access, since other
+  // threads may be accessing the object too. Under its own lock it should check
+  // IsLazyChildrenPopulated, and if not build the children and pass them to
+  // SetLazyChildrenPopulated. The releaser is called by ReleaseLazyChildren, and if it's safe to
+  // free the children it should do so with FreeLazyChildren under the same lock. They will then be
+  // generated again the next time they're needed.
+  void SetLazyChildren(LazyChildrenGenerator generator, LazyChildrenGenerator releaser)
+  {
+    DeleteChildren();
+
+    void *lazyAlloc = alloc(sizeof(LazyChildrenData));
+
+    m_LazyChildren = new(lazyAlloc) LazyChildrenData;
+    m_LazyChildren->generator = generator;
+    m_LazyChildren->releaser = releaser;
+    m_LazyChildren->populated = false;
+  }
+  bool HasLazyChildren() const { return m_LazyChildren != NULL; }
+  bool IsLazyChildrenPopulated() const { return m_LazyChildren && m_LazyChildren->populated; }
+  void SetLazyChildrenPopulated(StructuredObjectList &objs)
+  {
+    if(!m_LazyChildren || m_LazyChildren->populated)
+      return;
+
+    data.children.swap(objs);
+    for(size_t i = 0; i < data.children.size(); i++)
+      data.children[i]->m_Parent = this;
+
+    m_LazyChildren->populated = true;
+  }
+  // hint that lazily generated children aren't needed any more. They're only freed if whoever
+  // generates them also owns their lifetime, otherwise someone else could still be using them.
+  void ReleaseLazyChildren()
+  {
+    if(m_LazyChildren && m_LazyChildren->releaser)
+      m_LazyChildren->releaser(this);
+  }
+  void FreeLazyChildren()
+  {
+    if(!m_LazyChildren || !m_LazyChildren->populated)
+      return;
+
+    for(size_t i = 0; i < data.children.size(); i++)
+      delete data.children[i];
+
+    data.children.clear();
+
+    m_LazyChildren->populated = false;
+  }
 #endif
 
 // C++ gets more extensive typecasts. We'll add a couple for python in the interface file
@@ -884,8 +986,17 @@ protected:
     }
   }
 
+  inline void PopulateLazyChildren() const
+  {
+    // the populated flag is only checked by the generator, under its lock
+    if(m_LazyChildren)
+      m_LazyChildren->generator((SDObject *)this);
+  }
+
   void PopulateAllChildren() const
   {
+    PopulateLazyChildren();
+
     if(m_Lazy)
     {
       for(size_t i = 0; i < data.children.size(); i++)
@@ -919,6 +1030,7 @@ protected:
 private:
   SDObject *m_Parent = NULL;
   mutable LazyArrayData *m_Lazy = NULL;
+  LazyChildrenData *m_LazyChildren = NULL;
 
   // object serialisers need to be able to set the parent pointer. This is only for proxying really
   template <class SerialiserType>
@@ -935,6 +1047,16 @@ private:
       m_Lazy = NULL;
     }
   }
+
+  void DeleteLazyChildren()
+  {
+    if(m_LazyChildren)
+    {
+      m_LazyChildren->~LazyChildrenData();
+      dealloc(m_LazyChildren);
+      m_LazyChildren = NULL;
+    }
+  }
 };
 
 DECLARE_REFLECTION_STRUCT(SDObject);
@@ -1190,26 +1312,10 @@ struct SDChunk : public SDObject
 {
   /////////////////////////////////////////////////////////////////
   // memory management, in a dll safe way
-  void *operator new(size_t sz)
-  {
-    void *ret = NULL;
-#ifdef RENDERDOC_EXPORTS
-    ret = malloc(sz);
-    if(ret == NULL)
-      RENDERDOC_OutOfMemory(sz);
-#else
-    ret = RENDERDOC_AllocArrayMem(sz);
-#endif
-    return ret;
-  }
-  void operator delete(void *p)
-  {
-#ifdef RENDERDOC_EXPORTS
-    free(p);
-#else
-    RENDERDOC_FreeArrayMem(p);
-#endif
-  }
+  void *operator new(size_t sz) { return RENDERDOC_AllocSDObjectMem(sz); }
+  void operator delete(void *p) { RENDERDOC_FreeSDObjectMem(p); }
+  void *operator new(size_t, void *ptr) { return ptr; }
+  void operator delete(void *p, void *) {}
   void *operator new[](size_t count) = delete;
   void operator delete[](void *p) = delete;
 
@@ -1224,16 +1330,17 @@ struct SDChunk : public SDObject
   SDChunk *Duplicate() const
   {
     SDChunk *ret = new SDChunk();
-    ret->name = name;
+    ret->name = CopySDName(name);
     ret->metadata = metadata;
     ret->type = type;
+    ret->type.name = CopySDName(type.name);
     ret->data.basic = data.basic;
     ret->data.str = data.str;
 
-    ret->data.children.resize(data.children.size());
-
     PopulateAllChildren();
 
+    ret->data.children.resize(data.children.size());
+
     for(size_t i = 0; i < data.children.size(); i++)
       ret->data.children[i] = data.children[i]->Duplicate();
 
@@ -1362,6 +1469,11 @@ public:
 
     for(bytebuf *buf : buffers)
       delete buf;
+
+#if !defined(SWIG)
+    // freed last, since the chunks can refer to names interned in it
+    RENDERDOC_FreeSDFileStorage(m_Storage);
+#endif
   }
 
   DOCUMENT("A ``list`` of :class:`SDChunk` objects with the chunks in order.");
@@ -1378,9 +1490,20 @@ public:
     chunks.swap(other.chunks);
     buffers.swap(other.buffers);
     std::swap(version, other.version);
+#if !defined(SWIG)
+    std::swap(m_Storage, other.m_Storage);
+#endif
   }
 
 protected:
   SDFile(const SDFile &) = delete;
   SDFile &operator=(const SDFile &) = delete;
+
+private:
+#if !defined(SWIG)
+  friend SDFileStorage &GetSDFileStorage(SDFile &file);
+#endif
+
+  // always present so the layout doesn't depend on who's compiling the header
+  SDFileStorage *m_Storage = NULL;
 };
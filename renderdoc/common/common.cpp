@@ -30,6 +30,16 @@
 #include "os/os_specific.h"
 #include "strings/string_utils.h"
 
+// SSE2 is part of the x64 baseline and NEON of the ARM64 baseline, so both can be used
+// unconditionally where the compiler targets them. Elsewhere we fall back to 64-bit compares.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DIFF_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define DIFF_NEON
+#endif
+
 int utf8printv(char *buf, size_t bufsize, const char *fmt, va_list args);
 int utf8printf(char *str, size_t bufSize, const char *fmt, ...);
 
@@ -39,143 +49,315 @@ void rdcassert(const char *msg, const char *file, unsigned int line, const char
                 "Assertion failed: %s", msg);
 }
 
-#if 0
-static __m128 zero = {0};
-#endif
+// buffers at least this large are split across threads when looking for differences, as a single
+// thread can't saturate memory bandwidth. Each thread gets at least ParallelDiffMinChunk bytes.
+static const size_t ParallelDiffThreshold = 16 * 1024 * 1024;
+static const size_t ParallelDiffMinChunk = 4 * 1024 * 1024;
+// before splitting a buffer up, this much is swept serially in from each end. Differences are
+// usually close to the ends, and this finds them without reading the rest of the buffer.
+static const size_t ParallelDiffProbe = 64 * 1024;
+// threads check whether they can stop looking once per this many blocks
+static const size_t DiffCancelBlocks = 64;
 
-// assumes a and b both point to 16-byte aligned 16-byte chunks of memory.
+static const size_t DiffBlockSize = 64;
+
+// compares the 64-byte blocks at a and b, which don't need to be aligned. Unaligned loads cost the
+// same as aligned ones on aligned data with any CPU from the last decade.
 // Returns if they're equal or different
-bool Vec16NotEqual(void *a, void *b)
+static inline bool Block64NotEqual(const byte *a, const byte *b)
 {
-// disabled SSE version as it's acting dodgy
-#if 0
-	__m128 avec = _mm_load_ps(aflt);
-	__m128 bvec = _mm_load_ps(bflt);
-
-	__m128 diff = _mm_xor_ps(avec, bvec);
-
-	__m128 eq = _mm_cmpeq_ps(diff, zero);
-	int mask = _mm_movemask_ps(eq);
-	int signMask = _mm_movemask_ps(diff);
-
-	// first check ensures that diff is floatequal to zero (ie. avec bitwise equal to bvec).
-	// HOWEVER -0 is floatequal to 0, so we ensure no sign bits are set on diff
-	if((mask^0xf) || signMask != 0)
-	{
-		return true;
-	}
-	
-	return false;
-#elif ENABLED(RDOC_X64)
-  uint64_t *a64 = (uint64_t *)a;
-  uint64_t *b64 = (uint64_t *)b;
-
-  return a64[0] != b64[0] || a64[1] != b64[1];
+#if defined(DIFF_SSE2)
+  const __m128i *a128 = (const __m128i *)a;
+  const __m128i *b128 = (const __m128i *)b;
+
+  __m128i diff = _mm_or_si128(
+      _mm_or_si128(_mm_xor_si128(_mm_loadu_si128(a128 + 0), _mm_loadu_si128(b128 + 0)),
+                   _mm_xor_si128(_mm_loadu_si128(a128 + 1), _mm_loadu_si128(b128 + 1))),
+      _mm_or_si128(_mm_xor_si128(_mm_loadu_si128(a128 + 2), _mm_loadu_si128(b128 + 2)),
+                   _mm_xor_si128(_mm_loadu_si128(a128 + 3), _mm_loadu_si128(b128 + 3))));
+
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) != 0xffff;
+#elif defined(DIFF_NEON)
+  uint8x16_t diff = vorrq_u8(vorrq_u8(veorq_u8(vld1q_u8(a + 0), vld1q_u8(b + 0)),
+                                      veorq_u8(vld1q_u8(a + 16), vld1q_u8(b + 16))),
+                             vorrq_u8(veorq_u8(vld1q_u8(a + 32), vld1q_u8(b + 32)),
+                                      veorq_u8(vld1q_u8(a + 48), vld1q_u8(b + 48))));
+
+  uint64x2_t diff64 = vreinterpretq_u64_u8(diff);
+
+  return (vgetq_lane_u64(diff64, 0) | vgetq_lane_u64(diff64, 1)) != 0;
 #else
-  uint32_t *a32 = (uint32_t *)a;
-  uint32_t *b32 = (uint32_t *)b;
+  const uint64_t *a64 = (const uint64_t *)a;
+  const uint64_t *b64 = (const uint64_t *)b;
 
-  return a32[0] != b32[0] || a32[1] != b32[1] || a32[2] != b32[2] || a32[3] != b32[3];
+  return ((a64[0] ^ b64[0]) | (a64[1] ^ b64[1]) | (a64[2] ^ b64[2]) | (a64[3] ^ b64[3]) |
+          (a64[4] ^ b64[4]) | (a64[5] ^ b64[5]) | (a64[6] ^ b64[6]) | (a64[7] ^ b64[7])) != 0;
 #endif
 }
 
-bool FindDiffRange(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &diffEnd)
+static bool ScanDiffRange(const byte *a, const byte *b, size_t bufSize, size_t &diffStart,
+                          size_t &diffEnd)
 {
-  RDCASSERT(uintptr_t(a) % 16 == 0);
-  RDCASSERT(uintptr_t(b) % 16 == 0);
+  const size_t numBlocks = bufSize / DiffBlockSize;
+  const size_t alignedSize = numBlocks * DiffBlockSize;
 
-  diffStart = bufSize + 1;
-  diffEnd = 0;
+  // sweep to find the start of differences
+  size_t start = 0;
+  while(start < alignedSize && !Block64NotEqual(a + start, b + start))
+    start += DiffBlockSize;
 
-  size_t alignedSize = bufSize & (~0xf);
-  size_t numVecs = alignedSize / 16;
+  // make sure we're byte-accurate, to comply with WRITE_NO_OVERWRITE. This also checks any
+  // unaligned bytes at the end of the buffer if no difference was found in the blocks.
+  while(start < bufSize && a[start] == b[start])
+    start++;
 
-  size_t offs = 0;
+  if(start >= bufSize)
+    return false;
 
-  float *aflt = (float *)a;
-  float *bflt = (float *)b;
+  // sweep any unaligned bytes at the end of the buffer to find the end
+  size_t end = bufSize;
+  while(end > alignedSize && a[end - 1] == b[end - 1])
+    end--;
 
-  // sweep to find the start of differences
-  for(size_t v = 0; v < numVecs; v++)
+  if(end == alignedSize)
   {
-    if(Vec16NotEqual(aflt, bflt))
+    // sweep back from the last block. This will stop at the latest at the block containing the
+    // start, since we know there's a difference there.
+    while(end > 0 && !Block64NotEqual(a + end - DiffBlockSize, b + end - DiffBlockSize))
+      end -= DiffBlockSize;
+
+    // make sure we're byte-accurate, to comply with WRITE_NO_OVERWRITE
+    while(end > start && a[end - 1] == b[end - 1])
+      end--;
+  }
+
+  diffStart = start;
+  diffEnd = end;
+
+  return true;
+}
+
+// returns the offset of the first block in [begin, end) that differs, or end if none do or if
+// cancelled() returns true first.
+template <typename CancelFunc>
+static size_t FirstDiffBlock(const byte *a, const byte *b, size_t begin, size_t end,
+                             CancelFunc cancelled)
+{
+  size_t counter = 0;
+  for(size_t offs = begin; offs < end; offs += DiffBlockSize)
+  {
+    if(Block64NotEqual(a + offs, b + offs))
+      return offs;
+
+    if(++counter == DiffCancelBlocks)
     {
-      diffStart = offs;
-      break;
+      if(cancelled())
+        break;
+      counter = 0;
     }
+  }
 
-    aflt += 4;
-    bflt += 4;
-    offs += 4 * sizeof(float);
+  return end;
+}
+
+// returns the end of the last block in [begin, end) that differs, or begin if none do or if
+// cancelled() returns true first.
+template <typename CancelFunc>
+static size_t LastDiffBlock(const byte *a, const byte *b, size_t begin, size_t end,
+                            CancelFunc cancelled)
+{
+  size_t counter = 0;
+  for(size_t offs = end; offs > begin; offs -= DiffBlockSize)
+  {
+    if(Block64NotEqual(a + offs - DiffBlockSize, b + offs - DiffBlockSize))
+      return offs;
+
+    if(++counter == DiffCancelBlocks)
+    {
+      if(cancelled())
+        break;
+      counter = 0;
+    }
   }
 
-  // make sure we're byte-accurate, to comply with WRITE_NO_OVERWRITE
-  while(diffStart < bufSize && *((byte *)a + diffStart) == *((byte *)b + diffStart))
-    diffStart++;
+  return begin;
+}
+
+static bool NeverCancel()
+{
+  return false;
+}
+
+static int32_t AtomicRead(int32_t *val)
+{
+  return *(volatile int32_t *)val;
+}
+
+static void AtomicMin(int32_t *dest, int32_t val)
+{
+  int32_t cur = AtomicRead(dest);
+  while(val < cur)
+  {
+    int32_t prev = Atomic::CmpExch32(dest, cur, val);
+    if(prev == cur)
+      break;
+    cur = prev;
+  }
+}
 
-  // do we have some unaligned bytes at the end of the buffer?
-  if(bufSize > alignedSize)
+static void AtomicMax(int32_t *dest, int32_t val)
+{
+  int32_t cur = AtomicRead(dest);
+  while(val > cur)
   {
-    size_t numBytes = bufSize - alignedSize;
+    int32_t prev = Atomic::CmpExch32(dest, cur, val);
+    if(prev == cur)
+      break;
+    cur = prev;
+  }
+}
 
-    // if we haven't even found a start, check in these bytes
-    if(diffStart > bufSize)
+// finds the first and/or last differing block in the block-aligned range [begin, end), split into
+// one chunk per thread. A chunk stops looking for the first difference once an earlier chunk has
+// found one, and for the last difference once a later chunk has found one, since its own can't be
+// the overall first or last. first is set to end and last to begin if nothing differs.
+static void ParallelDiffBlocks(const byte *a, const byte *b, size_t begin, size_t end,
+                               bool findFirst, bool findLast, size_t &first, size_t &last)
+{
+  const size_t size = end - begin;
+  const uint32_t numChunks = (uint32_t)RDCCLAMP(size / ParallelDiffMinChunk, size_t(1),
+                                                size_t(Threading::MaxParallelThreads()));
+  const size_t chunkSize = AlignUp((size + numChunks - 1) / numChunks, DiffBlockSize);
+
+  rdcarray<size_t> firsts, lasts;
+  firsts.fill(numChunks, end);
+  lasts.fill(numChunks, begin);
+
+  // the earliest chunk that's found a first difference and the latest that's found a last one
+  int32_t firstChunk = INT32_MAX;
+  int32_t lastChunk = -1;
+
+  Threading::ParallelForRanges(numChunks, numChunks, [&](uint32_t rangeBegin, uint32_t rangeEnd) {
+    for(uint32_t c = rangeBegin; c < rangeEnd; c++)
     {
-      offs = alignedSize;
+      const size_t chunkBegin = begin + chunkSize * c;
+      const size_t chunkEnd = RDCMIN(end, chunkBegin + chunkSize);
+
+      if(chunkBegin >= chunkEnd)
+        continue;
+
+      const int32_t chunk = (int32_t)c;
 
-      for(size_t by = 0; by < numBytes; by++)
+      if(findFirst)
       {
-        if(*((byte *)a + alignedSize + by) != *((byte *)b + alignedSize + by))
+        size_t offs = FirstDiffBlock(a, b, chunkBegin, chunkEnd,
+                                     [&]() { return AtomicRead(&firstChunk) < chunk; });
+        if(offs < chunkEnd)
         {
-          diffStart = offs;
-          break;
+          firsts[c] = offs;
+          AtomicMin(&firstChunk, chunk);
         }
-
-        offs++;
       }
-    }
 
-    // sweep from the last byte to find the end
-    for(size_t by = 0; by < numBytes; by++)
-    {
-      if(*((byte *)a + bufSize - 1 - by) != *((byte *)b + bufSize - 1 - by))
+      if(findLast)
       {
-        diffEnd = bufSize - by;
-        break;
+        size_t offs = LastDiffBlock(a, b, chunkBegin, chunkEnd,
+                                    [&]() { return AtomicRead(&lastChunk) > chunk; });
+        if(offs > chunkBegin)
+        {
+          lasts[c] = offs;
+          AtomicMax(&lastChunk, chunk);
+        }
       }
     }
+  });
+
+  first = end;
+  last = begin;
+
+  for(uint32_t c = 0; c < numChunks; c++)
+  {
+    first = RDCMIN(first, firsts[c]);
+    last = RDCMAX(last, lasts[c]);
   }
+}
 
-  // if we haven't found a start, or we've found a start AND and end,
-  // then we're done.
-  if(diffStart > bufSize || diffEnd > 0)
-    return diffStart < bufSize;
+bool FindDiffRange(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &diffEnd)
+{
+  RDCASSERT(uintptr_t(a) % 16 == 0);
+  RDCASSERT(uintptr_t(b) % 16 == 0);
+
+  diffStart = bufSize + 1;
+  diffEnd = 0;
 
-  offs = alignedSize;
+  const byte *abyte = (const byte *)a;
+  const byte *bbyte = (const byte *)b;
 
-  // sweep from the last __m128
-  aflt = (float *)a + offs / sizeof(float) - 4;
-  bflt = (float *)b + offs / sizeof(float) - 4;
+  if(bufSize < ParallelDiffThreshold)
+    return ScanDiffRange(abyte, bbyte, bufSize, diffStart, diffEnd);
 
-  for(size_t v = 0; v < numVecs; v++)
+  // the block-aligned part of the buffer is split into a head and tail that are swept serially, and
+  // the middle between them which is only searched - across threads - for whichever of the start
+  // and end those sweeps didn't find.
+  const size_t alignedSize = (bufSize / DiffBlockSize) * DiffBlockSize;
+  const size_t headEnd = ParallelDiffProbe;
+  const size_t tailBegin = alignedSize - ParallelDiffProbe;
+
+  // sweep any unaligned bytes at the end of the buffer, if they differ the end is already exact
+  size_t end = bufSize;
+  while(end > alignedSize && abyte[end - 1] == bbyte[end - 1])
+    end--;
+
+  bool endFound = end > alignedSize;
+
+  size_t start = FirstDiffBlock(abyte, bbyte, 0, headEnd, NeverCancel);
+  bool startFound = start < headEnd;
+
+  if(!endFound)
   {
-    if(Vec16NotEqual(aflt, bflt))
+    end = LastDiffBlock(abyte, bbyte, tailBegin, alignedSize, NeverCancel);
+    endFound = end > tailBegin;
+  }
+
+  if(!startFound || !endFound)
+  {
+    size_t first = 0, last = 0;
+    ParallelDiffBlocks(abyte, bbyte, headEnd, tailBegin, !startFound, !endFound, first, last);
+
+    if(!startFound && first < tailBegin)
     {
-      diffEnd = offs;
-      break;
+      start = first;
+      startFound = true;
     }
 
-    aflt -= 4;
-    bflt -= 4;
-    offs -= 16;
+    if(!endFound && last > headEnd)
+    {
+      end = last;
+      endFound = true;
+    }
   }
 
+  // anything still not found can only be in the tail for the start or the head for the end. If
+  // no block differs the start is left at alignedSize, for any unaligned bytes to be checked below
+  if(!startFound)
+    start = FirstDiffBlock(abyte, bbyte, tailBegin, alignedSize, NeverCancel);
+  if(!endFound)
+    end = LastDiffBlock(abyte, bbyte, 0, headEnd, NeverCancel);
+
   // make sure we're byte-accurate, to comply with WRITE_NO_OVERWRITE
-  while(diffEnd > 0 && *((byte *)a + diffEnd - 1) == *((byte *)b + diffEnd - 1))
-    diffEnd--;
+  while(start < bufSize && abyte[start] == bbyte[start])
+    start++;
+
+  if(start >= bufSize)
+    return false;
+
+  while(end > start && abyte[end - 1] == bbyte[end - 1])
+    end--;
+
+  diffStart = start;
+  diffEnd = end;
 
-  // if we found a start then we necessarily found an end
-  return diffStart < bufSize;
+  return true;
 }
 
 uint32_t CalcNumMips(int w, int h, int d)
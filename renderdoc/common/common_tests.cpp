@@ -0,0 +1,183 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "common/common.h"
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "catch/catch.hpp"
+
+// straightforward byte-by-byte reference to check the optimised implementation against
+static bool ReferenceDiffRange(const byte *a, const byte *b, size_t bufSize, size_t &diffStart,
+                               size_t &diffEnd)
+{
+  diffStart = bufSize + 1;
+  diffEnd = 0;
+
+  for(size_t i = 0; i < bufSize; i++)
+  {
+    if(a[i] != b[i])
+    {
+      if(diffStart > bufSize)
+        diffStart = i;
+      diffEnd = i + 1;
+    }
+  }
+
+  return diffStart < bufSize;
+}
+
+static void CheckDiffRange(byte *a, byte *b, size_t bufSize)
+{
+  size_t refStart = 0, refEnd = 0;
+  bool refFound = ReferenceDiffRange(a, b, bufSize, refStart, refEnd);
+
+  size_t diffStart = 0, diffEnd = 0;
+  bool found = FindDiffRange(a, b, bufSize, diffStart, diffEnd);
+
+  CHECK(found == refFound);
+  if(refFound)
+  {
+    CHECK(diffStart == refStart);
+    CHECK(diffEnd == refEnd);
+  }
+}
+
+TEST_CASE("Test FindDiffRange", "[common]")
+{
+  // large enough to be split across threads
+  const size_t maxSize = 20 * 1024 * 1024 + 37;
+
+  byte *a = AllocAlignedBuffer(maxSize);
+  byte *b = AllocAlignedBuffer(maxSize);
+
+  for(size_t i = 0; i < maxSize; i++)
+    a[i] = b[i] = byte(i * 7);
+
+  SECTION("Identical buffers")
+  {
+    for(size_t size : {0, 1, 15, 16, 63, 64, 65, 1000, 4096, 4103})
+      CheckDiffRange(a, b, size);
+
+    size_t diffStart = 0, diffEnd = 0;
+    CHECK_FALSE(FindDiffRange(a, b, maxSize, diffStart, diffEnd));
+  };
+
+  SECTION("Single byte differences")
+  {
+    for(size_t size : {1, 15, 16, 63, 64, 65, 127, 128, 1000, 4096, 4103})
+    {
+      for(size_t offs : {size_t(0), size_t(1), size / 2, size - 2, size - 1})
+      {
+        if(offs >= size)
+          continue;
+
+        b[offs] ^= 0x10;
+        CheckDiffRange(a, b, size);
+        b[offs] ^= 0x10;
+      }
+    }
+  };
+
+  SECTION("Multiple differences")
+  {
+    for(size_t size : {65, 200, 4103})
+    {
+      for(size_t first = 0; first < size; first += 13)
+      {
+        for(size_t last = first; last < size; last += 29)
+        {
+          b[first] ^= 0x1;
+          b[last] ^= 0x80;
+          CheckDiffRange(a, b, size);
+          b[first] ^= 0x1;
+          b[last] ^= 0x80;
+        }
+      }
+    }
+  };
+
+  SECTION("Unaligned buffers")
+  {
+    for(size_t size : {64, 200, 4103})
+    {
+      for(size_t offs : {size_t(0), size_t(70), size - 1})
+      {
+        b[offs + 5] ^= 0x8;
+        CheckDiffRange(a + 5, b + 5, size);
+        CheckDiffRange(a + 5, b + 5, maxSize - 5);
+        b[offs + 5] ^= 0x8;
+      }
+    }
+  };
+
+  SECTION("Large buffers")
+  {
+    const size_t offsets[] = {
+        0, 64, 4 * 1024 * 1024 - 1, 4 * 1024 * 1024, 9 * 1024 * 1024 + 3, maxSize - 40, maxSize - 1,
+    };
+
+    for(size_t first : offsets)
+    {
+      for(size_t last : offsets)
+      {
+        if(last < first)
+          continue;
+
+        b[first] ^= 0x4;
+        b[last] ^= 0x2;
+        CheckDiffRange(a, b, maxSize);
+        CheckDiffRange(a, b, maxSize - 37);
+        b[first] ^= 0x4;
+        b[last] ^= 0x2;
+      }
+    }
+  };
+
+  SECTION("Differences a few blocks in from each end")
+  {
+    // these are found by the serial sweeps in from each end, or just past where they stop
+    for(size_t inset : {3 * 64 + 5, 64 * 1024 - 1, 64 * 1024, 64 * 1024 + 64, 5 * 1024 * 1024})
+    {
+      for(size_t size : {maxSize, maxSize - 37})
+      {
+        b[inset] ^= 0x4;
+        b[size - 1 - inset] ^= 0x2;
+        CheckDiffRange(a, b, size);
+        b[size - 1 - inset] ^= 0x2;
+        CheckDiffRange(a, b, size);
+        b[inset] ^= 0x4;
+
+        b[size - 1 - inset] ^= 0x2;
+        CheckDiffRange(a, b, size);
+        b[size - 1 - inset] ^= 0x2;
+      }
+    }
+  };
+
+  FreeAlignedBuffer(a);
+  FreeAlignedBuffer(b);
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -0,0 +1,237 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "persistent_cache.h"
+#include <algorithm>
+#include "api/replay/data_types.h"
+#include "os/os_specific.h"
+
+static const uint32_t PersistentCacheMagic = MAKE_FOURCC('R', 'D', 'P', 'C');
+
+struct PersistentCacheHeader
+{
+  uint32_t globalMagic;
+  uint32_t magic;
+  uint32_t version;
+  uint32_t padding;
+  // unix timestamp of when the cache was last opened
+  uint64_t lastUsed;
+};
+
+// each entry's data follows directly after this
+struct PersistentCacheEntryHeader
+{
+  uint64_t key;
+  uint32_t length;
+  uint32_t padding;
+};
+
+bool PersistentCache::Open(const rdcstr &folder, const rdcstr &name, uint32_t magic,
+                           uint32_t version, uint64_t maxFolderBytes)
+{
+  Close();
+
+  rdcstr filename = folder + "/" + name;
+
+  FileIO::CreateParentDirectory(filename);
+
+  uint64_t otherBytes = Evict(folder, name, maxFolderBytes);
+  m_MaxFileSize = maxFolderBytes > otherBytes ? maxFolderBytes - otherBytes : 0;
+
+  PersistentCacheHeader header = {};
+
+  m_File = FileIO::fopen(filename.c_str(), "r+b");
+
+  if(m_File && FileIO::fread(&header, sizeof(header), 1, m_File) == 1 &&
+     header.globalMagic == PersistentCacheMagic && header.magic == magic &&
+     header.version == version)
+  {
+    FileIO::fseek64(m_File, 0, SEEK_END);
+    uint64_t fileSize = FileIO::ftell64(m_File);
+
+    // index the entries, stopping at any entry cut short by an interrupted write
+    uint64_t offset = sizeof(header);
+    while(offset + sizeof(PersistentCacheEntryHeader) <= fileSize)
+    {
+      PersistentCacheEntryHeader entry = {};
+      FileIO::fseek64(m_File, offset, SEEK_SET);
+      if(FileIO::fread(&entry, sizeof(entry), 1, m_File) != 1)
+        break;
+
+      uint64_t dataOffset = offset + sizeof(entry);
+      if(dataOffset + entry.length > fileSize)
+        break;
+
+      m_Index[entry.key] = {dataOffset, entry.length};
+      offset = dataOffset + entry.length;
+    }
+
+    // new entries are appended after the last complete one
+    if(offset < fileSize)
+      FileIO::ftruncateat(m_File, offset);
+
+    m_FileSize = offset;
+
+    // this also updates the file's modified time, which eviction orders by
+    header.lastUsed = Timing::GetUnixTimestamp();
+    FileIO::fseek64(m_File, 0, SEEK_SET);
+    FileIO::fwrite(&header, sizeof(header), 1, m_File);
+    FileIO::fflush(m_File);
+
+    return true;
+  }
+
+  if(m_File)
+  {
+    FileIO::fclose(m_File);
+    m_File = NULL;
+  }
+
+  // the file is missing, or from an incompatible version, so start it again
+  m_File = FileIO::fopen(filename.c_str(), "w+b");
+
+  if(!m_File)
+  {
+    RDCWARN("Couldn't open persistent cache %s: %s", filename.c_str(),
+            FileIO::ErrorString().c_str());
+    return false;
+  }
+
+  return Create(magic, version);
+}
+
+bool PersistentCache::Create(uint32_t magic, uint32_t version)
+{
+  PersistentCacheHeader header = {};
+  header.globalMagic = PersistentCacheMagic;
+  header.magic = magic;
+  header.version = version;
+  header.lastUsed = Timing::GetUnixTimestamp();
+
+  if(FileIO::fwrite(&header, sizeof(header), 1, m_File) != 1)
+  {
+    Close();
+    return false;
+  }
+
+  FileIO::fflush(m_File);
+
+  m_FileSize = sizeof(header);
+
+  return true;
+}
+
+void PersistentCache::Close()
+{
+  if(m_File)
+    FileIO::fclose(m_File);
+
+  m_File = NULL;
+  m_Index.clear();
+  m_FileSize = 0;
+  m_MaxFileSize = 0;
+}
+
+bool PersistentCache::Read(uint64_t key, bytebuf &data)
+{
+  auto it = m_Index.find(key);
+
+  if(!m_File || it == m_Index.end())
+    return false;
+
+  data.resize(it->second.length);
+
+  FileIO::fseek64(m_File, it->second.offset, SEEK_SET);
+
+  return FileIO::fread(data.data(), 1, data.size(), m_File) == data.size();
+}
+
+bool PersistentCache::Write(uint64_t key, const byte *data, size_t length)
+{
+  const uint64_t entrySize = sizeof(PersistentCacheEntryHeader) + length;
+
+  if(!m_File || length > UINT32_MAX || m_FileSize + entrySize > m_MaxFileSize)
+    return false;
+
+  PersistentCacheEntryHeader entry = {};
+  entry.key = key;
+  entry.length = (uint32_t)length;
+
+  FileIO::fseek64(m_File, m_FileSize, SEEK_SET);
+
+  bool success = FileIO::fwrite(&entry, sizeof(entry), 1, m_File) == 1;
+  if(success && length > 0)
+    success = FileIO::fwrite(data, 1, length, m_File) == length;
+
+  if(!success)
+  {
+    // don't leave a partial entry behind for the next one to be appended after
+    FileIO::ftruncateat(m_File, m_FileSize);
+    return false;
+  }
+
+  FileIO::fflush(m_File);
+
+  m_Index[key] = {m_FileSize + sizeof(entry), entry.length};
+  m_FileSize += entrySize;
+
+  return true;
+}
+
+uint64_t PersistentCache::Evict(const rdcstr &folder, const rdcstr &keep, uint64_t maxBytes)
+{
+  rdcarray<PathEntry> files;
+  FileIO::GetFilesInDirectory(folder.c_str(), files);
+
+  // most recently used first
+  std::sort(files.begin(), files.end(),
+            [](const PathEntry &a, const PathEntry &b) { return a.lastmod > b.lastmod; });
+
+  uint64_t totalBytes = 0;
+  bool full = false;
+
+  for(const PathEntry &f : files)
+  {
+    if(f.flags & (PathProperty::Directory | PathProperty::ErrorUnknown |
+                  PathProperty::ErrorAccessDenied | PathProperty::ErrorInvalidPath))
+      continue;
+
+    if(f.filename == keep)
+      continue;
+
+    // once one file doesn't fit, every file used less recently is evicted too
+    if(!full && totalBytes + f.size <= maxBytes)
+    {
+      totalBytes += f.size;
+      continue;
+    }
+
+    full = true;
+
+    RDCLOG("Evicting persistent cache %s", f.filename.c_str());
+    FileIO::Delete((folder + "/" + f.filename).c_str());
+  }
+
+  return totalBytes;
+}
@@ -0,0 +1,80 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdio.h>
+#include <map>
+#include "api/replay/rdcarray.h"
+#include "api/replay/rdcstr.h"
+#include "common/common.h"
+
+// An on-disk cache of blobs that persists results between replays. Only the index of entries is
+// read when a cache is opened, each entry is read from disk when it's asked for. New entries are
+// appended as they're written, so nothing needs to be done when the cache is closed.
+//
+// Every cache file lives in one folder, which is kept under a size budget. When a cache is opened
+// the least recently used files in the folder are deleted until the others fit in the budget, and
+// the opened cache won't grow past what's left.
+class PersistentCache
+{
+public:
+  PersistentCache() = default;
+  ~PersistentCache() { Close(); }
+  PersistentCache(const PersistentCache &) = delete;
+  PersistentCache &operator=(const PersistentCache &) = delete;
+
+  // opens or creates the cache called name in folder. A file written with a different magic or
+  // version is discarded.
+  bool Open(const rdcstr &folder, const rdcstr &name, uint32_t magic, uint32_t version,
+            uint64_t maxFolderBytes);
+  void Close();
+  bool IsOpen() const { return m_File != NULL; }
+
+  bool Contains(uint64_t key) const { return m_Index.find(key) != m_Index.end(); }
+  bool Read(uint64_t key, bytebuf &data);
+  // adds an entry, replacing any earlier one with the same key. Returns false if it doesn't fit.
+  bool Write(uint64_t key, const byte *data, size_t length);
+
+  uint64_t GetFileSize() const { return m_FileSize; }
+  uint64_t GetMaxFileSize() const { return m_MaxFileSize; }
+
+  // deletes the least recently used files in folder, other than keep, until they take no more than
+  // maxBytes in total. Returns the number of bytes the remaining files take.
+  static uint64_t Evict(const rdcstr &folder, const rdcstr &keep, uint64_t maxBytes);
+
+private:
+  bool Create(uint32_t magic, uint32_t version);
+
+  struct Entry
+  {
+    uint64_t offset;
+    uint32_t length;
+  };
+
+  FILE *m_File = NULL;
+  std::map<uint64_t, Entry> m_Index;
+  uint64_t m_FileSize = 0;
+  uint64_t m_MaxFileSize = 0;
+};
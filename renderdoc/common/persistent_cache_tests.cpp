@@ -0,0 +1,192 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "common/persistent_cache.h"
+#include "api/replay/data_types.h"
+#include "os/os_specific.h"
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "catch/catch.hpp"
+
+static const uint32_t TestMagic = MAKE_FOURCC('T', 'E', 'S', 'T');
+
+static void ClearFolder(const rdcstr &folder)
+{
+  rdcarray<PathEntry> files;
+  FileIO::GetFilesInDirectory(folder.c_str(), files);
+
+  for(const PathEntry &f : files)
+    if(!(f.flags & PathProperty::ErrorInvalidPath) && !(f.flags & PathProperty::Directory))
+      FileIO::Delete((folder + "/" + f.filename).c_str());
+}
+
+static bytebuf MakeData(size_t size, byte seed)
+{
+  bytebuf ret;
+  ret.resize(size);
+  for(size_t i = 0; i < size; i++)
+    ret[i] = byte(seed + i);
+  return ret;
+}
+
+TEST_CASE("Persistent cache entries", "[persistentcache]")
+{
+  const rdcstr folder = FileIO::GetTempFolderFilename() + "/rdoc_persistent_cache_test";
+
+  ClearFolder(folder);
+
+  const bytebuf a = MakeData(100, 1), b = MakeData(2000, 7), c = MakeData(50, 3);
+
+  {
+    PersistentCache cache;
+    REQUIRE(cache.Open(folder, "cache", TestMagic, 1, 1024 * 1024));
+
+    CHECK(cache.Write(1, a.data(), a.size()));
+    CHECK(cache.Write(0x100000002ULL, b.data(), b.size()));
+    CHECK(cache.Write(3, b.data(), b.size()));
+    // a later entry replaces an earlier one
+    CHECK(cache.Write(3, c.data(), c.size()));
+  }
+
+  SECTION("Entries are read back after reopening")
+  {
+    PersistentCache cache;
+    REQUIRE(cache.Open(folder, "cache", TestMagic, 1, 1024 * 1024));
+
+    bytebuf data;
+    CHECK(cache.Read(1, data));
+    CHECK(data == a);
+    CHECK(cache.Read(0x100000002ULL, data));
+    CHECK(data == b);
+    CHECK(cache.Read(3, data));
+    CHECK(data == c);
+
+    CHECK_FALSE(cache.Contains(2));
+    CHECK_FALSE(cache.Read(2, data));
+  };
+
+  SECTION("A truncated entry is dropped and new entries are still appended")
+  {
+    const rdcstr filename = folder + "/cache";
+    const uint64_t size = FileIO::GetFileSize(filename);
+
+    FILE *f = FileIO::fopen(filename.c_str(), "r+b");
+    REQUIRE(f);
+    FileIO::ftruncateat(f, size - 10);
+    FileIO::fclose(f);
+
+    {
+      PersistentCache cache;
+      REQUIRE(cache.Open(folder, "cache", TestMagic, 1, 1024 * 1024));
+
+      bytebuf data;
+      CHECK(cache.Read(3, data));
+      CHECK(data == b);
+
+      CHECK(cache.Write(4, a.data(), a.size()));
+    }
+
+    PersistentCache cache;
+    REQUIRE(cache.Open(folder, "cache", TestMagic, 1, 1024 * 1024));
+
+    bytebuf data;
+    CHECK(cache.Read(4, data));
+    CHECK(data == a);
+    CHECK(cache.Read(0x100000002ULL, data));
+    CHECK(data == b);
+  };
+
+  SECTION("A different version discards the cache")
+  {
+    PersistentCache cache;
+    REQUIRE(cache.Open(folder, "cache", TestMagic, 2, 1024 * 1024));
+
+    CHECK_FALSE(cache.Contains(1));
+    CHECK_FALSE(cache.Contains(3));
+  };
+
+  SECTION("The cache doesn't grow past its budget")
+  {
+    const uint64_t budget = FileIO::GetFileSize(folder + "/cache") + b.size() + 100;
+
+    PersistentCache cache;
+    REQUIRE(cache.Open(folder, "cache", TestMagic, 1, budget));
+
+    CHECK(cache.Write(5, b.data(), b.size()));
+    CHECK_FALSE(cache.Write(6, b.data(), b.size()));
+    CHECK(cache.GetFileSize() <= budget);
+  };
+
+  ClearFolder(folder);
+}
+
+TEST_CASE("Persistent cache eviction", "[persistentcache]")
+{
+  const rdcstr folder = FileIO::GetTempFolderFilename() + "/rdoc_persistent_cache_evict_test";
+
+  ClearFolder(folder);
+
+  const bytebuf data = MakeData(1000, 0);
+
+  for(const char *name : {"a", "b", "c"})
+  {
+    PersistentCache cache;
+    REQUIRE(cache.Open(folder, name, TestMagic, 1, 1024 * 1024));
+    CHECK(cache.Write(0, data.data(), data.size()));
+  }
+
+  const uint64_t fileSize = FileIO::GetFileSize(folder + "/a");
+
+  // modified times only have a resolution of a second
+  Threading::Sleep(1100);
+
+  // opening a marks it as recently used, so b and c are now the least recently used
+  {
+    PersistentCache cache;
+    REQUIRE(cache.Open(folder, "a", TestMagic, 1, 1024 * 1024));
+    CHECK(cache.Contains(0));
+  }
+
+  // opening d with room for only one other file keeps a and evicts b and c
+  const uint64_t budget = fileSize + fileSize / 2;
+
+  PersistentCache cache;
+  REQUIRE(cache.Open(folder, "d", TestMagic, 1, budget));
+
+  CHECK(FileIO::exists((folder + "/a").c_str()));
+  CHECK_FALSE(FileIO::exists((folder + "/b").c_str()));
+  CHECK_FALSE(FileIO::exists((folder + "/c").c_str()));
+
+  // d can only use what a leaves
+  CHECK(cache.GetMaxFileSize() == budget - fileSize);
+  CHECK(cache.Write(0, data.data(), 100));
+  CHECK_FALSE(cache.Write(1, data.data(), data.size()));
+
+  cache.Close();
+
+  ClearFolder(folder);
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -0,0 +1,273 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Baldur Karlsson
+ * Copyright (c) 2014 Crytek
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "threading.h"
+
+namespace Threading
+{
+// the pool never grows past this many workers, so with the caller at most MaxPoolWorkers + 1
+// threads are busy with one job. The current users are limited by memory bandwidth before this.
+static const uint32_t MaxPoolWorkers = 7;
+
+struct ParallelJob
+{
+  std::function<void(uint32_t, uint32_t)> func;
+  uint32_t count;
+  uint32_t perRange;
+  uint32_t numRanges;
+  // the next range to hand out, protected by the pool lock
+  uint32_t nextRange;
+  // the number of ranges that haven't finished yet. Whoever finishes the last one signals
+  // finished, which the caller waits on before the job goes out of scope.
+  int32_t pending;
+  Semaphore finished;
+};
+
+struct WorkerPool
+{
+  CriticalSection lock;
+  Semaphore wake;
+  // jobs that still have ranges waiting to be handed out, oldest first
+  rdcarray<ParallelJob *> jobs;
+  uint32_t numWorkers = 0;
+  bool shutdown = false;
+};
+
+static WorkerPool *GetPool()
+{
+  // never freed, since detached workers may still be waking up after shutdown
+  static WorkerPool *pool = new WorkerPool();
+  return pool;
+}
+
+// must be called with the pool lock held
+static bool TakeRange(WorkerPool *pool, ParallelJob *job, uint32_t &range)
+{
+  if(job->nextRange >= job->numRanges)
+    return false;
+
+  range = job->nextRange++;
+
+  if(job->nextRange == job->numRanges)
+    pool->jobs.removeOne(job);
+
+  return true;
+}
+
+static void CompleteRange(ParallelJob *job)
+{
+  if(Atomic::Dec32(&job->pending) == 0)
+    job->finished.Signal(1);
+}
+
+static void RunRange(ParallelJob *job, uint32_t range)
+{
+  const uint32_t begin = range * job->perRange;
+  const uint32_t end = RDCMIN(job->count, begin + job->perRange);
+
+  job->func(begin, end);
+
+  CompleteRange(job);
+}
+
+static void WorkerMain(WorkerPool *pool)
+{
+  for(;;)
+  {
+    pool->wake.Wait();
+
+    ParallelJob *job = NULL;
+    uint32_t range = 0;
+
+    {
+      SCOPED_LOCK(pool->lock);
+
+      if(pool->shutdown)
+      {
+        pool->numWorkers--;
+        return;
+      }
+
+      // the caller may already have taken every range itself
+      if(pool->jobs.empty())
+        continue;
+
+      job = pool->jobs[0];
+      TakeRange(pool, job, range);
+    }
+
+    RunRange(job, range);
+  }
+}
+
+uint32_t MaxParallelThreads()
+{
+  return RDCMIN(GetNumberOfCores(), MaxPoolWorkers + 1);
+}
+
+static void InitJob(ParallelJob &job, uint32_t count, uint32_t numThreads,
+                    std::function<void(uint32_t, uint32_t)> &&func)
+{
+  numThreads = RDCCLAMP(numThreads, 1U, RDCMIN(count, MaxPoolWorkers + 1));
+
+  job.func = std::move(func);
+  job.count = count;
+  job.perRange = (count + numThreads - 1) / numThreads;
+  job.numRanges = (count + job.perRange - 1) / job.perRange;
+  job.nextRange = 0;
+  job.pending = (int32_t)job.numRanges;
+}
+
+// queues the job and wakes a worker for each of numWake ranges, up to the pool's limit
+static void StartJob(ParallelJob &job, uint32_t numWake)
+{
+  WorkerPool *pool = GetPool();
+
+  numWake = RDCMIN(numWake, MaxPoolWorkers);
+
+  {
+    SCOPED_LOCK(pool->lock);
+
+    // if the pool has been shut down, whoever finishes the job will process every range
+    if(pool->shutdown)
+      return;
+
+    while(pool->numWorkers < numWake)
+    {
+      DetachThread(CreateThread([pool]() { WorkerMain(pool); }));
+      pool->numWorkers++;
+    }
+
+    pool->jobs.push_back(&job);
+  }
+
+  pool->wake.Signal(numWake);
+}
+
+static void FinishJob(ParallelJob &job, bool run)
+{
+  WorkerPool *pool = GetPool();
+
+  // process ranges from the job until they've all been handed out. This covers the pool being
+  // shut down, and all the workers being busy with other jobs or other ranges of this one. When
+  // cancelling, the ranges are marked complete without being run.
+  for(;;)
+  {
+    uint32_t range = 0;
+
+    {
+      SCOPED_LOCK(pool->lock);
+      if(!TakeRange(pool, &job, range))
+        break;
+    }
+
+    if(run)
+      RunRange(&job, range);
+    else
+      CompleteRange(&job);
+  }
+
+  job.finished.Wait();
+}
+
+void ParallelForRanges(uint32_t count, uint32_t numThreads,
+                       std::function<void(uint32_t, uint32_t)> func)
+{
+  if(count == 0)
+    return;
+
+  ParallelJob job;
+  InitJob(job, count, numThreads, std::move(func));
+
+  if(job.numRanges == 1)
+  {
+    job.func(0, count);
+    return;
+  }
+
+  // wake one worker for each range besides the one we'll process ourselves
+  StartJob(job, job.numRanges - 1);
+  FinishJob(job, true);
+}
+
+AsyncParallelFor::~AsyncParallelFor()
+{
+  Wait();
+}
+
+void AsyncParallelFor::Start(uint32_t count, uint32_t numThreads,
+                             std::function<void(uint32_t, uint32_t)> func)
+{
+  Wait();
+
+  if(count == 0)
+    return;
+
+  m_Job = new ParallelJob;
+  InitJob(*m_Job, count, numThreads, std::move(func));
+
+  // nothing processes ranges on this thread until Wait(), so every range can go to a worker
+  StartJob(*m_Job, RDCMIN(m_Job->numRanges, MaxPoolWorkers));
+}
+
+void AsyncParallelFor::Wait()
+{
+  if(!m_Job)
+    return;
+
+  FinishJob(*m_Job, true);
+
+  delete m_Job;
+  m_Job = NULL;
+}
+
+void AsyncParallelFor::Cancel()
+{
+  if(!m_Job)
+    return;
+
+  FinishJob(*m_Job, false);
+
+  delete m_Job;
+  m_Job = NULL;
+}
+
+void ShutdownWorkerPool()
+{
+  WorkerPool *pool = GetPool();
+
+  uint32_t numWorkers = 0;
+
+  {
+    SCOPED_LOCK(pool->lock);
+    pool->shutdown = true;
+    numWorkers = pool->numWorkers;
+  }
+
+  // the workers are detached, so we don't wait for them to exit. That can deadlock on windows if
+  // we're shutting down while the module is being unloaded.
+  pool->wake.Signal(numWorkers);
+}
+};
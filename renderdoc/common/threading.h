@@ -110,6 +110,43 @@ public:
 private:
   SpinLock *m_Spin = NULL;
 };
+
+// splits [0, count) into at most numThreads contiguous ranges and calls func(begin, end) for each
+// range, blocking until all ranges have been processed. Ranges are picked up by a pool of worker
+// threads that is created the first time it's needed and then kept, so this is cheap enough to
+// call per batch. The calling thread processes ranges too, so with a single thread (or a single
+// item) the pool isn't touched at all, and calling this from inside func can't deadlock.
+void ParallelForRanges(uint32_t count, uint32_t numThreads,
+                       std::function<void(uint32_t, uint32_t)> func);
+
+struct ParallelJob;
+
+// the same as ParallelForRanges, but Start() returns as soon as the ranges are queued so the work
+// runs in the background. Wait() blocks until it has finished - processing any ranges that no
+// worker has picked up yet on the calling thread - and must be called before anything func uses
+// is destroyed. Cancel() instead skips any ranges that haven't started and waits only for the ones
+// in progress. Starting a new job or destroying this object waits for the previous job first.
+class AsyncParallelFor
+{
+public:
+  AsyncParallelFor() = default;
+  ~AsyncParallelFor();
+  AsyncParallelFor(const AsyncParallelFor &) = delete;
+  AsyncParallelFor &operator=(const AsyncParallelFor &) = delete;
+
+  void Start(uint32_t count, uint32_t numThreads, std::function<void(uint32_t, uint32_t)> func);
+  void Wait();
+  void Cancel();
+  bool Running() const { return m_Job != NULL; }
+private:
+  ParallelJob *m_Job = NULL;
+};
+
+// the number of threads ParallelForRanges will process ranges on at most, including the caller.
+uint32_t MaxParallelThreads();
+
+// tells the worker threads to exit. Later calls to ParallelForRanges run on the calling thread.
+void ShutdownWorkerPool();
 };
 
 #define SCOPED_LOCK(cs) Threading::ScopedLock CONCAT(scopedlock, __LINE__)(&cs);
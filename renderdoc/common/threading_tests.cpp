@@ -71,4 +71,104 @@ TEST_CASE("Test spin lock", "[threading]")
   CHECK(finalValue == value);
 }
 
+TEST_CASE("Test parallel for ranges", "[threading]")
+{
+  rdcarray<int32_t> visited;
+
+  SECTION("Ranges cover every index exactly once")
+  {
+    for(uint32_t count : {1U, 7U, 8U, 100U})
+    {
+      for(uint32_t numThreads : {1U, 3U, 8U, 200U})
+      {
+        visited.clear();
+        visited.resize(count);
+
+        Threading::ParallelForRanges(count, numThreads, [&visited](uint32_t begin, uint32_t end) {
+          for(uint32_t i = begin; i < end; i++)
+            Atomic::Inc32(&visited[i]);
+        });
+
+        for(uint32_t i = 0; i < count; i++)
+          CHECK(visited[i] == 1);
+      }
+    }
+  };
+
+  SECTION("Repeated and nested calls share the pool")
+  {
+    visited.clear();
+    visited.resize(64);
+
+    for(int rep = 0; rep < 100; rep++)
+    {
+      Threading::ParallelForRanges(8, 8, [&visited](uint32_t begin, uint32_t end) {
+        for(uint32_t i = begin; i < end; i++)
+        {
+          Threading::ParallelForRanges(8, 4, [&visited, i](uint32_t innerBegin, uint32_t innerEnd) {
+            for(uint32_t j = innerBegin; j < innerEnd; j++)
+              Atomic::Inc32(&visited[i * 8 + j]);
+          });
+        }
+      });
+    }
+
+    for(size_t i = 0; i < visited.size(); i++)
+      CHECK(visited[i] == 100);
+  };
+
+  SECTION("Empty range does nothing")
+  {
+    bool called = false;
+    Threading::ParallelForRanges(0, 4, [&called](uint32_t, uint32_t) { called = true; });
+    CHECK_FALSE(called);
+  };
+}
+
+TEST_CASE("Test async parallel for", "[threading]")
+{
+  rdcarray<int32_t> visited;
+  visited.resize(100);
+
+  SECTION("Waiting processes every index exactly once")
+  {
+    Threading::AsyncParallelFor job;
+
+    job.Start(100, 4, [&visited](uint32_t begin, uint32_t end) {
+      for(uint32_t i = begin; i < end; i++)
+        Atomic::Inc32(&visited[i]);
+    });
+
+    CHECK(job.Running());
+    job.Wait();
+    CHECK_FALSE(job.Running());
+
+    for(size_t i = 0; i < visited.size(); i++)
+      CHECK(visited[i] == 1);
+  };
+
+  SECTION("Cancelling skips ranges that haven't started")
+  {
+    Threading::AsyncParallelFor job;
+
+    job.Start(100, 4, [&visited](uint32_t begin, uint32_t end) {
+      for(uint32_t i = begin; i < end; i++)
+        Atomic::Inc32(&visited[i]);
+    });
+
+    job.Cancel();
+    CHECK_FALSE(job.Running());
+
+    // ranges are either processed completely or not at all
+    for(size_t i = 0; i < visited.size(); i += 25)
+    {
+      for(size_t j = i; j < i + 25; j++)
+      {
+        CHECK(visited[j] <= 1);
+        CHECK(visited[j] == visited[i]);
+      }
+    }
+  };
+}
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
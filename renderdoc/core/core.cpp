@@ -517,6 +517,8 @@ RenderDoc::~RenderDoc()
 
   delete m_Config;
 
+  Threading::ShutdownWorkerPool();
+
   Process::Shutdown();
 
   Network::Shutdown();
@@ -964,6 +966,10 @@ rdcstr RenderDoc::GetOverlayText(RDCDriver driver, uint32_t frameNumber, int fla
 #if ENABLED(RDOC_DEVEL)
     overlayText += StringFormat::Fmt("%llu chunks - %.2f MB\n", Chunk::NumLiveChunks(),
                                      float(Chunk::TotalMem()) / 1024.0f / 1024.0f);
+    overlayText += StringFormat::Fmt(
+        "Chunk pages - %.2f MB (%.2f MB pooled)\n",
+        float(ChunkAllocator::AllocatedPageMemory()) / 1024.0f / 1024.0f,
+        float(ChunkAllocator::PooledPageMemory()) / 1024.0f / 1024.0f);
 #endif
   }
   else if(capturesEnabled)
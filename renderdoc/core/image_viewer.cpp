@@ -227,6 +227,7 @@ public:
   const GLPipe::State *GetGLPipelineState() { return NULL; }
   const VKPipe::State *GetVulkanPipelineState() { return NULL; }
   void ReplayLog(uint32_t endEventID, ReplayLogType replayType) {}
+  void SetReplayRange(uint32_t startEventID, uint32_t endEventID) {}
   rdcarray<uint32_t> GetPassEvents(uint32_t eventId) { return rdcarray<uint32_t>(); }
   rdcarray<EventUsage> GetUsage(ResourceId id) { return rdcarray<EventUsage>(); }
   bool IsRenderOutput(ResourceId id) { return false; }
@@ -273,6 +274,13 @@ public:
   {
     return rdcarray<PixelModification>();
   }
+  rdcarray<PixelHistoryResult> PixelHistoryRegion(rdcarray<EventUsage> events, ResourceId target,
+                                                  uint32_t x, uint32_t y, uint32_t width,
+                                                  uint32_t height, const Subresource &sub,
+                                                  CompType typeCast)
+  {
+    return rdcarray<PixelHistoryResult>();
+  }
   ShaderDebugTrace *DebugVertex(uint32_t eventId, uint32_t vertid, uint32_t instid, uint32_t idx,
                                 uint32_t view)
   {
@@ -283,6 +291,14 @@ public:
   {
     return new ShaderDebugTrace();
   }
+  rdcarray<ShaderDebugTrace *> DebugPixels(uint32_t eventId,
+                                           const rdcarray<DebugPixelInputs> &pixels)
+  {
+    rdcarray<ShaderDebugTrace *> ret;
+    for(size_t i = 0; i < pixels.size(); i++)
+      ret.push_back(new ShaderDebugTrace());
+    return ret;
+  }
   ShaderDebugTrace *DebugThread(uint32_t eventId, const uint32_t groupid[3],
                                 const uint32_t threadid[3])
   {
@@ -37,6 +37,7 @@ rdcstr DoStringise(const ReplayProxyPacket &el)
     STRINGISE_ENUM_NAMED(eReplayProxy_RemoteExecutionFinished, "RemoteExecutionFinished");
 
     STRINGISE_ENUM_NAMED(eReplayProxy_ReplayLog, "ReplayLog");
+    STRINGISE_ENUM_NAMED(eReplayProxy_SetReplayRange, "SetReplayRange");
 
     STRINGISE_ENUM_NAMED(eReplayProxy_CacheBufferData, "CacheBufferData");
     STRINGISE_ENUM_NAMED(eReplayProxy_CacheTextureData, "CacheTextureData");
@@ -87,6 +88,8 @@ rdcstr DoStringise(const ReplayProxyPacket &el)
     STRINGISE_ENUM_NAMED(eReplayProxy_RenderOverlay, "RenderOverlay");
 
     STRINGISE_ENUM_NAMED(eReplayProxy_PixelHistory, "PixelHistory");
+    STRINGISE_ENUM_NAMED(eReplayProxy_PixelHistoryRegion, "PixelHistoryRegion");
+    STRINGISE_ENUM_NAMED(eReplayProxy_DebugPixels, "DebugPixels");
 
     STRINGISE_ENUM_NAMED(eReplayProxy_DisassembleShader, "DisassembleShader");
     STRINGISE_ENUM_NAMED(eReplayProxy_GetDisassemblyTargets, "GetDisassemblyTargets");
@@ -1452,6 +1455,50 @@ rdcarray<PixelModification> ReplayProxy::PixelHistory(rdcarray<EventUsage> event
   PROXY_FUNCTION(PixelHistory, events, target, x, y, sub, typeCast);
 }
 
+template <typename ParamSerialiser, typename ReturnSerialiser>
+rdcarray<PixelHistoryResult> ReplayProxy::Proxied_PixelHistoryRegion(
+    ParamSerialiser &paramser, ReturnSerialiser &retser, rdcarray<EventUsage> events,
+    ResourceId target, uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+    const Subresource &sub, CompType typeCast)
+{
+  const ReplayProxyPacket expectedPacket = eReplayProxy_PixelHistoryRegion;
+  ReplayProxyPacket packet = eReplayProxy_PixelHistoryRegion;
+  rdcarray<PixelHistoryResult> ret;
+
+  {
+    BEGIN_PARAMS();
+    SERIALISE_ELEMENT(events);
+    SERIALISE_ELEMENT(target);
+    SERIALISE_ELEMENT(x);
+    SERIALISE_ELEMENT(y);
+    SERIALISE_ELEMENT(width);
+    SERIALISE_ELEMENT(height);
+    SERIALISE_ELEMENT(sub);
+    SERIALISE_ELEMENT(typeCast);
+    END_PARAMS();
+  }
+
+  {
+    REMOTE_EXECUTION();
+    if(paramser.IsReading() && !paramser.IsErrored() && !m_IsErrored)
+      ret = m_Remote->PixelHistoryRegion(events, target, x, y, width, height, sub, typeCast);
+  }
+
+  SERIALISE_RETURN(ret);
+
+  return ret;
+}
+
+rdcarray<PixelHistoryResult> ReplayProxy::PixelHistoryRegion(rdcarray<EventUsage> events,
+                                                             ResourceId target, uint32_t x,
+                                                             uint32_t y, uint32_t width,
+                                                             uint32_t height,
+                                                             const Subresource &sub,
+                                                             CompType typeCast)
+{
+  PROXY_FUNCTION(PixelHistoryRegion, events, target, x, y, width, height, sub, typeCast);
+}
+
 template <typename ParamSerialiser, typename ReturnSerialiser>
 ShaderDebugTrace *ReplayProxy::Proxied_DebugVertex(ParamSerialiser &paramser,
                                                    ReturnSerialiser &retser, uint32_t eventId,
@@ -1529,6 +1576,58 @@ ShaderDebugTrace *ReplayProxy::DebugPixel(uint32_t eventId, uint32_t x, uint32_t
   PROXY_FUNCTION(DebugPixel, eventId, x, y, sample, primitive);
 }
 
+template <typename ParamSerialiser, typename ReturnSerialiser>
+rdcarray<ShaderDebugTrace *> ReplayProxy::Proxied_DebugPixels(
+    ParamSerialiser &paramser, ReturnSerialiser &retser, uint32_t eventId,
+    const rdcarray<DebugPixelInputs> &pixels)
+{
+  const ReplayProxyPacket expectedPacket = eReplayProxy_DebugPixels;
+  ReplayProxyPacket packet = eReplayProxy_DebugPixels;
+  rdcarray<ShaderDebugTrace *> ret;
+
+  // the traces are serialised by value. On the remote side the debugger pointers stay alive to be
+  // used opaquely in ContinueDebug/FreeDebugger, so only the trace structs themselves are freed.
+  rdcarray<ShaderDebugTrace> traces;
+
+  {
+    BEGIN_PARAMS();
+    SERIALISE_ELEMENT(eventId);
+    SERIALISE_ELEMENT(pixels);
+    END_PARAMS();
+  }
+
+  {
+    REMOTE_EXECUTION();
+    if(paramser.IsReading() && !paramser.IsErrored() && !m_IsErrored)
+    {
+      rdcarray<ShaderDebugTrace *> remoteTraces = m_Remote->DebugPixels(eventId, pixels);
+      traces.resize(remoteTraces.size());
+      for(size_t i = 0; i < remoteTraces.size(); i++)
+      {
+        traces[i] = *remoteTraces[i];
+        delete remoteTraces[i];
+      }
+    }
+  }
+
+  SERIALISE_RETURN(traces);
+
+  if(retser.IsReading())
+  {
+    ret.resize(traces.size());
+    for(size_t i = 0; i < traces.size(); i++)
+      ret[i] = new ShaderDebugTrace(traces[i]);
+  }
+
+  return ret;
+}
+
+rdcarray<ShaderDebugTrace *> ReplayProxy::DebugPixels(uint32_t eventId,
+                                                      const rdcarray<DebugPixelInputs> &pixels)
+{
+  PROXY_FUNCTION(DebugPixels, eventId, pixels);
+}
+
 template <typename ParamSerialiser, typename ReturnSerialiser>
 ShaderDebugTrace *ReplayProxy::Proxied_DebugThread(ParamSerialiser &paramser,
                                                    ReturnSerialiser &retser, uint32_t eventId,
@@ -1799,6 +1898,41 @@ void ReplayProxy::ReplayLog(uint32_t endEventID, ReplayLogType replayType)
   PROXY_FUNCTION(ReplayLog, endEventID, replayType);
 }
 
+template <typename ParamSerialiser, typename ReturnSerialiser>
+void ReplayProxy::Proxied_SetReplayRange(ParamSerialiser &paramser, ReturnSerialiser &retser,
+                                         uint32_t startEventID, uint32_t endEventID)
+{
+  const ReplayProxyPacket expectedPacket = eReplayProxy_SetReplayRange;
+  ReplayProxyPacket packet = eReplayProxy_SetReplayRange;
+
+  {
+    BEGIN_PARAMS();
+    SERIALISE_ELEMENT(startEventID);
+    SERIALISE_ELEMENT(endEventID);
+    END_PARAMS();
+  }
+
+  {
+    REMOTE_EXECUTION();
+    if(paramser.IsReading() && !paramser.IsErrored() && !m_IsErrored)
+      m_Remote->SetReplayRange(startEventID, endEventID);
+  }
+
+  // setting up the range replays the frame on the remote side
+  if(retser.IsReading())
+  {
+    m_TextureProxyCache.clear();
+    m_BufferProxyCache.clear();
+  }
+
+  SERIALISE_RETURN_VOID();
+}
+
+void ReplayProxy::SetReplayRange(uint32_t startEventID, uint32_t endEventID)
+{
+  PROXY_FUNCTION(SetReplayRange, startEventID, endEventID);
+}
+
 template <typename ParamSerialiser, typename ReturnSerialiser>
 void ReplayProxy::Proxied_FetchStructuredFile(ParamSerialiser &paramser, ReturnSerialiser &retser)
 {
@@ -2757,6 +2891,7 @@ bool ReplayProxy::Tick(int type)
       CacheTextureData(ResourceId(), Subresource(), GetTextureDataParams());
       break;
     case eReplayProxy_ReplayLog: ReplayLog(0, (ReplayLogType)0); break;
+    case eReplayProxy_SetReplayRange: SetReplayRange(0, 0); break;
     case eReplayProxy_FetchStructuredFile: FetchStructuredFile(); break;
     case eReplayProxy_GetAPIProperties: GetAPIProperties(); break;
     case eReplayProxy_GetPassEvents: GetPassEvents(0); break;
@@ -2823,6 +2958,7 @@ bool ReplayProxy::Tick(int type)
     case eReplayProxy_RemoveReplacement: RemoveReplacement(ResourceId()); break;
     case eReplayProxy_DebugVertex: DebugVertex(0, 0, 0, 0, 0); break;
     case eReplayProxy_DebugPixel: DebugPixel(0, 0, 0, 0, 0); break;
+    case eReplayProxy_DebugPixels: DebugPixels(0, {}); break;
     case eReplayProxy_DebugThread:
     {
       uint32_t dummy1[3] = {0};
@@ -2838,6 +2974,10 @@ bool ReplayProxy::Tick(int type)
     case eReplayProxy_PixelHistory:
       PixelHistory(rdcarray<EventUsage>(), ResourceId(), 0, 0, Subresource(), CompType::Typeless);
       break;
+    case eReplayProxy_PixelHistoryRegion:
+      PixelHistoryRegion(rdcarray<EventUsage>(), ResourceId(), 0, 0, 0, 0, Subresource(),
+                         CompType::Typeless);
+      break;
     case eReplayProxy_DisassembleShader: DisassembleShader(ResourceId(), NULL, ""); break;
     case eReplayProxy_GetDisassemblyTargets: GetDisassemblyTargets(false); break;
     case eReplayProxy_GetTargetShaderEncodings: GetTargetShaderEncodings(); break;
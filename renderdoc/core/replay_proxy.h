@@ -103,6 +103,12 @@ enum ReplayProxyPacket
 
   eReplayProxy_ContinueDebug,
   eReplayProxy_FreeDebugger,
+
+  eReplayProxy_PixelHistoryRegion,
+
+  eReplayProxy_DebugPixels,
+
+  eReplayProxy_SetReplayRange,
 };
 
 DECLARE_REFLECTION_ENUM(ReplayProxyPacket);
@@ -477,6 +483,7 @@ public:
 
   IMPLEMENT_FUNCTION_PROXIED(void, SavePipelineState, uint32_t eventId);
   IMPLEMENT_FUNCTION_PROXIED(void, ReplayLog, uint32_t endEventID, ReplayLogType replayType);
+  IMPLEMENT_FUNCTION_PROXIED(void, SetReplayRange, uint32_t startEventID, uint32_t endEventID);
 
   IMPLEMENT_FUNCTION_PROXIED(rdcarray<uint32_t>, GetPassEvents, uint32_t eventId);
 
@@ -523,10 +530,16 @@ public:
   IMPLEMENT_FUNCTION_PROXIED(rdcarray<PixelModification>, PixelHistory, rdcarray<EventUsage> events,
                              ResourceId target, uint32_t x, uint32_t y, const Subresource &sub,
                              CompType typeCast);
+  IMPLEMENT_FUNCTION_PROXIED(rdcarray<PixelHistoryResult>, PixelHistoryRegion,
+                             rdcarray<EventUsage> events, ResourceId target, uint32_t x, uint32_t y,
+                             uint32_t width, uint32_t height, const Subresource &sub,
+                             CompType typeCast);
   IMPLEMENT_FUNCTION_PROXIED(ShaderDebugTrace *, DebugVertex, uint32_t eventId, uint32_t vertid,
                              uint32_t instid, uint32_t idx, uint32_t view);
   IMPLEMENT_FUNCTION_PROXIED(ShaderDebugTrace *, DebugPixel, uint32_t eventId, uint32_t x,
                              uint32_t y, uint32_t sample, uint32_t primitive);
+  IMPLEMENT_FUNCTION_PROXIED(rdcarray<ShaderDebugTrace *>, DebugPixels, uint32_t eventId,
+                             const rdcarray<DebugPixelInputs> &pixels);
   IMPLEMENT_FUNCTION_PROXIED(ShaderDebugTrace *, DebugThread, uint32_t eventId,
                              const uint32_t groupid[3], const uint32_t threadid[3]);
   IMPLEMENT_FUNCTION_PROXIED(rdcarray<ShaderDebugState>, ContinueDebug, ShaderDebugger *debugger);
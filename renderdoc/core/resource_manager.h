@@ -282,6 +282,88 @@ inline bool MarkReferenced(std::map<ResourceId, FrameRefType> &refs, ResourceId
   return MarkReferenced(refs, id, refType, ComposeFrameRefs);
 }
 
+// The frame references made by a single record, such as a command buffer, which is marked on every
+// bind and draw. Each resource gets a dense index the first time it's referenced and its reference
+// is stored at that index in a flat array, with an open-addressed hash table to find the index of
+// an ID. Marking a resource again is then a single probe without allocating, and applying the
+// references at submit walks them linearly in the order they were first referenced.
+class FrameRefSet
+{
+public:
+  typedef rdcpair<ResourceId, FrameRefType> Entry;
+
+  // returns true if this is the first reference to the resource
+  template <typename Compose>
+  bool Mark(ResourceId id, FrameRefType refType, Compose comp)
+  {
+    // keep the table at most half full
+    if((m_Refs.size() + 1) * 2 > m_Table.size())
+      Rehash(RDCMAX(m_Table.size() * 2, (size_t)16));
+
+    const size_t mask = m_Table.size() - 1;
+    for(size_t slot = Hash(id) & mask;; slot = (slot + 1) & mask)
+    {
+      uint32_t idx = m_Table[slot];
+
+      if(idx == 0)
+      {
+        m_Refs.push_back({id, refType});
+        m_Table[slot] = (uint32_t)m_Refs.size();
+        return true;
+      }
+
+      Entry &e = m_Refs[idx - 1];
+      if(e.first == id)
+      {
+        e.second = comp(e.second, refType);
+        return false;
+      }
+    }
+  }
+
+  const Entry *begin() const { return m_Refs.begin(); }
+  const Entry *end() const { return m_Refs.end(); }
+  size_t size() const { return m_Refs.size(); }
+  bool empty() const { return m_Refs.empty(); }
+  void clear()
+  {
+    m_Refs.clear();
+    m_Table.clear();
+  }
+  void swap(FrameRefSet &other)
+  {
+    m_Refs.swap(other.m_Refs);
+    m_Table.swap(other.m_Table);
+  }
+
+private:
+  static size_t Hash(ResourceId id)
+  {
+    // IDs are allocated sequentially, so spread them with a multiplicative hash
+    return size_t((std::hash<ResourceId>()(id) * 0x9E3779B97F4A7C15ULL) >> 32);
+  }
+
+  void Rehash(size_t tableSize)
+  {
+    m_Table.clear();
+    m_Table.resize(tableSize);
+
+    const size_t mask = tableSize - 1;
+    for(size_t i = 0; i < m_Refs.size(); i++)
+    {
+      size_t slot = Hash(m_Refs[i].first) & mask;
+      while(m_Table[slot] != 0)
+        slot = (slot + 1) & mask;
+      m_Table[slot] = uint32_t(i + 1);
+    }
+  }
+
+  // the references, indexed by each resource's dense index
+  rdcarray<Entry> m_Refs;
+  // hash table of dense index + 1 into m_Refs, with 0 for empty slots. Always a power of two size
+  rdcarray<uint32_t> m_Table;
+};
+
 // verbose prints with IDs of each dirty resource and whether it was prepared,
 // and whether it was serialised.
 #define VERBOSE_DIRTY_RESOURCES OPTION_OFF
@@ -303,6 +385,84 @@ public:
   virtual void DestroyResourceRecord(ResourceRecord *record) = 0;
 };
 
+// A list of chunks gathered from resource records, to be written out in ID order. Each record adds
+// its chunks as one run, which is normally already in ID order, and once everything is added the
+// runs are merged together. This avoids building a sorted tree one chunk at a time.
+class RecordChunkList
+{
+public:
+  typedef rdcpair<int64_t, Chunk *> Entry;
+
+  void BeginRun() { m_Runs.push_back(m_Chunks.size()); }
+  void Add(int64_t id, Chunk *chunk) { m_Chunks.push_back({id, chunk}); }
+  size_t size() const { return m_Chunks.size(); }
+  // merge all the runs into a single list sorted by ID. If the same ID was added more than once,
+  // the last one added is kept. This must be called before iterating over the list.
+  void Sort()
+  {
+    m_Runs.push_back(m_Chunks.size());
+
+    // heap of the next chunk in each run, as (index of chunk, index of run end). The heap is a
+    // max-heap so we compare backwards, and break ties with the chunk index so later runs come
+    // later.
+    rdcarray<rdcpair<size_t, size_t>> heap;
+    auto after = [this](const rdcpair<size_t, size_t> &a, const rdcpair<size_t, size_t> &b) {
+      const int64_t ida = m_Chunks[a.first].first, idb = m_Chunks[b.first].first;
+      return ida > idb || (ida == idb && a.first > b.first);
+    };
+
+    for(size_t r = 0; r + 1 < m_Runs.size(); r++)
+    {
+      Entry *begin = m_Chunks.begin() + m_Runs[r];
+      Entry *end = m_Chunks.begin() + m_Runs[r + 1];
+
+      if(begin == end)
+        continue;
+
+      // runs are only out of order if chunks were added to a record with explicit IDs
+      auto idLess = [](const Entry &a, const Entry &b) { return a.first < b.first; };
+      if(!std::is_sorted(begin, end, idLess))
+        std::stable_sort(begin, end, idLess);
+
+      heap.push_back({m_Runs[r], m_Runs[r + 1]});
+    }
+
+    std::make_heap(heap.begin(), heap.end(), after);
+
+    rdcarray<Entry> sorted;
+    sorted.reserve(m_Chunks.size());
+
+    while(!heap.empty())
+    {
+      std::pop_heap(heap.begin(), heap.end(), after);
+      rdcpair<size_t, size_t> &next = heap.back();
+
+      const Entry &entry = m_Chunks[next.first];
+      if(!sorted.empty() && sorted.back().first == entry.first)
+        sorted.back() = entry;
+      else
+        sorted.push_back(entry);
+
+      next.first++;
+      if(next.first < next.second)
+        std::push_heap(heap.begin(), heap.end(), after);
+      else
+        heap.pop_back();
+    }
+
+    m_Chunks.swap(sorted);
+    m_Runs.clear();
+  }
+
+  const Entry *begin() const { return m_Chunks.begin(); }
+  const Entry *end() const { return m_Chunks.end(); }
+
+private:
+  rdcarray<Entry> m_Chunks;
+  // the index in m_Chunks where each run starts
+  rdcarray<size_t> m_Runs;
+};
+
 // This is a generic resource record, that APIs can inherit from and use.
 // A resource is an API object that gets tracked on its own, has dependencies on other resources
 // and has its own stream of chunks.
@@ -364,7 +524,7 @@ struct ResourceRecord
   }
 
   void MarkDataUnwritten() { DataWritten = false; }
-  void Insert(std::map<int64_t, Chunk *> &recordlist)
+  void Insert(RecordChunkList &recordlist)
   {
     bool dataWritten = DataWritten;
 
@@ -380,8 +540,9 @@ struct ResourceRecord
 
     if(!dataWritten)
     {
+      recordlist.BeginRun();
       for(auto it = m_Chunks.begin(); it != m_Chunks.end(); ++it)
-        recordlist[it->id] = it->chunk;
+        recordlist.Add(it->id, it->chunk);
     }
   }
 
@@ -392,9 +553,11 @@ struct ResourceRecord
   ResourceId GetResourceID() const { return ResID; }
   void AddChunk(Chunk *chunk, int64_t ID = 0)
   {
+    LockChunks();
+    // allocate the ID under the lock, so that each record's chunks stay in ID order and can be
+    // merged as a run by RecordChunkList
     if(ID == 0)
       ID = GetID();
-    LockChunks();
     m_Chunks.push_back(StoredChunk(ID, chunk));
     UnlockChunks();
   }
@@ -527,7 +690,7 @@ protected:
   rdcarray<StoredChunk> m_Chunks;
   Threading::CriticalSection *m_ChunkLock;
 
-  std::map<ResourceId, FrameRefType> m_FrameRefs;
+  FrameRefSet m_FrameRefs;
 };
 
 template <typename Compose>
@@ -535,7 +698,7 @@ bool ResourceRecord::MarkResourceFrameReferenced(ResourceId id, FrameRefType ref
 {
   if(id == ResourceId())
     return false;
-  return MarkReferenced(m_FrameRefs, id, refType, comp);
+  return m_FrameRefs.Mark(id, refType, comp);
 }
 
 // the resource manager is a utility class that's not required but is likely wanted by any API
@@ -657,6 +820,12 @@ public:
   // Apply the initial contents for the resources that need them, used at the start of a frame
   void ApplyInitialContents();
 
+  // Copy the current contents of every resource with initial contents, so that the replay can later
+  // return to this point in the frame with ApplySnapshotContents instead of replaying up to it.
+  void SnapshotContents();
+  void ApplySnapshotContents();
+  void FreeSnapshotContents();
+
   // Resource wrapping, allows for querying and adding/removing of wrapper layers around resources
   bool AddWrapper(WrappedResourceType wrap, RealResourceType real);
   bool HasWrapper(RealResourceType real);
@@ -741,6 +910,9 @@ protected:
   // used during capture or replay - holds initial contents
   std::map<ResourceId, InitialContentDataOrChunk> m_InitialContents;
 
+  // used during replay - holds contents snapshotted part-way through the frame
+  std::map<ResourceId, InitialContentDataOrChunk> m_SnapshotContents;
+
   // used during capture or replay - map of resources currently alive with their real IDs, used in
   // capture and replay.
   std::unordered_map<ResourceId, WrappedResourceType> m_CurrentResourceMap;
@@ -1100,6 +1272,8 @@ void ResourceManager<Configuration>::FreeInitialContents()
   }
   m_PostponedResourceIDs.clear();
   m_SkippedResourceIDs.clear();
+
+  FreeSnapshotContents();
 }
 
 template <typename Configuration>
@@ -1344,6 +1518,43 @@ void ResourceManager<Configuration>::ApplyInitialContents()
   RDCDEBUG("Applied %d", (uint32_t)resources.size());
 }
 
+template <typename Configuration>
+void ResourceManager<Configuration>::SnapshotContents()
+{
+  FreeSnapshotContents();
+
+  rdcarray<ResourceId> resources = InitialContentResources();
+
+  // creating initial states stores them as the initial contents, so move the frame's initial
+  // contents out of the way while the snapshot is created then swap them back.
+  std::swap(m_InitialContents, m_SnapshotContents);
+
+  for(ResourceId id : resources)
+    Create_InitialState(id, GetLiveResource(id), true);
+
+  std::swap(m_InitialContents, m_SnapshotContents);
+
+  RDCDEBUG("Snapshotted %u resources", (uint32_t)m_SnapshotContents.size());
+}
+
+template <typename Configuration>
+void ResourceManager<Configuration>::ApplySnapshotContents()
+{
+  for(auto it = m_SnapshotContents.begin(); it != m_SnapshotContents.end(); ++it)
+  {
+    if(HasLiveResource(it->first))
+      Apply_InitialState(GetLiveResource(it->first), it->second.data);
+  }
+}
+
+template <typename Configuration>
+void ResourceManager<Configuration>::FreeSnapshotContents()
+{
+  for(auto it = m_SnapshotContents.begin(); it != m_SnapshotContents.end(); ++it)
+    it->second.Free(this);
+  m_SnapshotContents.clear();
+}
+
 template <typename Configuration>
 rdcarray<ResourceId> ResourceManager<Configuration>::InitialContentResources()
 {
@@ -1372,7 +1583,7 @@ void ResourceManager<Configuration>::MarkUnwrittenResources()
 template <typename Configuration>
 void ResourceManager<Configuration>::InsertReferencedChunks(WriteSerialiser &ser)
 {
-  std::map<int64_t, Chunk *> sortedChunks;
+  RecordChunkList sortedChunks;
 
   SCOPED_LOCK_OPTIONAL(m_Lock, m_Capturing);
 
@@ -1413,6 +1624,8 @@ void ResourceManager<Configuration>::InsertReferencedChunks(WriteSerialiser &ser
     }
   }
 
+  sortedChunks.Sort();
+
   RDCDEBUG("%u frame resource chunks", (uint32_t)sortedChunks.size());
 
   for(auto it = sortedChunks.begin(); it != sortedChunks.end(); it++)
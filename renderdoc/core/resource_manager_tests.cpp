@@ -0,0 +1,208 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "core/resource_manager.h"
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "catch/catch.hpp"
+
+// the list never dereferences the chunks, so we can use IDs as fake pointers to check the order
+static Chunk *FakeChunk(uintptr_t i)
+{
+  return (Chunk *)i;
+}
+
+static rdcarray<uintptr_t> GetOrder(RecordChunkList &list)
+{
+  list.Sort();
+
+  rdcarray<uintptr_t> ret;
+  for(const RecordChunkList::Entry &e : list)
+    ret.push_back((uintptr_t)e.second);
+  return ret;
+}
+
+TEST_CASE("Test record chunk list merging", "[resourcemanager]")
+{
+  RecordChunkList list;
+
+  SECTION("Empty list")
+  {
+    CHECK(GetOrder(list).empty());
+
+    list.BeginRun();
+    list.BeginRun();
+
+    CHECK(GetOrder(list).empty());
+  };
+
+  SECTION("Single run")
+  {
+    list.BeginRun();
+    for(uintptr_t i = 1; i <= 5; i++)
+      list.Add(i * 10, FakeChunk(i));
+
+    CHECK(GetOrder(list) == rdcarray<uintptr_t>({1, 2, 3, 4, 5}));
+  };
+
+  SECTION("Interleaved runs")
+  {
+    list.BeginRun();
+    list.Add(10, FakeChunk(10));
+    list.Add(40, FakeChunk(40));
+    list.Add(70, FakeChunk(70));
+
+    list.BeginRun();
+
+    list.BeginRun();
+    list.Add(20, FakeChunk(20));
+    list.Add(30, FakeChunk(30));
+    list.Add(80, FakeChunk(80));
+
+    list.BeginRun();
+    list.Add(5, FakeChunk(5));
+    list.Add(50, FakeChunk(50));
+    list.Add(60, FakeChunk(60));
+
+    CHECK(list.size() == 9);
+    CHECK(GetOrder(list) == rdcarray<uintptr_t>({5, 10, 20, 30, 40, 50, 60, 70, 80}));
+    CHECK(list.size() == 9);
+  };
+
+  SECTION("Unsorted runs")
+  {
+    list.BeginRun();
+    list.Add(30, FakeChunk(30));
+    list.Add(10, FakeChunk(10));
+
+    list.BeginRun();
+    list.Add(40, FakeChunk(40));
+    list.Add(20, FakeChunk(20));
+
+    CHECK(GetOrder(list) == rdcarray<uintptr_t>({10, 20, 30, 40}));
+  };
+
+  SECTION("Duplicate IDs keep the last chunk added")
+  {
+    list.BeginRun();
+    list.Add(10, FakeChunk(1));
+    list.Add(20, FakeChunk(2));
+
+    list.BeginRun();
+    list.Add(20, FakeChunk(3));
+    list.Add(30, FakeChunk(4));
+
+    CHECK(GetOrder(list) == rdcarray<uintptr_t>({1, 3, 4}));
+  };
+
+  SECTION("Many runs")
+  {
+    // runs of varying length with IDs striped across them
+    const uintptr_t numRuns = 37;
+    for(uintptr_t r = 0; r < numRuns; r++)
+    {
+      list.BeginRun();
+      for(uintptr_t i = r; i < 1000; i += numRuns + (r % 3))
+        list.Add(int64_t(i), FakeChunk(i));
+    }
+
+    rdcarray<uintptr_t> order = GetOrder(list);
+
+    REQUIRE(!order.empty());
+    for(size_t i = 1; i < order.size(); i++)
+      CHECK(order[i - 1] < order[i]);
+  };
+}
+
+TEST_CASE("Test frame reference sets", "[resourcemanager]")
+{
+  FrameRefSet refs;
+
+  rdcarray<ResourceId> ids;
+  for(int i = 0; i < 1000; i++)
+    ids.push_back(ResourceIDGen::GetNewUniqueID());
+
+  SECTION("References are composed")
+  {
+    CHECK(refs.Mark(ids[0], eFrameRef_Read, ComposeFrameRefs));
+    CHECK(refs.Mark(ids[1], eFrameRef_CompleteWrite, ComposeFrameRefs));
+    CHECK_FALSE(refs.Mark(ids[0], eFrameRef_PartialWrite, ComposeFrameRefs));
+    CHECK_FALSE(refs.Mark(ids[1], eFrameRef_Read, ComposeFrameRefs));
+
+    REQUIRE(refs.size() == 2);
+
+    // references are in the order resources were first referenced
+    CHECK(refs.begin()[0].first == ids[0]);
+    CHECK(refs.begin()[0].second == eFrameRef_ReadBeforeWrite);
+    CHECK(refs.begin()[1].first == ids[1]);
+    CHECK(refs.begin()[1].second == eFrameRef_CompleteWrite);
+  };
+
+  SECTION("Many references")
+  {
+    // mark in a scattered order, several times each
+    for(int pass = 0; pass < 3; pass++)
+    {
+      for(size_t i = 0; i < ids.size(); i++)
+      {
+        bool first = refs.Mark(ids[(i * 7) % ids.size()], eFrameRef_Read, ComposeFrameRefs);
+        CHECK(first == (pass == 0));
+      }
+    }
+
+    CHECK(refs.size() == ids.size());
+
+    std::set<ResourceId> seen;
+    for(const FrameRefSet::Entry &e : refs)
+    {
+      CHECK(e.second == eFrameRef_Read);
+      seen.insert(e.first);
+    }
+    CHECK(seen.size() == ids.size());
+  };
+
+  SECTION("Swap and clear")
+  {
+    FrameRefSet other;
+
+    refs.Mark(ids[0], eFrameRef_Read, ComposeFrameRefs);
+    other.Mark(ids[1], eFrameRef_Read, ComposeFrameRefs);
+    other.Mark(ids[2], eFrameRef_Read, ComposeFrameRefs);
+
+    refs.swap(other);
+
+    CHECK(refs.size() == 2);
+    CHECK(other.size() == 1);
+    CHECK_FALSE(refs.Mark(ids[2], eFrameRef_Read, ComposeFrameRefs));
+    CHECK(refs.Mark(ids[0], eFrameRef_Read, ComposeFrameRefs));
+
+    refs.clear();
+
+    CHECK(refs.empty());
+    CHECK(refs.Mark(ids[1], eFrameRef_Read, ComposeFrameRefs));
+  };
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
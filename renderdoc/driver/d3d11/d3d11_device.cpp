@@ -270,6 +270,8 @@ WrappedID3D11Device::~WrappedID3D11Device()
 
   m_CachedStateObjects.clear();
 
+  SAFE_DELETE(m_ReplayRangeState);
+
   GetResourceManager()->ClearReferencedResources();
 
   SAFE_RELEASE(m_pDevice1);
@@ -1481,7 +1483,27 @@ void WrappedID3D11Device::ReplayLog(uint32_t startEventID, uint32_t endEventID,
 {
   bool partial = true;
 
-  if(startEventID == 0 && (replayType == eReplay_WithoutDraw || replayType == eReplay_Full))
+  bool inRange = m_ReplayRangeStartEID > 0 && endEventID >= m_ReplayRangeStartEID &&
+                 endEventID <= m_ReplayRangeEndEID;
+
+  // if we're replaying to an event inside the replay range, restore the snapshot from the start of
+  // the range instead of going back to the start of the frame.
+  if(startEventID == 0 && replayType == eReplay_WithoutDraw && inRange)
+  {
+    {
+      RENDERDOC_PROFILEREGION("ApplySnapshotContents");
+      D3D11MarkerRegion apply("!!!!RenderDoc Internal: ApplySnapshotContents");
+      GetResourceManager()->ApplySnapshotContents();
+      m_ReplayRangeState->ApplyState(m_pImmediateContext);
+    }
+
+    startEventID = m_ReplayRangeStartEID;
+
+    // nothing more to replay if the draw is the first event in the range
+    if(startEventID >= endEventID)
+      return;
+  }
+  else if(startEventID == 0 && (replayType == eReplay_WithoutDraw || replayType == eReplay_Full))
   {
     startEventID = 1;
     partial = false;
@@ -1522,6 +1544,27 @@ void WrappedID3D11Device::ReplayLog(uint32_t startEventID, uint32_t endEventID,
   D3D11MarkerRegion::Set("!!!!RenderDoc Internal: Done replay");
 }
 
+void WrappedID3D11Device::SetReplayRange(uint32_t startEventID, uint32_t endEventID)
+{
+  GetResourceManager()->FreeSnapshotContents();
+  SAFE_DELETE(m_ReplayRangeState);
+  m_ReplayRangeStartEID = m_ReplayRangeEndEID = 0;
+
+  // a range from the first event is no cheaper than replaying from the start of the frame
+  if(startEventID <= 1 || endEventID < startEventID)
+    return;
+
+  // replay up to just before the range, then snapshot everything that a replay from the start of
+  // the frame would otherwise restore.
+  ReplayLog(0, startEventID, eReplay_WithoutDraw);
+
+  m_ReplayRangeState = new D3D11RenderState(m_pImmediateContext);
+  GetResourceManager()->SnapshotContents();
+
+  m_ReplayRangeStartEID = startEventID;
+  m_ReplayRangeEndEID = endEventID;
+}
+
 void WrappedID3D11Device::NewSwapchainBuffer(IUnknown *backbuffer)
 {
   WrappedID3D11Texture2D1 *wrapped = (WrappedID3D11Texture2D1 *)backbuffer;
@@ -2069,8 +2112,8 @@ bool WrappedID3D11Device::EndFrameCapture(void *dev, void *wnd)
     {
       SectionProperties props;
 
-      // Compress with LZ4 so that it's fast
-      props.flags = SectionFlags::LZ4Compressed;
+      // Compress with LZ4 so that it's fast, and index it so it can be read from any point
+      props.flags = SectionFlags::LZ4Compressed | SectionFlags::SeekIndexed;
       props.version = m_SectionVersion;
       props.type = SectionType::FrameCapture;
 
@@ -2131,8 +2174,9 @@ bool WrappedID3D11Device::EndFrameCapture(void *dev, void *wnd)
 
         RDCDEBUG("Accumulating context resource list");
 
-        std::map<int64_t, Chunk *> recordlist;
+        RecordChunkList recordlist;
         record->Insert(recordlist);
+        recordlist.Sort();
 
         RDCDEBUG("Flushing %u records to file serialiser", (uint32_t)recordlist.size());
 
@@ -41,6 +41,7 @@ class D3D11DebugManager;
 class D3D11TextRenderer;
 class D3D11ShaderCache;
 class D3D11Replay;
+struct D3D11RenderState;
 
 #ifndef D3D11_1_UAV_SLOT_COUNT
 #define D3D11_1_UAV_SLOT_COUNT 64
@@ -494,6 +495,13 @@ private:
   ID3DUserDefinedAnnotation *m_RealAnnotations;
   int m_ReplayEventCount;
 
+  // the event range set with SetReplayRange, and the render state from just before its first event.
+  // Replays to an event inside the range restore this state and the snapshotted resource contents,
+  // then carry on from the first event instead of replaying from the start of the frame.
+  uint32_t m_ReplayRangeStartEID = 0;
+  uint32_t m_ReplayRangeEndEID = 0;
+  D3D11RenderState *m_ReplayRangeState = NULL;
+
   // the device only has one refcount, all device childs take precisely one when they have external
   // references (if they lose their external references they release it) and when it reaches 0 the
   // device is deleted.
@@ -720,6 +728,7 @@ public:
   ReplayStatus ReadLogInitialisation(RDCFile *rdc, bool storeStructuredBuffers);
   bool ProcessChunk(ReadSerialiser &ser, D3D11Chunk context);
   void ReplayLog(uint32_t startEventID, uint32_t endEventID, ReplayLogType replayType);
+  void SetReplayRange(uint32_t startEventID, uint32_t endEventID);
 
   ////////////////////////////////////////////////////////////////
   // 'fake' interfaces
@@ -170,7 +170,7 @@ struct D3D11ResourceRecord : public ResourceRecord
       SubResources[i]->SetDataPtr(ptr);
   }
 
-  void Insert(std::map<int64_t, Chunk *> &recordlist)
+  void Insert(RecordChunkList &recordlist)
   {
     bool dataWritten = DataWritten;
 
@@ -186,8 +186,9 @@ struct D3D11ResourceRecord : public ResourceRecord
 
     if(!dataWritten)
     {
+      recordlist.BeginRun();
       for(auto it = m_Chunks.begin(); it != m_Chunks.end(); ++it)
-        recordlist[it->id] = it->chunk;
+        recordlist.Add(it->id, it->chunk);
 
       for(int i = 0; i < NumSubResources; i++)
         SubResources[i]->Insert(recordlist);
@@ -2523,3 +2523,28 @@ rdcarray<PixelModification> D3D11Replay::PixelHistory(rdcarray<EventUsage> event
 
   return history;
 }
+
+rdcarray<PixelHistoryResult> D3D11Replay::PixelHistoryRegion(rdcarray<EventUsage> events,
+                                                             ResourceId target, uint32_t x,
+                                                             uint32_t y, uint32_t width,
+                                                             uint32_t height,
+                                                             const Subresource &sub,
+                                                             CompType typeCast)
+{
+  rdcarray<PixelHistoryResult> ret;
+  ret.resize(width * height);
+
+  // no replay passes are shared between pixels here yet, so fetch each pixel's history in turn
+  for(uint32_t py = 0; py < height; py++)
+  {
+    for(uint32_t px = 0; px < width; px++)
+    {
+      PixelHistoryResult &result = ret[py * width + px];
+      result.x = x + px;
+      result.y = y + py;
+      result.history = PixelHistory(events, target, result.x, result.y, sub, typeCast);
+    }
+  }
+
+  return ret;
+}
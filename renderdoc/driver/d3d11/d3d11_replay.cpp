@@ -1563,6 +1563,11 @@ void D3D11Replay::ReplayLog(uint32_t endEventID, ReplayLogType replayType)
   m_pDevice->ReplayLog(0, endEventID, replayType);
 }
 
+void D3D11Replay::SetReplayRange(uint32_t startEventID, uint32_t endEventID)
+{
+  m_pDevice->SetReplayRange(startEventID, endEventID);
+}
+
 const SDFile &D3D11Replay::GetStructuredFile()
 {
   return m_pDevice->GetStructuredFile();
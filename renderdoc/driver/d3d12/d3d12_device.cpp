@@ -2415,8 +2415,8 @@ bool WrappedID3D12Device::EndFrameCapture(void *dev, void *wnd)
   {
     SectionProperties props;
 
-    // Compress with LZ4 so that it's fast
-    props.flags = SectionFlags::LZ4Compressed;
+    // Compress with LZ4 so that it's fast, and index it so it can be read from any point
+    props.flags = SectionFlags::LZ4Compressed | SectionFlags::SeekIndexed;
     props.version = m_SectionVersion;
     props.type = SectionType::FrameCapture;
 
@@ -2469,7 +2469,7 @@ bool WrappedID3D12Device::EndFrameCapture(void *dev, void *wnd)
     // in capframe (the transition is thread-protected) so nothing will be
     // pushed to the vector
 
-    std::map<int64_t, Chunk *> recordlist;
+    RecordChunkList recordlist;
 
     for(auto it = queues.begin(); it != queues.end(); ++it)
     {
@@ -2498,6 +2498,8 @@ bool WrappedID3D12Device::EndFrameCapture(void *dev, void *wnd)
 
     m_FrameCaptureRecord->Insert(recordlist);
 
+    recordlist.Sort();
+
     RDCDEBUG("Flushing %u chunks to file serialiser from context record",
              (uint32_t)recordlist.size());
 
@@ -254,6 +254,12 @@ void D3D12Replay::ReplayLog(uint32_t endEventID, ReplayLogType replayType)
   m_pDevice->ReplayLog(0, endEventID, replayType);
 }
 
+void D3D12Replay::SetReplayRange(uint32_t startEventID, uint32_t endEventID)
+{
+  // we can't start a replay part-way through the frame as it may be inside a command list, so
+  // there's nothing to snapshot. Every replay starts from the beginning of the frame.
+}
+
 const SDFile &D3D12Replay::GetStructuredFile()
 {
   return m_pDevice->GetStructuredFile();
@@ -3755,6 +3761,16 @@ rdcarray<PixelModification> D3D12Replay::PixelHistory(rdcarray<EventUsage> event
   return {};
 }
 
+rdcarray<PixelHistoryResult> D3D12Replay::PixelHistoryRegion(rdcarray<EventUsage> events,
+                                                             ResourceId target, uint32_t x,
+                                                             uint32_t y, uint32_t width,
+                                                             uint32_t height,
+                                                             const Subresource &sub,
+                                                             CompType typeCast)
+{
+  return {};
+}
+
 ResourceId D3D12Replay::CreateProxyTexture(const TextureDescription &templateTex)
 {
   return ResourceId();
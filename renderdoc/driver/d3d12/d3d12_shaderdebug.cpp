@@ -2916,6 +2916,15 @@ void ExtractInputsPS(PSInput IN, float4 debug_pixelPos : SV_Position,
   return ret;
 }
 
+rdcarray<ShaderDebugTrace *> D3D12Replay::DebugPixels(uint32_t eventId,
+                                                      const rdcarray<DebugPixelInputs> &pixels)
+{
+  rdcarray<ShaderDebugTrace *> ret;
+  for(const DebugPixelInputs &p : pixels)
+    ret.push_back(DebugPixel(eventId, p.x, p.y, p.sample, p.primitive));
+  return ret;
+}
+
 ShaderDebugTrace *D3D12Replay::DebugThread(uint32_t eventId, const uint32_t groupid[3],
                                            const uint32_t threadid[3])
 {
@@ -2287,8 +2287,8 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
     {
       SectionProperties props;
 
-      // Compress with LZ4 so that it's fast
-      props.flags = SectionFlags::LZ4Compressed;
+      // Compress with LZ4 so that it's fast, and index it so it can be read from any point
+      props.flags = SectionFlags::LZ4Compressed | SectionFlags::SeekIndexed;
       props.version = m_SectionVersion;
       props.type = SectionType::FrameCapture;
 
@@ -2353,7 +2353,7 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
       {
         RDCDEBUG("Accumulating context resource list");
 
-        std::map<int64_t, Chunk *> recordlist;
+        RecordChunkList recordlist;
         m_ContextRecord->Insert(recordlist);
 
         for(auto it = m_ContextData.begin(); it != m_ContextData.end(); ++it)
@@ -2370,6 +2370,8 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
           }
         }
 
+        recordlist.Sort();
+
         RDCDEBUG("Flushing %u records to file serialiser", (uint32_t)recordlist.size());
 
         float num = float(recordlist.size());
@@ -5628,7 +5630,29 @@ void WrappedOpenGL::ReplayLog(uint32_t startEventID, uint32_t endEventID, Replay
 {
   bool partial = true;
 
-  if(startEventID == 0 && (replayType == eReplay_WithoutDraw || replayType == eReplay_Full))
+  bool inRange = m_ReplayRangeStartEID > 0 && endEventID >= m_ReplayRangeStartEID &&
+                 endEventID <= m_ReplayRangeEndEID;
+
+  // if we're replaying to an event inside the replay range, restore the snapshot from the start of
+  // the range instead of going back to the start of the frame.
+  if(startEventID == 0 && replayType == eReplay_WithoutDraw && inRange)
+  {
+    {
+      RENDERDOC_PROFILEREGION("ApplySnapshotContents");
+      GLMarkerRegion apply("!!!!RenderDoc Internal: ApplySnapshotContents");
+      GetResourceManager()->ApplySnapshotContents();
+      m_ReplayRangeState.ApplyState(this);
+    }
+
+    m_WasActiveFeedback = false;
+
+    startEventID = m_ReplayRangeStartEID;
+
+    // nothing more to replay if the draw is the first event in the range
+    if(startEventID >= endEventID)
+      return;
+  }
+  else if(startEventID == 0 && (replayType == eReplay_WithoutDraw || replayType == eReplay_Full))
   {
     startEventID = 1;
     partial = false;
@@ -5669,3 +5693,24 @@ void WrappedOpenGL::ReplayLog(uint32_t startEventID, uint32_t endEventID, Replay
 
   GLMarkerRegion::Set("!!!!RenderDoc Internal: Done replay");
 }
+
+void WrappedOpenGL::SetReplayRange(uint32_t startEventID, uint32_t endEventID)
+{
+  GetResourceManager()->FreeSnapshotContents();
+  m_ReplayRangeState.Clear();
+  m_ReplayRangeStartEID = m_ReplayRangeEndEID = 0;
+
+  // a range from the first event is no cheaper than replaying from the start of the frame
+  if(startEventID <= 1 || endEventID < startEventID)
+    return;
+
+  // replay up to just before the range, then snapshot everything that a replay from the start of
+  // the frame would otherwise restore.
+  ReplayLog(0, startEventID, eReplay_WithoutDraw);
+
+  m_ReplayRangeState.FetchState(this);
+  GetResourceManager()->SnapshotRangeContents();
+
+  m_ReplayRangeStartEID = startEventID;
+  m_ReplayRangeEndEID = endEventID;
+}
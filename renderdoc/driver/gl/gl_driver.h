@@ -233,6 +233,13 @@ private:
 
   int m_ReplayEventCount = 0;
 
+  // the event range set with SetReplayRange, and the render state from just before its first event.
+  // Replays to an event inside the range restore this state and the snapshotted resource contents,
+  // then carry on from the first event instead of replaying from the start of the frame.
+  uint32_t m_ReplayRangeStartEID = 0;
+  uint32_t m_ReplayRangeEndEID = 0;
+  GLRenderState m_ReplayRangeState;
+
   // we store two separate sets of maps, since for an explicit glMemoryBarrier
   // we need to flush both types of maps, but for implicit sync points we only
   // want to consider coherent maps, and since that happens often we want it to
@@ -638,6 +645,7 @@ public:
   // replay interface
   void Initialise(GLInitParams &params, uint64_t sectionVersion, const ReplayOptions &opts);
   void ReplayLog(uint32_t startEventID, uint32_t endEventID, ReplayLogType replayType);
+  void SetReplayRange(uint32_t startEventID, uint32_t endEventID);
   ReplayStatus ReadLogInitialisation(RDCFile *rdc, bool storeStructuredBuffers);
 
   GLuint GetFakeVAO0() { return m_Global_VAO0; }
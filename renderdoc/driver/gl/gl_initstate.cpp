@@ -1097,6 +1097,143 @@ uint64_t GLResourceManager::GetSize_InitialState(ResourceId resid, const GLIniti
   return 16;
 }
 
+GLuint GLResourceManager::CreateInitialProgram(ResourceId liveid)
+{
+  WrappedOpenGL &drv = *m_Driver;
+
+  WrappedOpenGL::ProgramData &details = m_Driver->m_Programs[liveid];
+
+  bool IsProgramSPIRV = false;
+
+  GLuint initProg = drv.glCreateProgram();
+
+  uint32_t numShaders = 0;
+
+  rdcarray<rdcstr> vertexOutputs;
+  for(size_t i = 0; i < ARRAY_COUNT(details.stageShaders); i++)
+  {
+    if(details.stageShaders[i] == ResourceId())
+      continue;
+
+    numShaders++;
+
+    const auto &shadDetails = m_Driver->m_Shaders[details.stageShaders[i]];
+
+    IsProgramSPIRV |= shadDetails.reflection.encoding == ShaderEncoding::SPIRV;
+
+    GLuint shad = drv.glCreateShader(shadDetails.type);
+
+    if(shadDetails.type == eGL_VERTEX_SHADER)
+    {
+      for(const SigParameter &sig : shadDetails.reflection.outputSignature)
+      {
+        rdcstr name = sig.varName;
+
+        // look for :row or :col added to split up matrix variables
+        int32_t colon = name.find(":");
+
+        // remove it, if present
+        if(colon >= 0)
+          name.resize(colon);
+
+        // only push matrix variables once
+        if(!vertexOutputs.contains(name))
+          vertexOutputs.push_back(name);
+      }
+    }
+
+    if(!shadDetails.sources.empty())
+    {
+      char **srcs = new char *[shadDetails.sources.size()];
+      for(size_t s = 0; s < shadDetails.sources.size(); s++)
+        srcs[s] = (char *)shadDetails.sources[s].c_str();
+      drv.glShaderSource(shad, (GLsizei)shadDetails.sources.size(), srcs, NULL);
+
+      SAFE_DELETE_ARRAY(srcs);
+      drv.glCompileShader(shad);
+      drv.glAttachShader(initProg, shad);
+      drv.glDeleteShader(shad);
+    }
+    else if(!shadDetails.spirvWords.empty())
+    {
+      drv.glShaderBinary(1, &shad, eGL_SHADER_BINARY_FORMAT_SPIR_V, shadDetails.spirvWords.data(),
+                         (GLsizei)shadDetails.spirvWords.size() * sizeof(uint32_t));
+
+      drv.glSpecializeShader(shad, shadDetails.entryPoint.c_str(),
+                             (GLuint)shadDetails.specIDs.size(), shadDetails.specIDs.data(),
+                             shadDetails.specValues.data());
+
+      drv.glAttachShader(initProg, shad);
+      drv.glDeleteShader(shad);
+    }
+    else
+    {
+      RDCERR("Unexpectedly empty shader in program initial state!");
+    }
+  }
+
+  // Some drivers optimize out uniforms if they dont change any active vertex shader outputs.
+  // This resulted in initProg locationTranslate table being -1 for a particular shader where
+  // some uniforms were only intended to affect TF. Therefore set a TF mode for all varyings.
+  // As the initial state program is never used for TF, this wont adversely affect anything.
+
+  // don't print debug messages from these links - we know some might fail but as long as we
+  // eventually get one to work that's fine.
+  m_Driver->SuppressDebugMessages(true);
+
+  rdcarray<const char *> vertexOutputsPtr;
+  vertexOutputsPtr.resize(vertexOutputs.size());
+  for(size_t i = 0; i < vertexOutputs.size(); i++)
+    vertexOutputsPtr[i] = vertexOutputs[i].c_str();
+
+  if(!IsProgramSPIRV)
+    drv.glTransformFeedbackVaryings(initProg, (GLsizei)vertexOutputsPtr.size(),
+                                    &vertexOutputsPtr[0], eGL_INTERLEAVED_ATTRIBS);
+  drv.glLinkProgram(initProg);
+
+  GLint status = 0;
+  drv.glGetProgramiv(initProg, eGL_LINK_STATUS, &status);
+
+  // if it failed to link, first remove the varyings hack above as maybe the driver is barfing
+  // on trying to make some output a varying
+  if(status == 0 && !IsProgramSPIRV)
+  {
+    drv.glTransformFeedbackVaryings(initProg, 0, NULL, eGL_INTERLEAVED_ATTRIBS);
+    drv.glLinkProgram(initProg);
+
+    drv.glGetProgramiv(initProg, eGL_LINK_STATUS, &status);
+  }
+
+  // if it failed to link, try again as a separable program.
+  // we can't do this by default because of the silly rules meaning
+  // shaders need fixup to be separable-compatible.
+  if(status == 0)
+  {
+    drv.glProgramParameteri(initProg, eGL_PROGRAM_SEPARABLE, 1);
+    drv.glLinkProgram(initProg);
+
+    drv.glGetProgramiv(initProg, eGL_LINK_STATUS, &status);
+  }
+
+  m_Driver->SuppressDebugMessages(false);
+
+  if(status == 0)
+  {
+    if(numShaders == 0)
+    {
+      RDCWARN("No shaders attached to program");
+    }
+    else
+    {
+      char buffer[1025] = {0};
+      drv.glGetProgramInfoLog(initProg, 1024, NULL, buffer);
+      RDCERR("Link error: %s", buffer);
+    }
+  }
+
+  return initProg;
+}
+
 template <typename SerialiserType>
 bool GLResourceManager::Serialise_InitialState(SerialiserType &ser, ResourceId id,
                                                GLResourceRecord *record,
@@ -1161,146 +1298,18 @@ bool GLResourceManager::Serialise_InitialState(SerialiserType &ser, ResourceId i
   }
   else if(Type == eResProgram)
   {
-    WrappedOpenGL &drv = *m_Driver;
-
     GLuint bindingsProgram = 0, uniformsProgram = 0;
     std::map<GLint, GLint> *translationTable = NULL;
 
     PerStageReflections stages;
 
-    bool IsProgramSPIRV = false;
-
     if(IsReplayingAndReading())
     {
       WrappedOpenGL::ProgramData &details = m_Driver->m_Programs[GetLiveID(id)];
 
       m_Driver->FillReflectionArray(GetLiveID(id), stages);
 
-      GLuint initProg = drv.glCreateProgram();
-
-      uint32_t numShaders = 0;
-
-      rdcarray<rdcstr> vertexOutputs;
-      for(size_t i = 0; i < ARRAY_COUNT(details.stageShaders); i++)
-      {
-        if(details.stageShaders[i] == ResourceId())
-          continue;
-
-        numShaders++;
-
-        const auto &shadDetails = m_Driver->m_Shaders[details.stageShaders[i]];
-
-        IsProgramSPIRV |= shadDetails.reflection.encoding == ShaderEncoding::SPIRV;
-
-        GLuint shad = drv.glCreateShader(shadDetails.type);
-
-        if(shadDetails.type == eGL_VERTEX_SHADER)
-        {
-          for(const SigParameter &sig : shadDetails.reflection.outputSignature)
-          {
-            rdcstr name = sig.varName;
-
-            // look for :row or :col added to split up matrix variables
-            int32_t colon = name.find(":");
-
-            // remove it, if present
-            if(colon >= 0)
-              name.resize(colon);
-
-            // only push matrix variables once
-            if(!vertexOutputs.contains(name))
-              vertexOutputs.push_back(name);
-          }
-        }
-
-        if(!shadDetails.sources.empty())
-        {
-          char **srcs = new char *[shadDetails.sources.size()];
-          for(size_t s = 0; s < shadDetails.sources.size(); s++)
-            srcs[s] = (char *)shadDetails.sources[s].c_str();
-          drv.glShaderSource(shad, (GLsizei)shadDetails.sources.size(), srcs, NULL);
-
-          SAFE_DELETE_ARRAY(srcs);
-          drv.glCompileShader(shad);
-          drv.glAttachShader(initProg, shad);
-          drv.glDeleteShader(shad);
-        }
-        else if(!shadDetails.spirvWords.empty())
-        {
-          drv.glShaderBinary(1, &shad, eGL_SHADER_BINARY_FORMAT_SPIR_V, shadDetails.spirvWords.data(),
-                             (GLsizei)shadDetails.spirvWords.size() * sizeof(uint32_t));
-
-          drv.glSpecializeShader(shad, shadDetails.entryPoint.c_str(),
-                                 (GLuint)shadDetails.specIDs.size(), shadDetails.specIDs.data(),
-                                 shadDetails.specValues.data());
-
-          drv.glAttachShader(initProg, shad);
-          drv.glDeleteShader(shad);
-        }
-        else
-        {
-          RDCERR("Unexpectedly empty shader in program initial state!");
-        }
-      }
-
-      // Some drivers optimize out uniforms if they dont change any active vertex shader outputs.
-      // This resulted in initProg locationTranslate table being -1 for a particular shader where
-      // some uniforms were only intended to affect TF. Therefore set a TF mode for all varyings.
-      // As the initial state program is never used for TF, this wont adversely affect anything.
-
-      // don't print debug messages from these links - we know some might fail but as long as we
-      // eventually get one to work that's fine.
-      m_Driver->SuppressDebugMessages(true);
-
-      rdcarray<const char *> vertexOutputsPtr;
-      vertexOutputsPtr.resize(vertexOutputs.size());
-      for(size_t i = 0; i < vertexOutputs.size(); i++)
-        vertexOutputsPtr[i] = vertexOutputs[i].c_str();
-
-      if(!IsProgramSPIRV)
-        drv.glTransformFeedbackVaryings(initProg, (GLsizei)vertexOutputsPtr.size(),
-                                        &vertexOutputsPtr[0], eGL_INTERLEAVED_ATTRIBS);
-      drv.glLinkProgram(initProg);
-
-      GLint status = 0;
-      drv.glGetProgramiv(initProg, eGL_LINK_STATUS, &status);
-
-      // if it failed to link, first remove the varyings hack above as maybe the driver is barfing
-      // on trying to make some output a varying
-      if(status == 0 && !IsProgramSPIRV)
-      {
-        drv.glTransformFeedbackVaryings(initProg, 0, NULL, eGL_INTERLEAVED_ATTRIBS);
-        drv.glLinkProgram(initProg);
-
-        drv.glGetProgramiv(initProg, eGL_LINK_STATUS, &status);
-      }
-
-      // if it failed to link, try again as a separable program.
-      // we can't do this by default because of the silly rules meaning
-      // shaders need fixup to be separable-compatible.
-      if(status == 0)
-      {
-        drv.glProgramParameteri(initProg, eGL_PROGRAM_SEPARABLE, 1);
-        drv.glLinkProgram(initProg);
-
-        drv.glGetProgramiv(initProg, eGL_LINK_STATUS, &status);
-      }
-
-      m_Driver->SuppressDebugMessages(false);
-
-      if(status == 0)
-      {
-        if(numShaders == 0)
-        {
-          RDCWARN("No shaders attached to program");
-        }
-        else
-        {
-          char buffer[1025] = {0};
-          drv.glGetProgramInfoLog(initProg, 1024, NULL, buffer);
-          RDCERR("Link error: %s", buffer);
-        }
-      }
+      GLuint initProg = CreateInitialProgram(GetLiveID(id));
 
       // normally we'd serialise programs and uniforms into the initial state program, but on some
       // drivers uniform locations can change between it and the live program, so we serialise the
@@ -1815,6 +1824,13 @@ bool GLResourceManager::Serialise_InitialState(SerialiserType &ser, ResourceId i
     RDCWARN(
         "Technically you could try and readback the contents of a RenderBuffer via pixel copy.");
     RDCWARN("Currently we don't support that though, and initial contents will be uninitialised.");
+
+    // register empty contents so that the renderbuffer is still included in range snapshots
+    if(IsReplayingAndReading())
+    {
+      initContents.type = eResRenderbuffer;
+      SetInitialContents(id, initContents);
+    }
   }
   else
   {
@@ -1888,8 +1904,62 @@ void GLResourceManager::Create_InitialState(ResourceId id, GLResource live, bool
   {
     ContextPrepare_InitialState(live);
   }
+  else if(live.Namespace == eResProgram)
+  {
+    ResourceId liveid = GetID(live);
+
+    const WrappedOpenGL::ProgramData &prog = m_Driver->m_Programs[liveid];
+
+    GLuint initProg = CreateInitialProgram(liveid);
+
+    // copy the bindings and uniforms out of the live program, the reverse of Apply_InitialState
+    bool changedBindings = false;
+
+    if(prog.stageShaders[0] != ResourceId())
+      changedBindings |= CopyProgramAttribBindings(
+          live.name, initProg, &m_Driver->m_Shaders[prog.stageShaders[0]].reflection);
+
+    if(prog.stageShaders[4] != ResourceId())
+      changedBindings |= CopyProgramFragDataBindings(
+          live.name, initProg, &m_Driver->m_Shaders[prog.stageShaders[4]].reflection);
+
+    if(changedBindings)
+      GL.glLinkProgram(initProg);
+
+    PerStageReflections stages;
+    m_Driver->FillReflectionArray(liveid, stages);
+
+    CopyProgramUniforms(stages, live.name, stages, initProg);
+
+    SetInitialContents(id, GLInitialContents(ProgramRes(m_Driver->GetCtx(), initProg), 0));
+  }
   else if(live.Namespace == eResRenderbuffer)
   {
+    GLInitialContents initContents;
+    initContents.type = eResRenderbuffer;
+
+    // renderbuffers have no initial contents in the frame, but for a range snapshot we need to
+    // preserve whatever the replay has rendered into them so far.
+    if(m_SnapshottingRange)
+    {
+      ResourceId liveid = GetID(live);
+      const WrappedOpenGL::TextureData &details = m_Driver->m_Textures[liveid];
+
+      if(details.internalFormat != eGL_NONE && details.width > 0 && details.height > 0)
+      {
+        GLuint rb = 0;
+        GL.glGenRenderbuffers(1, &rb);
+        GL.glNamedRenderbufferStorageMultisampleEXT(rb, details.samples > 1 ? details.samples : 0,
+                                                    details.internalFormat, details.width,
+                                                    details.height);
+
+        CopyRenderbufferContents(liveid, live.name, rb);
+
+        initContents.resource = RenderbufferRes(m_Driver->GetCtx(), rb);
+      }
+    }
+
+    SetInitialContents(id, initContents);
   }
   else
   {
@@ -1897,6 +1967,56 @@ void GLResourceManager::Create_InitialState(ResourceId id, GLResource live, bool
   }
 }
 
+void GLResourceManager::SnapshotRangeContents()
+{
+  m_SnapshottingRange = true;
+  SnapshotContents();
+  m_SnapshottingRange = false;
+}
+
+void GLResourceManager::CopyRenderbufferContents(ResourceId liveid, GLuint src, GLuint dst)
+{
+  const WrappedOpenGL::TextureData &details = m_Driver->m_Textures[liveid];
+
+  GLenum fmt = GetBaseFormat(details.internalFormat);
+
+  GLenum attach = eGL_COLOR_ATTACHMENT0;
+  GLbitfield mask = GL_COLOR_BUFFER_BIT;
+  if(fmt == eGL_DEPTH_COMPONENT)
+  {
+    attach = eGL_DEPTH_ATTACHMENT;
+    mask = GL_DEPTH_BUFFER_BIT;
+  }
+  else if(fmt == eGL_STENCIL)
+  {
+    attach = eGL_STENCIL_ATTACHMENT;
+    mask = GL_STENCIL_BUFFER_BIT;
+  }
+  else if(fmt == eGL_DEPTH_STENCIL)
+  {
+    attach = eGL_DEPTH_STENCIL_ATTACHMENT;
+    mask = GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
+  }
+
+  GLuint prevread = 0, prevdraw = 0;
+  GL.glGetIntegerv(eGL_DRAW_FRAMEBUFFER_BINDING, (GLint *)&prevdraw);
+  GL.glGetIntegerv(eGL_READ_FRAMEBUFFER_BINDING, (GLint *)&prevread);
+
+  GLuint fbos[2] = {};
+  GL.glGenFramebuffers(2, fbos);
+  GL.glBindFramebuffer(eGL_READ_FRAMEBUFFER, fbos[0]);
+  GL.glBindFramebuffer(eGL_DRAW_FRAMEBUFFER, fbos[1]);
+  GL.glNamedFramebufferRenderbufferEXT(fbos[0], attach, eGL_RENDERBUFFER, src);
+  GL.glNamedFramebufferRenderbufferEXT(fbos[1], attach, eGL_RENDERBUFFER, dst);
+
+  SafeBlitFramebuffer(0, 0, details.width, details.height, 0, 0, details.width, details.height,
+                      mask, eGL_NEAREST);
+
+  GL.glBindFramebuffer(eGL_DRAW_FRAMEBUFFER, prevdraw);
+  GL.glBindFramebuffer(eGL_READ_FRAMEBUFFER, prevread);
+  GL.glDeleteFramebuffers(2, fbos);
+}
+
 void GLResourceManager::Apply_InitialState(GLResource live, const GLInitialContents &initial)
 {
   if(live.Namespace == eResBuffer)
@@ -2531,6 +2651,9 @@ void GLResourceManager::Apply_InitialState(GLResource live, const GLInitialConte
   }
   else if(live.Namespace == eResRenderbuffer)
   {
+    // only range snapshots have contents to restore
+    if(initial.resource.name)
+      CopyRenderbufferContents(GetID(live), initial.resource.name, live.name);
   }
   else
   {
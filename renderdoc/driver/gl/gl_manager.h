@@ -321,6 +321,10 @@ public:
 
   void ContextPrepare_InitialState(GLResource res);
 
+  // snapshot the current contents for a replay range. Unlike the frame's initial contents this
+  // also copies renderbuffers, which otherwise have no contents restored.
+  void SnapshotRangeContents();
+
   void SetInternalResource(GLResource res);
 
 private:
@@ -331,6 +335,8 @@ private:
   uint64_t GetSize_InitialState(ResourceId resid, const GLInitialContents &initial);
 
   void PrepareTextureInitialContents(ResourceId liveid, ResourceId origid, GLResource res);
+  GLuint CreateInitialProgram(ResourceId liveid);
+  void CopyRenderbufferContents(ResourceId liveid, GLuint src, GLuint dst);
 
   void Create_InitialState(ResourceId id, GLResource live, bool hasData);
   void Apply_InitialState(GLResource live, const GLInitialContents &initial);
@@ -357,5 +363,7 @@ private:
 
   rdcflatmap<ResourceId, FBOCache *> m_FBOAttachmentsCache;
 
+  bool m_SnapshottingRange = false;
+
   WrappedOpenGL *m_Driver;
 };
@@ -105,6 +105,12 @@ void GLReplay::ReplayLog(uint32_t endEventID, ReplayLogType replayType)
   }
 }
 
+void GLReplay::SetReplayRange(uint32_t startEventID, uint32_t endEventID)
+{
+  MakeCurrentReplayContext(&m_ReplayCtx);
+  m_pDriver->SetReplayRange(startEventID, endEventID);
+}
+
 const SDFile &GLReplay::GetStructuredFile()
 {
   return m_pDriver->GetStructuredFile();
@@ -3656,6 +3662,15 @@ rdcarray<PixelModification> GLReplay::PixelHistory(rdcarray<EventUsage> events,
   return {};
 }
 
+rdcarray<PixelHistoryResult> GLReplay::PixelHistoryRegion(rdcarray<EventUsage> events,
+                                                          ResourceId target, uint32_t x, uint32_t y,
+                                                          uint32_t width, uint32_t height,
+                                                          const Subresource &sub, CompType typeCast)
+{
+  GLNOTIMP("GLReplay::PixelHistoryRegion");
+  return {};
+}
+
 ShaderDebugTrace *GLReplay::DebugVertex(uint32_t eventId, uint32_t vertid, uint32_t instid,
                                         uint32_t idx, uint32_t view)
 {
@@ -3670,6 +3685,15 @@ ShaderDebugTrace *GLReplay::DebugPixel(uint32_t eventId, uint32_t x, uint32_t y,
   return new ShaderDebugTrace();
 }
 
+rdcarray<ShaderDebugTrace *> GLReplay::DebugPixels(uint32_t eventId,
+                                                   const rdcarray<DebugPixelInputs> &pixels)
+{
+  rdcarray<ShaderDebugTrace *> ret;
+  for(const DebugPixelInputs &p : pixels)
+    ret.push_back(DebugPixel(eventId, p.x, p.y, p.sample, p.primitive));
+  return ret;
+}
+
 ShaderDebugTrace *GLReplay::DebugThread(uint32_t eventId, const uint32_t groupid[3],
                                         const uint32_t threadid[3])
 {
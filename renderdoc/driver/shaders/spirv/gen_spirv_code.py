@@ -296,6 +296,8 @@ for operand_kind in spirv['operand_kinds']:
     operand_kind['push_words'] = lambda name: 'words.push_back((uint32_t){});'.format(name)
     operand_kind['from_words'] = None
     operand_kind['is_id'] = False
+    # the words within the operand that are IDs
+    operand_kind['id_words'] = []
 
     if operand_kind['category'] == 'ValueEnum':
         operand_kind['size'] = 1
@@ -396,6 +398,7 @@ rdcstr DoStringise(const rdcspv::{name} &el)
         operand_kind['def_value'] = 'Id()'
         operand_kind['type'] = 'Id'
         operand_kind['is_id'] = True
+        operand_kind['id_words'] = [0]
         operand_kind['push_words'] = lambda name: 'words.push_back({}.value());'.format(name)
         operand_kind['from_words'] = lambda name: 'Id::fromWord({})'.format(name)
     elif (operand_kind['kind'] == 'IdResultType' or
@@ -405,6 +408,7 @@ rdcstr DoStringise(const rdcspv::{name} &el)
         operand_kind['size'] = 1
         operand_kind['type'] = name
         operand_kind['is_id'] = True
+        operand_kind['id_words'] = [0]
         operand_kind['def_name'] = name[2].lower() + name[3:]
         operand_kind['def_value'] = name + '()'
         operand_kind['push_words'] = lambda name: 'words.push_back({}.value());'.format(name)
@@ -429,6 +433,7 @@ rdcstr DoStringise(const rdcspv::{name} &el)
         operand_kind['size'] = None
     elif (operand_kind['kind'] == 'PairLiteralIntegerIdRef'):
         operand_kind['size'] = 2
+        operand_kind['id_words'] = [1]
         operand_kind['def_name'] = name[0].lower() + name[1:]
         operand_kind['def_value'] = '{0, Id()}'
         operand_kind['type'] = name
@@ -436,6 +441,7 @@ rdcstr DoStringise(const rdcspv::{name} &el)
         ops_header.write('struct {} {{ uint32_t first; Id second; }};\n\n'.format(name))
     elif (operand_kind['kind'] == 'PairIdRefLiteralInteger'):
         operand_kind['size'] = 2
+        operand_kind['id_words'] = [0]
         operand_kind['def_name'] = name[0].lower() + name[1:]
         operand_kind['def_value'] = '{Id(), 0}'
         operand_kind['type'] = name
@@ -443,6 +449,7 @@ rdcstr DoStringise(const rdcspv::{name} &el)
         ops_header.write('struct {} {{ Id first; uint32_t second; }};\n\n'.format(name))
     elif (operand_kind['kind'] == 'PairIdRefIdRef'):
         operand_kind['size'] = 2
+        operand_kind['id_words'] = [0, 1]
         operand_kind['def_name'] = name[0].lower() + name[1:]
         operand_kind['def_value'] = '{Id(), Id()}'
         operand_kind['type'] = name
@@ -886,6 +893,8 @@ for inst in spirv['instructions']:
     resultType = -1
 
     used_ids += '    case rdcspv::Op::{}:\n'.format(inst['opname'][2:])
+    inst_ids = ''
+    ids_word = False
 
     operands = []
     
@@ -973,11 +982,40 @@ for inst in spirv['instructions']:
                         if quantifier == '*':
                             manual_init += '    uint32_t word = {};\n'.format(all_size)
 
-                if kind['is_id']:
+                # only visit the words that are IDs, and only when the operand is present. Operands
+                # after a string don't have a fixed offset, so they're found by walking the words.
+                if len(kind['id_words']) > 0:
+                    is_result = 'true' if i+1==result else 'false'
                     if quantifier == '*':
-                        used_ids += '      for(size_t i=0; i < size-{0}; i++) callback(Id::fromWord(it.word({0}+i)), {1});\n'.format(all_size, 'true' if i+1==result else 'false')
+                        if kind['size'] == 1:
+                            if ids_word:
+                                inst_ids += '      for(; word < size; word++) callback(Id::fromWord(it.word(word)), {});\n'.format(is_result)
+                            else:
+                                inst_ids += '      for(size_t i=0; i < size-{0}; i++) callback(Id::fromWord(it.word({0}+i)), {1});\n'.format(all_size, is_result)
+                        else:
+                            if ids_word:
+                                inst_ids += '      for(; word + {0} <= size; word += {0})\n'.format(kind['size'])
+                                offs = 'word'
+                            else:
+                                inst_ids += '      for(size_t i={0}; i + {1} <= size; i += {1})\n'.format(all_size, kind['size'])
+                                offs = 'i'
+                            inst_ids += '      {\n'
+                            for w in kind['id_words']:
+                                inst_ids += '        callback(Id::fromWord(it.word({}{})), {});\n'.format(offs, '+{}'.format(w) if w > 0 else '', is_result)
+                            inst_ids += '      }\n'
+                    elif quantifier == '?':
+                        inst_ids += '      if(size > {0}) callback(Id::fromWord(it.word({0})), {1});\n'.format('word' if ids_word else all_size, is_result)
                     else:
-                        used_ids += '      callback(Id::fromWord(it.word({})), {});\n'.format(all_size, 'true' if i+1==result else 'false')
+                        inst_ids += '      callback(Id::fromWord(it.word({})), {});\n'.format('word' if ids_word else all_size, is_result)
+                    if ids_word and quantifier != '*':
+                        inst_ids += '      word += {};\n'.format(kind['size'])
+                elif (operand['kind'] == 'LiteralString' or kind['has_params']) and any([len(kinds[o['kind']]['id_words']) > 0 for o in operands[i+1:]]):
+                    if not ids_word:
+                        inst_ids += '      uint32_t word = {};\n'.format(all_size)
+                        ids_word = True
+                    inst_ids += '      DecodeParam<{}>(it, word);\n'.format(kind['type'])
+                elif ids_word:
+                    inst_ids += '      word += {};\n'.format(kind['size'])
 
                 if kind['size'] < 0:
                     size_name = 'MinWordSize'
@@ -1115,7 +1153,11 @@ for inst in spirv['instructions']:
             if operand != last_operand and 'quantifier' in operand and ('quantifier' not in last_operand or last_operand['quantifier'] != operand['quantifier'] or operand['quantifier'] != '?'):
                 raise ValueError('quantifier on operand {} in {} but not on last operand'.format(operand['name'], inst['opname']))
 
-    used_ids += '      break;\n'
+    # scope the word offset, if one is declared, to this case
+    if ids_word:
+        used_ids += '    {\n' + inst_ids + '      break;\n    }\n'
+    else:
+        used_ids += inst_ids + '      break;\n'
 
     if result < 0:
         result = ' result = Id();'
@@ -490,17 +490,15 @@ void ThreadState::JumpToLabel(Id target)
   nextInstruction = debugger.GetInstructionForLabel(target) + 1;
 
   // if jumping to an empty unconditional loop header, continue to the loop block
-  Iter it = debugger.GetIterForInstruction(nextInstruction);
-  if(it.opcode() == Op::LoopMerge)
+  const DecodedInstruction &decoded = debugger.GetDecodedInstruction(nextInstruction);
+  if(decoded.op == Op::LoopMerge)
   {
-    OpLoopMerge merge(it);
-
-    mergeBlock = merge.mergeBlock;
+    mergeBlock = decoded.target;
 
-    it++;
-    if(it.opcode() == Op::Branch)
+    const DecodedInstruction &next = debugger.GetDecodedInstruction(nextInstruction + 1);
+    if(next.op == Op::Branch)
     {
-      JumpToLabel(OpBranch(it).targetLabel);
+      JumpToLabel(next.target);
     }
   }
 
@@ -561,29 +559,17 @@ void ThreadState::SkipIgnoredInstructions()
   // in pixel shaders, but otherwise skip them.
   while(true)
   {
-    Iter it = debugger.GetIterForInstruction(nextInstruction);
-    rdcspv::Op op = it.opcode();
+    const DecodedInstruction &decoded = debugger.GetDecodedInstruction(nextInstruction);
+    rdcspv::Op op = decoded.op;
     if(op == Op::Line || op == Op::NoLine)
     {
       nextInstruction++;
       continue;
     }
 
-    if(op == Op::SelectionMerge)
-    {
-      OpSelectionMerge merge(it);
-
-      mergeBlock = merge.mergeBlock;
-
-      nextInstruction++;
-      continue;
-    }
-
-    if(op == Op::LoopMerge)
+    if(op == Op::SelectionMerge || op == Op::LoopMerge)
     {
-      OpLoopMerge merge(it);
-
-      mergeBlock = merge.mergeBlock;
+      mergeBlock = decoded.target;
 
       nextInstruction++;
       continue;
@@ -607,10 +593,9 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
   m_State = state;
 
   Iter it = debugger.GetIterForInstruction(nextInstruction);
+  const DecodedInstruction &opdata = debugger.GetDecodedInstruction(nextInstruction);
   nextInstruction++;
 
-  OpDecoder opdata(it);
-
   // don't skip any instructions here. These should be skipped *after* processing, so that
   // nextInstruction always points to the next real instruction.
 
@@ -872,7 +857,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
 
       ShaderVariable var;
 
-      const DataType &type = debugger.GetType(construct.resultType);
+      const DataType &type = *opdata.type;
 
       RDCASSERT(!construct.constituents.empty());
 
@@ -949,7 +934,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
 
       ShaderVariable var;
 
-      const DataType &type = debugger.GetType(shuffle.resultType);
+      const DataType &type = *opdata.type;
 
       var.type = type.scalar().Type();
       var.rows = 1;
@@ -1049,7 +1034,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
       OpConvertFToS convert(it);
 
       const ShaderVariable &var = GetSrc(convert.floatValue);
-      const DataType &resultType = debugger.GetType(convert.resultType);
+      const DataType &resultType = *opdata.type;
 
       ShaderVariable conv = var;
       conv.type = resultType.scalar().Type();
@@ -1146,7 +1131,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
       OpUConvert cast(it);
 
       const ShaderVariable &var = GetSrc(cast.unsignedValue);
-      const DataType &resultType = debugger.GetType(cast.resultType);
+      const DataType &resultType = *opdata.type;
 
       ShaderVariable conv = var;
       conv.type = resultType.scalar().Type();
@@ -1176,7 +1161,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
       OpSConvert cast(it);
 
       const ShaderVariable &var = GetSrc(cast.signedValue);
-      const DataType &resultType = debugger.GetType(cast.resultType);
+      const DataType &resultType = *opdata.type;
 
       ShaderVariable conv = var;
       conv.type = resultType.scalar().Type();
@@ -1206,7 +1191,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
       OpFConvert cast(it);
 
       const ShaderVariable &var = GetSrc(cast.floatValue);
-      const DataType &resultType = debugger.GetType(cast.resultType);
+      const DataType &resultType = *opdata.type;
 
       ShaderVariable conv = var;
       conv.type = resultType.scalar().Type();
@@ -1240,7 +1225,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
     {
       OpBitcast cast(it);
 
-      const DataType &type = debugger.GetType(cast.resultType);
+      const DataType &type = *opdata.type;
       ShaderVariable var = GetSrc(cast.operand);
 
       if((type.type == DataType::ScalarType && var.columns == 1) || type.vector().count == var.columns)
@@ -1709,7 +1694,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
     {
       OpBitCount bitwise(it);
 
-      const DataType &type = debugger.GetType(bitwise.resultType);
+      const DataType &type = *opdata.type;
       ShaderVariable var = GetSrc(bitwise.base);
       ShaderVariable ret = var;
       ret.type = type.scalar().Type();
@@ -2317,7 +2302,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
       ShaderVariable var = vector;
       var.columns = matrix.columns;
 
-      const DataType &type = debugger.GetType(mul.resultType);
+      const DataType &type = *opdata.type;
       RDCASSERTEQUAL(type.vector().count, var.columns);
       RDCASSERTEQUAL(matrix.rows, vector.columns);
 
@@ -2367,7 +2352,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
       ShaderVariable var = vector;
       var.columns = matrix.rows;
 
-      const DataType &type = debugger.GetType(mul.resultType);
+      const DataType &type = *opdata.type;
       RDCASSERTEQUAL(type.vector().count, var.columns);
       RDCASSERTEQUAL(matrix.columns, vector.columns);
 
@@ -2649,7 +2634,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
         sampler = sampler.members[1];
       }
 
-      const DataType &resultType = debugger.GetType(opdata.resultType);
+      const DataType &resultType = *opdata.type;
 
       RDCASSERT(img.type == VarType::ReadOnlyResource || img.type == VarType::ReadWriteResource);
       RDCASSERT(sampler.type == VarType::Unknown || sampler.type == VarType::ReadOnlyResource ||
@@ -2690,7 +2675,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
       ShaderVariable img = GetSrc(read.image);
       ShaderVariable coord = GetSrc(read.coordinate);
 
-      const DataType &resultType = debugger.GetType(opdata.resultType);
+      const DataType &resultType = *opdata.type;
 
       // only the sample operand should be here
       RDCASSERT((read.imageOperands.flags & ImageOperands::Sample) == read.imageOperands.flags);
@@ -2860,7 +2845,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
     }
     case Op::ReadClockKHR:
     {
-      const DataType &resultType = debugger.GetType(opdata.resultType);
+      const DataType &resultType = *opdata.type;
 
       ShaderVariable result;
 
@@ -2910,7 +2895,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
       if(returnValue.name.empty())
       {
         uint32_t returnInstruction = nextInstruction - 1;
-        nextInstruction = debugger.GetInstructionForFunction(call.function);
+        nextInstruction = opdata.targetInstruction;
 
         EnterFunction(call.arguments);
 
@@ -3023,7 +3008,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
       }
       else
       {
-        const DataType &resultType = debugger.GetType(opdata.resultType);
+        const DataType &resultType = *opdata.type;
 
         result.rows = result.columns = 1;
         result.type = resultType.scalar().Type();
@@ -3081,7 +3066,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
       }
       else
       {
-        const DataType &resultType = debugger.GetType(opdata.resultType);
+        const DataType &resultType = *opdata.type;
 
         result.rows = result.columns = 1;
         result.type = resultType.scalar().Type();
@@ -3121,7 +3106,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
       }
       else
       {
-        const DataType &resultType = debugger.GetType(opdata.resultType);
+        const DataType &resultType = *opdata.type;
 
         result.rows = result.columns = 1;
         result.type = resultType.scalar().Type();
@@ -3181,7 +3166,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
       }
       else
       {
-        const DataType &resultType = debugger.GetType(opdata.resultType);
+        const DataType &resultType = *opdata.type;
 
         result.rows = result.columns = 1;
         result.type = resultType.scalar().Type();
@@ -3246,7 +3231,7 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
       }
       else
       {
-        const DataType &resultType = debugger.GetType(opdata.resultType);
+        const DataType &resultType = *opdata.type;
 
         result.rows = result.columns = 1;
         result.type = resultType.scalar().Type();
@@ -3836,21 +3821,11 @@ void ThreadState::StepNext(ShaderDebugState *state, const rdcarray<ThreadState>
   // skip over any degenerate branches
   while(true)
   {
-    it = debugger.GetIterForInstruction(nextInstruction);
-    if(it.opcode() == Op::Branch)
+    const DecodedInstruction &decoded = debugger.GetDecodedInstruction(nextInstruction);
+    if(decoded.op == Op::Branch && decoded.targetInstruction == decoded.nextNonLine)
     {
-      Id target = OpBranch(it).targetLabel;
-
-      it++;
-
-      while(it.opcode() == Op::Line || it.opcode() == Op::NoLine)
-        it++;
-
-      if(target == OpLabel(it).result)
-      {
-        JumpToLabel(target);
-        continue;
-      }
+      JumpToLabel(decoded.target);
+      continue;
     }
 
     break;
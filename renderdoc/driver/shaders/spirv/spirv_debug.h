@@ -159,6 +159,25 @@ private:
   StackFrame &operator=(const StackFrame &o) = delete;
 };
 
+// pre-decoded form of an instruction, built once when the module is parsed so that stepping can
+// dispatch and follow control flow without re-decoding the SPIR-V words or looking up IDs in maps.
+struct DecodedInstruction
+{
+  Op op = Op::Max;
+  Id result;
+  Id resultType;
+  // the resolved result type, or NULL if the instruction has no result type
+  const DataType *type = NULL;
+  // the merge block for OpSelectionMerge/OpLoopMerge, the target label for OpBranch and the
+  // called function for OpFunctionCall
+  Id target;
+  // the instruction index of the target for OpBranch (the OpLabel) and OpFunctionCall (the
+  // OpFunction)
+  uint32_t targetInstruction = ~0U;
+  // the index of the first instruction after this one that isn't an OpLine/OpNoLine
+  uint32_t nextNonLine = ~0U;
+};
+
 class Debugger;
 
 struct ThreadState
@@ -257,6 +276,10 @@ public:
   uint32_t GetInstructionForIter(Iter it);
   uint32_t GetInstructionForFunction(Id id);
   uint32_t GetInstructionForLabel(Id id);
+  const DecodedInstruction &GetDecodedInstruction(uint32_t inst) const
+  {
+    return decodedInstructions[inst];
+  }
   const DataType &GetType(Id typeId);
   const DataType &GetTypeForId(Id ssaId);
   const Decorations &GetDecorations(Id typeId);
@@ -330,13 +353,13 @@ private:
   rdcarray<MemberName> memberNames;
   std::map<rdcstr, Id> entryLookup;
 
-  SparseIdMap<size_t> idDeathOffset;
+  DenseIdMap<size_t> idDeathOffset;
 
   SparseIdMap<size_t> m_Files;
   LineColumnInfo m_CurLineCol;
   std::map<size_t, LineColumnInfo> m_LineColInfo;
 
-  SparseIdMap<uint32_t> labelInstruction;
+  DenseIdMap<uint32_t> labelInstruction;
 
   // the live mutable global variables, to initialise a stack frame's live list
   rdcarray<Id> liveGlobals;
@@ -344,7 +367,7 @@ private:
 
   struct Function
   {
-    size_t begin = 0;
+    uint32_t begin = 0;
     rdcarray<Id> parameters;
     rdcarray<Id> variables;
   };
@@ -353,6 +376,7 @@ private:
   Function *curFunction = NULL;
 
   rdcarray<size_t> instructionOffsets;
+  rdcarray<DecodedInstruction> decodedInstructions;
 
   std::set<rdcstr> usedNames;
   std::map<Id, rdcstr> dynamicNames;
@@ -137,12 +137,17 @@ Iter Debugger::GetIterForInstruction(uint32_t inst)
 
 uint32_t Debugger::GetInstructionForIter(Iter it)
 {
-  return instructionOffsets.indexOf(it.offs());
+  // instructions are registered in order so the offsets are sorted
+  const size_t *found =
+      std::lower_bound(instructionOffsets.begin(), instructionOffsets.end(), it.offs());
+  if(found == instructionOffsets.end() || *found != it.offs())
+    return ~0U;
+  return uint32_t(found - instructionOffsets.begin());
 }
 
 uint32_t Debugger::GetInstructionForFunction(Id id)
 {
-  return instructionOffsets.indexOf(functions[id].begin);
+  return functions[id].begin;
 }
 
 uint32_t Debugger::GetInstructionForLabel(Id id)
@@ -559,7 +564,7 @@ ShaderDebugTrace *Debugger::BeginDebug(DebugAPIWrapper *api, const ShaderStage s
 
   ThreadState &active = GetActiveLane();
 
-  active.nextInstruction = instructionOffsets.indexOf(functions[entryId].begin);
+  active.nextInstruction = GetInstructionForFunction(entryId);
 
   active.ids.resize(idOffsets.size());
 
@@ -2296,6 +2301,8 @@ void Debugger::PreParse(uint32_t maxId)
   Processor::PreParse(maxId);
 
   strings.resize(idTypes.size());
+  idDeathOffset.resize(idTypes.size());
+  labelInstruction.resize(idTypes.size());
 }
 
 void Debugger::PostParse()
@@ -2310,6 +2317,45 @@ void Debugger::PostParse()
     idDeathOffset[v.id] = ~0U;
 
   memberNames.clear();
+
+  // decode every instruction once up front, now that all labels, functions and types are known
+  decodedInstructions.resize(instructionOffsets.size());
+  for(size_t i = 0; i < instructionOffsets.size(); i++)
+  {
+    ConstIter it(m_SPIRV, instructionOffsets[i]);
+    OpDecoder opdata(it);
+
+    DecodedInstruction &decoded = decodedInstructions[i];
+    decoded.op = opdata.op;
+    decoded.result = opdata.result;
+    decoded.resultType = opdata.resultType;
+    if(opdata.resultType)
+      decoded.type = &dataTypes[opdata.resultType];
+
+    switch(opdata.op)
+    {
+      case Op::SelectionMerge: decoded.target = OpSelectionMerge(it).mergeBlock; break;
+      case Op::LoopMerge: decoded.target = OpLoopMerge(it).mergeBlock; break;
+      case Op::Branch:
+        decoded.target = OpBranch(it).targetLabel;
+        decoded.targetInstruction = labelInstruction[decoded.target];
+        break;
+      case Op::FunctionCall:
+        decoded.target = OpFunctionCall(it).function;
+        decoded.targetInstruction = functions[decoded.target].begin;
+        break;
+      default: break;
+    }
+  }
+
+  uint32_t nextNonLine = ~0U;
+  for(size_t i = decodedInstructions.size(); i > 0; i--)
+  {
+    DecodedInstruction &decoded = decodedInstructions[i - 1];
+    decoded.nextNonLine = nextNonLine;
+    if(decoded.op != Op::Line && decoded.op != Op::NoLine)
+      nextNonLine = uint32_t(i - 1);
+  }
 }
 
 void Debugger::RegisterOp(Iter it)
@@ -2399,7 +2445,7 @@ void Debugger::RegisterOp(Iter it)
 
     curFunction = &functions[func.result];
 
-    curFunction->begin = it.offs();
+    curFunction->begin = (uint32_t)instructionOffsets.size();
   }
   else if(opdata.op == Op::FunctionParameter)
   {
@@ -2453,3 +2499,48 @@ void Debugger::RegisterOp(Iter it)
 }
 
 };    // namespace rdcspv
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "catch/catch.hpp"
+
+TEST_CASE("Test SPIR-V ID operand iteration", "[spirv]")
+{
+  using namespace rdcspv;
+
+  // the literals are all 2, which is also a live ID. Only the ID operands that are present must be
+  // visited, or ID death offsets would be extended by instructions that don't use the ID.
+  rdcarray<uint32_t> words;
+
+  // no initializer
+  Operation(OpVariable(Id::fromWord(1), Id::fromWord(2), StorageClass::Private)).appendTo(words);
+  // no file
+  Operation(Op::Source, {(uint32_t)SourceLanguage::GLSL, 2}).appendTo(words);
+  // a literal case value
+  Operation(OpSwitch(Id::fromWord(3), Id::fromWord(4), {{2, Id::fromWord(5)}})).appendTo(words);
+  // a name long enough to run into a second word, followed by the interface
+  Operation(OpEntryPoint(ExecutionModel::Fragment, Id::fromWord(6), "main\x02", {Id::fromWord(7)}))
+      .appendTo(words);
+  // a literal decoration parameter
+  Operation(OpDecorate(Id::fromWord(8), DecorationParam<Decoration::Location>(2))).appendTo(words);
+
+  rdcarray<rdcarray<uint32_t>> expected = {
+      {1, 2}, {}, {3, 4, 5}, {6, 7}, {8},
+  };
+
+  ConstIter it(words, 0);
+  for(const rdcarray<uint32_t> &ids : expected)
+  {
+    REQUIRE(bool(it));
+
+    rdcarray<uint32_t> visited;
+    OpDecoder::ForEachID(it, [&visited](Id id, bool result) { visited.push_back(id.value()); });
+
+    INFO("Op" << ToStr(it.opcode()));
+    CHECK(visited == ids);
+
+    it++;
+  }
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
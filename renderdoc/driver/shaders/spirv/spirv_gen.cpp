@@ -1898,7 +1898,7 @@ void OpDecoder::ForEachID(const ConstIter &it, const std::function<void(Id,bool)
     case rdcspv::Op::SourceContinued:
       break;
     case rdcspv::Op::Source:
-      callback(Id::fromWord(it.word(3)), false);
+      if(size > 3) callback(Id::fromWord(it.word(3)), false);
       break;
     case rdcspv::Op::SourceExtension:
       break;
@@ -1924,9 +1924,13 @@ void OpDecoder::ForEachID(const ConstIter &it, const std::function<void(Id,bool)
     case rdcspv::Op::MemoryModel:
       break;
     case rdcspv::Op::EntryPoint:
+    {
       callback(Id::fromWord(it.word(2)), false);
-      for(size_t i=0; i < size-4; i++) callback(Id::fromWord(it.word(4+i)), false);
+      uint32_t word = 3;
+      DecodeParam<rdcstr>(it, word);
+      for(; word < size; word++) callback(Id::fromWord(it.word(word)), false);
       break;
+    }
     case rdcspv::Op::ExecutionMode:
       callback(Id::fromWord(it.word(1)), false);
       break;
@@ -2066,7 +2070,7 @@ void OpDecoder::ForEachID(const ConstIter &it, const std::function<void(Id,bool)
     case rdcspv::Op::Variable:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), true);
-      callback(Id::fromWord(it.word(4)), false);
+      if(size > 4) callback(Id::fromWord(it.word(4)), false);
       break;
     case rdcspv::Op::ImageTexelPointer:
       callback(Id::fromWord(it.word(1)), false);
@@ -2144,6 +2148,10 @@ void OpDecoder::ForEachID(const ConstIter &it, const std::function<void(Id,bool)
       break;
     case rdcspv::Op::GroupMemberDecorate:
       callback(Id::fromWord(it.word(1)), false);
+      for(size_t i=2; i + 2 <= size; i += 2)
+      {
+        callback(Id::fromWord(it.word(i)), false);
+      }
       break;
     case rdcspv::Op::VectorExtractDynamic:
       callback(Id::fromWord(it.word(1)), false);
@@ -3049,6 +3057,11 @@ void OpDecoder::ForEachID(const ConstIter &it, const std::function<void(Id,bool)
     case rdcspv::Op::Phi:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), true);
+      for(size_t i=3; i + 2 <= size; i += 2)
+      {
+        callback(Id::fromWord(it.word(i)), false);
+        callback(Id::fromWord(it.word(i+1)), false);
+      }
       break;
     case rdcspv::Op::LoopMerge:
       callback(Id::fromWord(it.word(1)), false);
@@ -3071,6 +3084,10 @@ void OpDecoder::ForEachID(const ConstIter &it, const std::function<void(Id,bool)
     case rdcspv::Op::Switch:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), false);
+      for(size_t i=3; i + 2 <= size; i += 2)
+      {
+        callback(Id::fromWord(it.word(i+1)), false);
+      }
       break;
     case rdcspv::Op::Kill:
       break;
@@ -3634,112 +3651,112 @@ void OpDecoder::ForEachID(const ConstIter &it, const std::function<void(Id,bool)
       callback(Id::fromWord(it.word(2)), true);
       callback(Id::fromWord(it.word(3)), false);
       callback(Id::fromWord(it.word(5)), false);
-      callback(Id::fromWord(it.word(6)), false);
+      if(size > 6) callback(Id::fromWord(it.word(6)), false);
       break;
     case rdcspv::Op::GroupNonUniformFAdd:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), true);
       callback(Id::fromWord(it.word(3)), false);
       callback(Id::fromWord(it.word(5)), false);
-      callback(Id::fromWord(it.word(6)), false);
+      if(size > 6) callback(Id::fromWord(it.word(6)), false);
       break;
     case rdcspv::Op::GroupNonUniformIMul:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), true);
       callback(Id::fromWord(it.word(3)), false);
       callback(Id::fromWord(it.word(5)), false);
-      callback(Id::fromWord(it.word(6)), false);
+      if(size > 6) callback(Id::fromWord(it.word(6)), false);
       break;
     case rdcspv::Op::GroupNonUniformFMul:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), true);
       callback(Id::fromWord(it.word(3)), false);
       callback(Id::fromWord(it.word(5)), false);
-      callback(Id::fromWord(it.word(6)), false);
+      if(size > 6) callback(Id::fromWord(it.word(6)), false);
       break;
     case rdcspv::Op::GroupNonUniformSMin:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), true);
       callback(Id::fromWord(it.word(3)), false);
       callback(Id::fromWord(it.word(5)), false);
-      callback(Id::fromWord(it.word(6)), false);
+      if(size > 6) callback(Id::fromWord(it.word(6)), false);
       break;
     case rdcspv::Op::GroupNonUniformUMin:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), true);
       callback(Id::fromWord(it.word(3)), false);
       callback(Id::fromWord(it.word(5)), false);
-      callback(Id::fromWord(it.word(6)), false);
+      if(size > 6) callback(Id::fromWord(it.word(6)), false);
       break;
     case rdcspv::Op::GroupNonUniformFMin:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), true);
       callback(Id::fromWord(it.word(3)), false);
       callback(Id::fromWord(it.word(5)), false);
-      callback(Id::fromWord(it.word(6)), false);
+      if(size > 6) callback(Id::fromWord(it.word(6)), false);
       break;
     case rdcspv::Op::GroupNonUniformSMax:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), true);
       callback(Id::fromWord(it.word(3)), false);
       callback(Id::fromWord(it.word(5)), false);
-      callback(Id::fromWord(it.word(6)), false);
+      if(size > 6) callback(Id::fromWord(it.word(6)), false);
       break;
     case rdcspv::Op::GroupNonUniformUMax:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), true);
       callback(Id::fromWord(it.word(3)), false);
       callback(Id::fromWord(it.word(5)), false);
-      callback(Id::fromWord(it.word(6)), false);
+      if(size > 6) callback(Id::fromWord(it.word(6)), false);
       break;
     case rdcspv::Op::GroupNonUniformFMax:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), true);
       callback(Id::fromWord(it.word(3)), false);
       callback(Id::fromWord(it.word(5)), false);
-      callback(Id::fromWord(it.word(6)), false);
+      if(size > 6) callback(Id::fromWord(it.word(6)), false);
       break;
     case rdcspv::Op::GroupNonUniformBitwiseAnd:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), true);
       callback(Id::fromWord(it.word(3)), false);
       callback(Id::fromWord(it.word(5)), false);
-      callback(Id::fromWord(it.word(6)), false);
+      if(size > 6) callback(Id::fromWord(it.word(6)), false);
       break;
     case rdcspv::Op::GroupNonUniformBitwiseOr:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), true);
       callback(Id::fromWord(it.word(3)), false);
       callback(Id::fromWord(it.word(5)), false);
-      callback(Id::fromWord(it.word(6)), false);
+      if(size > 6) callback(Id::fromWord(it.word(6)), false);
       break;
     case rdcspv::Op::GroupNonUniformBitwiseXor:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), true);
       callback(Id::fromWord(it.word(3)), false);
       callback(Id::fromWord(it.word(5)), false);
-      callback(Id::fromWord(it.word(6)), false);
+      if(size > 6) callback(Id::fromWord(it.word(6)), false);
       break;
     case rdcspv::Op::GroupNonUniformLogicalAnd:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), true);
       callback(Id::fromWord(it.word(3)), false);
       callback(Id::fromWord(it.word(5)), false);
-      callback(Id::fromWord(it.word(6)), false);
+      if(size > 6) callback(Id::fromWord(it.word(6)), false);
       break;
     case rdcspv::Op::GroupNonUniformLogicalOr:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), true);
       callback(Id::fromWord(it.word(3)), false);
       callback(Id::fromWord(it.word(5)), false);
-      callback(Id::fromWord(it.word(6)), false);
+      if(size > 6) callback(Id::fromWord(it.word(6)), false);
       break;
     case rdcspv::Op::GroupNonUniformLogicalXor:
       callback(Id::fromWord(it.word(1)), false);
       callback(Id::fromWord(it.word(2)), true);
       callback(Id::fromWord(it.word(3)), false);
       callback(Id::fromWord(it.word(5)), false);
-      callback(Id::fromWord(it.word(6)), false);
+      if(size > 6) callback(Id::fromWord(it.word(6)), false);
       break;
     case rdcspv::Op::GroupNonUniformQuadBroadcast:
       callback(Id::fromWord(it.word(1)), false);
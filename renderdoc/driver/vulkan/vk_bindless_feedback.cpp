@@ -27,6 +27,7 @@
 #include "driver/shaders/spirv/spirv_editor.h"
 #include "driver/shaders/spirv/spirv_op_helpers.h"
 #include "vk_core.h"
+#include "common/shader_cache.h"
 #include "vk_debug.h"
 #include "vk_replay.h"
 #include "vk_shader_cache.h"
@@ -536,6 +537,65 @@ void VulkanReplay::ClearFeedbackCache()
   m_BindlessFeedback.Usage.clear();
 }
 
+bool VulkanReplay::RestoreFeedback(uint32_t eventId)
+{
+  bytebuf persisted;
+
+  if(!m_PersistentCache.Read(PersistedKey(PersistedData::BindlessFeedback, eventId), persisted))
+    return false;
+
+  StreamReader reader(persisted);
+
+  DynamicUsedBinds result;
+  uint32_t numUsed = 0;
+
+  reader.Read(result.compute);
+  reader.Read(result.valid);
+  reader.Read(numUsed);
+
+  if(reader.IsErrored() || numUsed > reader.GetSize())
+    return false;
+
+  result.used.resize(numUsed);
+  for(BindpointIndex &used : result.used)
+  {
+    reader.Read(used.bindset);
+    reader.Read(used.bind);
+    reader.Read(used.arrayIndex);
+  }
+
+  if(reader.IsErrored())
+  {
+    RDCWARN("Invalid cached bindless feedback for event %u, fetching it again", eventId);
+    return false;
+  }
+
+  m_BindlessFeedback.Usage[eventId] = result;
+
+  return true;
+}
+
+void VulkanReplay::PersistFeedback(uint32_t eventId)
+{
+  const DynamicUsedBinds &result = m_BindlessFeedback.Usage[eventId];
+
+  StreamWriter writer(StreamWriter::DefaultScratchSize);
+
+  writer.Write(result.compute);
+  writer.Write(result.valid);
+  writer.Write((uint32_t)result.used.size());
+  for(const BindpointIndex &used : result.used)
+  {
+    writer.Write(used.bindset);
+    writer.Write(used.bind);
+    writer.Write(used.arrayIndex);
+  }
+
+  // if the cache is full this event will just be fetched again next time
+  m_PersistentCache.Write(PersistedKey(PersistedData::BindlessFeedback, eventId),
+                          writer.GetData(), (size_t)writer.GetOffset());
+}
+
 void VulkanReplay::FetchShaderFeedback(uint32_t eventId)
 {
   if(m_BindlessFeedback.Usage.find(eventId) != m_BindlessFeedback.Usage.end())
@@ -544,6 +604,9 @@ void VulkanReplay::FetchShaderFeedback(uint32_t eventId)
   if(!Vulkan_BindlessFeedback())
     return;
 
+  if(RestoreFeedback(eventId))
+    return;
+
   // create it here so we won't re-run any code if the event is re-selected. We'll mark it as valid
   // if it actually has any data in it later.
   DynamicUsedBinds &result = m_BindlessFeedback.Usage[eventId];
@@ -920,6 +983,9 @@ void VulkanReplay::FetchShaderFeedback(uint32_t eventId)
 
   result.valid = true;
 
+  if(m_PersistentCache.IsOpen())
+    PersistFeedback(eventId);
+
   if(descpool != VK_NULL_HANDLE)
   {
     // delete descriptors. Technically we don't have to free the descriptor sets, but our tracking
@@ -25,6 +25,7 @@
 #include "vk_core.h"
 #include <ctype.h>
 #include <algorithm>
+#include "core/settings.h"
 #include "driver/ihv/amd/amd_rgp.h"
 #include "driver/shaders/spirv/spirv_compile.h"
 #include "jpeg-compressor/jpge.h"
@@ -36,6 +37,10 @@
 
 #include "stb/stb_image_write.h"
 
+RDOC_CONFIG(bool, Vulkan_LazyStructuredData, false,
+            "Only structurise each frame chunk when its structured data is first accessed, instead "
+            "of all chunks when the capture is loaded. Saves time and memory on huge captures.");
+
 uint64_t VkInitParams::GetSerialiseSize()
 {
   // misc bytes and fixed integer members
@@ -187,6 +192,8 @@ WrappedVulkan::~WrappedVulkan()
 
   SAFE_DELETE(m_FrameReader);
 
+  SAFE_DELETE(m_LazyExporter);
+
   for(size_t i = 0; i < m_ThreadSerialisers.size(); i++)
     delete m_ThreadSerialisers[i];
 
@@ -1766,6 +1773,10 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
         FreeAlignedBuffer((*it)->memMapState->refData);
         (*it)->memMapState->refData = NULL;
         (*it)->memMapState->needRefData = false;
+
+        // stop watching for writes until the next capture compares against new ref data
+        if((*it)->memMapState->writeWatch)
+          Process::ResetWriteWatch((*it)->memMapState->writeWatch, false);
       }
     }
 
@@ -1982,8 +1993,8 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
   {
     SectionProperties props;
 
-    // Compress with LZ4 so that it's fast
-    props.flags = SectionFlags::LZ4Compressed;
+    // Compress with LZ4 so that it's fast, and index it so it can be read from any point
+    props.flags = SectionFlags::LZ4Compressed | SectionFlags::SeekIndexed;
     props.version = m_SectionVersion;
     props.type = SectionType::FrameCapture;
 
@@ -2042,7 +2053,7 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
       RDCDEBUG("Flushing %u command buffer records to file serialiser",
                (uint32_t)m_CmdBufferRecords.size());
 
-      std::map<int64_t, Chunk *> recordlist;
+      RecordChunkList recordlist;
 
       // ensure all command buffer records within the frame evne if recorded before, but
       // otherwise order must be preserved (vs. queue submits and desc set updates)
@@ -2056,6 +2067,8 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
 
       m_FrameCaptureRecord->Insert(recordlist);
 
+      recordlist.Sort();
+
       RDCDEBUG("Flushing %u chunks to file serialiser from context record",
                (uint32_t)recordlist.size());
 
@@ -2137,6 +2150,10 @@ bool WrappedVulkan::DiscardFrameCapture(void *dev, void *wnd)
         FreeAlignedBuffer((*it)->memMapState->refData);
         (*it)->memMapState->refData = NULL;
         (*it)->memMapState->needRefData = false;
+
+        // stop watching for writes until the next capture compares against new ref data
+        if((*it)->memMapState->writeWatch)
+          Process::ResetWriteWatch((*it)->memMapState->writeWatch, false);
       }
     }
   }
@@ -2472,6 +2489,36 @@ ReplayStatus WrappedVulkan::ReadLogInitialisation(RDCFile *rdc, bool storeStruct
   return ReplayStatus::Succeeded;
 }
 
+// conservatively returns true for any usage that could modify the contents of the resource
+static bool IsWriteUsage(ResourceUsage usage)
+{
+  switch(usage)
+  {
+    case ResourceUsage::StreamOut:
+    case ResourceUsage::VS_RWResource:
+    case ResourceUsage::HS_RWResource:
+    case ResourceUsage::DS_RWResource:
+    case ResourceUsage::GS_RWResource:
+    case ResourceUsage::PS_RWResource:
+    case ResourceUsage::CS_RWResource:
+    case ResourceUsage::All_RWResource:
+    case ResourceUsage::ColorTarget:
+    case ResourceUsage::DepthStencilTarget:
+    case ResourceUsage::Clear:
+    case ResourceUsage::Discard:
+    case ResourceUsage::GenMips:
+    case ResourceUsage::Resolve:
+    case ResourceUsage::ResolveDst:
+    case ResourceUsage::Copy:
+    case ResourceUsage::CopyDst:
+    case ResourceUsage::Barrier:
+    case ResourceUsage::CPUWrite: return true;
+    default: break;
+  }
+
+  return false;
+}
+
 ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t startEventID,
                                              uint32_t endEventID, bool partial)
 {
@@ -2487,8 +2534,29 @@ ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t sta
 
   if(IsLoading(m_State) || IsStructuredExporting(m_State))
   {
-    ser.ConfigureStructuredExport(&GetChunkName, IsStructuredExporting(m_State), m_TimeBase,
-                                  m_TimeFrequency);
+    if(IsLoading(m_State) && Vulkan_LazyStructuredData())
+    {
+      if(m_LazyExporter == NULL)
+      {
+        m_LazyExporter = new WrappedVulkan();
+        m_LazyExporter->SetStructuredExport(m_SectionVersion);
+      }
+
+      WrappedVulkan *exporter = m_LazyExporter;
+
+      // falls back to structurising everything now if the frame isn't in memory. There's no
+      // budget, since the structured file is handed out to the UI and python, which can hold on to
+      // any chunk's children for as long as the capture is open.
+      ser.ConfigureLazyStructuredExport(
+          &GetChunkName,
+          [exporter](StreamReader &reader) { return exporter->StructuriseChunk(reader); }, 0,
+          m_TimeBase, m_TimeFrequency);
+    }
+    else
+    {
+      ser.ConfigureStructuredExport(&GetChunkName, IsStructuredExporting(m_State), m_TimeBase,
+                                    m_TimeFrequency);
+    }
 
     ser.GetStructuredFile().Swap(*m_StructuredFile);
 
@@ -2562,6 +2630,13 @@ ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t sta
     m_LastEventID = ~0U;
   }
 
+  // anything we replay from here on may write to resources, so account for it before we start in
+  // case the replay fails part-way
+  if(IsLoading(m_State))
+    m_ReplayedSinceApplyEID = ~0U;
+  else if(IsActiveReplaying(m_State))
+    m_ReplayedSinceApplyEID = RDCMAX(m_ReplayedSinceApplyEID, endEventID);
+
   if(!partial && !IsStructuredExporting(m_State))
     AddFrameTerminator(AMDRGPControl::GetBeginTag());
 
@@ -2652,6 +2727,25 @@ ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t sta
     SetupDrawcallPointers(m_Drawcalls, GetReplay()->WriteFrameRecord().drawcallList);
 
     m_ParentDrawcall.children.clear();
+
+    m_ImageFirstWriteEID.clear();
+    for(auto it = m_ResourceUses.begin(); it != m_ResourceUses.end(); ++it)
+    {
+      if(m_CreationInfo.m_Image.find(it->first) == m_CreationInfo.m_Image.end())
+        continue;
+
+      for(const EventUsage &u : it->second)
+      {
+        if(!IsWriteUsage(u.usage))
+          continue;
+
+        auto first = m_ImageFirstWriteEID.find(it->first);
+        if(first == m_ImageFirstWriteEID.end())
+          m_ImageFirstWriteEID[it->first] = u.eventId;
+        else
+          first->second = RDCMIN(first->second, u.eventId);
+      }
+    }
   }
 
   if(!IsStructuredExporting(m_State))
@@ -2748,6 +2842,8 @@ void WrappedVulkan::ApplyInitialContents()
   // actually apply the initial contents here
   GetResourceManager()->ApplyInitialContents();
 
+  m_ReplayedSinceApplyEID = 0;
+
   for(auto it = m_ImageStates.begin(); it != m_ImageStates.end(); ++it)
   {
     if(GetResourceManager()->HasCurrentResource(it->first))
@@ -2868,6 +2964,36 @@ bool WrappedVulkan::ContextProcessChunk(ReadSerialiser &ser, VulkanChunk chunk)
   return true;
 }
 
+SDChunk *WrappedVulkan::StructuriseChunk(StreamReader &reader)
+{
+  RDCASSERT(IsStructuredExporting(m_State));
+
+  ReadSerialiser ser(&reader, Ownership::Nothing);
+
+  ser.SetStringDatabase(&m_StringDB);
+  ser.SetUserData(GetResourceManager());
+  ser.SetVersion(m_SectionVersion);
+  ser.ConfigureStructuredExport(&GetChunkName, false, 0, 1.0);
+
+  VulkanChunk chunktype = ser.ReadChunk<VulkanChunk>();
+
+  bool success = true;
+
+  if((SystemChunk)chunktype == SystemChunk::CaptureBegin)
+    success = Serialise_BeginCaptureFrame(ser);
+  else
+    success = ProcessChunk(ser, chunktype);
+
+  ser.EndChunk();
+
+  SDFile &file = ser.GetStructuredFile();
+
+  if(!success || reader.IsErrored() || file.chunks.empty())
+    return NULL;
+
+  return file.chunks.takeAt(0);
+}
+
 bool WrappedVulkan::ProcessChunk(ReadSerialiser &ser, VulkanChunk chunk)
 {
   switch(chunk)
@@ -4214,6 +4340,10 @@ void WrappedVulkan::AddUsage(VulkanDrawcallTreeNode &drawNode, rdcarray<DebugMes
           if(!hugeRangeWarned)
             RDCWARN("Skipping large, most likely 'bindless', descriptor range");
           hugeRangeWarned = true;
+
+          // we can't tell which resources this writes to
+          if(types[t].usage == ResourceUsage::VS_RWResource)
+            m_IncompleteWriteUsage = true;
           continue;
         }
 
@@ -353,6 +353,10 @@ private:
   SDFile *m_StructuredFile;
   SDFile m_StoredStructuredData;
 
+  // a structured-export-only instance used to structurise frame chunks on demand, see
+  // Vulkan_LazyStructuredData
+  WrappedVulkan *m_LazyExporter = NULL;
+
   void AddResource(ResourceId id, ResourceType type, const char *defaultNamePrefix);
   void DerivedResource(ResourceId parentLive, ResourceId child);
   template <typename VulkanType>
@@ -816,6 +820,16 @@ private:
   std::map<ResourceId, rdcarray<EventUsage>> m_ResourceUses;
   std::map<uint32_t, EventFlags> m_EventFlags;
 
+  // the first event in the frame that writes to each image, built from m_ResourceUses once loading
+  // is complete. Images that haven't been written by any event replayed since the initial contents
+  // were last applied still hold their initial contents, so they don't need to be applied again.
+  std::map<ResourceId, uint32_t> m_ImageFirstWriteEID;
+  // the furthest event replayed since the initial contents were last applied
+  uint32_t m_ReplayedSinceApplyEID = ~0U;
+  // set if some writes can't be seen in m_ResourceUses, e.g. through large 'bindless' descriptor
+  // arrays, in which case we always apply all initial contents
+  bool m_IncompleteWriteUsage = false;
+
   bytebuf m_MaskedMapData;
 
   // returns thread-local temporary memory
@@ -939,6 +953,7 @@ private:
   ReplayStatus ContextReplayLog(CaptureState readType, uint32_t startEventID, uint32_t endEventID,
                                 bool partial);
   bool ContextProcessChunk(ReadSerialiser &ser, VulkanChunk chunk);
+  SDChunk *StructuriseChunk(StreamReader &reader);
   void AddDrawcall(const DrawcallDescription &d, bool hasEvents);
   void AddEvent();
 
@@ -1126,6 +1141,7 @@ public:
     return m_PhysicalDeviceData.performanceQueryFeatures;
   }
   VkDriverInfo GetDriverInfo() { return m_PhysicalDeviceData.driverInfo; }
+  const ReplayOptions &GetReplayOptions() { return m_ReplayOptions; }
   uint32_t FindCommandQueueFamily(ResourceId cmdId);
   void InsertCommandQueueFamily(ResourceId cmdId, uint32_t queueFamilyIndex);
   LockedImageStateRef FindImageState(ResourceId id);
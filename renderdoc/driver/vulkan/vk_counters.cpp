@@ -523,207 +523,26 @@ rdcarray<CounterResult> VulkanReplay::FetchCountersAMD(const rdcarray<GPUCounter
   return ret;
 }
 
-struct VulkanKHRCallback : public VulkanDrawcallCallback
-{
-  VulkanKHRCallback(WrappedVulkan *vk, VulkanReplay *rp, VkQueryPool qp)
-      : m_pDriver(vk), m_pReplay(rp), m_QueryPool(qp)
-  {
-    m_pDriver->SetDrawcallCB(this);
-  }
-  ~VulkanKHRCallback() { m_pDriver->SetDrawcallCB(NULL); }
-  void PreDraw(uint32_t eid, VkCommandBuffer cmd) override
-  {
-    ObjDisp(cmd)->CmdBeginQuery(Unwrap(cmd), m_QueryPool, (uint32_t)m_Results.size(), 0);
-  }
-
-  bool PostDraw(uint32_t eid, VkCommandBuffer cmd) override
-  {
-    ObjDisp(cmd)->CmdEndQuery(Unwrap(cmd), m_QueryPool, (uint32_t)m_Results.size());
-    m_Results.push_back(eid);
-    return false;
-  }
-
-  void PostRedraw(uint32_t eid, VkCommandBuffer cmd) override {}
-  // we don't need to distinguish, call the Draw functions
-  void PreDispatch(uint32_t eid, VkCommandBuffer cmd) override { PreDraw(eid, cmd); }
-  bool PostDispatch(uint32_t eid, VkCommandBuffer cmd) override { return PostDraw(eid, cmd); }
-  void PostRedispatch(uint32_t eid, VkCommandBuffer cmd) override { PostRedraw(eid, cmd); }
-  void PreMisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) override { PreDraw(eid, cmd); }
-  bool PostMisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) override
-  {
-    return PostDraw(eid, cmd);
-  }
-  void PostRemisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) override
-  {
-    PostRedraw(eid, cmd);
-  }
-  void AliasEvent(uint32_t primary, uint32_t alias) override
-  {
-    m_AliasEvents.push_back(std::make_pair(primary, alias));
-  }
-  bool SplitSecondary() override { return false; }
-  void PreCmdExecute(uint32_t baseEid, uint32_t secondaryFirst, uint32_t secondaryLast,
-                     VkCommandBuffer cmd) override
-  {
-  }
-  void PostCmdExecute(uint32_t baseEid, uint32_t secondaryFirst, uint32_t secondaryLast,
-                      VkCommandBuffer cmd) override
-  {
-  }
-
-  void PreEndCommandBuffer(VkCommandBuffer cmd) override {}
-  WrappedVulkan *m_pDriver;
-  VulkanReplay *m_pReplay;
-  VkQueryPool m_QueryPool;
-  rdcarray<uint32_t> m_Results;
-  // events which are the 'same' from being the same command buffer resubmitted
-  // multiple times in the frame. We will only get the full callback when we're
-  // recording the command buffer, and will be given the first EID. After that
-  // we'll just be told which other EIDs alias this event.
-  rdcarray<std::pair<uint32_t, uint32_t> > m_AliasEvents;
-};
-
-rdcarray<CounterResult> VulkanReplay::FetchCountersKHR(const rdcarray<GPUCounter> &counters)
-{
-  rdcarray<uint32_t> counterIndices;
-  for(const GPUCounter &c : counters)
-    counterIndices.push_back(FromKHRCounter(c));
-
-  VkQueryPoolPerformanceCreateInfoKHR perfCreateInfo = {
-      VK_STRUCTURE_TYPE_QUERY_POOL_PERFORMANCE_CREATE_INFO_KHR, NULL, 0,
-      (uint32_t)counterIndices.size(), &counterIndices[0]};
-  uint32_t passCount = 0;
-  ObjDisp(m_pDriver->GetInstance())
-      ->GetPhysicalDeviceQueueFamilyPerformanceQueryPassesKHR(Unwrap(m_pDriver->GetPhysDev()),
-                                                              &perfCreateInfo, &passCount);
-
-  VkDevice dev = m_pDriver->GetDev();
-  VkAcquireProfilingLockInfoKHR acquireLockInfo = {
-      VK_STRUCTURE_TYPE_ACQUIRE_PROFILING_LOCK_INFO_KHR, NULL, 0, 50 * 1000 * 1000 /* 50ms */};
-  VkResult vkr = ObjDisp(dev)->AcquireProfilingLockKHR(Unwrap(dev), &acquireLockInfo);
-  if(vkr != VK_SUCCESS)
-  {
-    RDCWARN("Unable to acquire profiling lock: %s", ToStr(vkr).c_str());
-    return {};
-  }
-
-  uint32_t maxEID = m_pDriver->GetMaxEID();
-  VkQueryPoolCreateInfo queryPoolCreateInfo = {
-      VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, &perfCreateInfo, 0,
-      VK_QUERY_TYPE_PERFORMANCE_QUERY_KHR,      maxEID,          0};
-
-  VkQueryPool queryPool;
-  vkr = ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &queryPoolCreateInfo, NULL, &queryPool);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-  // Reset query pool
-  VkCommandBuffer cmd = m_pDriver->GetNextCmd();
-
-  VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
-                                        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
-
-  vkr = ObjDisp(dev)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-  ObjDisp(dev)->CmdResetQueryPool(Unwrap(cmd), queryPool, 0, maxEID);
-
-  vkr = ObjDisp(dev)->EndCommandBuffer(Unwrap(cmd));
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-  m_pDriver->SubmitCmds();
-
-  VulkanKHRCallback cb(m_pDriver, this, queryPool);
-
-  // replay the events to perform all the queries
-  for(uint32_t i = 0; i < passCount; i++)
-  {
-    VkPerformanceQuerySubmitInfoKHR perfSubmitInfo = {
-        VK_STRUCTURE_TYPE_PERFORMANCE_QUERY_SUBMIT_INFO_KHR, NULL, i};
-
-    cb.m_Results.clear();
-
-    m_pDriver->SetSubmitChain(&perfSubmitInfo);
-    m_pDriver->ReplayLog(0, maxEID, eReplay_Full);
-    m_pDriver->SetSubmitChain(NULL);
-  }
-
-  rdcarray<VkPerformanceCounterResultKHR> perfResults;
-  perfResults.resize(cb.m_Results.size() * counters.size());
-
-  vkr = ObjDisp(dev)->GetQueryPoolResults(
-      Unwrap(dev), queryPool, 0, (uint32_t)cb.m_Results.size(),
-      sizeof(VkPerformanceCounterResultKHR) * perfResults.size(), &perfResults[0],
-      sizeof(VkPerformanceCounterResultKHR) * counters.size(), VK_QUERY_RESULT_WAIT_BIT);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-  ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), queryPool, NULL);
-
-  ObjDisp(dev)->ReleaseProfilingLockKHR(Unwrap(dev));
-
-  rdcarray<CounterResult> ret;
-  for(size_t i = 0; i < cb.m_Results.size(); i++)
-  {
-    for(size_t c = 0; c < counters.size(); c++)
-    {
-      CounterResult result;
-
-      result.eventId = cb.m_Results[i];
-      result.counter = counters[c];
-
-      const VkPerformanceCounterKHR &khrCounter = m_KHRCounters[counterIndices[c]];
-
-      convertKhrCounterResult(result, perfResults[counters.size() * i + c], khrCounter.unit,
-                              khrCounter.storage);
-      ret.push_back(result);
-    }
-  }
-
-  for(size_t i = 0; i < cb.m_AliasEvents.size(); i++)
-  {
-    for(size_t c = 0; c < counters.size(); c++)
-    {
-      CounterResult search;
-      search.counter = counters[c];
-      search.eventId = cb.m_AliasEvents[i].first;
-
-      // find the result we're aliasing
-      int32_t idx = ret.indexOf(search);
-      if(idx >= 0)
-      {
-        // duplicate the result and append
-        CounterResult aliased = ret[idx];
-        aliased.eventId = cb.m_AliasEvents[i].second;
-        ret.push_back(aliased);
-      }
-      else
-      {
-        RDCERR("Expected to find alias-target result for EID %u counter %u, but didn't",
-               search.eventId, search.counter);
-      }
-    }
-  }
-
-  // sort so that the alias results appear in the right places
-  std::sort(ret.begin(), ret.end());
-
-  return ret;
-}
-
 struct VulkanGPUTimerCallback : public VulkanDrawcallCallback
 {
   VulkanGPUTimerCallback(WrappedVulkan *vk, VulkanReplay *rp, VkQueryPool tsqp, VkQueryPool occqp,
-                         VkQueryPool psqp)
+                         VkQueryPool psqp, VkQueryPool perfqp)
       : m_pDriver(vk),
         m_pReplay(rp),
         m_TimeStampQueryPool(tsqp),
         m_OcclusionQueryPool(occqp),
-        m_PipeStatsQueryPool(psqp)
+        m_PipeStatsQueryPool(psqp),
+        m_PerfQueryPool(perfqp)
   {
     m_pDriver->SetDrawcallCB(this);
   }
   ~VulkanGPUTimerCallback() { m_pDriver->SetDrawcallCB(NULL); }
   void PreDraw(uint32_t eid, VkCommandBuffer cmd) override
   {
+    if(m_PerfQueries)
+      ObjDisp(cmd)->CmdBeginQuery(Unwrap(cmd), m_PerfQueryPool, (uint32_t)m_Results.size(), 0);
+    if(!m_GenericQueries)
+      return;
     if(m_OcclusionQueryPool != VK_NULL_HANDLE)
       ObjDisp(cmd)->CmdBeginQuery(Unwrap(cmd), m_OcclusionQueryPool, (uint32_t)m_Results.size(),
                                   VK_QUERY_CONTROL_PRECISE_BIT);
@@ -735,12 +554,17 @@ struct VulkanGPUTimerCallback : public VulkanDrawcallCallback
 
   bool PostDraw(uint32_t eid, VkCommandBuffer cmd) override
   {
-    ObjDisp(cmd)->CmdWriteTimestamp(Unwrap(cmd), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                                    m_TimeStampQueryPool, (uint32_t)(m_Results.size() * 2 + 1));
-    if(m_OcclusionQueryPool != VK_NULL_HANDLE)
-      ObjDisp(cmd)->CmdEndQuery(Unwrap(cmd), m_OcclusionQueryPool, (uint32_t)m_Results.size());
-    if(m_PipeStatsQueryPool != VK_NULL_HANDLE)
-      ObjDisp(cmd)->CmdEndQuery(Unwrap(cmd), m_PipeStatsQueryPool, (uint32_t)m_Results.size());
+    if(m_GenericQueries)
+    {
+      ObjDisp(cmd)->CmdWriteTimestamp(Unwrap(cmd), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                      m_TimeStampQueryPool, (uint32_t)(m_Results.size() * 2 + 1));
+      if(m_OcclusionQueryPool != VK_NULL_HANDLE)
+        ObjDisp(cmd)->CmdEndQuery(Unwrap(cmd), m_OcclusionQueryPool, (uint32_t)m_Results.size());
+      if(m_PipeStatsQueryPool != VK_NULL_HANDLE)
+        ObjDisp(cmd)->CmdEndQuery(Unwrap(cmd), m_PipeStatsQueryPool, (uint32_t)m_Results.size());
+    }
+    if(m_PerfQueries)
+      ObjDisp(cmd)->CmdEndQuery(Unwrap(cmd), m_PerfQueryPool, (uint32_t)m_Results.size());
     m_Results.push_back(eid);
     return false;
   }
@@ -788,6 +612,11 @@ struct VulkanGPUTimerCallback : public VulkanDrawcallCallback
   VkQueryPool m_TimeStampQueryPool;
   VkQueryPool m_OcclusionQueryPool;
   VkQueryPool m_PipeStatsQueryPool;
+  VkQueryPool m_PerfQueryPool;
+  // the generic queries and the KHR performance queries are recorded on separate passes, so that
+  // the performance counters' sampling doesn't skew the timings or pipeline statistics
+  bool m_GenericQueries = true;
+  bool m_PerfQueries = false;
   rdcarray<uint32_t> m_Results;
   // events which are the 'same' from being the same command buffer resubmitted
   // multiple times in the frame. We will only get the full callback when we're
@@ -822,14 +651,60 @@ rdcarray<CounterResult> VulkanReplay::FetchCounters(const rdcarray<GPUCounter> &
   rdcarray<GPUCounter> vkKHRCounters;
   std::copy_if(counters.begin(), counters.end(), std::back_inserter(vkKHRCounters),
                [](const GPUCounter &c) { return IsVulkanExtendedCounter(c); });
+
+  VkDevice dev = m_pDriver->GetDev();
+  VkResult vkr = VK_SUCCESS;
+
+  // the KHR counters are all packed into one query pool and the driver tells us how many passes it
+  // needs to sample them. The generic queries get a pass of their own without any performance
+  // queries active, so the frame is replayed once for them plus once per KHR pass.
+  rdcarray<uint32_t> counterIndices;
+  uint32_t perfPassCount = 0;
+  VkQueryPool perfPool = VK_NULL_HANDLE;
+
   if(!vkKHRCounters.empty())
   {
-    ret.append(FetchCountersKHR(vkKHRCounters));
+    for(const GPUCounter &c : vkKHRCounters)
+      counterIndices.push_back(FromKHRCounter(c));
+
+    VkQueryPoolPerformanceCreateInfoKHR perfCreateInfo = {
+        VK_STRUCTURE_TYPE_QUERY_POOL_PERFORMANCE_CREATE_INFO_KHR, NULL, 0,
+        (uint32_t)counterIndices.size(), &counterIndices[0]};
+    ObjDisp(m_pDriver->GetInstance())
+        ->GetPhysicalDeviceQueueFamilyPerformanceQueryPassesKHR(Unwrap(m_pDriver->GetPhysDev()),
+                                                                &perfCreateInfo, &perfPassCount);
+
+    VkAcquireProfilingLockInfoKHR acquireLockInfo = {
+        VK_STRUCTURE_TYPE_ACQUIRE_PROFILING_LOCK_INFO_KHR, NULL, 0, 50 * 1000 * 1000 /* 50ms */};
+    vkr = ObjDisp(dev)->AcquireProfilingLockKHR(Unwrap(dev), &acquireLockInfo);
+    if(vkr == VK_SUCCESS)
+    {
+      VkQueryPoolCreateInfo perfPoolCreateInfo = {
+          VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, &perfCreateInfo, 0,
+          VK_QUERY_TYPE_PERFORMANCE_QUERY_KHR,      maxEID,          0};
+
+      vkr = ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &perfPoolCreateInfo, NULL, &perfPool);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    }
+    else
+    {
+      RDCWARN("Unable to acquire profiling lock: %s", ToStr(vkr).c_str());
+      m_pDriver->AddDebugMessage(
+          MessageCategory::Performance, MessageSeverity::High, MessageSource::RuntimeWarning,
+          StringFormat::Fmt("Couldn't acquire the profiling lock (%s), %zu KHR performance "
+                            "counter(s) will have no results",
+                            ToStr(vkr).c_str(), vkKHRCounters.size()));
+      vkKHRCounters.clear();
+      counterIndices.clear();
+      perfPassCount = 0;
+    }
   }
 
-  VkPhysicalDeviceFeatures availableFeatures = m_pDriver->GetDeviceEnabledFeatures();
+  // if only AMD counters were requested there's nothing left to replay
+  if(vkCounters.empty() && vkKHRCounters.empty())
+    return ret;
 
-  VkDevice dev = m_pDriver->GetDev();
+  VkPhysicalDeviceFeatures availableFeatures = m_pDriver->GetDeviceEnabledFeatures();
 
   VkQueryPoolCreateInfo timeStampPoolCreateInfo = {
       VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, NULL, 0, VK_QUERY_TYPE_TIMESTAMP, maxEID * 2, 0};
@@ -855,8 +730,7 @@ rdcarray<CounterResult> VulkanReplay::FetchCounters(const rdcarray<GPUCounter> &
       VK_QUERY_TYPE_PIPELINE_STATISTICS,        maxEID, pipeStatsFlags};
 
   VkQueryPool timeStampPool;
-  VkResult vkr =
-      ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &timeStampPoolCreateInfo, NULL, &timeStampPool);
+  vkr = ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &timeStampPoolCreateInfo, NULL, &timeStampPool);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   bool occlNeeded = false;
@@ -909,27 +783,53 @@ rdcarray<CounterResult> VulkanReplay::FetchCounters(const rdcarray<GPUCounter> &
     ObjDisp(dev)->CmdResetQueryPool(Unwrap(cmd), occlusionPool, 0, maxEID);
   if(pipeStatsPool != VK_NULL_HANDLE)
     ObjDisp(dev)->CmdResetQueryPool(Unwrap(cmd), pipeStatsPool, 0, maxEID);
+  if(perfPool != VK_NULL_HANDLE)
+    ObjDisp(dev)->CmdResetQueryPool(Unwrap(cmd), perfPool, 0, maxEID);
 
   vkr = ObjDisp(dev)->EndCommandBuffer(Unwrap(cmd));
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
 #if ENABLED(SINGLE_FLUSH_VALIDATE)
   m_pDriver->SubmitCmds();
+#else
+  // the performance query pool must be reset before the first profiling pass is submitted
+  if(perfPool != VK_NULL_HANDLE)
+    m_pDriver->SubmitCmds();
 #endif
 
-  VulkanGPUTimerCallback cb(m_pDriver, this, timeStampPool, occlusionPool, pipeStatsPool);
+  VulkanGPUTimerCallback cb(m_pDriver, this, timeStampPool, occlusionPool, pipeStatsPool, perfPool);
 
-  // replay the events to perform all the queries
-  m_pDriver->ReplayLog(0, maxEID, eReplay_Full);
+  // replay the events to perform all the queries. The first pass (if any generic counters were
+  // requested) records only the generic queries, the rest sample one KHR counter pass each.
+  const uint32_t genericPasses = vkCounters.empty() ? 0 : 1;
+  for(uint32_t i = 0; i < genericPasses + perfPassCount; i++)
+  {
+    VkPerformanceQuerySubmitInfoKHR perfSubmitInfo = {
+        VK_STRUCTURE_TYPE_PERFORMANCE_QUERY_SUBMIT_INFO_KHR, NULL, i - genericPasses};
+
+    cb.m_GenericQueries = (i < genericPasses);
+    cb.m_PerfQueries = !cb.m_GenericQueries;
+    cb.m_Results.clear();
+    cb.m_AliasEvents.clear();
+
+    if(cb.m_PerfQueries)
+      m_pDriver->SetSubmitChain(&perfSubmitInfo);
+    m_pDriver->ReplayLog(0, maxEID, eReplay_Full);
+    m_pDriver->SetSubmitChain(NULL);
+  }
 
   rdcarray<uint64_t> m_TimeStampData;
   m_TimeStampData.resize(cb.m_Results.size() * 2);
 
-  vkr = ObjDisp(dev)->GetQueryPoolResults(
-      Unwrap(dev), timeStampPool, 0, (uint32_t)m_TimeStampData.size(),
-      sizeof(uint64_t) * m_TimeStampData.size(), &m_TimeStampData[0], sizeof(uint64_t),
-      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  // the timestamps are only written on the generic pass
+  if(genericPasses > 0)
+  {
+    vkr = ObjDisp(dev)->GetQueryPoolResults(
+        Unwrap(dev), timeStampPool, 0, (uint32_t)m_TimeStampData.size(),
+        sizeof(uint64_t) * m_TimeStampData.size(), &m_TimeStampData[0], sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  }
 
   ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), timeStampPool, NULL);
 
@@ -959,6 +859,21 @@ rdcarray<CounterResult> VulkanReplay::FetchCounters(const rdcarray<GPUCounter> &
     ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), pipeStatsPool, NULL);
   }
 
+  rdcarray<VkPerformanceCounterResultKHR> perfResults;
+  perfResults.resize(cb.m_Results.size() * vkKHRCounters.size());
+  if(perfPool != VK_NULL_HANDLE)
+  {
+    vkr = ObjDisp(dev)->GetQueryPoolResults(
+        Unwrap(dev), perfPool, 0, (uint32_t)cb.m_Results.size(),
+        sizeof(VkPerformanceCounterResultKHR) * perfResults.size(), &perfResults[0],
+        sizeof(VkPerformanceCounterResultKHR) * vkKHRCounters.size(), VK_QUERY_RESULT_WAIT_BIT);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), perfPool, NULL);
+
+    ObjDisp(dev)->ReleaseProfilingLockKHR(Unwrap(dev));
+  }
+
   for(size_t i = 0; i < cb.m_Results.size(); i++)
   {
     for(size_t c = 0; c < vkCounters.size(); c++)
@@ -998,14 +913,31 @@ rdcarray<CounterResult> VulkanReplay::FetchCounters(const rdcarray<GPUCounter> &
       }
       ret.push_back(result);
     }
+
+    for(size_t c = 0; c < vkKHRCounters.size(); c++)
+    {
+      CounterResult result;
+
+      result.eventId = cb.m_Results[i];
+      result.counter = vkKHRCounters[c];
+
+      const VkPerformanceCounterKHR &khrCounter = m_KHRCounters[counterIndices[c]];
+
+      convertKhrCounterResult(result, perfResults[vkKHRCounters.size() * i + c], khrCounter.unit,
+                              khrCounter.storage);
+      ret.push_back(result);
+    }
   }
 
+  rdcarray<GPUCounter> replayedCounters = vkCounters;
+  replayedCounters.append(vkKHRCounters);
+
   for(size_t i = 0; i < cb.m_AliasEvents.size(); i++)
   {
-    for(size_t c = 0; c < vkCounters.size(); c++)
+    for(size_t c = 0; c < replayedCounters.size(); c++)
     {
       CounterResult search;
-      search.counter = vkCounters[c];
+      search.counter = replayedCounters[c];
       search.eventId = cb.m_AliasEvents[i].first;
 
       // find the result we're aliasing
@@ -1410,6 +1410,15 @@ void WrappedVulkan::Apply_InitialState(WrappedVkRes *live, const VkInitialConten
       return;
     }
 
+    // if nothing replayed since the initial contents were last applied has written to this image,
+    // it still has them. Only do this when the memory isn't written through anything else.
+    if(initialized && !m_IncompleteWriteUsage)
+    {
+      auto it = m_ImageFirstWriteEID.find(id);
+      if(it != m_ImageFirstWriteEID.end() && it->second > m_ReplayedSinceApplyEID)
+        return;
+    }
+
     // handle any 'created' initial states, without an actual image with contents
     if(initial.tag != VkInitialContents::BufferCopy)
     {
@@ -100,6 +100,8 @@
  */
 
 #include <float.h>
+#include <algorithm>
+#include <set>
 #include "driver/shaders/spirv/spirv_editor.h"
 #include "driver/shaders/spirv/spirv_op_helpers.h"
 #include "maths/formatpacking.h"
@@ -107,6 +109,23 @@
 #include "vk_replay.h"
 #include "vk_shader_cache.h"
 
+// upper bound on the occlusion queries in a single pass when fetching the history of a region. Each
+// pixel needs one query per event.
+static const uint32_t MaxPixelHistoryOcclusionQueries = 1024 * 1024;
+
+// the most occlusion queries the tests-failed pass makes for one event on one pixel, one per test.
+static const uint32_t MaxPixelHistoryTestsPerEvent = 8;
+
+// upper bound on the EventInfo results kept from a single colour and stencil pass over a region,
+// which has a slot for every event on every pixel in the pass.
+static const uint32_t MaxPixelHistoryEventInfos = 128 * 1024;
+
+// each pixel's events are gathered in event order, so can be searched directly.
+static bool SortedContains(const rdcarray<uint32_t> &events, uint32_t eid)
+{
+  return std::binary_search(events.begin(), events.end(), eid);
+}
+
 bool isDirectWrite(ResourceUsage usage)
 {
   return ((usage >= ResourceUsage::VS_RWResource && usage <= ResourceUsage::CS_RWResource) ||
@@ -475,8 +494,14 @@ struct VulkanPixelHistoryCallback : public VulkanDrawcallCallback
   // Update the given scissor to just the pixel for which pixel history was requested.
   void ScissorToPixel(const VkViewport &view, VkRect2D &scissor)
   {
-    float fx = (float)m_CallbackInfo.x;
-    float fy = (float)m_CallbackInfo.y;
+    ScissorToPixel({(int32_t)m_CallbackInfo.x, (int32_t)m_CallbackInfo.y}, view, scissor);
+  }
+
+  // Update the given scissor to just the given pixel.
+  void ScissorToPixel(VkOffset2D pixel, const VkViewport &view, VkRect2D &scissor)
+  {
+    float fx = (float)pixel.x;
+    float fy = (float)pixel.y;
     float y_start = view.y;
     float y_end = view.y + view.height;
     if(view.height < 0)
@@ -491,8 +516,7 @@ struct VulkanPixelHistoryCallback : public VulkanDrawcallCallback
     }
     else
     {
-      scissor.offset.x = m_CallbackInfo.x;
-      scissor.offset.y = m_CallbackInfo.y;
+      scissor.offset = pixel;
       scissor.extent.width = scissor.extent.height = 1;
     }
   }
@@ -1084,8 +1108,8 @@ struct VulkanOcclusionCallback : public VulkanPixelHistoryCallback
 {
   VulkanOcclusionCallback(WrappedVulkan *vk, PixelHistoryShaderCache *shaderCache,
                           const PixelHistoryCallbackInfo &callbackInfo, VkQueryPool occlusionPool,
-                          const rdcarray<EventUsage> &allEvents)
-      : VulkanPixelHistoryCallback(vk, shaderCache, callbackInfo, occlusionPool)
+                          const rdcarray<EventUsage> &allEvents, const rdcarray<VkOffset2D> &pixels)
+      : VulkanPixelHistoryCallback(vk, shaderCache, callbackInfo, occlusionPool), m_Pixels(pixels)
   {
     for(size_t i = 0; i < allEvents.size(); i++)
       m_Events.push_back(allEvents[i].eventId);
@@ -1106,15 +1130,21 @@ struct VulkanOcclusionCallback : public VulkanPixelHistoryCallback
 
     VkPipeline pipe = GetPixelOcclusionPipeline(eid, prevState.graphics.pipeline,
                                                 GetColorAttachmentIndex(prevState));
-    // set the scissor
-    for(uint32_t i = 0; i < pipestate.views.size(); i++)
-      ScissorToPixel(pipestate.views[i], pipestate.scissors[i]);
     // set stencil state (though it's unused here)
     pipestate.front.compare = pipestate.front.write = 0xff;
     pipestate.front.ref = 0;
     pipestate.back = pipestate.front;
     pipestate.graphics.pipeline = GetResID(pipe);
-    ReplayDrawWithQuery(cmd, eid);
+
+    // replay the draw once for each pixel, with the scissor set to that pixel. The queries for an
+    // event are allocated contiguously, in the same order as the pixels
+    m_OcclusionQueries.insert(std::make_pair(eid, m_NumQueries));
+    for(const VkOffset2D &pixel : m_Pixels)
+    {
+      for(uint32_t i = 0; i < pipestate.views.size(); i++)
+        ScissorToPixel(pixel, pipestate.views[i], pipestate.scissors[i]);
+      ReplayDrawWithQuery(cmd, eid);
+    }
 
     m_pDriver->GetCmdRenderState() = prevState;
     m_pDriver->GetCmdRenderState().BindPipeline(m_pDriver, cmd, VulkanRenderState::BindGraphics,
@@ -1143,10 +1173,10 @@ struct VulkanOcclusionCallback : public VulkanPixelHistoryCallback
 
   void FetchOcclusionResults()
   {
-    if(m_OcclusionQueries.size() == 0)
+    if(m_NumQueries == 0)
       return;
 
-    m_OcclusionResults.resize(m_OcclusionQueries.size());
+    m_OcclusionResults.resize(m_NumQueries);
     VkResult vkr = ObjDisp(m_pDriver->GetDev())
                        ->GetQueryPoolResults(Unwrap(m_pDriver->GetDev()), m_OcclusionPool, 0,
                                              (uint32_t)m_OcclusionResults.size(),
@@ -1156,13 +1186,13 @@ struct VulkanOcclusionCallback : public VulkanPixelHistoryCallback
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
   }
 
-  uint64_t GetOcclusionResult(uint32_t eventId)
+  uint64_t GetOcclusionResult(uint32_t eventId, uint32_t pixelIndex)
   {
     auto it = m_OcclusionQueries.find(eventId);
     if(it == m_OcclusionQueries.end())
       return 0;
-    RDCASSERT(it->second < m_OcclusionResults.size());
-    return m_OcclusionResults[it->second];
+    RDCASSERT(it->second + pixelIndex < m_OcclusionResults.size());
+    return m_OcclusionResults[it->second + pixelIndex];
   }
 
 private:
@@ -1174,13 +1204,12 @@ private:
     m_pDriver->GetCmdRenderState().BindPipeline(m_pDriver, cmd, VulkanRenderState::BindGraphics,
                                                 false);
 
-    uint32_t occlIndex = (uint32_t)m_OcclusionQueries.size();
+    uint32_t occlIndex = m_NumQueries++;
     ObjDisp(cmd)->CmdBeginQuery(Unwrap(cmd), m_OcclusionPool, occlIndex, m_QueryFlags);
 
     m_pDriver->ReplayDraw(cmd, *drawcall);
 
     ObjDisp(cmd)->CmdEndQuery(Unwrap(cmd), m_OcclusionPool, occlIndex);
-    m_OcclusionQueries.insert(std::make_pair(eventId, occlIndex));
   }
 
   VkPipeline GetPixelOcclusionPipeline(uint32_t eid, ResourceId pipeline, uint32_t outputIndex)
@@ -1213,20 +1242,36 @@ private:
 private:
   std::map<ResourceId, VkPipeline> m_PipeCache;
   rdcarray<uint32_t> m_Events;
-  // Key is event ID, and value is an index of where the occlusion result.
+  rdcarray<VkOffset2D> m_Pixels;
+  // Key is event ID, and value is the index of the occlusion result for the first pixel.
   std::map<uint32_t, uint32_t> m_OcclusionQueries;
+  uint32_t m_NumQueries = 0;
   rdcarray<uint64_t> m_OcclusionResults;
 };
 
 struct VulkanColorAndStencilCallback : public VulkanPixelHistoryCallback
 {
+  // pixelEvents holds the sorted events that could have modified each pixel in pixels. Each pixel's
+  // results are stored in its own block of eventStride EventInfos in the destination buffer.
   VulkanColorAndStencilCallback(WrappedVulkan *vk, PixelHistoryShaderCache *shaderCache,
                                 const PixelHistoryCallbackInfo &callbackInfo,
-                                const rdcarray<uint32_t> &events)
+                                const rdcarray<VkOffset2D> &pixels,
+                                const rdcarray<rdcarray<uint32_t>> &pixelEvents, size_t eventStride)
       : VulkanPixelHistoryCallback(vk, shaderCache, callbackInfo, VK_NULL_HANDLE),
-        m_Events(events),
+        m_Pixels(pixels),
+        m_PixelEvents(pixelEvents),
+        m_EventStride(eventStride),
         multipleSubpassWarningPrinted(false)
   {
+    std::set<uint32_t> events;
+    for(const rdcarray<uint32_t> &pixEvents : pixelEvents)
+      for(uint32_t eid : pixEvents)
+        events.insert(eid);
+
+    for(uint32_t eid : events)
+      m_Events.push_back(eid);
+
+    m_EventIndices.resize(pixels.size());
   }
 
   ~VulkanColorAndStencilCallback()
@@ -1240,7 +1285,7 @@ struct VulkanColorAndStencilCallback : public VulkanPixelHistoryCallback
 
   void PreDraw(uint32_t eid, VkCommandBuffer cmd)
   {
-    if(!m_Events.contains(eid) || !m_pDriver->IsCmdPrimary())
+    if(!SortedContains(m_Events, eid) || !m_pDriver->IsCmdPrimary())
       return;
 
     if(HasMultipleSubpasses())
@@ -1258,11 +1303,6 @@ struct VulkanColorAndStencilCallback : public VulkanPixelHistoryCallback
 
     pipestate.EndRenderPass(cmd);
 
-    // Get pre-modification values
-    size_t storeOffset = m_EventIndices.size() * sizeof(EventInfo);
-
-    CopyPixel(eid, cmd, storeOffset);
-
     ResourceId prevRenderpass = pipestate.renderPass;
     ResourceId prevFramebuffer = pipestate.GetFramebuffer();
     rdcarray<ResourceId> prevFBattachments = pipestate.GetFramebufferAttachments();
@@ -1278,21 +1318,13 @@ struct VulkanColorAndStencilCallback : public VulkanPixelHistoryCallback
       PipelineReplacements replacements = GetPipelineReplacements(
           eid, pipestate.graphics.pipeline, newRp, GetColorAttachmentIndex(prevState));
 
-      for(uint32_t i = 0; i < pipestate.views.size(); i++)
-        ScissorToPixel(pipestate.views[i], pipestate.scissors[i]);
-
       // TODO: should fill depth value from the original DS attachment.
 
-      // Replay the draw with a fixed color shader that never discards, and stencil
-      // increment to count number of fragments. We will get the number of fragments
-      // not accounting for shader discard.
       pipestate.SetFramebuffer(m_pDriver, GetResID(newFb));
       pipestate.renderPass = GetResID(newRp);
-      pipestate.graphics.pipeline = GetResID(replacements.fixedShaderStencil);
       pipestate.front.compare = pipestate.front.write = 0xff;
       pipestate.front.ref = 0;
       pipestate.back = pipestate.front;
-      ReplayDraw(cmd, eid, true);
 
       CopyPixelParams params = {};
       params.srcImage = m_CallbackInfo.dsImage;
@@ -1300,18 +1332,45 @@ struct VulkanColorAndStencilCallback : public VulkanPixelHistoryCallback
       params.srcImageFormat = m_CallbackInfo.dsFormat;
       params.multisampled = (m_CallbackInfo.samples != VK_SAMPLE_COUNT_1_BIT);
       params.multiview = multiview;
-      // Copy stencil value that indicates the number of fragments ignoring
-      // shader discard.
-      CopyImagePixel(cmd, params, storeOffset + offsetof(struct EventInfo, dsWithoutShaderDiscard));
 
-      // TODO: in between reset the depth value.
+      // the draw is replayed for each pixel in turn with the scissor set to that pixel. Colour
+      // writes are disabled in the replacement pipelines and each pixel's stencil is cleared
+      // before its draws, so pixels don't disturb each other.
+      for(size_t p = 0; p < m_Pixels.size(); p++)
+      {
+        if(!SortedContains(m_PixelEvents[p], eid))
+          continue;
+
+        SetCurrentPixel(p);
 
-      // Replay the draw with the original fragment shader to get the actual number
-      // of fragments, accounting for potential shader discard.
-      pipestate.graphics.pipeline = GetResID(replacements.originalShaderStencil);
-      ReplayDraw(cmd, eid, true);
+        // Get pre-modification values
+        size_t storeOffset = GetStoreOffset(p, m_EventIndices[p].size());
 
-      CopyImagePixel(cmd, params, storeOffset + offsetof(struct EventInfo, dsWithShaderDiscard));
+        CopyPixel(eid, cmd, storeOffset);
+
+        for(uint32_t i = 0; i < pipestate.views.size(); i++)
+          ScissorToPixel(pipestate.views[i], pipestate.scissors[i]);
+
+        // Replay the draw with a fixed color shader that never discards, and stencil
+        // increment to count number of fragments. We will get the number of fragments
+        // not accounting for shader discard.
+        pipestate.graphics.pipeline = GetResID(replacements.fixedShaderStencil);
+        ReplayDraw(cmd, eid, true);
+
+        // Copy stencil value that indicates the number of fragments ignoring
+        // shader discard.
+        CopyImagePixel(cmd, params,
+                       storeOffset + offsetof(struct EventInfo, dsWithoutShaderDiscard));
+
+        // TODO: in between reset the depth value.
+
+        // Replay the draw with the original fragment shader to get the actual number
+        // of fragments, accounting for potential shader discard.
+        pipestate.graphics.pipeline = GetResID(replacements.originalShaderStencil);
+        ReplayDraw(cmd, eid, true);
+
+        CopyImagePixel(cmd, params, storeOffset + offsetof(struct EventInfo, dsWithShaderDiscard));
+      }
     }
 
     // Restore the state.
@@ -1327,7 +1386,7 @@ struct VulkanColorAndStencilCallback : public VulkanPixelHistoryCallback
 
   bool PostDraw(uint32_t eid, VkCommandBuffer cmd)
   {
-    if(!m_Events.contains(eid) || !m_pDriver->IsCmdPrimary())
+    if(!SortedContains(m_Events, eid) || !m_pDriver->IsCmdPrimary())
       return false;
 
     if(HasMultipleSubpasses())
@@ -1342,15 +1401,12 @@ struct VulkanColorAndStencilCallback : public VulkanPixelHistoryCallback
 
     m_pDriver->GetCmdRenderState().EndRenderPass(cmd);
 
-    size_t storeOffset = m_EventIndices.size() * sizeof(EventInfo);
-
-    CopyPixel(eid, cmd, storeOffset + offsetof(struct EventInfo, postmod));
+    // Get post-modification values
+    CopyPostMod(eid, cmd);
 
     m_pDriver->GetCmdRenderState().BeginRenderPassAndApplyState(m_pDriver, cmd,
                                                                 VulkanRenderState::BindGraphics);
 
-    // Get post-modification values
-    m_EventIndices.insert(std::make_pair(eid, m_EventIndices.size()));
     return false;
   }
 
@@ -1362,19 +1418,7 @@ struct VulkanColorAndStencilCallback : public VulkanPixelHistoryCallback
   void PreCmdExecute(uint32_t baseEid, uint32_t secondaryFirst, uint32_t secondaryLast,
                      VkCommandBuffer cmd)
   {
-    uint32_t eventId = 0;
-    if(m_Events.size() == 0)
-      return;
-    for(size_t i = 0; i < m_Events.size(); i++)
-    {
-      // Find the first event in range
-      if(m_Events[i] >= secondaryFirst && m_Events[i] <= secondaryLast)
-      {
-        eventId = m_Events[i];
-        break;
-      }
-    }
-    if(eventId == 0)
+    if(FirstEventInRange(m_Events, secondaryFirst, secondaryLast) == 0)
       return;
 
     if(HasMultipleSubpasses())
@@ -1389,10 +1433,19 @@ struct VulkanColorAndStencilCallback : public VulkanPixelHistoryCallback
 
     m_pDriver->GetCmdRenderState().EndRenderPass(cmd);
 
-    // Copy
-    size_t storeOffset = m_EventIndices.size() * sizeof(EventInfo);
-    CopyPixel(eventId, cmd, storeOffset);
-    m_EventIndices.insert(std::make_pair(eventId, m_EventIndices.size()));
+    for(size_t p = 0; p < m_Pixels.size(); p++)
+    {
+      uint32_t eventId = FirstEventInRange(m_PixelEvents[p], secondaryFirst, secondaryLast);
+      if(eventId == 0)
+        continue;
+
+      SetCurrentPixel(p);
+
+      // Copy
+      size_t storeOffset = GetStoreOffset(p, m_EventIndices[p].size());
+      CopyPixel(eventId, cmd, storeOffset);
+      m_EventIndices[p].insert(std::make_pair(eventId, m_EventIndices[p].size()));
+    }
 
     m_pDriver->GetCmdRenderState().BeginRenderPassAndApplyState(m_pDriver, cmd,
                                                                 VulkanRenderState::BindNone);
@@ -1401,19 +1454,7 @@ struct VulkanColorAndStencilCallback : public VulkanPixelHistoryCallback
   void PostCmdExecute(uint32_t baseEid, uint32_t secondaryFirst, uint32_t secondaryLast,
                       VkCommandBuffer cmd)
   {
-    uint32_t eventId = 0;
-    if(m_Events.size() == 0)
-      return;
-    for(int32_t i = (int32_t)m_Events.size() - 1; i >= 0; i--)
-    {
-      // Find the last event in range.
-      if(m_Events[i] >= secondaryFirst && m_Events[i] <= secondaryLast)
-      {
-        eventId = m_Events[i];
-        break;
-      }
-    }
-    if(eventId == 0)
+    if(LastEventInRange(m_Events, secondaryFirst, secondaryLast) == 0)
       return;
 
     if(HasMultipleSubpasses())
@@ -1427,42 +1468,56 @@ struct VulkanColorAndStencilCallback : public VulkanPixelHistoryCallback
     }
 
     m_pDriver->GetCmdRenderState().EndRenderPass(cmd);
-    size_t storeOffset = 0;
-    auto it = m_EventIndices.find(eventId);
-    if(it != m_EventIndices.end())
-    {
-      storeOffset = it->second * sizeof(EventInfo);
-    }
-    else
+
+    for(size_t p = 0; p < m_Pixels.size(); p++)
     {
-      storeOffset = m_EventIndices.size() * sizeof(EventInfo);
-      m_EventIndices.insert(std::make_pair(eventId, m_EventIndices.size()));
+      uint32_t eventId = LastEventInRange(m_PixelEvents[p], secondaryFirst, secondaryLast);
+      if(eventId == 0)
+        continue;
+
+      SetCurrentPixel(p);
+
+      size_t storeOffset = 0;
+      auto it = m_EventIndices[p].find(eventId);
+      if(it != m_EventIndices[p].end())
+      {
+        storeOffset = GetStoreOffset(p, it->second);
+      }
+      else
+      {
+        storeOffset = GetStoreOffset(p, m_EventIndices[p].size());
+        m_EventIndices[p].insert(std::make_pair(eventId, m_EventIndices[p].size()));
+      }
+      CopyPixel(eventId, cmd, storeOffset + offsetof(struct EventInfo, postmod));
     }
-    CopyPixel(eventId, cmd, storeOffset + offsetof(struct EventInfo, postmod));
+
     m_pDriver->GetCmdRenderState().BeginRenderPassAndApplyState(m_pDriver, cmd,
                                                                 VulkanRenderState::BindNone);
   }
 
   void PreDispatch(uint32_t eid, VkCommandBuffer cmd)
   {
-    if(!m_Events.contains(eid))
+    if(!SortedContains(m_Events, eid))
       return;
-    size_t storeOffset = m_EventIndices.size() * sizeof(EventInfo);
-    CopyPixel(eid, cmd, storeOffset);
+    for(size_t p = 0; p < m_Pixels.size(); p++)
+    {
+      if(!SortedContains(m_PixelEvents[p], eid))
+        continue;
+      SetCurrentPixel(p);
+      CopyPixel(eid, cmd, GetStoreOffset(p, m_EventIndices[p].size()));
+    }
   }
   bool PostDispatch(uint32_t eid, VkCommandBuffer cmd)
   {
-    if(!m_Events.contains(eid))
+    if(!SortedContains(m_Events, eid))
       return false;
-    size_t storeOffset = m_EventIndices.size() * sizeof(EventInfo);
-    CopyPixel(eid, cmd, storeOffset + offsetof(struct EventInfo, postmod));
-    m_EventIndices.insert(std::make_pair(eid, m_EventIndices.size()));
+    CopyPostMod(eid, cmd);
     return false;
   }
   void PostRedispatch(uint32_t eid, VkCommandBuffer cmd) {}
   void PreMisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd)
   {
-    if(!m_Events.contains(eid))
+    if(!SortedContains(m_Events, eid))
       return;
     if(HasMultipleSubpasses())
     {
@@ -1477,7 +1532,7 @@ struct VulkanColorAndStencilCallback : public VulkanPixelHistoryCallback
   }
   bool PostMisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd)
   {
-    if(!m_Events.contains(eid))
+    if(!SortedContains(m_Events, eid))
       return false;
     if(HasMultipleSubpasses())
     {
@@ -1511,15 +1566,15 @@ struct VulkanColorAndStencilCallback : public VulkanPixelHistoryCallback
         primary, alias);
   }
 
-  int32_t GetEventIndex(uint32_t eventId)
+  // Returns the index of the EventInfo in the destination buffer for this pixel's event.
+  int32_t GetEventIndex(uint32_t pixelIndex, uint32_t eventId)
   {
-    auto it = m_EventIndices.find(eventId);
-    if(it == m_EventIndices.end())
+    auto it = m_EventIndices[pixelIndex].find(eventId);
+    if(it == m_EventIndices[pixelIndex].end())
       // Most likely a secondary command buffer event for which there is no
       // information.
       return -1;
-    RDCASSERT(it != m_EventIndices.end());
-    return (int32_t)it->second;
+    return int32_t(pixelIndex * m_EventStride + it->second);
   }
 
   VkFormat GetDepthFormat(uint32_t eventId)
@@ -1533,6 +1588,55 @@ struct VulkanColorAndStencilCallback : public VulkanPixelHistoryCallback
   }
 
 private:
+  void SetCurrentPixel(size_t pixelIndex)
+  {
+    m_CallbackInfo.x = m_Pixels[pixelIndex].x;
+    m_CallbackInfo.y = m_Pixels[pixelIndex].y;
+  }
+
+  size_t GetStoreOffset(size_t pixelIndex, size_t eventIndex) const
+  {
+    RDCASSERT(eventIndex < m_EventStride);
+    return (pixelIndex * m_EventStride + eventIndex) * sizeof(EventInfo);
+  }
+
+  static uint32_t FirstEventInRange(const rdcarray<uint32_t> &events, uint32_t first, uint32_t last)
+  {
+    for(size_t i = 0; i < events.size(); i++)
+    {
+      if(events[i] >= first && events[i] <= last)
+        return events[i];
+    }
+    return 0;
+  }
+
+  static uint32_t LastEventInRange(const rdcarray<uint32_t> &events, uint32_t first, uint32_t last)
+  {
+    for(int32_t i = (int32_t)events.size() - 1; i >= 0; i--)
+    {
+      if(events[i] >= first && events[i] <= last)
+        return events[i];
+    }
+    return 0;
+  }
+
+  // copies the post-modification values of every pixel this event could have modified, and
+  // records where they are stored.
+  void CopyPostMod(uint32_t eid, VkCommandBuffer cmd)
+  {
+    for(size_t p = 0; p < m_Pixels.size(); p++)
+    {
+      if(!SortedContains(m_PixelEvents[p], eid))
+        continue;
+
+      SetCurrentPixel(p);
+
+      size_t storeOffset = GetStoreOffset(p, m_EventIndices[p].size());
+      CopyPixel(eid, cmd, storeOffset + offsetof(struct EventInfo, postmod));
+      m_EventIndices[p].insert(std::make_pair(eid, m_EventIndices[p].size()));
+    }
+  }
+
   void CopyPixel(uint32_t eid, VkCommandBuffer cmd, size_t offset)
   {
     CopyPixelParams targetCopyParams = {};
@@ -1649,9 +1753,14 @@ private:
   }
 
   std::map<ResourceId, PipelineReplacements> m_PipeCache;
+  rdcarray<VkOffset2D> m_Pixels;
+  rdcarray<rdcarray<uint32_t>> m_PixelEvents;
+  size_t m_EventStride;
+  // every event for any pixel, sorted
   rdcarray<uint32_t> m_Events;
-  // Key is event ID, and value is an index of where the event data is stored.
-  std::map<uint32_t, size_t> m_EventIndices;
+  // Per pixel, key is event ID, and value is an index of where the event data is stored in that
+  // pixel's block.
+  rdcarray<std::map<uint32_t, size_t>> m_EventIndices;
   bool multipleSubpassWarningPrinted;
   std::map<uint32_t, VkFormat> m_DepthFormats;
 };
@@ -1660,34 +1769,58 @@ private:
 // stencil test etc).
 struct TestsFailedCallback : public VulkanPixelHistoryCallback
 {
+  // pixelEvents holds the sorted draw events to test for each pixel in pixels.
   TestsFailedCallback(WrappedVulkan *vk, PixelHistoryShaderCache *shaderCache,
                       const PixelHistoryCallbackInfo &callbackInfo, VkQueryPool occlusionPool,
-                      rdcarray<uint32_t> events)
-      : VulkanPixelHistoryCallback(vk, shaderCache, callbackInfo, occlusionPool), m_Events(events)
+                      const rdcarray<VkOffset2D> &pixels,
+                      const rdcarray<rdcarray<uint32_t>> &pixelEvents)
+      : VulkanPixelHistoryCallback(vk, shaderCache, callbackInfo, occlusionPool),
+        m_Pixels(pixels),
+        m_PixelEvents(pixelEvents)
   {
+    for(const rdcarray<uint32_t> &events : pixelEvents)
+      for(uint32_t eid : events)
+        m_Events.insert(eid);
+
+    m_EventFlags.resize(pixels.size());
+    m_OcclusionQueries.resize(pixels.size());
   }
 
   ~TestsFailedCallback() {}
   void PreDraw(uint32_t eid, VkCommandBuffer cmd)
   {
-    if(!m_Events.contains(eid))
+    if(m_Events.find(eid) == m_Events.end())
       return;
 
-    VulkanRenderState &pipestate = m_pDriver->GetCmdRenderState();
+    VulkanRenderState prevState = m_pDriver->GetCmdRenderState();
     const VulkanCreationInfo::Pipeline &p =
-        m_pDriver->GetDebugManager()->GetPipelineInfo(pipestate.graphics.pipeline);
-    uint32_t eventFlags = CalculateEventFlags(p, pipestate);
-    m_EventFlags[eid] = eventFlags;
+        m_pDriver->GetDebugManager()->GetPipelineInfo(prevState.graphics.pipeline);
 
     // TODO: figure out if the shader has early fragments tests turned on,
     // based on the currently bound fragment shader.
     bool earlyFragmentTests = false;
     m_HasEarlyFragments[eid] = earlyFragmentTests;
 
-    ResourceId curPipeline = pipestate.graphics.pipeline;
-    VulkanRenderState prevState = m_pDriver->GetCmdRenderState();
+    ResourceId curPipeline = prevState.graphics.pipeline;
+    uint32_t outputIndex = GetColorAttachmentIndex(prevState);
 
-    ReplayDrawWithTests(cmd, eid, eventFlags, curPipeline, GetColorAttachmentIndex(prevState));
+    // the tests are replayed for each pixel in turn, with the scissor set to that pixel
+    for(size_t i = 0; i < m_Pixels.size(); i++)
+    {
+      if(!SortedContains(m_PixelEvents[i], eid))
+        continue;
+
+      m_CallbackInfo.x = m_Pixels[i].x;
+      m_CallbackInfo.y = m_Pixels[i].y;
+      m_CurrentPixel = i;
+
+      m_pDriver->GetCmdRenderState() = prevState;
+
+      uint32_t eventFlags = CalculateEventFlags(p, prevState);
+      m_EventFlags[i][eid] = eventFlags;
+
+      ReplayDrawWithTests(cmd, eid, eventFlags, curPipeline, outputIndex);
+    }
 
     m_pDriver->GetCmdRenderState() = prevState;
     m_pDriver->GetCmdRenderState().BindPipeline(m_pDriver, cmd, VulkanRenderState::BindGraphics,
@@ -1721,20 +1854,26 @@ struct TestsFailedCallback : public VulkanPixelHistoryCallback
   {
   }
   void PreEndCommandBuffer(VkCommandBuffer cmd) {}
-  bool HasEventFlags(uint32_t eventId) { return m_EventFlags.find(eventId) != m_EventFlags.end(); }
-  uint32_t GetEventFlags(uint32_t eventId)
+  bool HasEventFlags(uint32_t pixelIndex, uint32_t eventId) const
   {
-    auto it = m_EventFlags.find(eventId);
-    if(it == m_EventFlags.end())
+    return m_EventFlags[pixelIndex].find(eventId) != m_EventFlags[pixelIndex].end();
+  }
+  uint32_t GetEventFlags(uint32_t pixelIndex, uint32_t eventId) const
+  {
+    auto it = m_EventFlags[pixelIndex].find(eventId);
+    if(it == m_EventFlags[pixelIndex].end())
+    {
       RDCERR("Can't find event flags for event %u", eventId);
+      return 0;
+    }
     return it->second;
   }
 
   void FetchOcclusionResults()
   {
-    if(m_OcclusionQueries.empty())
+    if(m_NumQueries == 0)
       return;
-    m_OcclusionResults.resize(m_OcclusionQueries.size());
+    m_OcclusionResults.resize(m_NumQueries);
     VkResult vkr =
         ObjDisp(m_pDriver->GetDev())
             ->GetQueryPoolResults(Unwrap(m_pDriver->GetDev()), m_OcclusionPool, 0,
@@ -1744,14 +1883,20 @@ struct TestsFailedCallback : public VulkanPixelHistoryCallback
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
   }
 
-  uint64_t GetOcclusionResult(uint32_t eventId, uint32_t test) const
+  uint64_t GetOcclusionResult(uint32_t pixelIndex, uint32_t eventId, uint32_t test) const
   {
-    auto it = m_OcclusionQueries.find(rdcpair<uint32_t, uint32_t>(eventId, test));
-    if(it == m_OcclusionQueries.end())
+    auto it = m_OcclusionQueries[pixelIndex].find(rdcpair<uint32_t, uint32_t>(eventId, test));
+    if(it == m_OcclusionQueries[pixelIndex].end())
+    {
       RDCERR("Can't locate occlusion query for event id %u and test flags %u", eventId, test);
+      return 0;
+    }
     if(it->second >= m_OcclusionResults.size())
+    {
       RDCERR("Event %u, occlusion index is %u, and the total # of occlusion query data %zu",
              eventId, it->second, m_OcclusionResults.size());
+      return 0;
+    }
     return m_OcclusionResults[it->second];
   }
 
@@ -2121,10 +2266,11 @@ private:
     m_pDriver->GetCmdRenderState().BindPipeline(m_pDriver, cmd, VulkanRenderState::BindGraphics,
                                                 false);
 
-    uint32_t index = (uint32_t)m_OcclusionQueries.size();
-    if(m_OcclusionQueries.find(rdcpair<uint32_t, uint32_t>(eventId, test)) != m_OcclusionQueries.end())
+    std::map<rdcpair<uint32_t, uint32_t>, uint32_t> &queries = m_OcclusionQueries[m_CurrentPixel];
+    uint32_t index = m_NumQueries++;
+    if(queries.find(rdcpair<uint32_t, uint32_t>(eventId, test)) != queries.end())
       RDCERR("A query already exist for event id %u and test %u", eventId, test);
-    m_OcclusionQueries.insert(std::make_pair(rdcpair<uint32_t, uint32_t>(eventId, test), index));
+    queries.insert(std::make_pair(rdcpair<uint32_t, uint32_t>(eventId, test), index));
 
     ObjDisp(cmd)->CmdBeginQuery(Unwrap(cmd), m_OcclusionPool, index, m_QueryFlags);
 
@@ -2134,14 +2280,20 @@ private:
     ObjDisp(cmd)->CmdEndQuery(Unwrap(cmd), m_OcclusionPool, index);
   }
 
-  rdcarray<uint32_t> m_Events;
-  // Key is event ID, value is the flags for that event.
-  std::map<uint32_t, uint32_t> m_EventFlags;
+  rdcarray<VkOffset2D> m_Pixels;
+  rdcarray<rdcarray<uint32_t>> m_PixelEvents;
+  // every event tested for any pixel
+  std::set<uint32_t> m_Events;
+  // the pixel whose tests are currently being replayed
+  size_t m_CurrentPixel = 0;
+  // Per pixel, key is event ID, value is the flags for that event.
+  rdcarray<std::map<uint32_t, uint32_t>> m_EventFlags;
   // Key is a pair <Base pipeline, pipeline flags>
   std::map<rdcpair<ResourceId, uint32_t>, VkPipeline> m_PipeCache;
-  // Key: pair <event ID, test>
+  // Per pixel, key: pair <event ID, test>
   // value: the index where occlusion query is in m_OcclusionResults
-  std::map<rdcpair<uint32_t, uint32_t>, uint32_t> m_OcclusionQueries;
+  rdcarray<std::map<rdcpair<uint32_t, uint32_t>, uint32_t>> m_OcclusionQueries;
+  uint32_t m_NumQueries = 0;
   std::map<uint32_t, bool> m_HasEarlyFragments;
   rdcarray<uint64_t> m_OcclusionResults;
 };
@@ -3088,14 +3240,14 @@ VkImageLayout VulkanDebugManager::GetImageLayout(ResourceId image, VkImageAspect
   return ret;
 }
 
-void UpdateTestsFailed(const TestsFailedCallback *tfCb, uint32_t eventId, uint32_t eventFlags,
-                       PixelModification &mod)
+void UpdateTestsFailed(const TestsFailedCallback *tfCb, uint32_t pixelIndex, uint32_t eventId,
+                       uint32_t eventFlags, PixelModification &mod)
 {
   bool earlyFragmentTests = tfCb->HasEarlyFragments(eventId);
 
   if((eventFlags & (TestEnabled_Culling | TestMustFail_Culling)) == TestEnabled_Culling)
   {
-    uint64_t occlData = tfCb->GetOcclusionResult(eventId, TestEnabled_Culling);
+    uint64_t occlData = tfCb->GetOcclusionResult(pixelIndex, eventId, TestEnabled_Culling);
     mod.backfaceCulled = (occlData == 0);
   }
 
@@ -3104,7 +3256,7 @@ void UpdateTestsFailed(const TestsFailedCallback *tfCb, uint32_t eventId, uint32
 
   if(eventFlags & TestEnabled_DepthClipping)
   {
-    uint64_t occlData = tfCb->GetOcclusionResult(eventId, TestEnabled_DepthClipping);
+    uint64_t occlData = tfCb->GetOcclusionResult(pixelIndex, eventId, TestEnabled_DepthClipping);
     mod.depthClipped = (occlData == 0);
   }
 
@@ -3114,7 +3266,7 @@ void UpdateTestsFailed(const TestsFailedCallback *tfCb, uint32_t eventId, uint32
   if((eventFlags & (TestEnabled_Scissor | TestMustPass_Scissor | TestMustFail_Scissor)) ==
      TestEnabled_Scissor)
   {
-    uint64_t occlData = tfCb->GetOcclusionResult(eventId, TestEnabled_Scissor);
+    uint64_t occlData = tfCb->GetOcclusionResult(pixelIndex, eventId, TestEnabled_Scissor);
     mod.scissorClipped = (occlData == 0);
   }
   if(mod.scissorClipped)
@@ -3124,7 +3276,7 @@ void UpdateTestsFailed(const TestsFailedCallback *tfCb, uint32_t eventId, uint32
 
   if((eventFlags & (TestEnabled_SampleMask | TestMustFail_SampleMask)) == TestEnabled_SampleMask)
   {
-    uint64_t occlData = tfCb->GetOcclusionResult(eventId, TestEnabled_SampleMask);
+    uint64_t occlData = tfCb->GetOcclusionResult(pixelIndex, eventId, TestEnabled_SampleMask);
     mod.sampleMasked = (occlData == 0);
   }
   if(mod.sampleMasked)
@@ -3133,7 +3285,7 @@ void UpdateTestsFailed(const TestsFailedCallback *tfCb, uint32_t eventId, uint32
   // Shader discard with default fragment tests order.
   if(!earlyFragmentTests)
   {
-    uint64_t occlData = tfCb->GetOcclusionResult(eventId, TestEnabled_FragmentDiscard);
+    uint64_t occlData = tfCb->GetOcclusionResult(pixelIndex, eventId, TestEnabled_FragmentDiscard);
     mod.shaderDiscarded = (occlData == 0);
     if(mod.shaderDiscarded)
       return;
@@ -3141,7 +3293,7 @@ void UpdateTestsFailed(const TestsFailedCallback *tfCb, uint32_t eventId, uint32
 
   if(eventFlags & TestEnabled_DepthBounds)
   {
-    uint64_t occlData = tfCb->GetOcclusionResult(eventId, TestEnabled_DepthBounds);
+    uint64_t occlData = tfCb->GetOcclusionResult(pixelIndex, eventId, TestEnabled_DepthBounds);
     mod.depthBoundsFailed = (occlData == 0);
   }
   if(mod.depthBoundsFailed)
@@ -3150,7 +3302,7 @@ void UpdateTestsFailed(const TestsFailedCallback *tfCb, uint32_t eventId, uint32
   if((eventFlags & (TestEnabled_StencilTesting | TestMustFail_StencilTesting)) ==
      TestEnabled_StencilTesting)
   {
-    uint64_t occlData = tfCb->GetOcclusionResult(eventId, TestEnabled_StencilTesting);
+    uint64_t occlData = tfCb->GetOcclusionResult(pixelIndex, eventId, TestEnabled_StencilTesting);
     mod.stencilTestFailed = (occlData == 0);
   }
   if(mod.stencilTestFailed)
@@ -3158,7 +3310,7 @@ void UpdateTestsFailed(const TestsFailedCallback *tfCb, uint32_t eventId, uint32
 
   if((eventFlags & (TestEnabled_DepthTesting | TestMustFail_DepthTesting)) == TestEnabled_DepthTesting)
   {
-    uint64_t occlData = tfCb->GetOcclusionResult(eventId, TestEnabled_DepthTesting);
+    uint64_t occlData = tfCb->GetOcclusionResult(pixelIndex, eventId, TestEnabled_DepthTesting);
     mod.depthTestFailed = (occlData == 0);
   }
   if(mod.depthTestFailed)
@@ -3167,7 +3319,7 @@ void UpdateTestsFailed(const TestsFailedCallback *tfCb, uint32_t eventId, uint32
   // Shader discard with early fragment tests order.
   if(earlyFragmentTests)
   {
-    uint64_t occlData = tfCb->GetOcclusionResult(eventId, TestEnabled_FragmentDiscard);
+    uint64_t occlData = tfCb->GetOcclusionResult(pixelIndex, eventId, TestEnabled_FragmentDiscard);
     mod.shaderDiscarded = (occlData == 0);
   }
 }
@@ -3184,148 +3336,25 @@ float GetDepthValue(VkFormat depthFormat, const PixelHistoryValue &value)
   return v4.x;
 }
 
-rdcarray<PixelModification> VulkanReplay::PixelHistory(rdcarray<EventUsage> events,
-                                                       ResourceId target, uint32_t x, uint32_t y,
-                                                       const Subresource &sub, CompType typeCast)
+// the events that wrote fragments to one pixel, found from the colour and stencil pass. These drive
+// that pixel's per-fragment passes.
+struct PixelFragmentEvents
 {
-  rdcarray<PixelModification> history;
-
-  if(events.empty())
-    return history;
-
-  const VulkanCreationInfo::Image &imginfo = GetDebugManager()->GetImageInfo(target);
-  if(imginfo.format == VK_FORMAT_UNDEFINED)
-    return history;
-
-  rdcstr regionName = StringFormat::Fmt(
-      "PixelHistory: pixel: (%u, %u) on %s subresource (%u, %u, %u) cast to %s with %zu events", x, y,
-      ToStr(target).c_str(), sub.mip, sub.slice, sub.sample, ToStr(typeCast).c_str(), events.size());
-
-  RDCDEBUG("%s", regionName.c_str());
-
-  VkMarkerRegion region(regionName);
-
-  uint32_t sampleIdx = sub.sample;
-
-  // TODO: use the given type hint for typeless textures
-  SCOPED_TIMER("VkDebugManager::PixelHistory");
-
-  if(sampleIdx > (uint32_t)imginfo.samples)
-    sampleIdx = 0;
-
-  uint32_t sampleMask = ~0U;
-  if(sampleIdx < 32)
-    sampleMask = 1U << sampleIdx;
-
-  bool multisampled = (imginfo.samples > 1);
-
-  if(sampleIdx == ~0U || !multisampled)
-    sampleIdx = 0;
-
-  VkDevice dev = m_pDriver->GetDev();
-  VkQueryPool occlusionPool;
-  CreateOcclusionPool(m_pDriver, (uint32_t)events.size(), &occlusionPool);
-
-  PixelHistoryResources resources = {};
-  // TODO: perhaps should do this after making an occlusion query, since we will
-  // get a smaller subset of events that passed the occlusion query.
-  VkImage targetImage = GetResourceManager()->GetCurrentHandle<VkImage>(target);
-  GetDebugManager()->PixelHistorySetupResources(resources, targetImage, imginfo.extent,
-                                                imginfo.format, imginfo.samples, sub,
-                                                (uint32_t)events.size());
-
-  PixelHistoryShaderCache *shaderCache = new PixelHistoryShaderCache(m_pDriver);
-
-  PixelHistoryCallbackInfo callbackInfo = {};
-  callbackInfo.targetImage = targetImage;
-  callbackInfo.targetImageFormat = imginfo.format;
-  callbackInfo.layers = imginfo.arrayLayers;
-  callbackInfo.mipLevels = imginfo.mipLevels;
-  callbackInfo.samples = imginfo.samples;
-  callbackInfo.extent = imginfo.extent;
-  callbackInfo.targetSubresource = sub;
-  callbackInfo.x = x;
-  callbackInfo.y = y;
-  callbackInfo.sampleMask = sampleMask;
-  callbackInfo.subImage = resources.colorImage;
-  callbackInfo.subImageView = resources.colorImageView;
-  callbackInfo.dsImage = resources.dsImage;
-  callbackInfo.dsFormat = resources.dsFormat;
-  callbackInfo.dsImageView = resources.dsImageView;
-  callbackInfo.dstBuffer = resources.dstBuffer;
-
-  VulkanOcclusionCallback occlCb(m_pDriver, shaderCache, callbackInfo, occlusionPool, events);
-  {
-    VkMarkerRegion occlRegion("VulkanOcclusionCallback");
-    m_pDriver->ReplayLog(0, events.back().eventId, eReplay_Full);
-    m_pDriver->SubmitCmds();
-    m_pDriver->FlushQ();
-    occlCb.FetchOcclusionResults();
-  }
-
-  // Gather all draw events that could have written to pixel for another replay pass,
-  // to determine if these draws failed for some reason (for ex., depth test).
-  rdcarray<uint32_t> modEvents;
-  rdcarray<uint32_t> drawEvents;
-  for(size_t ev = 0; ev < events.size(); ev++)
-  {
-    bool clear = (events[ev].usage == ResourceUsage::Clear);
-    bool directWrite = isDirectWrite(events[ev].usage);
-
-    if(events[ev].view != ResourceId())
-    {
-      // TODO: Check that the slice and mip matches.
-      VulkanCreationInfo::ImageView viewInfo =
-          m_pDriver->GetDebugManager()->GetImageViewInfo(events[ev].view);
-      uint32_t layerEnd = viewInfo.range.baseArrayLayer + viewInfo.range.layerCount;
-      if(sub.slice < viewInfo.range.baseArrayLayer || sub.slice >= layerEnd)
-      {
-        RDCDEBUG("Usage %d at %u didn't refer to the matching mip/slice (%u/%u)", events[ev].usage,
-                 events[ev].eventId, sub.mip, sub.slice);
-        continue;
-      }
-    }
-
-    if(directWrite || clear)
-    {
-      modEvents.push_back(events[ev].eventId);
-    }
-    else
-    {
-      uint64_t occlData = occlCb.GetOcclusionResult((uint32_t)events[ev].eventId);
-      VkMarkerRegion::Set(StringFormat::Fmt("%u has occl %llu", events[ev].eventId, occlData));
-      if(occlData > 0)
-      {
-        drawEvents.push_back(events[ev].eventId);
-        modEvents.push_back(events[ev].eventId);
-      }
-    }
-  }
-
-  VulkanColorAndStencilCallback cb(m_pDriver, shaderCache, callbackInfo, modEvents);
-  {
-    VkMarkerRegion colorStencilRegion("VulkanColorAndStencilCallback");
-    m_pDriver->ReplayLog(0, events.back().eventId, eReplay_Full);
-    m_pDriver->SubmitCmds();
-    m_pDriver->FlushQ();
-  }
+  std::map<uint32_t, uint32_t> eventsWithFrags;
+  std::map<uint32_t, ModificationValue> eventPremods;
+};
 
-  // If there are any draw events, do another replay pass, in order to figure out
-  // which tests failed for each draw event.
-  TestsFailedCallback *tfCb = NULL;
-  if(drawEvents.size() > 0)
-  {
-    VkMarkerRegion testsRegion("TestsFailedCallback");
-    VkQueryPool tfOcclusionPool;
-    CreateOcclusionPool(m_pDriver, (uint32_t)drawEvents.size() * 6, &tfOcclusionPool);
+// Builds one pixel's modifications from the results of the batched colour and stencil and
+// tests-failed passes. eventsInfo is the mapped destination buffer.
+static rdcarray<PixelModification> GetPixelModifications(
+    const rdcarray<EventUsage> &events, const PixelHistoryCallbackInfo &callbackInfo,
+    VulkanColorAndStencilCallback &cb, const TestsFailedCallback *tfCb, uint32_t pixelIndex,
+    const rdcarray<uint32_t> &drawEvents, const EventInfo *eventsInfo,
+    PixelFragmentEvents &fragEvents)
+{
+  rdcarray<PixelModification> history;
 
-    tfCb = new TestsFailedCallback(m_pDriver, shaderCache, callbackInfo, tfOcclusionPool, drawEvents);
-    m_pDriver->ReplayLog(0, events.back().eventId, eReplay_Full);
-    m_pDriver->SubmitCmds();
-    m_pDriver->FlushQ();
-    tfCb->FetchOcclusionResults();
-    ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), tfOcclusionPool, NULL);
-  }
+  bool multisampled = (callbackInfo.samples > 1);
 
   for(size_t ev = 0; ev < events.size(); ev++)
   {
@@ -3333,7 +3362,7 @@ rdcarray<PixelModification> VulkanReplay::PixelHistory(rdcarray<EventUsage> even
     bool clear = (events[ev].usage == ResourceUsage::Clear);
     bool directWrite = isDirectWrite(events[ev].usage);
 
-    if(drawEvents.contains(events[ev].eventId) || clear || directWrite)
+    if(SortedContains(drawEvents, eventId) || clear || directWrite)
     {
       PixelModification mod;
       RDCEraseEl(mod);
@@ -3345,7 +3374,7 @@ rdcarray<PixelModification> VulkanReplay::PixelHistory(rdcarray<EventUsage> even
       if(!clear && !directWrite)
       {
         RDCASSERT(tfCb != NULL);
-        uint32_t flags = tfCb->GetEventFlags(eventId);
+        uint32_t flags = tfCb->GetEventFlags(pixelIndex, eventId);
         VkMarkerRegion::Set(StringFormat::Fmt("%u has flags %x", eventId, flags));
         if(flags & TestMustFail_Culling)
           mod.backfaceCulled = true;
@@ -3358,28 +3387,19 @@ rdcarray<PixelModification> VulkanReplay::PixelHistory(rdcarray<EventUsage> even
         if(flags & UnboundFragmentShader)
           mod.unboundPS = true;
 
-        UpdateTestsFailed(tfCb, eventId, flags, mod);
+        UpdateTestsFailed(tfCb, pixelIndex, eventId, flags, mod);
       }
       history.push_back(mod);
     }
   }
 
-  // Try to read memory back
-
-  EventInfo *eventsInfo;
-  VkResult vkr =
-      m_pDriver->vkMapMemory(dev, resources.bufferMemory, 0, VK_WHOLE_SIZE, 0, (void **)&eventsInfo);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-  std::map<uint32_t, uint32_t> eventsWithFrags;
-  std::map<uint32_t, ModificationValue> eventPremods;
-  ResourceFormat fmt = MakeResourceFormat(imginfo.format);
+  ResourceFormat fmt = MakeResourceFormat(callbackInfo.targetImageFormat);
 
   for(size_t h = 0; h < history.size();)
   {
     PixelModification &mod = history[h];
 
-    int32_t eventIndex = cb.GetEventIndex(mod.eventId);
+    int32_t eventIndex = cb.GetEventIndex(pixelIndex, mod.eventId);
     if(eventIndex == -1)
     {
       // There is no information, skip the event.
@@ -3419,8 +3439,8 @@ rdcarray<PixelModification> VulkanReplay::PixelHistory(rdcarray<EventUsage> even
     // so nothing else needs to be checked in the callback itself.
     if(frags > 0)
     {
-      eventsWithFrags[mod.eventId] = frags;
-      eventPremods[mod.eventId] = mod.preMod;
+      fragEvents.eventsWithFrags[mod.eventId] = frags;
+      fragEvents.eventPremods[mod.eventId] = mod.preMod;
     }
 
     for(int32_t f = 1; f < frags; f++)
@@ -3435,165 +3455,429 @@ rdcarray<PixelModification> VulkanReplay::PixelHistory(rdcarray<EventUsage> even
         "%u",
         mod.eventId, ei.dsWithoutShaderDiscard[4], ei.dsWithShaderDiscard[4]);
   }
-  m_pDriver->vkUnmapMemory(dev, resources.bufferMemory);
 
-  if(eventsWithFrags.size() > 0)
+  return history;
+}
+
+// Replays the per-fragment and discarded fragments passes for one pixel, filling in the shader
+// output and the values after each fragment. These passes stay per pixel: they write the real
+// target and clear the shared depth-stencil image for every fragment, so replaying them for several
+// pixels at once would disturb the neighbouring pixels' results.
+static void FillPixelFragments(WrappedVulkan *vk, const PixelHistoryCallbackInfo &callbackInfo,
+                               const PixelHistoryResources &resources,
+                               PixelHistoryShaderCache *shaderCache,
+                               VulkanColorAndStencilCallback &cb, const TestsFailedCallback *tfCb,
+                               uint32_t pixelIndex, const PixelFragmentEvents &fragEvents,
+                               rdcarray<PixelModification> &history)
+{
+  VkDevice dev = vk->GetDev();
+
+  ResourceFormat fmt = MakeResourceFormat(callbackInfo.targetImageFormat);
+
+  // Replay to get shader output value, post modification value and primitive ID for every
+  // fragment.
+  VulkanPixelHistoryPerFragmentCallback perFragmentCB(
+      vk, shaderCache, callbackInfo, fragEvents.eventsWithFrags, fragEvents.eventPremods);
+  {
+    VkMarkerRegion perFragmentRegion("VulkanPixelHistoryPerFragmentCallback");
+    vk->ReplayLog(0, fragEvents.eventsWithFrags.rbegin()->first, eReplay_Full);
+    vk->SubmitCmds();
+    vk->FlushQ();
+  }
+
+  PerFragmentInfo *bp = NULL;
+  VkResult vkr = vk->vkMapMemory(dev, resources.bufferMemory, 0, VK_WHOLE_SIZE, 0, (void **)&bp);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  // Retrieve primitive ID values where fragment shader discarded some
+  // fragments. For these primitives we are going to perform an occlusion
+  // query to see if a primitive was discarded.
+  std::map<uint32_t, rdcarray<int32_t> > discardedPrimsEvents;
+  uint32_t primitivesToCheck = 0;
+  for(size_t h = 0; h < history.size(); h++)
   {
-    // Replay to get shader output value, post modification value and primitive ID for every
-    // fragment.
-    VulkanPixelHistoryPerFragmentCallback perFragmentCB(m_pDriver, shaderCache, callbackInfo,
-                                                        eventsWithFrags, eventPremods);
+    uint32_t eid = history[h].eventId;
+    if(fragEvents.eventsWithFrags.find(eid) == fragEvents.eventsWithFrags.end())
+      continue;
+    uint32_t f = history[h].fragIndex;
+    bool someFragsClipped = (history[h].primitiveID == 1);
+    int32_t primId = bp[perFragmentCB.GetEventOffset(eid) + f].primitiveID;
+    history[h].primitiveID = primId;
+    if(someFragsClipped)
     {
-      VkMarkerRegion perFragmentRegion("VulkanPixelHistoryPerFragmentCallback");
-      m_pDriver->ReplayLog(0, eventsWithFrags.rbegin()->first, eReplay_Full);
-      m_pDriver->SubmitCmds();
-      m_pDriver->FlushQ();
+      discardedPrimsEvents[eid].push_back(primId);
+      primitivesToCheck++;
     }
+  }
 
-    PerFragmentInfo *bp = NULL;
-    vkr = m_pDriver->vkMapMemory(dev, resources.bufferMemory, 0, VK_WHOLE_SIZE, 0, (void **)&bp);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  // without the geometry shader feature we can't get the primitive ID, so we can't establish
+  // discard per-primitive so we assume all shaders don't discard.
+  if(vk->GetDeviceEnabledFeatures().geometryShader)
+  {
+    if(primitivesToCheck > 0)
+    {
+      VkMarkerRegion discardedRegion("VulkanPixelHistoryDiscardedFragmentsCallback");
+      VkQueryPool occlPool;
+      CreateOcclusionPool(vk, primitivesToCheck, &occlPool);
+
+      // Replay to see which primitives were discarded.
+      VulkanPixelHistoryDiscardedFragmentsCallback discardedCb(
+          vk, shaderCache, callbackInfo, discardedPrimsEvents, occlPool);
+      vk->ReplayLog(0, fragEvents.eventsWithFrags.rbegin()->first, eReplay_Full);
+      vk->SubmitCmds();
+      vk->FlushQ();
+      discardedCb.FetchOcclusionResults();
+      ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), occlPool, NULL);
 
-    // Retrieve primitive ID values where fragment shader discarded some
-    // fragments. For these primitives we are going to perform an occlusion
-    // query to see if a primitive was discarded.
-    std::map<uint32_t, rdcarray<int32_t> > discardedPrimsEvents;
-    uint32_t primitivesToCheck = 0;
+      for(size_t h = 0; h < history.size(); h++)
+        history[h].shaderDiscarded =
+            discardedCb.PrimitiveDiscarded(history[h].eventId, history[h].primitiveID);
+    }
+  }
+  else
+  {
+    // mark that we have no primitive IDs
     for(size_t h = 0; h < history.size(); h++)
+      history[h].primitiveID = ~0U;
+  }
+
+  uint32_t discardOffset = 0;
+  ResourceFormat shaderOutFormat = MakeResourceFormat(VK_FORMAT_R32G32B32A32_SFLOAT);
+  for(size_t h = 0; h < history.size(); h++)
+  {
+    uint32_t eid = history[h].eventId;
+    uint32_t f = history[h].fragIndex;
+    // Reset discard offset if this is a new event.
+    if(h > 0 && (eid != history[h - 1].eventId))
+      discardOffset = 0;
+    if(fragEvents.eventsWithFrags.find(eid) != fragEvents.eventsWithFrags.end())
     {
-      uint32_t eid = history[h].eventId;
-      if(eventsWithFrags.find(eid) == eventsWithFrags.end())
+      if(history[h].shaderDiscarded)
+      {
+        discardOffset++;
+        // Copy previous post-mod value if its not the first event
+        if(h > 0)
+          history[h].postMod = history[h - 1].postMod;
         continue;
-      uint32_t f = history[h].fragIndex;
-      bool someFragsClipped = (history[h].primitiveID == 1);
-      int32_t primId = bp[perFragmentCB.GetEventOffset(eid) + f].primitiveID;
-      history[h].primitiveID = primId;
-      if(someFragsClipped)
+      }
+      uint32_t offset = perFragmentCB.GetEventOffset(eid) + f - discardOffset;
+      FillInColor(shaderOutFormat, bp[offset].shaderOut, history[h].shaderOut);
+      history[h].shaderOut.depth = bp[offset].shaderOut.depth.fdepth;
+
+      if((h < history.size() - 1) && (history[h].eventId == history[h + 1].eventId))
       {
-        discardedPrimsEvents[eid].push_back(primId);
-        primitivesToCheck++;
+        // Get post-modification value if this is not the last fragment for the event.
+        FillInColor(fmt, bp[offset].postMod, history[h].postMod);
+        // MSAA depth is expanded out to floats in the compute shader
+        if((uint32_t)callbackInfo.samples > 1)
+          history[h].postMod.depth = bp[offset].postMod.depth.fdepth;
+        else
+          history[h].postMod.depth = GetDepthValue(cb.GetDepthFormat(eid), bp[offset].postMod);
+      }
+      // If it is not the first fragment for the event, set the preMod to the
+      // postMod of the previous fragment.
+      if(h > 0 && (history[h].eventId == history[h - 1].eventId))
+      {
+        history[h].preMod = history[h - 1].postMod;
       }
     }
 
-    // without the geometry shader feature we can't get the primitive ID, so we can't establish
-    // discard per-primitive so we assume all shaders don't discard.
-    if(m_pDriver->GetDeviceEnabledFeatures().geometryShader)
+    // check the depth value between premod/shaderout against the known test if we have valid
+    // depth values, as we don't have per-fragment depth test information.
+    if(history[h].preMod.depth >= 0.0f && history[h].shaderOut.depth >= 0.0f && tfCb &&
+       tfCb->HasEventFlags(pixelIndex, history[h].eventId))
     {
-      if(primitivesToCheck > 0)
-      {
-        VkMarkerRegion discardedRegion("VulkanPixelHistoryDiscardedFragmentsCallback");
-        VkQueryPool occlPool;
-        CreateOcclusionPool(m_pDriver, primitivesToCheck, &occlPool);
-
-        // Replay to see which primitives were discarded.
-        VulkanPixelHistoryDiscardedFragmentsCallback discardedCb(
-            m_pDriver, shaderCache, callbackInfo, discardedPrimsEvents, occlPool);
-        m_pDriver->ReplayLog(0, eventsWithFrags.rbegin()->first, eReplay_Full);
-        m_pDriver->SubmitCmds();
-        m_pDriver->FlushQ();
-        discardedCb.FetchOcclusionResults();
-        ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), occlPool, NULL);
+      uint32_t flags = tfCb->GetEventFlags(pixelIndex, history[h].eventId);
+
+      flags &= 0x7 << DepthTest_Shift;
+
+      VkFormat dfmt = cb.GetDepthFormat(eid);
+      float shadDepth = history[h].shaderOut.depth;
 
-        for(size_t h = 0; h < history.size(); h++)
-          history[h].shaderDiscarded =
-              discardedCb.PrimitiveDiscarded(history[h].eventId, history[h].primitiveID);
+      // quantise depth to match before comparing
+      if(dfmt == VK_FORMAT_D24_UNORM_S8_UINT || dfmt == VK_FORMAT_X8_D24_UNORM_PACK32)
+      {
+        shadDepth = float(uint32_t(float(shadDepth * 0xffffff))) / float(0xffffff);
       }
+      else if(dfmt == VK_FORMAT_D16_UNORM || dfmt == VK_FORMAT_D16_UNORM_S8_UINT)
+      {
+        shadDepth = float(uint32_t(float(shadDepth * 0xffff))) / float(0xffff);
+      }
+
+      bool passed = true;
+      if(flags == DepthTest_Equal)
+        passed = (shadDepth == history[h].preMod.depth);
+      else if(flags == DepthTest_NotEqual)
+        passed = (shadDepth != history[h].preMod.depth);
+      else if(flags == DepthTest_Less)
+        passed = (shadDepth < history[h].preMod.depth);
+      else if(flags == DepthTest_LessEqual)
+        passed = (shadDepth <= history[h].preMod.depth);
+      else if(flags == DepthTest_Greater)
+        passed = (shadDepth > history[h].preMod.depth);
+      else if(flags == DepthTest_GreaterEqual)
+        passed = (shadDepth >= history[h].preMod.depth);
+
+      if(!passed)
+        history[h].depthTestFailed = true;
     }
-    else
-    {
-      // mark that we have no primitive IDs
-      for(size_t h = 0; h < history.size(); h++)
-        history[h].primitiveID = ~0U;
-    }
+  }
+}
+
+rdcarray<PixelModification> VulkanReplay::PixelHistory(rdcarray<EventUsage> events,
+                                                       ResourceId target, uint32_t x, uint32_t y,
+                                                       const Subresource &sub, CompType typeCast)
+{
+  rdcarray<PixelHistoryResult> region =
+      PixelHistoryRegion(events, target, x, y, 1, 1, sub, typeCast);
+
+  if(region.empty())
+    return rdcarray<PixelModification>();
+
+  return region[0].history;
+}
+
+rdcarray<PixelHistoryResult> VulkanReplay::PixelHistoryRegion(rdcarray<EventUsage> events,
+                                                              ResourceId target, uint32_t x,
+                                                              uint32_t y, uint32_t width,
+                                                              uint32_t height,
+                                                              const Subresource &sub,
+                                                              CompType typeCast)
+{
+  rdcarray<PixelHistoryResult> ret;
+
+  if(events.empty() || width == 0 || height == 0)
+    return ret;
+
+  const VulkanCreationInfo::Image &imginfo = GetDebugManager()->GetImageInfo(target);
+  if(imginfo.format == VK_FORMAT_UNDEFINED)
+    return ret;
+
+  rdcstr regionName = StringFormat::Fmt(
+      "PixelHistory: region: (%u, %u) %ux%u on %s subresource (%u, %u, %u) cast to %s with %zu "
+      "events",
+      x, y, width, height, ToStr(target).c_str(), sub.mip, sub.slice, sub.sample,
+      ToStr(typeCast).c_str(), events.size());
+
+  RDCDEBUG("%s", regionName.c_str());
+
+  VkMarkerRegion region(regionName);
+
+  uint32_t sampleIdx = sub.sample;
+
+  // TODO: use the given type hint for typeless textures
+  SCOPED_TIMER("VkDebugManager::PixelHistory");
+
+  if(sampleIdx > (uint32_t)imginfo.samples)
+    sampleIdx = 0;
+
+  uint32_t sampleMask = ~0U;
+  if(sampleIdx < 32)
+    sampleMask = 1U << sampleIdx;
+
+  VkDevice dev = m_pDriver->GetDev();
+
+  const uint32_t numPixels = width * height;
+  const uint32_t numEvents = (uint32_t)events.size();
+
+  // the pixels are processed in batches, with the occlusion, colour and stencil, and tests-failed
+  // passes each replaying once for a whole batch. The batch size is bounded by the occlusion
+  // queries of the tests-failed pass, and by the EventInfo results of the colour and stencil pass,
+  // as both need a slot for every event on every pixel.
+  uint32_t pixelsPerPass =
+      RDCMIN(MaxPixelHistoryOcclusionQueries / (numEvents * MaxPixelHistoryTestsPerEvent),
+             MaxPixelHistoryEventInfos / numEvents);
+  pixelsPerPass = RDCCLAMP(pixelsPerPass, 1U, numPixels);
+
+  // the resources and shaders are shared by every pixel in the region. Each pixel in a batch has
+  // its own block of numEvents results in the destination buffer.
+  PixelHistoryResources resources = {};
+  // TODO: perhaps should do this after making an occlusion query, since we will
+  // get a smaller subset of events that passed the occlusion query.
+  VkImage targetImage = GetResourceManager()->GetCurrentHandle<VkImage>(target);
+  GetDebugManager()->PixelHistorySetupResources(resources, targetImage, imginfo.extent,
+                                                imginfo.format, imginfo.samples, sub,
+                                                numEvents * pixelsPerPass);
+
+  PixelHistoryShaderCache *shaderCache = new PixelHistoryShaderCache(m_pDriver);
+
+  PixelHistoryCallbackInfo callbackInfo = {};
+  callbackInfo.targetImage = targetImage;
+  callbackInfo.targetImageFormat = imginfo.format;
+  callbackInfo.layers = imginfo.arrayLayers;
+  callbackInfo.mipLevels = imginfo.mipLevels;
+  callbackInfo.samples = imginfo.samples;
+  callbackInfo.extent = imginfo.extent;
+  callbackInfo.targetSubresource = sub;
+  callbackInfo.sampleMask = sampleMask;
+  callbackInfo.subImage = resources.colorImage;
+  callbackInfo.subImageView = resources.colorImageView;
+  callbackInfo.dsImage = resources.dsImage;
+  callbackInfo.dsFormat = resources.dsFormat;
+  callbackInfo.dsImageView = resources.dsImageView;
+  callbackInfo.dstBuffer = resources.dstBuffer;
+
+  ret.resize(numPixels);
+  for(uint32_t p = 0; p < numPixels; p++)
+  {
+    ret[p].x = x + p % width;
+    ret[p].y = y + p / width;
+  }
+
+  for(uint32_t first = 0; first < numPixels; first += pixelsPerPass)
+  {
+    const uint32_t count = RDCMIN(pixelsPerPass, numPixels - first);
+
+    rdcarray<VkOffset2D> pixels;
+    for(uint32_t p = first; p < first + count; p++)
+      pixels.push_back({(int32_t)ret[p].x, (int32_t)ret[p].y});
+
+    // Gather all draw events that could have written to each pixel for the following passes,
+    // to determine if these draws failed for some reason (for ex., depth test).
+    rdcarray<rdcarray<uint32_t>> modEvents;
+    rdcarray<rdcarray<uint32_t>> drawEvents;
+    modEvents.resize(count);
+    drawEvents.resize(count);
+    uint32_t numModEvents = 0;
+    uint32_t numDrawEvents = 0;
 
-    uint32_t discardOffset = 0;
-    ResourceFormat shaderOutFormat = MakeResourceFormat(VK_FORMAT_R32G32B32A32_SFLOAT);
-    for(size_t h = 0; h < history.size(); h++)
     {
-      uint32_t eid = history[h].eventId;
-      uint32_t f = history[h].fragIndex;
-      // Reset discard offset if this is a new event.
-      if(h > 0 && (eid != history[h - 1].eventId))
-        discardOffset = 0;
-      if(eventsWithFrags.find(eid) != eventsWithFrags.end())
+      VkQueryPool occlusionPool;
+      CreateOcclusionPool(m_pDriver, numEvents * count, &occlusionPool);
+
+      VulkanOcclusionCallback occlCb(m_pDriver, shaderCache, callbackInfo, occlusionPool, events,
+                                     pixels);
       {
-        if(history[h].shaderDiscarded)
-        {
-          discardOffset++;
-          // Copy previous post-mod value if its not the first event
-          if(h > 0)
-            history[h].postMod = history[h - 1].postMod;
-          continue;
-        }
-        uint32_t offset = perFragmentCB.GetEventOffset(eid) + f - discardOffset;
-        FillInColor(shaderOutFormat, bp[offset].shaderOut, history[h].shaderOut);
-        history[h].shaderOut.depth = bp[offset].shaderOut.depth.fdepth;
+        VkMarkerRegion occlRegion("VulkanOcclusionCallback");
+        m_pDriver->ReplayLog(0, events.back().eventId, eReplay_Full);
+        m_pDriver->SubmitCmds();
+        m_pDriver->FlushQ();
+        occlCb.FetchOcclusionResults();
+      }
 
-        if((h < history.size() - 1) && (history[h].eventId == history[h + 1].eventId))
+      for(size_t ev = 0; ev < events.size(); ev++)
+      {
+        bool clear = (events[ev].usage == ResourceUsage::Clear);
+        bool directWrite = isDirectWrite(events[ev].usage);
+
+        if(events[ev].view != ResourceId())
         {
-          // Get post-modification value if this is not the last fragment for the event.
-          FillInColor(fmt, bp[offset].postMod, history[h].postMod);
-          // MSAA depth is expanded out to floats in the compute shader
-          if((uint32_t)callbackInfo.samples > 1)
-            history[h].postMod.depth = bp[offset].postMod.depth.fdepth;
-          else
-            history[h].postMod.depth = GetDepthValue(cb.GetDepthFormat(eid), bp[offset].postMod);
+          // TODO: Check that the slice and mip matches.
+          VulkanCreationInfo::ImageView viewInfo =
+              m_pDriver->GetDebugManager()->GetImageViewInfo(events[ev].view);
+          uint32_t layerEnd = viewInfo.range.baseArrayLayer + viewInfo.range.layerCount;
+          if(sub.slice < viewInfo.range.baseArrayLayer || sub.slice >= layerEnd)
+          {
+            RDCDEBUG("Usage %d at %u didn't refer to the matching mip/slice (%u/%u)",
+                     events[ev].usage, events[ev].eventId, sub.mip, sub.slice);
+            continue;
+          }
         }
-        // If it is not the first fragment for the event, set the preMod to the
-        // postMod of the previous fragment.
-        if(h > 0 && (history[h].eventId == history[h - 1].eventId))
+
+        for(uint32_t p = 0; p < count; p++)
         {
-          history[h].preMod = history[h - 1].postMod;
+          if(directWrite || clear)
+          {
+            modEvents[p].push_back(events[ev].eventId);
+            numModEvents++;
+          }
+          else if(occlCb.GetOcclusionResult((uint32_t)events[ev].eventId, p) > 0)
+          {
+            drawEvents[p].push_back(events[ev].eventId);
+            modEvents[p].push_back(events[ev].eventId);
+            numDrawEvents++;
+            numModEvents++;
+          }
         }
       }
 
-      // check the depth value between premod/shaderout against the known test if we have valid
-      // depth values, as we don't have per-fragment depth test information.
-      if(history[h].preMod.depth >= 0.0f && history[h].shaderOut.depth >= 0.0f && tfCb &&
-         tfCb->HasEventFlags(history[h].eventId))
-      {
-        uint32_t flags = tfCb->GetEventFlags(history[h].eventId);
+      ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), occlusionPool, NULL);
+    }
 
-        flags &= 0x7 << DepthTest_Shift;
+    // nothing could have modified these pixels, so there's no need to replay any further
+    if(numModEvents == 0)
+      continue;
 
-        VkFormat dfmt = cb.GetDepthFormat(eid);
-        float shadDepth = history[h].shaderOut.depth;
+    {
+      // the previous batch's per-fragment passes may have left data in the destination buffer,
+      // which the colour and stencil pass doesn't overwrite for events without draws.
+      VkCommandBuffer cmd = m_pDriver->GetNextCmd();
+      VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+                                            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
 
-        // quantise depth to match before comparing
-        if(dfmt == VK_FORMAT_D24_UNORM_S8_UINT || dfmt == VK_FORMAT_X8_D24_UNORM_PACK32)
-        {
-          shadDepth = float(uint32_t(float(shadDepth * 0xffffff))) / float(0xffffff);
-        }
-        else if(dfmt == VK_FORMAT_D16_UNORM || dfmt == VK_FORMAT_D16_UNORM_S8_UINT)
-        {
-          shadDepth = float(uint32_t(float(shadDepth * 0xffff))) / float(0xffff);
-        }
+      VkResult vkr = ObjDisp(dev)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      ObjDisp(cmd)->CmdFillBuffer(Unwrap(cmd), Unwrap(resources.dstBuffer), 0, VK_WHOLE_SIZE, 0);
+      vkr = ObjDisp(dev)->EndCommandBuffer(Unwrap(cmd));
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      m_pDriver->SubmitCmds();
+    }
 
-        bool passed = true;
-        if(flags == DepthTest_Equal)
-          passed = (shadDepth == history[h].preMod.depth);
-        else if(flags == DepthTest_NotEqual)
-          passed = (shadDepth != history[h].preMod.depth);
-        else if(flags == DepthTest_Less)
-          passed = (shadDepth < history[h].preMod.depth);
-        else if(flags == DepthTest_LessEqual)
-          passed = (shadDepth <= history[h].preMod.depth);
-        else if(flags == DepthTest_Greater)
-          passed = (shadDepth > history[h].preMod.depth);
-        else if(flags == DepthTest_GreaterEqual)
-          passed = (shadDepth >= history[h].preMod.depth);
-
-        if(!passed)
-          history[h].depthTestFailed = true;
-      }
+    VulkanColorAndStencilCallback cb(m_pDriver, shaderCache, callbackInfo, pixels, modEvents,
+                                     numEvents);
+    {
+      VkMarkerRegion colorStencilRegion("VulkanColorAndStencilCallback");
+      m_pDriver->ReplayLog(0, events.back().eventId, eReplay_Full);
+      m_pDriver->SubmitCmds();
+      m_pDriver->FlushQ();
     }
-  }
 
-  SAFE_DELETE(tfCb);
+    // If there are any draw events, do another replay pass, in order to figure out
+    // which tests failed for each draw event.
+    TestsFailedCallback *tfCb = NULL;
+    if(numDrawEvents > 0)
+    {
+      VkMarkerRegion testsRegion("TestsFailedCallback");
+      VkQueryPool tfOcclusionPool;
+      CreateOcclusionPool(m_pDriver, numDrawEvents * MaxPixelHistoryTestsPerEvent,
+                          &tfOcclusionPool);
+
+      tfCb = new TestsFailedCallback(m_pDriver, shaderCache, callbackInfo, tfOcclusionPool, pixels,
+                                     drawEvents);
+      m_pDriver->ReplayLog(0, events.back().eventId, eReplay_Full);
+      m_pDriver->SubmitCmds();
+      m_pDriver->FlushQ();
+      tfCb->FetchOcclusionResults();
+      ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), tfOcclusionPool, NULL);
+    }
+
+    // read back every pixel's results before the per-fragment passes reuse the buffer
+    rdcarray<PixelFragmentEvents> fragEvents;
+    fragEvents.resize(count);
+
+    EventInfo *eventsInfo;
+    VkResult vkr = m_pDriver->vkMapMemory(dev, resources.bufferMemory, 0, VK_WHOLE_SIZE, 0,
+                                          (void **)&eventsInfo);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    for(uint32_t p = 0; p < count; p++)
+    {
+      if(modEvents[p].empty())
+        continue;
+
+      ret[first + p].history = GetPixelModifications(events, callbackInfo, cb, tfCb, p,
+                                                     drawEvents[p], eventsInfo, fragEvents[p]);
+    }
+
+    m_pDriver->vkUnmapMemory(dev, resources.bufferMemory);
+
+    for(uint32_t p = 0; p < count; p++)
+    {
+      if(fragEvents[p].eventsWithFrags.empty())
+        continue;
+
+      callbackInfo.x = ret[first + p].x;
+      callbackInfo.y = ret[first + p].y;
+
+      FillPixelFragments(m_pDriver, callbackInfo, resources, shaderCache, cb, tfCb, p,
+                         fragEvents[p], ret[first + p].history);
+    }
+
+    SAFE_DELETE(tfCb);
+  }
 
   GetDebugManager()->PixelHistoryDestroyResources(resources);
-  ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), occlusionPool, NULL);
   delete shaderCache;
 
-  return history;
+  return ret;
 }
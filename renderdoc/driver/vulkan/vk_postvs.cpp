@@ -25,6 +25,7 @@
 #include <float.h>
 #include <math.h>
 #include <algorithm>
+#include "common/shader_cache.h"
 #include "core/settings.h"
 #include "driver/shaders/spirv/spirv_editor.h"
 #include "driver/shaders/spirv/spirv_op_helpers.h"
@@ -36,8 +37,30 @@
 RDOC_CONFIG(rdcstr, Vulkan_Debug_PostVSDumpDirPath, "",
             "Path to dump gnerated SPIR-V compute shaders for fetching post-vs.");
 
+// when fetching post-vs data for many events at once, how much readback memory can be outstanding
+// before waiting for the GPU
+static const uint64_t MaxPendingPostVSReadback = 256 * 1024 * 1024;
+
 #undef None
 
+// the properties of a stage's output that are stored directly in the persistent cache, the buffer
+// contents follow it
+struct PersistedPostVSStage
+{
+  VkPrimitiveTopology topo;
+  int32_t baseVertex;
+  uint32_t numVerts;
+  uint32_t vertStride;
+  uint32_t instStride;
+  uint32_t numViews;
+  VkIndexType idxFmt;
+  bool useIndices;
+  bool hasPosOut;
+  bool flipY;
+  float nearPlane;
+  float farPlane;
+};
+
 struct VkXfbQueryResult
 {
   uint64_t numPrimitivesWritten;
@@ -1213,6 +1236,201 @@ void VulkanReplay::ClearPostVSCache()
   m_PostVS.Data.clear();
 }
 
+static void WritePersistedStage(StreamWriter &writer, const VulkanPostVSData::StageData &stage,
+                                const byte *data, size_t dataSize, const bytebuf &idxData)
+{
+  PersistedPostVSStage persisted;
+  RDCEraseEl(persisted);
+
+  persisted.topo = stage.topo;
+  persisted.baseVertex = stage.baseVertex;
+  persisted.numVerts = stage.numVerts;
+  persisted.vertStride = stage.vertStride;
+  persisted.instStride = stage.instStride;
+  persisted.numViews = stage.numViews;
+  persisted.idxFmt = stage.idxFmt;
+  persisted.useIndices = stage.useIndices;
+  persisted.hasPosOut = stage.hasPosOut;
+  persisted.flipY = stage.flipY;
+  persisted.nearPlane = stage.nearPlane;
+  persisted.farPlane = stage.farPlane;
+
+  writer.Write(persisted);
+
+  writer.Write((uint32_t)stage.instData.size());
+  writer.Write(stage.instData.data(), stage.instData.byteSize());
+
+  writer.Write((uint64_t)dataSize);
+  writer.Write(data, dataSize);
+
+  writer.Write((uint64_t)idxData.size());
+  writer.Write(idxData.data(), idxData.size());
+}
+
+static bool ReadPersistedBytes(StreamReader &reader, bytebuf &data)
+{
+  uint64_t length = 0;
+  reader.Read(length);
+
+  if(reader.IsErrored() || length > reader.GetSize())
+    return false;
+
+  data.resize((size_t)length);
+  return reader.Read(data.data(), length);
+}
+
+static bool ReadPersistedStage(StreamReader &reader, VulkanPostVSData::StageData &stage,
+                               bytebuf &data, bytebuf &idxData)
+{
+  PersistedPostVSStage persisted;
+  uint32_t numInstData = 0;
+
+  reader.Read(persisted);
+  reader.Read(numInstData);
+
+  if(reader.IsErrored() || numInstData > reader.GetSize())
+    return false;
+
+  stage.instData.resize(numInstData);
+  reader.Read(stage.instData.data(), stage.instData.byteSize());
+
+  if(!ReadPersistedBytes(reader, data) || !ReadPersistedBytes(reader, idxData))
+    return false;
+
+  stage.topo = persisted.topo;
+  stage.baseVertex = persisted.baseVertex;
+  stage.numVerts = persisted.numVerts;
+  stage.vertStride = persisted.vertStride;
+  stage.instStride = persisted.instStride;
+  stage.numViews = persisted.numViews;
+  stage.idxFmt = persisted.idxFmt;
+  stage.useIndices = persisted.useIndices;
+  stage.hasPosOut = persisted.hasPosOut;
+  stage.flipY = persisted.flipY;
+  stage.nearPlane = persisted.nearPlane;
+  stage.farPlane = persisted.farPlane;
+
+  return true;
+}
+
+static VkBuffer CreatePersistedBuffer(WrappedVulkan *driver, const bytebuf &data,
+                                      VkBufferUsageFlags usage, VkDeviceMemory &mem)
+{
+  mem = VK_NULL_HANDLE;
+
+  if(data.empty())
+    return VK_NULL_HANDLE;
+
+  VkDevice dev = driver->GetDev();
+
+  VkBufferCreateInfo bufInfo = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+  // match the minimum size the buffers are originally created with
+  bufInfo.size = RDCMAX((VkDeviceSize)64, (VkDeviceSize)data.size());
+  bufInfo.usage = usage;
+
+  VkBuffer buf = VK_NULL_HANDLE;
+  VkResult vkr = driver->vkCreateBuffer(dev, &bufInfo, NULL, &buf);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  VkMemoryRequirements mrq = {0};
+  driver->vkGetBufferMemoryRequirements(dev, buf, &mrq);
+
+  VkMemoryAllocateInfo allocInfo = {
+      VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
+      driver->GetUploadMemoryIndex(mrq.memoryTypeBits),
+  };
+
+  vkr = driver->vkAllocateMemory(dev, &allocInfo, NULL, &mem);
+
+  if(vkr != VK_SUCCESS)
+  {
+    RDCWARN("Failed to allocate %llu bytes for cached post-VS data", mrq.size);
+    driver->vkDestroyBuffer(dev, buf, NULL);
+    mem = VK_NULL_HANDLE;
+    return VK_NULL_HANDLE;
+  }
+
+  vkr = driver->vkBindBufferMemory(dev, buf, mem, 0);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  byte *mapped = NULL;
+  vkr = driver->vkMapMemory(dev, mem, 0, VK_WHOLE_SIZE, 0, (void **)&mapped);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  if(mapped)
+  {
+    memcpy(mapped, data.data(), data.size());
+
+    VkMappedMemoryRange range = {
+        VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL, mem, 0, VK_WHOLE_SIZE,
+    };
+
+    vkr = driver->vkFlushMappedMemoryRanges(dev, 1, &range);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    driver->vkUnmapMemory(dev, mem);
+  }
+
+  return buf;
+}
+
+void VulkanReplay::PersistPostVSData(uint32_t eventId, const byte *vsoutData, size_t vsoutSize,
+                                     const bytebuf &vsoutIdx, const bytebuf &gsoutData)
+{
+  const VulkanPostVSData &postvs = m_PostVS.Data[eventId];
+
+  StreamWriter writer(StreamWriter::DefaultScratchSize);
+
+  writer.Write(postvs.vsin.topo);
+  WritePersistedStage(writer, postvs.vsout, vsoutData, vsoutSize, vsoutIdx);
+  WritePersistedStage(writer, postvs.gsout, gsoutData.data(), gsoutData.size(), bytebuf());
+
+  // if the cache is full this event will just be fetched again next time
+  m_PersistentCache.Write(PersistedKey(PersistedData::PostVS, eventId), writer.GetData(),
+                          (size_t)writer.GetOffset());
+}
+
+bool VulkanReplay::RestorePostVSData(uint32_t eventId)
+{
+  bytebuf persisted;
+
+  if(!m_PersistentCache.Read(PersistedKey(PersistedData::PostVS, eventId), persisted))
+    return false;
+
+  StreamReader reader(persisted);
+
+  VulkanPostVSData postvs;
+  bytebuf vsoutData, vsoutIdx, gsoutData, gsoutIdx;
+
+  reader.Read(postvs.vsin.topo);
+
+  bool success = ReadPersistedStage(reader, postvs.vsout, vsoutData, vsoutIdx) &&
+                 ReadPersistedStage(reader, postvs.gsout, gsoutData, gsoutIdx);
+
+  if(!success)
+  {
+    RDCWARN("Invalid cached post-VS data for event %u, fetching it again", eventId);
+    return false;
+  }
+
+  // the buffers are recreated with the same usage they were fetched with
+  VkBufferUsageFlags vertUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+  vertUsage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  vertUsage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+  vertUsage |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+
+  VkBufferUsageFlags idxUsage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+  postvs.vsout.buf = CreatePersistedBuffer(m_pDriver, vsoutData, vertUsage, postvs.vsout.bufmem);
+  postvs.vsout.idxbuf =
+      CreatePersistedBuffer(m_pDriver, vsoutIdx, idxUsage, postvs.vsout.idxbufmem);
+  postvs.gsout.buf = CreatePersistedBuffer(m_pDriver, gsoutData, vertUsage, postvs.gsout.bufmem);
+
+  m_PostVS.Data[eventId] = postvs;
+
+  return true;
+}
+
 void VulkanReplay::FetchVSOut(uint32_t eventId, VulkanRenderState &state)
 {
   VulkanCreationInfo &creationInfo = m_pDriver->m_CreationInfo;
@@ -1344,6 +1562,9 @@ void VulkanReplay::FetchVSOut(uint32_t eventId, VulkanRenderState &state)
   VkBuffer rebasedIdxBuf = VK_NULL_HANDLE;
   VkDeviceMemory rebasedIdxBufMem = VK_NULL_HANDLE;
 
+  // the rebased indices, kept to persist alongside the vertex data
+  bytebuf persistIdx;
+
   uint32_t numVerts = drawcall->numIndices;
   VkDeviceSize bufSize = 0;
 
@@ -1620,6 +1841,9 @@ void VulkanReplay::FetchVSOut(uint32_t eventId, VulkanRenderState &state)
 
     memcpy(idxData, idxdata.data(), idxdata.size());
 
+    if(m_PersistentCache.IsOpen())
+      persistIdx.swap(idxdata);
+
     VkMappedMemoryRange rebasedRange = {
         VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL, rebasedIdxBufMem, 0, VK_WHOLE_SIZE,
     };
@@ -2214,109 +2438,39 @@ void VulkanReplay::FetchVSOut(uint32_t eventId, VulkanRenderState &state)
     vkr = ObjDisp(dev)->EndCommandBuffer(Unwrap(cmd));
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    // submit & flush so that we don't have to keep pipeline around for a while
+    // submit now, but only wait for the GPU to finish if we aren't fetching a batch of events
     m_pDriver->SubmitCmds();
-    m_pDriver->FlushQ();
-  }
-
-  for(CompactedAttrBuffer attrBuf : vbuffers)
-  {
-    m_pDriver->vkDestroyBufferView(dev, attrBuf.view, NULL);
-    m_pDriver->vkDestroyBuffer(dev, attrBuf.buf, NULL);
-    m_pDriver->vkFreeMemory(dev, attrBuf.mem, NULL);
   }
 
-  // readback mesh data
-  byte *byteData = NULL;
-  vkr = m_pDriver->vkMapMemory(m_Device, readbackMem, 0, VK_WHOLE_SIZE, 0, (void **)&byteData);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-  VkMappedMemoryRange range = {
-      VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL, readbackMem, 0, VK_WHOLE_SIZE,
-  };
-
-  vkr = m_pDriver->vkInvalidateMappedMemoryRanges(m_Device, 1, &range);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-  // do near/far calculations
-
-  float nearp = 0.1f;
-  float farp = 100.0f;
-
-  Vec4f *pos0 = (Vec4f *)byteData;
-
-  bool found = false;
-
-  // expect position at the start of the buffer, as system values are sorted first
-  // and position is the first value
-
-  for(uint32_t i = 1;
-      refl->outputSignature[0].systemValue == ShaderBuiltin::Position && i < numVerts; i++)
-  {
-    //////////////////////////////////////////////////////////////////////////////////
-    // derive near/far, assuming a standard perspective matrix
-    //
-    // the transformation from from pre-projection {Z,W} to post-projection {Z,W}
-    // is linear. So we can say Zpost = Zpre*m + c . Here we assume Wpre = 1
-    // and we know Wpost = Zpre from the perspective matrix.
-    // we can then see from the perspective matrix that
-    // m = F/(F-N)
-    // c = -(F*N)/(F-N)
-    //
-    // with re-arranging and substitution, we then get:
-    // N = -c/m
-    // F = c/(1-m)
-    //
-    // so if we can derive m and c then we can determine N and F. We can do this with
-    // two points, and we pick them reasonably distinct on z to reduce floating-point
-    // error
-
-    Vec4f *pos = (Vec4f *)(byteData + i * bufStride);
-
-    // skip invalid vertices (w=0)
-    if(pos->w != 0.0f && fabs(pos->w - pos0->w) > 0.01f && fabs(pos->z - pos0->z) > 0.01f)
-    {
-      Vec2f A(pos0->w, pos0->z);
-      Vec2f B(pos->w, pos->z);
-
-      float m = (B.y - A.y) / (B.x - A.x);
-      float c = B.y - B.x * m;
-
-      if(m == 1.0f)
-        continue;
-
-      if(-c / m <= 0.000001f)
-        continue;
-
-      nearp = -c / m;
-      farp = c / (1 - m);
-
-      found = true;
+  // the temporary objects can't be destroyed until the fetch has completed, so hand them off with
+  // the readback
+  PostVS::PendingFetch fetch;
+  fetch.eventId = eventId;
+  fetch.readbackBuffer = readbackBuffer;
+  fetch.readbackMem = readbackMem;
+  fetch.dataSize = bufSize;
+  fetch.numVerts = numVerts;
+  fetch.vertStride = bufStride;
+  fetch.hasPosOut = refl->outputSignature[0].systemValue == ShaderBuiltin::Position;
+  fetch.descpool = descpool;
+  fetch.setLayouts = setLayouts;
+  fetch.descSets = descSets;
+  fetch.pipeLayout = pipeLayout;
+  fetch.pipe = pipe;
+  fetch.module = module;
 
-      break;
-    }
-  }
-
-  // if we didn't find anything, all z's and w's were identical.
-  // If the z is positive and w greater for the first element then
-  // we detect this projection as reversed z with infinite far plane
-  if(!found && pos0->z > 0.0f && pos0->w > pos0->z)
+  for(CompactedAttrBuffer attrBuf : vbuffers)
   {
-    nearp = pos0->z;
-    farp = FLT_MAX;
+    fetch.tempViews.push_back(attrBuf.view);
+    fetch.tempBuffers.push_back(attrBuf.buf);
+    fetch.tempMems.push_back(attrBuf.mem);
   }
 
-  m_pDriver->vkUnmapMemory(m_Device, readbackMem);
-
-  // clean up temporary memories
-  m_pDriver->vkDestroyBuffer(m_Device, readbackBuffer, NULL);
-  m_pDriver->vkFreeMemory(m_Device, readbackMem, NULL);
-
   if(uniqIdxBuf != VK_NULL_HANDLE)
   {
-    m_pDriver->vkDestroyBuffer(m_Device, uniqIdxBuf, NULL);
-    m_pDriver->vkFreeMemory(m_Device, uniqIdxBufMem, NULL);
-    m_pDriver->vkDestroyBufferView(m_Device, uniqIdxBufView, NULL);
+    fetch.tempViews.push_back(uniqIdxBufView);
+    fetch.tempBuffers.push_back(uniqIdxBuf);
+    fetch.tempMems.push_back(uniqIdxBufMem);
   }
 
   // fill out m_PostVS.Data
@@ -2330,8 +2484,6 @@ void VulkanReplay::FetchVSOut(uint32_t eventId, VulkanRenderState &state)
   m_PostVS.Data[eventId].vsout.numViews = numViews;
 
   m_PostVS.Data[eventId].vsout.vertStride = bufStride;
-  m_PostVS.Data[eventId].vsout.nearPlane = nearp;
-  m_PostVS.Data[eventId].vsout.farPlane = farp;
 
   m_PostVS.Data[eventId].vsout.useIndices = bool(drawcall->flags & DrawFlags::Indexed);
   m_PostVS.Data[eventId].vsout.numVerts = drawcall->numIndices;
@@ -2352,29 +2504,158 @@ void VulkanReplay::FetchVSOut(uint32_t eventId, VulkanRenderState &state)
     m_PostVS.Data[eventId].vsout.idxbuf = rebasedIdxBuf;
     m_PostVS.Data[eventId].vsout.idxbufmem = rebasedIdxBufMem;
     m_PostVS.Data[eventId].vsout.idxFmt = type;
+
+    fetch.idxData.swap(persistIdx);
   }
 
   m_PostVS.Data[eventId].vsout.hasPosOut =
       refl->outputSignature[0].systemValue == ShaderBuiltin::Position;
   m_PostVS.Data[eventId].vsout.flipY = state.views.empty() ? false : state.views[0].height < 0.0f;
 
-  // delete descriptors. Technically we don't have to free the descriptor sets, but our tracking on
-  // replay doesn't handle destroying children of pooled objects so we do it explicitly anyway.
-  m_pDriver->vkFreeDescriptorSets(dev, descpool, (uint32_t)descSets.size(), descSets.data());
+  // the near/far planes are filled in once the readback completes
+  m_PostVS.Pending.push_back(fetch);
+  m_PostVS.PendingBytes += bufSize;
+}
 
-  // delete pipeline layout
-  m_pDriver->vkDestroyPipelineLayout(dev, pipeLayout, NULL);
+void VulkanReplay::ResolvePendingVSOut()
+{
+  if(m_PostVS.Pending.empty())
+    return;
 
-  m_pDriver->vkDestroyDescriptorPool(dev, descpool, NULL);
+  VkResult vkr = VK_SUCCESS;
+  VkDevice dev = m_Device;
 
-  for(VkDescriptorSetLayout layout : setLayouts)
-    m_pDriver->vkDestroyDescriptorSetLayout(dev, layout, NULL);
+  // a single wait covers every fetch that has been submitted since the last resolve
+  m_pDriver->FlushQ();
 
-  // delete pipeline
-  m_pDriver->vkDestroyPipeline(dev, pipe, NULL);
+  for(const PostVS::PendingFetch &fetch : m_PostVS.Pending)
+  {
+    const uint32_t numVerts = fetch.numVerts;
+    const uint32_t bufStride = fetch.vertStride;
+    VkDeviceMemory readbackMem = fetch.readbackMem;
 
-  // delete shader/shader module
-  m_pDriver->vkDestroyShaderModule(dev, module, NULL);
+    // readback mesh data
+    byte *byteData = NULL;
+    vkr = m_pDriver->vkMapMemory(m_Device, readbackMem, 0, VK_WHOLE_SIZE, 0, (void **)&byteData);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    VkMappedMemoryRange range = {
+        VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL, readbackMem, 0, VK_WHOLE_SIZE,
+    };
+
+    vkr = m_pDriver->vkInvalidateMappedMemoryRanges(m_Device, 1, &range);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    // do near/far calculations
+
+    float nearp = 0.1f;
+    float farp = 100.0f;
+
+    Vec4f *pos0 = (Vec4f *)byteData;
+
+    bool found = false;
+
+    // expect position at the start of the buffer, as system values are sorted first
+    // and position is the first value
+
+    for(uint32_t i = 1; fetch.hasPosOut && i < numVerts; i++)
+    {
+      //////////////////////////////////////////////////////////////////////////////////
+      // derive near/far, assuming a standard perspective matrix
+      //
+      // the transformation from from pre-projection {Z,W} to post-projection {Z,W}
+      // is linear. So we can say Zpost = Zpre*m + c . Here we assume Wpre = 1
+      // and we know Wpost = Zpre from the perspective matrix.
+      // we can then see from the perspective matrix that
+      // m = F/(F-N)
+      // c = -(F*N)/(F-N)
+      //
+      // with re-arranging and substitution, we then get:
+      // N = -c/m
+      // F = c/(1-m)
+      //
+      // so if we can derive m and c then we can determine N and F. We can do this with
+      // two points, and we pick them reasonably distinct on z to reduce floating-point
+      // error
+
+      Vec4f *pos = (Vec4f *)(byteData + i * bufStride);
+
+      // skip invalid vertices (w=0)
+      if(pos->w != 0.0f && fabs(pos->w - pos0->w) > 0.01f && fabs(pos->z - pos0->z) > 0.01f)
+      {
+        Vec2f A(pos0->w, pos0->z);
+        Vec2f B(pos->w, pos->z);
+
+        float m = (B.y - A.y) / (B.x - A.x);
+        float c = B.y - B.x * m;
+
+        if(m == 1.0f)
+          continue;
+
+        if(-c / m <= 0.000001f)
+          continue;
+
+        nearp = -c / m;
+        farp = c / (1 - m);
+
+        found = true;
+
+        break;
+      }
+    }
+
+    // if we didn't find anything, all z's and w's were identical.
+    // If the z is positive and w greater for the first element then
+    // we detect this projection as reversed z with infinite far plane
+    if(!found && pos0->z > 0.0f && pos0->w > pos0->z)
+    {
+      nearp = pos0->z;
+      farp = FLT_MAX;
+    }
+
+    m_PostVS.Data[fetch.eventId].vsout.nearPlane = nearp;
+    m_PostVS.Data[fetch.eventId].vsout.farPlane = farp;
+
+    // every stage has been fetched by now, so persist the event while its data is mapped
+    if(m_PersistentCache.IsOpen())
+      PersistPostVSData(fetch.eventId, byteData, (size_t)fetch.dataSize, fetch.idxData,
+                        fetch.gsoutData);
+
+    m_pDriver->vkUnmapMemory(m_Device, readbackMem);
+
+    // clean up temporary memories
+    m_pDriver->vkDestroyBuffer(dev, fetch.readbackBuffer, NULL);
+    m_pDriver->vkFreeMemory(dev, fetch.readbackMem, NULL);
+
+    for(VkBufferView view : fetch.tempViews)
+      m_pDriver->vkDestroyBufferView(dev, view, NULL);
+    for(VkBuffer buf : fetch.tempBuffers)
+      m_pDriver->vkDestroyBuffer(dev, buf, NULL);
+    for(VkDeviceMemory mem : fetch.tempMems)
+      m_pDriver->vkFreeMemory(dev, mem, NULL);
+
+    // delete descriptors. Technically we don't have to free the descriptor sets, but our tracking
+    // on replay doesn't handle destroying children of pooled objects so we do it explicitly anyway.
+    m_pDriver->vkFreeDescriptorSets(dev, fetch.descpool, (uint32_t)fetch.descSets.size(),
+                                    fetch.descSets.data());
+
+    // delete pipeline layout
+    m_pDriver->vkDestroyPipelineLayout(dev, fetch.pipeLayout, NULL);
+
+    m_pDriver->vkDestroyDescriptorPool(dev, fetch.descpool, NULL);
+
+    for(VkDescriptorSetLayout layout : fetch.setLayouts)
+      m_pDriver->vkDestroyDescriptorSetLayout(dev, layout, NULL);
+
+    // delete pipeline
+    m_pDriver->vkDestroyPipeline(dev, fetch.pipe, NULL);
+
+    // delete shader/shader module
+    m_pDriver->vkDestroyShaderModule(dev, fetch.module, NULL);
+  }
+
+  m_PostVS.Pending.clear();
+  m_PostVS.PendingBytes = 0;
 }
 
 void VulkanReplay::FetchTessGSOut(uint32_t eventId, VulkanRenderState &state)
@@ -2897,6 +3178,12 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId, VulkanRenderState &state)
   m_PostVS.Data[eventId].gsout.hasPosOut = true;
   m_PostVS.Data[eventId].gsout.flipY = state.views.empty() ? false : state.views[0].height < 0.0f;
 
+  // the vertex output is still pending, so hand the written vertices to it to be persisted with
+  const uint64_t writtenSize = uint64_t(m_PostVS.Data[eventId].gsout.numVerts) * xfbStride;
+  if(m_PersistentCache.IsOpen() && writtenSize > 0 && !m_PostVS.Pending.empty() &&
+     m_PostVS.Pending.back().eventId == eventId)
+    GetBufferData(GetResID(meshBuffer), 0, writtenSize, m_PostVS.Pending.back().gsoutData);
+
   // delete framebuffer and renderpass
   m_pDriver->vkDestroyFramebuffer(dev, fb, NULL);
   m_pDriver->vkDestroyRenderPass(dev, rp, NULL);
@@ -2917,6 +3204,9 @@ void VulkanReplay::InitPostVSBuffers(uint32_t eventId, VulkanRenderState state)
   if(m_PostVS.Data.find(eventId) != m_PostVS.Data.end())
     return;
 
+  if(RestorePostVSData(eventId))
+    return;
+
   VulkanCreationInfo &creationInfo = m_pDriver->m_CreationInfo;
 
   if(state.graphics.pipeline == ResourceId() || state.renderPass == ResourceId())
@@ -2938,15 +3228,19 @@ void VulkanReplay::InitPostVSBuffers(uint32_t eventId, VulkanRenderState state)
 
   VkMarkerRegion::End();
 
-  // if there's no tessellation or geometry shader active, bail out now
-  if(pipeInfo.shaders[2].module == ResourceId() && pipeInfo.shaders[3].module == ResourceId())
-    return;
+  // only fetch tessellation or geometry shader output if one is active
+  if(pipeInfo.shaders[2].module != ResourceId() || pipeInfo.shaders[3].module != ResourceId())
+  {
+    VkMarkerRegion::Begin(StringFormat::Fmt("FetchTessGSOut for %u", eventId));
 
-  VkMarkerRegion::Begin(StringFormat::Fmt("FetchTessGSOut for %u", eventId));
+    FetchTessGSOut(eventId, state);
 
-  FetchTessGSOut(eventId, state);
+    VkMarkerRegion::End();
+  }
 
-  VkMarkerRegion::End();
+  // the near/far planes are filled in once the readback completes
+  if(!m_PostVS.Batching || m_PostVS.PendingBytes >= MaxPendingPostVSReadback)
+    ResolvePendingVSOut();
 }
 
 void VulkanReplay::InitPostVSBuffers(uint32_t eventId)
@@ -3010,7 +3304,12 @@ void VulkanReplay::InitPostVSBuffers(const rdcarray<uint32_t> &events)
   // now we replay the events, which are guaranteed (because we generated them in
   // GetPassEvents above) to come from the same command buffer, so the event IDs are
   // still locally continuous, even if we jump into replaying.
+  m_PostVS.Batching = true;
   m_pDriver->ReplayLog(events.front(), events.back(), eReplay_Full);
+  m_PostVS.Batching = false;
+
+  // wait for and read back everything fetched during the replay in one go
+  ResolvePendingVSOut();
 }
 
 MeshFormat VulkanReplay::GetPostVSBuffers(uint32_t eventId, uint32_t instID, uint32_t viewID,
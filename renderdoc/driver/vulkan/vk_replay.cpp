@@ -27,6 +27,7 @@
 #include <float.h>
 #include <math.h>
 #include <algorithm>
+#include "api/replay/version.h"
 #include "core/settings.h"
 #include "driver/ihv/amd/amd_rgp.h"
 #include "driver/shaders/spirv/spirv_compile.h"
@@ -38,10 +39,23 @@
 #include "vk_debug.h"
 #include "vk_resources.h"
 #include "vk_shader_cache.h"
+#include "zstd/xxhash.h"
 
 #define VULKAN 1
 #include "data/glsl/glsl_ubos_cpp.h"
 
+RDOC_CONFIG(bool, Vulkan_PersistentReplayCache, false,
+            "Persist post-transform vertex data and bindless feedback results to disk for each "
+            "capture, so they don't need to be fetched again the next time it's opened.");
+
+RDOC_CONFIG(uint32_t, Vulkan_PersistentReplayCacheMB, 1024,
+            "The disk space in megabytes that persisted replay caches can use in total. The least "
+            "recently used caches are deleted to stay within it.");
+
+static const uint32_t PersistentReplayCacheMagic = MAKE_FOURCC('V', 'K', 'R', 'C');
+// bump this whenever the contents of any persisted entry change
+static const uint32_t PersistentReplayCacheVersion = 2;
+
 static const char *SPIRVDisassemblyTarget = "SPIR-V (RenderDoc)";
 static const char *AMDShaderInfoTarget = "AMD_shader_info";
 static const char *KHRExecutablePropertiesTarget = "KHR_pipeline_executable_properties";
@@ -77,6 +91,8 @@ VulkanResourceManager *VulkanReplay::GetResourceManager()
 
 void VulkanReplay::Shutdown()
 {
+  m_PersistentCache.Close();
+
   SAFE_DELETE(m_RGP);
 
   m_pDriver->Shutdown();
@@ -195,7 +211,42 @@ APIProperties VulkanReplay::GetAPIProperties()
 
 ReplayStatus VulkanReplay::ReadLogInitialisation(RDCFile *rdc, bool storeStructuredBuffers)
 {
-  return m_pDriver->ReadLogInitialisation(rdc, storeStructuredBuffers);
+  ReplayStatus status = m_pDriver->ReadLogInitialisation(rdc, storeStructuredBuffers);
+
+  uint64_t sectionHash = 0;
+
+  if(status == ReplayStatus::Succeeded && Vulkan_PersistentReplayCache() &&
+     rdc->HashSection(rdc->SectionIndex(SectionType::FrameCapture), sectionHash))
+  {
+    // results can depend on how and where the capture is replayed, not just on its contents
+    const ReplayOptions &opts = m_pDriver->GetReplayOptions();
+    const VkPhysicalDeviceProperties &props = m_pDriver->GetDeviceProps();
+
+    XXH64_state_t *state = XXH64_createState();
+    XXH64_reset(state, sectionHash);
+
+    XXH64_update(state, &opts.apiValidation, sizeof(opts.apiValidation));
+    XXH64_update(state, &opts.optimisation, sizeof(opts.optimisation));
+    XXH64_update(state, &props.vendorID, sizeof(props.vendorID));
+    XXH64_update(state, &props.deviceID, sizeof(props.deviceID));
+    XXH64_update(state, &props.driverVersion, sizeof(props.driverVersion));
+
+    // a different build can fetch different results, and its cache would never be used again.
+    // Including it in the name means stale caches are evicted instead of being overwritten.
+    XXH64_update(state, FULL_VERSION_STRING, strlen(FULL_VERSION_STRING));
+    XXH64_update(state, GitVersionHash, strlen(GitVersionHash));
+
+    uint64_t key = XXH64_digest(state);
+    XXH64_freeState(state);
+
+    // only the index of entries is read now, the entries are read as events are selected
+    m_PersistentCache.Open(FileIO::GetAppFolderFilename("replaycache"),
+                           StringFormat::Fmt("vulkan_%016llx", key), PersistentReplayCacheMagic,
+                           PersistentReplayCacheVersion,
+                           uint64_t(Vulkan_PersistentReplayCacheMB()) * 1024 * 1024);
+  }
+
+  return status;
 }
 
 void VulkanReplay::ReplayLog(uint32_t endEventID, ReplayLogType replayType)
@@ -203,6 +254,12 @@ void VulkanReplay::ReplayLog(uint32_t endEventID, ReplayLogType replayType)
   m_pDriver->ReplayLog(0, endEventID, replayType);
 }
 
+void VulkanReplay::SetReplayRange(uint32_t startEventID, uint32_t endEventID)
+{
+  // we can't start a replay part-way through the frame as it may be inside a command buffer, so
+  // there's nothing to snapshot. Every replay starts from the beginning of the frame.
+}
+
 const SDFile &VulkanReplay::GetStructuredFile()
 {
   return m_pDriver->GetStructuredFile();
@@ -3931,6 +3988,10 @@ void VulkanReplay::FreeTargetResource(ResourceId id)
 
 void VulkanReplay::ReplaceResource(ResourceId from, ResourceId to)
 {
+  // anything fetched from now on depends on the replaced shader, and anything already persisted
+  // no longer applies. Stop using the cache for the rest of this replay.
+  m_PersistentCache.Close();
+
   // replace the shader module
   m_pDriver->GetResourceManager()->ReplaceResource(from, to);
 
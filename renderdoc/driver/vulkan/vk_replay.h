@@ -25,6 +25,7 @@
 #pragma once
 
 #include "api/replay/renderdoc_replay.h"
+#include "common/persistent_cache.h"
 #include "core/core.h"
 #include "replay/replay_driver.h"
 #include "vk_common.h"
@@ -293,6 +294,7 @@ public:
 
   ReplayStatus ReadLogInitialisation(RDCFile *rdc, bool storeStructuredBuffers);
   void ReplayLog(uint32_t endEventID, ReplayLogType replayType);
+  void SetReplayRange(uint32_t startEventID, uint32_t endEventID);
   const SDFile &GetStructuredFile();
 
   rdcarray<uint32_t> GetPassEvents(uint32_t eventId);
@@ -377,10 +379,16 @@ public:
 
   rdcarray<PixelModification> PixelHistory(rdcarray<EventUsage> events, ResourceId target, uint32_t x,
                                            uint32_t y, const Subresource &sub, CompType typeCast);
+  rdcarray<PixelHistoryResult> PixelHistoryRegion(rdcarray<EventUsage> events, ResourceId target,
+                                                  uint32_t x, uint32_t y, uint32_t width,
+                                                  uint32_t height, const Subresource &sub,
+                                                  CompType typeCast);
   ShaderDebugTrace *DebugVertex(uint32_t eventId, uint32_t vertid, uint32_t instid, uint32_t idx,
                                 uint32_t view);
   ShaderDebugTrace *DebugPixel(uint32_t eventId, uint32_t x, uint32_t y, uint32_t sample,
                                uint32_t primitive);
+  rdcarray<ShaderDebugTrace *> DebugPixels(uint32_t eventId,
+                                           const rdcarray<DebugPixelInputs> &pixels);
   ShaderDebugTrace *DebugThread(uint32_t eventId, const uint32_t groupid[3],
                                 const uint32_t threadid[3]);
   rdcarray<ShaderDebugState> ContinueDebug(ShaderDebugger *debugger);
@@ -427,6 +435,8 @@ public:
 private:
   void FetchShaderFeedback(uint32_t eventId);
   void ClearFeedbackCache();
+  bool RestoreFeedback(uint32_t eventId);
+  void PersistFeedback(uint32_t eventId);
 
   void PatchReservedDescriptors(const VulkanStatePipeline &pipe, VkDescriptorPool &descpool,
                                 rdcarray<VkDescriptorSetLayout> &setLayouts,
@@ -437,7 +447,11 @@ private:
 
   void FetchVSOut(uint32_t eventId, VulkanRenderState &state);
   void FetchTessGSOut(uint32_t eventId, VulkanRenderState &state);
+  void ResolvePendingVSOut();
   void ClearPostVSCache();
+  bool RestorePostVSData(uint32_t eventId);
+  void PersistPostVSData(uint32_t eventId, const byte *vsoutData, size_t vsoutSize,
+                         const bytebuf &vsoutIdx, const bytebuf &gsoutData);
 
   void RefreshDerivedReplacements();
 
@@ -722,6 +736,40 @@ private:
 
     std::map<uint32_t, VulkanPostVSData> Data;
     std::map<uint32_t, uint32_t> Alias;
+
+    // a VS output fetch that has been submitted but not yet waited on. When fetching a batch of
+    // events we only wait for the GPU once at the end, so the readback and any temporary objects
+    // used by the fetch must be kept alive until then.
+    struct PendingFetch
+    {
+      uint32_t eventId = 0;
+
+      VkBuffer readbackBuffer = VK_NULL_HANDLE;
+      VkDeviceMemory readbackMem = VK_NULL_HANDLE;
+      VkDeviceSize dataSize = 0;
+      uint32_t numVerts = 0;
+      uint32_t vertStride = 0;
+      bool hasPosOut = false;
+
+      // only kept when the results are persisted, the rest is read back with the vertex data
+      bytebuf idxData;
+      bytebuf gsoutData;
+
+      VkDescriptorPool descpool = VK_NULL_HANDLE;
+      rdcarray<VkDescriptorSetLayout> setLayouts;
+      rdcarray<VkDescriptorSet> descSets;
+      VkPipelineLayout pipeLayout = VK_NULL_HANDLE;
+      VkPipeline pipe = VK_NULL_HANDLE;
+      VkShaderModule module = VK_NULL_HANDLE;
+
+      rdcarray<VkBuffer> tempBuffers;
+      rdcarray<VkBufferView> tempViews;
+      rdcarray<VkDeviceMemory> tempMems;
+    };
+
+    bool Batching = false;
+    rdcarray<PendingFetch> Pending;
+    uint64_t PendingBytes = 0;
   } m_PostVS;
 
   struct Feedback
@@ -733,6 +781,22 @@ private:
     std::map<uint32_t, DynamicUsedBinds> Usage;
   } m_BindlessFeedback;
 
+  // what each entry in the persistent cache holds, combined with its event ID to key it
+  enum class PersistedData : uint32_t
+  {
+    PostVS = 1,
+    BindlessFeedback = 2,
+  };
+
+  static uint64_t PersistedKey(PersistedData type, uint32_t eventId)
+  {
+    return (uint64_t(type) << 32) | eventId;
+  }
+
+  // if open, post-VS and feedback results are persisted to disk in a cache named with a hash of the
+  // capture's contents, the replay options, the GPU replaying and the RenderDoc build.
+  PersistentCache m_PersistentCache;
+
   ShaderDebugData m_ShaderDebugData;
 
   rdcarray<ResourceDescription> m_Resources;
@@ -770,8 +834,6 @@ private:
 
   VulkanAMDDrawCallback *m_pAMDDrawCallback = NULL;
 
-  rdcarray<CounterResult> FetchCountersKHR(const rdcarray<GPUCounter> &counters);
-
   rdcarray<VkPerformanceCounterKHR> m_KHRCounters;
   rdcarray<VkPerformanceCounterDescriptionKHR> m_KHRCountersDescriptions;
 
@@ -1103,6 +1103,9 @@ struct MemMapState
   // flush this may point to the readback memory so that we read from that fast copy instead of the
   // slow actual pointer.
   byte *cpuReadPtr = NULL;
+  // for coherent maps, optionally a write watch on the mapped pointer so that only pages the
+  // application has written need to be compared when flushing. See Process::RegisterWriteWatch
+  uint64_t writeWatch = 0;
   Threading::CriticalSection mrLock;
 };
 
@@ -153,7 +153,7 @@ public:
     m_pDriver = vk;
 
     // when we're first setting up, the state is pristine and no replay is needed
-    m_ResourcesDirty = false;
+    m_Shared = new SharedState;
 
     const VulkanRenderState &state = m_pDriver->GetRenderState();
 
@@ -281,7 +281,7 @@ public:
               idx.bindset = (int32_t)set;
               idx.bind = (int32_t)bind;
               idx.arrayIndex = 0;
-              bufferCache[idx].assign(curInline.data() + curSlots->inlineOffset, descriptorCount);
+              m_Shared->bufferCache[idx].assign(curInline.data() + curSlots->inlineOffset, descriptorCount);
               break;
             }
             case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
@@ -318,6 +318,23 @@ public:
     }
   }
 
+  // creates a wrapper for another invocation in the same event, re-using the descriptor and push
+  // constant snapshot rather than fetching it again. The buffer cache and the dirty state are
+  // shared with the original. Objects owned by a wrapper like the sample views and bias samplers
+  // are not shared, they are created on demand.
+  VulkanAPIWrapper(const VulkanAPIWrapper &o)
+      : m_DescSets(o.m_DescSets),
+        builtin_inputs(o.builtin_inputs),
+        m_pDriver(o.m_pDriver),
+        m_DebugData(o.m_DebugData),
+        m_Creation(o.m_Creation),
+        m_Shared(o.m_Shared),
+        m_EventID(o.m_EventID),
+        pushData(o.pushData)
+  {
+    m_Shared->refCount++;
+  }
+
   ~VulkanAPIWrapper()
   {
     m_pDriver->FlushQ();
@@ -327,18 +344,21 @@ public:
       m_pDriver->vkDestroyImageView(dev, it->second, NULL);
     for(auto it = m_BiasSamplers.begin(); it != m_BiasSamplers.end(); it++)
       m_pDriver->vkDestroySampler(dev, it->second, NULL);
+
+    if(--m_Shared->refCount == 0)
+      delete m_Shared;
   }
 
   void ResetReplay()
   {
-    if(!m_ResourcesDirty)
+    if(!m_Shared->resourcesDirty)
     {
       VkMarkerRegion region("ResetReplay");
       // replay the draw to get back to 'normal' state for this event, and mark that we need to
       // replay back to pristine state next time we need to fetch data.
       m_pDriver->ReplayLog(0, m_EventID, eReplay_OnlyDraw);
     }
-    m_ResourcesDirty = true;
+    m_Shared->resourcesDirty = true;
   }
 
   virtual void AddDebugMessage(MessageCategory c, MessageSeverity sv, MessageSource src,
@@ -1463,7 +1483,17 @@ private:
   ShaderDebugData &m_DebugData;
   VulkanCreationInfo &m_Creation;
 
-  bool m_ResourcesDirty = false;
+  // state for the event rather than the invocation, shared by all copies of a wrapper. Whether
+  // the draw's side-effects are present applies to all of them, and buffer contents are only
+  // fetched once.
+  struct SharedState
+  {
+    int32_t refCount = 1;
+    bool resourcesDirty = false;
+    std::map<BindpointIndex, bytebuf> bufferCache;
+  };
+
+  SharedState *m_Shared = NULL;
   uint32_t m_EventID;
 
   std::map<ResourceId, VkImageView> m_SampleViews;
@@ -1473,8 +1503,6 @@ private:
 
   bytebuf pushData;
 
-  std::map<BindpointIndex, bytebuf> bufferCache;
-
   struct ImageData
   {
     uint32_t width = 0, height = 0, depth = 0;
@@ -1562,7 +1590,7 @@ private:
 
   bytebuf &PopulateBuffer(BindpointIndex bind)
   {
-    auto insertIt = bufferCache.insert(std::make_pair(bind, bytebuf()));
+    auto insertIt = m_Shared->bufferCache.insert(std::make_pair(bind, bytebuf()));
     bytebuf &data = insertIt.first->second;
     if(insertIt.second)
     {
@@ -1579,11 +1607,11 @@ private:
         {
           // if the resources might be dirty from side-effects from the draw, replay back to right
           // before it.
-          if(m_ResourcesDirty)
+          if(m_Shared->resourcesDirty)
           {
             VkMarkerRegion region("un-dirtying resources");
             m_pDriver->ReplayLog(0, m_EventID, eReplay_WithoutDraw);
-            m_ResourcesDirty = false;
+            m_Shared->resourcesDirty = false;
           }
 
           if(bufData.buffer != VK_NULL_HANDLE)
@@ -1611,11 +1639,11 @@ private:
       {
         // if the resources might be dirty from side-effects from the draw, replay back to right
         // before it.
-        if(m_ResourcesDirty)
+        if(m_Shared->resourcesDirty)
         {
           VkMarkerRegion region("un-dirtying resources");
           m_pDriver->ReplayLog(0, m_EventID, eReplay_WithoutDraw);
-          m_ResourcesDirty = false;
+          m_Shared->resourcesDirty = false;
         }
 
         if(imgData.imageView != VK_NULL_HANDLE)
@@ -2820,6 +2848,8 @@ enum class InputSpecConstant
   ArrayLength,
   DestX,
   DestY,
+  DestMaxX,
+  DestMaxY,
   AddressMSB,
   Count,
 };
@@ -2836,6 +2866,70 @@ struct PSHit
   // PSInput base, ddx, ....
 };
 
+// if we encounter multiple hits at our destination pixel co-ord (or any other) we check to see if a
+// specific primitive was requested (via primitive parameter not being set to ~0U). If it was, debug
+// that pixel, otherwise do a best-estimate of which fragment was the last to successfully depth
+// test and debug that, just by checking if the depth test is ordered and picking the final fragment
+// in the series
+static bool IsBetterPSHit(const PSHit *winner, const PSHit *hit, uint32_t sample,
+                          uint32_t primitive, VkCompareOp depthOp)
+{
+  // if there's no previous winner it's clearly better
+  if(winner == NULL)
+    return true;
+
+  // if we're looking for a specific primitive
+  if(primitive != ~0U)
+  {
+    // and this hit is a match and the winner isn't, it's better
+    if(winner->prim != primitive && hit->prim == primitive)
+      return true;
+
+    // if the winner is a match and we're not, we can't be better so stop now
+    if(winner->prim == primitive && hit->prim != primitive)
+      return false;
+  }
+
+  // if we're looking for a particular sample, check that
+  if(sample != ~0U)
+  {
+    if(winner->sample != sample && hit->sample == sample)
+      return true;
+
+    if(winner->sample == sample && hit->sample != sample)
+      return false;
+  }
+
+  // otherwise apply depth test
+  switch(depthOp)
+  {
+    case VK_COMPARE_OP_NEVER:
+    case VK_COMPARE_OP_EQUAL:
+    case VK_COMPARE_OP_NOT_EQUAL:
+    case VK_COMPARE_OP_ALWAYS:
+    default:
+      // don't emulate equal or not equal since we don't know the reference value. Take any hit
+      // (thus meaning the last hit)
+      return true;
+    case VK_COMPARE_OP_LESS: return hit->pos.z < winner->pos.z;
+    case VK_COMPARE_OP_LESS_OR_EQUAL: return hit->pos.z <= winner->pos.z;
+    case VK_COMPARE_OP_GREATER: return hit->pos.z > winner->pos.z;
+    case VK_COMPARE_OP_GREATER_OR_EQUAL: return hit->pos.z >= winner->pos.z;
+  }
+}
+
+static rdcarray<ShaderDebugTrace *> EmptyPixelTraces(size_t count)
+{
+  rdcarray<ShaderDebugTrace *> ret;
+  for(size_t i = 0; i < count; i++)
+  {
+    ShaderDebugTrace *trace = new ShaderDebugTrace;
+    trace->stage = ShaderStage::Pixel;
+    ret.push_back(trace);
+  }
+  return ret;
+}
+
 static void CreatePSInputFetcher(rdcarray<uint32_t> &fragspv, uint32_t &structStride,
                                  VulkanCreationInfo::ShaderModuleReflection &shadRefl,
                                  const uint32_t paramAlign, StorageMode storageMode,
@@ -3148,6 +3242,19 @@ static void CreatePSInputFetcher(rdcarray<uint32_t> &fragspv, uint32_t &structSt
 
   editor.SetName(destXY, "destXY");
 
+  rdcspv::Id destMaxX =
+      editor.AddSpecConstantImmediate<float>(0.0f, (uint32_t)InputSpecConstant::DestMaxX);
+  rdcspv::Id destMaxY =
+      editor.AddSpecConstantImmediate<float>(0.0f, (uint32_t)InputSpecConstant::DestMaxY);
+
+  editor.SetName(destMaxX, "destMaxX");
+  editor.SetName(destMaxY, "destMaxY");
+
+  rdcspv::Id destMaxXY = editor.AddConstant(
+      rdcspv::OpSpecConstantComposite(float2Type, editor.MakeId(), {destMaxX, destMaxY}));
+
+  editor.SetName(destMaxXY, "destMaxXY");
+
   rdcspv::Id PSHit = editor.DeclareStructType({
       // float4 pos;
       float4Type,
@@ -3373,8 +3480,6 @@ static void CreatePSInputFetcher(rdcarray<uint32_t> &fragspv, uint32_t &structSt
   rdcspv::Id uint32BufPtr = editor.DeclareType(rdcspv::Pointer(uint32Type, bufferClass));
   rdcspv::Id floatBufPtr = editor.DeclareType(rdcspv::Pointer(floatType, bufferClass));
 
-  rdcspv::Id glsl450 = editor.ImportExtInst("GLSL.std.450");
-
   editor.AddCapability(rdcspv::Capability::DerivativeControl);
 
   {
@@ -3511,26 +3616,21 @@ static void CreatePSInputFetcher(rdcarray<uint32_t> &fragspv, uint32_t &structSt
       rdcspv::Id fragXY = ops.add(rdcspv::OpVectorShuffle(
           float2Type, editor.MakeId(), fragCoordLoaded, fragCoordLoaded, {0, 1}));
 
-      // subtract from the destination co-ord
-      rdcspv::Id fragXYRelative =
-          ops.add(rdcspv::OpFSub(float2Type, editor.MakeId(), fragXY, destXY));
-
-      // abs()
-      rdcspv::Id fragXYAbs = ops.add(rdcspv::OpGLSL450(float2Type, editor.MakeId(), glsl450,
-                                                       rdcspv::GLSLstd450::FAbs, {fragXYRelative}));
+      // at or after the top-left of the destination rect
+      rdcspv::Id afterMin =
+          ops.add(rdcspv::OpFOrdGreaterThanEqual(bool2Type, editor.MakeId(), fragXY, destXY));
 
-      rdcspv::Id half = editor.AddConstantImmediate<float>(0.5f);
-      rdcspv::Id threshold =
-          editor.AddConstant(rdcspv::OpConstantComposite(float2Type, editor.MakeId(), {half, half}));
+      // before the bottom-right of the destination rect
+      rdcspv::Id beforeMax =
+          ops.add(rdcspv::OpFOrdLessThan(bool2Type, editor.MakeId(), fragXY, destMaxXY));
 
-      // less than 0.5
-      rdcspv::Id inPixelXY =
-          ops.add(rdcspv::OpFOrdLessThan(bool2Type, editor.MakeId(), fragXYAbs, threshold));
+      rdcspv::Id inRectXY =
+          ops.add(rdcspv::OpLogicalAnd(bool2Type, editor.MakeId(), afterMin, beforeMax));
 
-      // both less than 0.5
-      rdcspv::Id inPixel = ops.add(rdcspv::OpAll(boolType, editor.MakeId(), inPixelXY));
+      // inside on both axes
+      rdcspv::Id inPixel = ops.add(rdcspv::OpAll(boolType, editor.MakeId(), inRectXY));
 
-      // bool inPixel = all(abs(gl_FragCoord.xy - dest.xy) < 0.5f);
+      // bool inPixel = all(gl_FragCoord.xy >= destMin.xy && gl_FragCoord.xy < destMax.xy);
 
       rdcspv::Id killLabel = editor.MakeId();
       rdcspv::Id continueLabel = editor.MakeId();
@@ -3899,16 +3999,33 @@ ShaderDebugTrace *VulkanReplay::DebugVertex(uint32_t eventId, uint32_t vertid, u
 ShaderDebugTrace *VulkanReplay::DebugPixel(uint32_t eventId, uint32_t x, uint32_t y,
                                            uint32_t sample, uint32_t primitive)
 {
+  DebugPixelInputs pixel;
+  pixel.x = x;
+  pixel.y = y;
+  pixel.sample = sample;
+  pixel.primitive = primitive;
+
+  rdcarray<ShaderDebugTrace *> traces = DebugPixels(eventId, {pixel});
+
+  return traces[0];
+}
+
+rdcarray<ShaderDebugTrace *> VulkanReplay::DebugPixels(uint32_t eventId,
+                                                       const rdcarray<DebugPixelInputs> &pixels)
+{
+  if(pixels.empty())
+    return {};
+
   if(!GetAPIProperties().shaderDebugging)
   {
     RDCUNIMPLEMENTED("Pixel debugging not yet implemented for Vulkan");
-    return new ShaderDebugTrace;
+    return EmptyPixelTraces(pixels.size());
   }
 
   if(!m_pDriver->GetDeviceEnabledFeatures().fragmentStoresAndAtomics)
   {
     RDCWARN("Pixel debugging is not supported without fragment stores");
-    return new ShaderDebugTrace;
+    return EmptyPixelTraces(pixels.size());
   }
 
   VkDevice dev = m_pDriver->GetDev();
@@ -3917,8 +4034,12 @@ ShaderDebugTrace *VulkanReplay::DebugPixel(uint32_t eventId, uint32_t x, uint32_
   const VulkanRenderState &state = m_pDriver->GetRenderState();
   VulkanCreationInfo &c = m_pDriver->m_CreationInfo;
 
-  rdcstr regionName = StringFormat::Fmt("DebugPixel @ %u of (%u,%u) sample %u primitive %u",
-                                        eventId, x, y, sample, primitive);
+  rdcstr regionName;
+  if(pixels.size() == 1)
+    regionName = StringFormat::Fmt("DebugPixel @ %u of (%u,%u) sample %u primitive %u", eventId,
+                                   pixels[0].x, pixels[0].y, pixels[0].sample, pixels[0].primitive);
+  else
+    regionName = StringFormat::Fmt("DebugPixels @ %u of %zu pixels", eventId, pixels.size());
 
   VkMarkerRegion region(regionName);
 
@@ -3930,7 +4051,7 @@ ShaderDebugTrace *VulkanReplay::DebugPixel(uint32_t eventId, uint32_t x, uint32_
   if(!(draw->flags & DrawFlags::Drawcall))
   {
     RDCLOG("No drawcall selected");
-    return new ShaderDebugTrace();
+    return EmptyPixelTraces(pixels.size());
   }
 
   const VulkanCreationInfo::Pipeline &pipe = c.m_Pipeline[state.graphics.pipeline];
@@ -3938,7 +4059,7 @@ ShaderDebugTrace *VulkanReplay::DebugPixel(uint32_t eventId, uint32_t x, uint32_
   if(pipe.shaders[4].module == ResourceId())
   {
     RDCLOG("No pixel shader bound at draw");
-    return new ShaderDebugTrace();
+    return EmptyPixelTraces(pixels.size());
   }
 
   // get ourselves in pristine state before this draw (without any side effects it may have had)
@@ -3954,18 +4075,19 @@ ShaderDebugTrace *VulkanReplay::DebugPixel(uint32_t eventId, uint32_t x, uint32_
   if(!shadRefl.refl.debugInfo.debuggable)
   {
     RDCLOG("Shader is not debuggable: %s", shadRefl.refl.debugInfo.debugStatus.c_str());
-    return new ShaderDebugTrace();
+    return EmptyPixelTraces(pixels.size());
   }
 
   shadRefl.PopulateDisassembly(shader.spirv);
 
-  VulkanAPIWrapper *apiWrapper =
+  // this wrapper is never debugged itself, it holds the snapshot of the descriptors and push
+  // constants at this event that every pixel's wrapper is copied from.
+  VulkanAPIWrapper *baseWrapper =
       new VulkanAPIWrapper(m_pDriver, c, VK_SHADER_STAGE_FRAGMENT_BIT, eventId);
 
-  std::map<ShaderBuiltin, ShaderVariable> &builtins = apiWrapper->builtin_inputs;
+  std::map<ShaderBuiltin, ShaderVariable> &builtins = baseWrapper->builtin_inputs;
   builtins[ShaderBuiltin::DeviceIndex] = ShaderVariable(rdcstr(), 0U, 0U, 0U, 0U);
   builtins[ShaderBuiltin::DrawIndex] = ShaderVariable(rdcstr(), draw->drawIndex, 0U, 0U, 0U);
-  builtins[ShaderBuiltin::Position] = ShaderVariable(rdcstr(), x, y, 0U, 0U);
 
   // If the pipe contains a geometry shader, then Primitive ID cannot be used in the pixel
   // shader without being emitted from the geometry shader. For now, check if this semantic
@@ -4070,7 +4192,38 @@ ShaderDebugTrace *VulkanReplay::DebugPixel(uint32_t eventId, uint32_t x, uint32_
   if(!Vulkan_Debug_PSDebugDumpDirPath().empty())
     FileIO::WriteAll(Vulkan_Debug_PSDebugDumpDirPath() + "/debug_psinput_after.spv", fragspv);
 
-  uint32_t overdrawLevels = 100;    // maximum number of overdraw levels
+  uint32_t overdrawLevels = 100;    // maximum number of overdraw levels per pixel
+
+  // the pixels are fetched in tiles, with one draw per tile that captures the inputs for every
+  // fragment in the rect bounding the tile's pixels. Keeping the tiles small keeps the worst-case
+  // hit storage bounded, since unrequested pixels inside the rect still consume hit slots.
+  const uint32_t tileSize = 8;
+
+  struct PixelTile
+  {
+    uint32_t minX = ~0U, minY = ~0U;
+    uint32_t maxX = 0, maxY = 0;
+    rdcarray<size_t> pixels;
+  };
+
+  std::map<rdcpair<uint32_t, uint32_t>, PixelTile> tiles;
+
+  for(size_t i = 0; i < pixels.size(); i++)
+  {
+    const DebugPixelInputs &p = pixels[i];
+
+    PixelTile &tile = tiles[make_rdcpair(p.y / tileSize, p.x / tileSize)];
+    tile.minX = RDCMIN(tile.minX, p.x);
+    tile.minY = RDCMIN(tile.minY, p.y);
+    tile.maxX = RDCMAX(tile.maxX, p.x + 1);
+    tile.maxY = RDCMAX(tile.maxY, p.y + 1);
+    tile.pixels.push_back(i);
+  }
+
+  uint32_t maxTileArea = 1;
+  for(auto it = tiles.begin(); it != tiles.end(); ++it)
+    maxTileArea = RDCMAX(maxTileArea,
+                         (it->second.maxX - it->second.minX) * (it->second.maxY - it->second.minY));
 
   VkGraphicsPipelineCreateInfo graphicsInfo = {};
 
@@ -4079,12 +4232,13 @@ ShaderDebugTrace *VulkanReplay::DebugPixel(uint32_t eventId, uint32_t x, uint32_
   // struct size is PSHit header plus 5x structStride = base, ddxcoarse, ddycoarse, ddxfine, ddyfine
   uint32_t structSize = sizeof(PSHit) + structStride * 5;
 
-  VkDeviceSize feedbackStorageSize = overdrawLevels * structSize + sizeof(Vec4f) + 1024;
+  VkDeviceSize feedbackStorageSize =
+      overdrawLevels * maxTileArea * structSize + sizeof(Vec4f) + 1024;
 
   if(Vulkan_Debug_ShaderDebugLogging())
   {
-    RDCLOG("Output structure is %u sized, output buffer is %llu bytes", structStride,
-           feedbackStorageSize);
+    RDCLOG("Output structure is %u sized, output buffer is %llu bytes for %zu tiles", structStride,
+           feedbackStorageSize, tiles.size());
   }
 
   if(feedbackStorageSize > m_BindlessFeedback.FeedbackBuffer.sz)
@@ -4104,12 +4258,10 @@ ShaderDebugTrace *VulkanReplay::DebugPixel(uint32_t eventId, uint32_t x, uint32_
     uint32_t arrayLength;
     float destX;
     float destY;
+    float destMaxX;
+    float destMaxY;
   } specData = {};
 
-  specData.arrayLength = overdrawLevels;
-  specData.destX = float(x) + 0.5f;
-  specData.destY = float(y) + 0.5f;
-
   VkDescriptorPool descpool = VK_NULL_HANDLE;
   rdcarray<VkDescriptorSetLayout> setLayouts;
   rdcarray<VkDescriptorSet> descSets;
@@ -4151,12 +4303,9 @@ ShaderDebugTrace *VulkanReplay::DebugPixel(uint32_t eventId, uint32_t x, uint32_
     // if the pool failed due to limits, it will be NULL so bail now
     if(descpool == VK_NULL_HANDLE)
     {
-      delete apiWrapper;
-
-      ShaderDebugTrace *ret = new ShaderDebugTrace;
-      ret->stage = ShaderStage::Pixel;
+      delete baseWrapper;
 
-      return ret;
+      return EmptyPixelTraces(pixels.size());
     }
 
     // create pipeline layout with new descriptor set layouts
@@ -4215,6 +4364,14 @@ ShaderDebugTrace *VulkanReplay::DebugPixel(uint32_t eventId, uint32_t x, uint32_
       {
           (uint32_t)InputSpecConstant::DestY, offsetof(SpecData, destY), sizeof(SpecData::destY),
       },
+      {
+          (uint32_t)InputSpecConstant::DestMaxX, offsetof(SpecData, destMaxX),
+          sizeof(SpecData::destMaxX),
+      },
+      {
+          (uint32_t)InputSpecConstant::DestMaxY, offsetof(SpecData, destMaxY),
+          sizeof(SpecData::destMaxY),
+      },
       {
           (uint32_t)InputSpecConstant::AddressMSB, offsetof(SpecData, bufferAddress) + 4,
           sizeof(uint32_t),
@@ -4294,213 +4451,199 @@ ShaderDebugTrace *VulkanReplay::DebugPixel(uint32_t eventId, uint32_t x, uint32_
     }
   }
 
-  // we don't use a pipeline cache here because our spec constants will cause failures often and
-  // bloat the cache. Even if we avoided the high-frequency x/y and stored them e.g. in the feedback
-  // buffer, we'd still want to spec-constant the address when possible so we're always going to
-  // have some varying value.
-  VkPipeline inputsPipe;
-  vkr = m_pDriver->vkCreateGraphicsPipelines(dev, NULL, 1, &graphicsInfo, NULL, &inputsPipe);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-  // make copy of state to draw from
-  VulkanRenderState modifiedstate = state;
-
-  // bind created pipeline to partial replay state
-  modifiedstate.graphics.pipeline = GetResID(inputsPipe);
+  VkCompareOp depthOp = state.depthCompareOp;
 
-  if(storageMode == Binding)
-  {
-    // Treplace descriptor set IDs with our temporary sets. The offsets we keep the same. If the
-    // original draw had no sets, we ensure there's room (with no offsets needed)
-    if(modifiedstate.graphics.descSets.empty())
-      modifiedstate.graphics.descSets.resize(1);
+  // depth tests disabled acts the same as always compare mode
+  if(!state.depthTestEnable)
+    depthOp = VK_COMPARE_OP_ALWAYS;
 
-    for(size_t i = 0; i < descSets.size(); i++)
-    {
-      modifiedstate.graphics.descSets[i].pipeLayout = GetResID(pipeLayout);
-      modifiedstate.graphics.descSets[i].descSet = GetResID(descSets[i]);
-    }
-  }
+  // the winning hit for each pixel, copied out of the readback since the feedback buffer is
+  // re-used for each tile.
+  rdcarray<bytebuf> winners;
+  winners.resize(pixels.size());
 
+  for(auto tileIt = tiles.begin(); tileIt != tiles.end(); ++tileIt)
   {
-    VkCommandBuffer cmd = m_pDriver->GetNextCmd();
-
-    VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
-                                          VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
-
-    vkr = ObjDisp(dev)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+    const PixelTile &tile = tileIt->second;
+
+    specData.arrayLength = overdrawLevels * (tile.maxX - tile.minX) * (tile.maxY - tile.minY);
+    specData.destX = float(tile.minX);
+    specData.destY = float(tile.minY);
+    specData.destMaxX = float(tile.maxX);
+    specData.destMaxY = float(tile.maxY);
+
+    // we don't use a pipeline cache here because our spec constants will cause failures often and
+    // bloat the cache. Even if we avoided the high-frequency x/y and stored them e.g. in the
+    // feedback buffer, we'd still want to spec-constant the address when possible so we're always
+    // going to have some varying value.
+    VkPipeline inputsPipe;
+    vkr = m_pDriver->vkCreateGraphicsPipelines(dev, NULL, 1, &graphicsInfo, NULL, &inputsPipe);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    // fill destination buffer with 0s to ensure a baseline to then feedback against
-    ObjDisp(dev)->CmdFillBuffer(Unwrap(cmd), Unwrap(m_BindlessFeedback.FeedbackBuffer.buf), 0,
-                                feedbackStorageSize, 0);
-
-    VkBufferMemoryBarrier feedbackbufBarrier = {
-        VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-        NULL,
-        VK_ACCESS_TRANSFER_WRITE_BIT,
-        VK_ACCESS_SHADER_WRITE_BIT,
-        VK_QUEUE_FAMILY_IGNORED,
-        VK_QUEUE_FAMILY_IGNORED,
-        Unwrap(m_BindlessFeedback.FeedbackBuffer.buf),
-        0,
-        feedbackStorageSize,
-    };
-
-    // wait for the above fill to finish.
-    DoPipelineBarrier(cmd, 1, &feedbackbufBarrier);
+    // make copy of state to draw from
+    VulkanRenderState modifiedstate = state;
 
-    modifiedstate.BeginRenderPassAndApplyState(m_pDriver, cmd, VulkanRenderState::BindGraphics);
+    // bind created pipeline to partial replay state
+    modifiedstate.graphics.pipeline = GetResID(inputsPipe);
 
-    m_pDriver->ReplayDraw(cmd, *draw);
+    if(storageMode == Binding)
+    {
+      // Treplace descriptor set IDs with our temporary sets. The offsets we keep the same. If the
+      // original draw had no sets, we ensure there's room (with no offsets needed)
+      if(modifiedstate.graphics.descSets.empty())
+        modifiedstate.graphics.descSets.resize(1);
 
-    modifiedstate.EndRenderPass(cmd);
+      for(size_t i = 0; i < descSets.size(); i++)
+      {
+        modifiedstate.graphics.descSets[i].pipeLayout = GetResID(pipeLayout);
+        modifiedstate.graphics.descSets[i].descSet = GetResID(descSets[i]);
+      }
+    }
 
-    vkr = ObjDisp(dev)->EndCommandBuffer(Unwrap(cmd));
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    {
+      VkCommandBuffer cmd = m_pDriver->GetNextCmd();
 
-    m_pDriver->SubmitCmds();
-    m_pDriver->FlushQ();
-  }
+      VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+                                            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
 
-  bytebuf data;
-  GetBufferData(GetResID(m_BindlessFeedback.FeedbackBuffer.buf), 0, 0, data);
+      vkr = ObjDisp(dev)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  byte *base = data.data();
-  uint32_t numHits = ((uint32_t *)base)[0];
-  uint32_t totalHits = ((uint32_t *)base)[1];
+      // fill destination buffer with 0s to ensure a baseline to then feedback against
+      ObjDisp(dev)->CmdFillBuffer(Unwrap(cmd), Unwrap(m_BindlessFeedback.FeedbackBuffer.buf), 0,
+                                  feedbackStorageSize, 0);
 
-  if(numHits > overdrawLevels)
-  {
-    RDCERR("%u hits, more than max overdraw levels allowed %u. Clamping", numHits, overdrawLevels);
-    numHits = overdrawLevels;
-  }
+      VkBufferMemoryBarrier feedbackbufBarrier = {
+          VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+          NULL,
+          VK_ACCESS_TRANSFER_WRITE_BIT,
+          VK_ACCESS_SHADER_WRITE_BIT,
+          VK_QUEUE_FAMILY_IGNORED,
+          VK_QUEUE_FAMILY_IGNORED,
+          Unwrap(m_BindlessFeedback.FeedbackBuffer.buf),
+          0,
+          feedbackStorageSize,
+      };
 
-  base += sizeof(Vec4f);
+      // wait for the above fill to finish.
+      DoPipelineBarrier(cmd, 1, &feedbackbufBarrier);
 
-  PSHit *winner = NULL;
+      modifiedstate.BeginRenderPassAndApplyState(m_pDriver, cmd, VulkanRenderState::BindGraphics);
 
-  RDCLOG("Got %u hit candidates out of %u total instances", numHits, totalHits);
+      m_pDriver->ReplayDraw(cmd, *draw);
 
-  // if we encounter multiple hits at our destination pixel co-ord (or any other) we
-  // check to see if a specific primitive was requested (via primitive parameter not
-  // being set to ~0U). If it was, debug that pixel, otherwise do a best-estimate
-  // of which fragment was the last to successfully depth test and debug that, just by
-  // checking if the depth test is ordered and picking the final fragment in the series
+      modifiedstate.EndRenderPass(cmd);
 
-  // figure out the TL pixel's coords. Assume even top left (towards 0,0)
-  // this isn't spec'd but is a reasonable assumption.
-  int xTL = x & (~1);
-  int yTL = y & (~1);
+      vkr = ObjDisp(dev)->EndCommandBuffer(Unwrap(cmd));
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  // get the index of our desired pixel
-  int destIdx = (x - xTL) + 2 * (y - yTL);
+      m_pDriver->SubmitCmds();
+      m_pDriver->FlushQ();
+    }
 
-  VkCompareOp depthOp = state.depthCompareOp;
+    // delete pipeline
+    m_pDriver->vkDestroyPipeline(dev, inputsPipe, NULL);
 
-  // depth tests disabled acts the same as always compare mode
-  if(!state.depthTestEnable)
-    depthOp = VK_COMPARE_OP_ALWAYS;
+    bytebuf data;
+    GetBufferData(GetResID(m_BindlessFeedback.FeedbackBuffer.buf), 0, 0, data);
 
-  for(uint32_t i = 0; i < numHits; i++)
-  {
-    PSHit *hit = (PSHit *)(base + structSize * i);
+    byte *base = data.data();
+    uint32_t numHits = ((uint32_t *)base)[0];
+    uint32_t totalHits = ((uint32_t *)base)[1];
 
-    if(hit->valid != validMagicNumber)
+    if(numHits > specData.arrayLength)
     {
-      RDCWARN("Hit %u doesn't have valid magic number", i);
-      continue;
+      RDCERR("%u hits, more than max overdraw levels allowed %u. Clamping", numHits,
+             specData.arrayLength);
+      numHits = specData.arrayLength;
     }
 
-    if(hit->ddxDerivCheck != 1.0f)
-    {
-      RDCWARN("Hit %u doesn't have valid derivatives", i);
-      continue;
-    }
+    base += sizeof(Vec4f);
 
-    // see if this hit is a closer match than the previous winner.
+    rdcarray<PSHit *> tileWinners;
+    tileWinners.resize(tile.pixels.size());
 
-    // if there's no previous winner it's clearly better
-    if(winner == NULL)
-    {
-      winner = hit;
-      continue;
-    }
+    RDCLOG("Got %u hit candidates out of %u total instances", numHits, totalHits);
 
-    // if we're looking for a specific primitive
-    if(primitive != ~0U)
+    for(uint32_t i = 0; i < numHits; i++)
     {
-      // and this hit is a match and the winner isn't, it's better
-      if(winner->prim != primitive && hit->prim == primitive)
-      {
-        winner = hit;
-        continue;
-      }
+      PSHit *hit = (PSHit *)(base + structSize * i);
 
-      // if the winner is a match and we're not, we can't be better so stop now
-      if(winner->prim == primitive && hit->prim != primitive)
+      if(hit->valid != validMagicNumber)
       {
+        RDCWARN("Hit %u doesn't have valid magic number", i);
         continue;
       }
-    }
 
-    // if we're looking for a particular sample, check that
-    if(sample != ~0U)
-    {
-      if(winner->sample != sample && hit->sample == sample)
+      if(hit->ddxDerivCheck != 1.0f)
       {
-        winner = hit;
+        RDCWARN("Hit %u doesn't have valid derivatives", i);
         continue;
       }
 
-      if(winner->sample == sample && hit->sample != sample)
+      // the rect may contain pixels that weren't requested, and the same pixel may be requested
+      // more than once with different samples or primitives.
+      uint32_t hitX = (uint32_t)hit->pos.x;
+      uint32_t hitY = (uint32_t)hit->pos.y;
+
+      for(size_t p = 0; p < tile.pixels.size(); p++)
       {
-        continue;
+        const DebugPixelInputs &pixel = pixels[tile.pixels[p]];
+
+        if(pixel.x != hitX || pixel.y != hitY)
+          continue;
+
+        // see if this hit is a closer match than the previous winner.
+        if(IsBetterPSHit(tileWinners[p], hit, pixel.sample, pixel.primitive, depthOp))
+          tileWinners[p] = hit;
       }
     }
 
-    // otherwise apply depth test
-    switch(depthOp)
+    for(size_t p = 0; p < tile.pixels.size(); p++)
     {
-      case VK_COMPARE_OP_NEVER:
-      case VK_COMPARE_OP_EQUAL:
-      case VK_COMPARE_OP_NOT_EQUAL:
-      case VK_COMPARE_OP_ALWAYS:
-      default:
-        // don't emulate equal or not equal since we don't know the reference value. Take any hit
-        // (thus meaning the last hit)
-        winner = hit;
-        break;
-      case VK_COMPARE_OP_LESS:
-        if(hit->pos.z < winner->pos.z)
-          winner = hit;
-        break;
-      case VK_COMPARE_OP_LESS_OR_EQUAL:
-        if(hit->pos.z <= winner->pos.z)
-          winner = hit;
-        break;
-      case VK_COMPARE_OP_GREATER:
-        if(hit->pos.z > winner->pos.z)
-          winner = hit;
-        break;
-      case VK_COMPARE_OP_GREATER_OR_EQUAL:
-        if(hit->pos.z >= winner->pos.z)
-          winner = hit;
-        break;
+      if(tileWinners[p])
+        winners[tile.pixels[p]].assign((byte *)tileWinners[p], structSize);
     }
   }
 
-  ShaderDebugTrace *ret = NULL;
+  rdcarray<ShaderDebugTrace *> ret;
+  ret.resize(pixels.size());
+
+  VulkanAPIWrapper *firstWrapper = NULL;
 
-  if(winner)
+  for(size_t p = 0; p < pixels.size(); p++)
   {
+    const DebugPixelInputs &pixel = pixels[p];
+
+    if(winners[p].empty())
+    {
+      RDCLOG("Didn't get any valid hit to debug at (%u,%u)", pixel.x, pixel.y);
+
+      ret[p] = new ShaderDebugTrace;
+      ret[p]->stage = ShaderStage::Pixel;
+      continue;
+    }
+
+    VulkanAPIWrapper *apiWrapper = new VulkanAPIWrapper(*baseWrapper);
+
+    apiWrapper->builtin_inputs[ShaderBuiltin::Position] =
+        ShaderVariable(rdcstr(), pixel.x, pixel.y, 0U, 0U);
+
+    // figure out the TL pixel's coords. Assume even top left (towards 0,0)
+    // this isn't spec'd but is a reasonable assumption.
+    int xTL = pixel.x & (~1);
+    int yTL = pixel.y & (~1);
+
+    // get the index of our desired pixel
+    int destIdx = (pixel.x - xTL) + 2 * (pixel.y - yTL);
+
     rdcspv::Debugger *debugger = new rdcspv::Debugger;
     debugger->Parse(shader.spirv.GetSPIRV());
 
     // the data immediately follows the PSHit header. Every piece of data is uniformly aligned,
     // either 16-byte by default or 32-byte if larger components exist. The output is in input
     // signature order.
-    byte *PSInputs = (byte *)(winner + 1);
+    byte *PSInputs = (byte *)(((PSHit *)winners[p].data()) + 1);
     byte *value = (byte *)(PSInputs + 0 * structStride);
     byte *ddxcoarse = (byte *)(PSInputs + 1 * structStride);
     byte *ddycoarse = (byte *)(PSInputs + 2 * structStride);
@@ -4539,19 +4682,20 @@ ShaderDebugTrace *VulkanReplay::DebugPixel(uint32_t eventId, uint32_t x, uint32_
       memcpy(((byte *)deriv.ddyfine.value.u64v) + elemSize * comp, ddyfine + i * paramAlign, sz);
     }
 
-    ret = debugger->BeginDebug(apiWrapper, ShaderStage::Pixel, entryPoint, spec,
-                               shadRefl.instructionLines, shadRefl.patchData, destIdx);
-    apiWrapper->ResetReplay();
-  }
-  else
-  {
-    RDCLOG("Didn't get any valid hit to debug");
-    delete apiWrapper;
+    ret[p] = debugger->BeginDebug(apiWrapper, ShaderStage::Pixel, entryPoint, spec,
+                                  shadRefl.instructionLines, shadRefl.patchData, destIdx);
 
-    ret = new ShaderDebugTrace;
-    ret->stage = ShaderStage::Pixel;
+    if(firstWrapper == NULL)
+      firstWrapper = apiWrapper;
   }
 
+  // every trace has been set up against the pristine state. The wrappers share their dirty state
+  // so replaying the draw once is seen by all of them
+  if(firstWrapper)
+    firstWrapper->ResetReplay();
+
+  delete baseWrapper;
+
   if(descpool != VK_NULL_HANDLE)
   {
     // delete descriptors. Technically we don't have to free the descriptor sets, but our tracking
@@ -4567,9 +4711,6 @@ ShaderDebugTrace *VulkanReplay::DebugPixel(uint32_t eventId, uint32_t x, uint32_
   // delete pipeline layout
   m_pDriver->vkDestroyPipelineLayout(dev, pipeLayout, NULL);
 
-  // delete pipeline
-  m_pDriver->vkDestroyPipeline(dev, inputsPipe, NULL);
-
   // delete shader modules
   for(VkShaderModule s : modules)
     m_pDriver->vkDestroyShaderModule(dev, s, NULL);
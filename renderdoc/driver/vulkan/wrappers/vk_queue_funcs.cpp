@@ -1033,9 +1033,6 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
             continue;
           }
 
-          size_t diffStart = 0, diffEnd = 0;
-          bool found = true;
-
           // this causes vkFlushMappedMemoryRanges call to allocate and copy to refData
           // from serialised buffer. We want to copy *precisely* the serialised data,
           // otherwise there is a gap in time between serialising out a snapshot of
@@ -1055,6 +1052,40 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
           // shouldn't miss anything
           state.needRefData = true;
 
+          // the ranges of the map that could have changed since the last flush. With a write watch
+          // this is only the pages that were written, and we fetch them before reading anything so
+          // that any write from here on is caught at the next flush. The first flush serialises the
+          // whole map and starts watching it.
+          rdcarray<rdcpair<size_t, size_t>> ranges;
+
+          if(state.writeWatch)
+          {
+            bool watched = state.refData
+                               ? Process::FetchWrittenRanges(state.writeWatch, ranges)
+                               : Process::ResetWriteWatch(state.writeWatch, true);
+
+            if(!watched)
+            {
+              RDCWARN("Write watch failed for %s, falling back to comparisons",
+                      ToStr(record->GetResourceID()).c_str());
+              Process::UnregisterWriteWatch(state.writeWatch);
+              state.writeWatch = 0;
+            }
+          }
+
+          if(!state.writeWatch || !state.refData)
+          {
+            ranges.clear();
+            ranges.push_back({0, (size_t)state.mapSize});
+          }
+
+          if(ranges.empty())
+          {
+            RDCDEBUG("Persistent map flush not needed for %s, nothing written",
+                     ToStr(record->GetResourceID()).c_str());
+            continue;
+          }
+
           if(state.readbackOnGPU)
           {
             RDCDEBUG("Reading back %s with GPU for comparison",
@@ -1124,45 +1155,53 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
             state.cpuReadPtr = state.mappedPtr;
           }
 
-          // if we have a previous set of data, compare.
-          // otherwise just serialise it all
-          if(state.refData)
-            found = FindDiffRange(((byte *)state.cpuReadPtr) + state.mapOffset, state.refData,
-                                  (size_t)state.mapSize, diffStart, diffEnd);
-          else
-            diffEnd = (size_t)state.mapSize;
-
-          // sanitise diff start/end. Since the mapped pointer might be written on another thread
-          // (or even the GPU) this could cause a difference to appear and disappear transiently. In
-          // this case FindDiffRange could find the difference when locating the start but not find
-          // it when locating the end. In this case we don't need to write the difference (the
-          // application is responsible for ensuring it's not writing to memory the GPU might need)
-          if(diffEnd <= diffStart)
-            found = false;
+          // MULTIDEVICE should find the device for this queue.
+          // MULTIDEVICE only want to flush maps associated with this queue
+          VkDevice dev = GetDev();
 
-          if(found)
+          for(const rdcpair<size_t, size_t> &range : ranges)
           {
-            // MULTIDEVICE should find the device for this queue.
-            // MULTIDEVICE only want to flush maps associated with this queue
-            VkDevice dev = GetDev();
+            size_t diffStart = range.first, diffEnd = range.second;
+            bool found = true;
+
+            // if we have a previous set of data, compare.
+            // otherwise just serialise it all
+            if(state.refData)
+            {
+              found = FindDiffRange(((byte *)state.cpuReadPtr) + state.mapOffset + range.first,
+                                    state.refData + range.first, range.second - range.first,
+                                    diffStart, diffEnd);
+              diffStart += range.first;
+              diffEnd += range.first;
+            }
+
+            // sanitise diff start/end. Since the mapped pointer might be written on another thread
+            // (or even the GPU) this could cause a difference to appear and disappear transiently.
+            // In this case FindDiffRange could find the difference when locating the start but not
+            // find it when locating the end. In this case we don't need to write the difference
+            // (the application is responsible for ensuring it's not writing to memory the GPU
+            // might need)
+            if(diffEnd <= diffStart)
+              found = false;
 
+            if(found)
             {
               RDCLOG("Persistent map flush forced for %s (%llu -> %llu)",
                      ToStr(record->GetResourceID()).c_str(), (uint64_t)diffStart, (uint64_t)diffEnd);
-              VkMappedMemoryRange range = {
+              VkMappedMemoryRange flushRange = {
                   VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
                   &internalMemoryFlushMarker,
                   (VkDeviceMemory)(uint64_t)record->Resource,
                   state.mapOffset + diffStart,
                   diffEnd - diffStart,
               };
-              vkFlushMappedMemoryRanges(dev, 1, &range);
+              vkFlushMappedMemoryRanges(dev, 1, &flushRange);
+            }
+            else
+            {
+              RDCDEBUG("Persistent map flush not needed for %s",
+                       ToStr(record->GetResourceID()).c_str());
             }
-          }
-          else
-          {
-            RDCDEBUG("Persistent map flush not needed for %s",
-                     ToStr(record->GetResourceID()).c_str());
           }
 
           // restore this just in case
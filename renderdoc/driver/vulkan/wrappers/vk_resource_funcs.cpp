@@ -31,6 +31,12 @@ RDOC_CONFIG(bool, Vulkan_GPUReadbackDeviceLocal, true,
             "When reading back mapped device-local memory from discrete GPUs, use a GPU copy "
             "instead of a CPU side comparison directly to mapped memory.");
 
+RDOC_CONFIG(bool, Vulkan_WriteWatchCoherentMaps, false,
+            "Write-protect persistently mapped coherent memory while capturing, so that only the "
+            "pages the application writes are compared and serialised at each submit. Not "
+            "compatible with applications that pass mapped pointers to system calls or handle "
+            "SIGSEGV themselves.");
+
 /************************************************************************
  *
  * Mapping is simpler in Vulkan, at least in concept, but that comes with
@@ -627,6 +633,12 @@ void WrappedVulkan::vkFreeMemory(VkDevice device, VkDeviceMemory memory,
     if(memMapState)
     {
       // there is an implicit unmap on free, so make sure to tidy up
+      if(memMapState->writeWatch)
+      {
+        Process::UnregisterWriteWatch(memMapState->writeWatch);
+        memMapState->writeWatch = 0;
+      }
+
       if(memMapState->refData)
       {
         FreeAlignedBuffer(memMapState->refData);
@@ -702,6 +714,9 @@ VkResult WrappedVulkan::vkMapMemory(VkDevice device, VkDeviceMemory mem, VkDevic
 
       if(state.mapCoherent)
       {
+        if(Vulkan_WriteWatchCoherentMaps())
+          state.writeWatch = Process::RegisterWriteWatch(realData, (size_t)state.mapSize);
+
         SCOPED_LOCK(m_CoherentMapsLock);
         m_CoherentMaps.push_back(memrecord);
       }
@@ -856,6 +871,12 @@ void WrappedVulkan::vkUnmapMemory(VkDevice device, VkDeviceMemory mem)
         RDCERR("vkUnmapMemory for memory handle that's not currently mapped");
       else
         m_CoherentMaps.erase(idx);
+
+      if(state.writeWatch)
+      {
+        Process::UnregisterWriteWatch(state.writeWatch);
+        state.writeWatch = 0;
+      }
     }
 
     {
@@ -58,6 +58,21 @@ const char *GetEnvVariable(const char *name);
 
 uint64_t GetMemoryUsage();
 
+// write watches track which pages of a region of memory are written by the CPU. While watching,
+// the region is write-protected and the first write to each page is recorded before that page is
+// made writable again. Returns 0 if write watches aren't supported on this platform, in which case
+// callers must fall back to comparing the whole region.
+uint64_t RegisterWriteWatch(void *base, size_t size);
+void UnregisterWriteWatch(uint64_t watch);
+// forgets any recorded writes. If watching is true the whole region is write-protected so that
+// subsequent writes are recorded, otherwise it's made fully writable and nothing is recorded.
+bool ResetWriteWatch(uint64_t watch, bool watching);
+// returns the [start, end) byte ranges relative to base of pages written since the last reset or
+// fetch, and write-protects those pages again so that further writes are recorded.
+// Resetting and fetching return false if the protection couldn't be changed, in which case writes
+// may have been missed and the watch should no longer be relied upon.
+bool FetchWrittenRanges(uint64_t watch, rdcarray<rdcpair<size_t, size_t>> &ranges);
+
 bool CanGlobalHook();
 bool StartGlobalHook(const char *pathmatch, const char *capturefile, const CaptureOptions &opts);
 bool IsGlobalHookActive();
@@ -137,6 +152,25 @@ public:
   data m_Data;
 };
 
+// a counting semaphore. Wait() blocks until the count is non-zero and then decrements it, Signal()
+// increments it and wakes that many waiting threads.
+template <class data>
+class SemaphoreTemplate
+{
+public:
+  SemaphoreTemplate();
+  ~SemaphoreTemplate();
+
+  void Wait();
+  void Signal(uint32_t count);
+
+  // no copying
+  SemaphoreTemplate &operator=(const SemaphoreTemplate &other) = delete;
+  SemaphoreTemplate(const SemaphoreTemplate &other) = delete;
+
+  data m_Data;
+};
+
 void Init();
 void Shutdown();
 uint64_t AllocateTLSSlot();
@@ -144,13 +178,15 @@ uint64_t AllocateTLSSlot();
 void *GetTLSValue(uint64_t slot);
 void SetTLSValue(uint64_t slot, void *value);
 
-// must typedef CriticalSectionTemplate<X> CriticalSection
+// must typedef CriticalSectionTemplate<X> CriticalSection, RWLockTemplate<Y> RWLock and
+// SemaphoreTemplate<Z> Semaphore
 
 void SetCurrentThreadName(const rdcstr &name);
 
 typedef uint64_t ThreadHandle;
 ThreadHandle CreateThread(std::function<void()> entryFunc);
 uint64_t GetCurrentID();
+uint32_t GetNumberOfCores();
 void JoinThread(ThreadHandle handle);
 void DetachThread(ThreadHandle handle);
 void CloseThread(ThreadHandle handle);
@@ -318,6 +354,17 @@ bool feof(FILE *f);
 
 int fclose(FILE *f);
 
+// functions for mapping part of a file read-only into memory. The offset does not need to be
+// aligned to anything, the mapping is adjusted internally. The mapping is independent of the FILE
+// and remains valid after it's closed, until mmap_close is called. Ranges beyond the current end of
+// the file aren't mapped. Replacing the file (deleting or renaming over it) is safe, but on posix
+// truncating it in place while it's mapped makes reads from the lost range raise SIGBUS. Windows
+// refuses to truncate mapped files.
+struct MappedFile;
+MappedFile *mmap_open(FILE *f, uint64_t offset, uint64_t length);
+const void *mmap_data(MappedFile *mapping);
+void mmap_close(MappedFile *mapping);
+
 // functions for atomically appending to a log that may be in use in multiple
 // processes
 struct LogFileHandle;
@@ -0,0 +1,175 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include <atomic>
+#include "common/common.h"
+#include "os/os_specific.h"
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "catch/catch.hpp"
+
+TEST_CASE("Test write watches", "[osspecific]")
+{
+  const size_t size = 1024 * 1024;
+
+  // page-align the allocation and pad it so that the watched pages don't contain anything else,
+  // for any page size up to 64kB
+  const size_t allocSize = size + 128 * 1024;
+  byte *buf = AllocAlignedBuffer(allocSize, 64 * 1024);
+  memset(buf, 0, allocSize);
+
+  // watch a region that doesn't start or end on a page boundary
+  byte *base = buf + 48;
+
+  uint64_t watch = Process::RegisterWriteWatch(base, size);
+
+  // not supported on every platform
+  if(watch == 0)
+  {
+    FreeAlignedBuffer(buf);
+    return;
+  }
+
+  rdcarray<rdcpair<size_t, size_t>> ranges;
+
+  SECTION("Nothing recorded until watching")
+  {
+    base[100] = 1;
+
+    CHECK(Process::FetchWrittenRanges(watch, ranges));
+    CHECK(ranges.empty());
+  };
+
+  SECTION("Written pages are recorded once")
+  {
+    CHECK(Process::ResetWriteWatch(watch, true));
+
+    CHECK(Process::FetchWrittenRanges(watch, ranges));
+    CHECK(ranges.empty());
+
+    base[0] = 1;
+    base[1] = 2;
+    base[size - 1] = 3;
+
+    CHECK(Process::FetchWrittenRanges(watch, ranges));
+    REQUIRE(ranges.size() == 2);
+
+    // the first range is clipped to the start of the region and runs to the end of the page
+    const size_t pageSize = ranges[0].second + 48;
+    CHECK((pageSize & (pageSize - 1)) == 0);
+
+    CHECK(ranges[0].first == 0);
+    CHECK(ranges[1].first == ((size + 47) & ~(pageSize - 1)) - 48);
+    CHECK(ranges[1].second == size);
+
+    // writes are kept
+    CHECK(base[0] == 1);
+    CHECK(base[1] == 2);
+    CHECK(base[size - 1] == 3);
+
+    CHECK(Process::FetchWrittenRanges(watch, ranges));
+    CHECK(ranges.empty());
+
+    // adjacent pages are merged into a single range
+    base[pageSize * 2 - 48] = 4;
+    base[pageSize * 3 - 48] = 5;
+
+    CHECK(Process::FetchWrittenRanges(watch, ranges));
+    REQUIRE(ranges.size() == 1);
+    CHECK(ranges[0].first == pageSize * 2 - 48);
+    CHECK(ranges[0].second == pageSize * 4 - 48);
+
+    // stopping the watch makes everything writable again
+    CHECK(Process::ResetWriteWatch(watch, false));
+
+    base[2] = 6;
+
+    CHECK(Process::FetchWrittenRanges(watch, ranges));
+    CHECK(ranges.empty());
+  };
+
+  SECTION("Writes racing with a fetch are not lost")
+  {
+    CHECK(Process::ResetWriteWatch(watch, true));
+
+    // a writer thread faults on the watched pages while this thread fetches. After the two are
+    // done and everything has been fetched, the pages must be protected again so the next write is
+    // recorded - if a fetch could clear a page's flag in the middle of the fault handler, the page
+    // would be left writable and the write below would be missed.
+    const uint32_t numIterations = 2000;
+    const size_t stride = 4096;
+    const size_t numWrites = size / stride;
+
+    std::atomic<uint32_t> go(0), done(0);
+
+    Threading::ThreadHandle writer = Threading::CreateThread([&]() {
+      for(uint32_t iter = 1; iter <= numIterations; iter++)
+      {
+        while(go.load() != iter)
+          Threading::Sleep(0);
+
+        for(size_t i = 0; i < numWrites; i++)
+          base[i * stride] = byte(iter);
+
+        done.store(iter);
+      }
+    });
+
+    uint32_t missed = 0;
+
+    for(uint32_t iter = 1; iter <= numIterations; iter++)
+    {
+      go.store(iter);
+
+      while(done.load() != iter)
+        Process::FetchWrittenRanges(watch, ranges);
+
+      Process::FetchWrittenRanges(watch, ranges);
+
+      base[(iter % numWrites) * stride] = 0;
+
+      Process::FetchWrittenRanges(watch, ranges);
+      if(ranges.empty())
+        missed++;
+    }
+
+    Threading::JoinThread(writer);
+    Threading::CloseThread(writer);
+
+    CHECK(missed == 0);
+
+    CHECK(Process::ResetWriteWatch(watch, false));
+  };
+
+  Process::UnregisterWriteWatch(watch);
+
+  // memory stays writable after unregistering
+  base[3] = 7;
+  CHECK(base[3] == 7);
+
+  FreeAlignedBuffer(buf);
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
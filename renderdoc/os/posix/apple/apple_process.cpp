@@ -198,3 +198,23 @@ uint64_t Process::GetMemoryUsage()
 
   return taskInfo.resident_size;
 }
+
+uint64_t Process::RegisterWriteWatch(void *base, size_t size)
+{
+  return 0;
+}
+
+void Process::UnregisterWriteWatch(uint64_t watch)
+{
+}
+
+bool Process::ResetWriteWatch(uint64_t watch, bool watching)
+{
+  return false;
+}
+
+bool Process::FetchWrittenRanges(uint64_t watch, rdcarray<rdcpair<size_t, size_t>> &ranges)
+{
+  ranges.clear();
+  return false;
+}
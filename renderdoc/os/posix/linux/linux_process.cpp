@@ -23,6 +23,9 @@
  ******************************************************************************/
 
 #include <elf.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
 #include <sys/ptrace.h>
 #include <sys/types.h>
 #include <sys/uio.h>
@@ -31,9 +34,11 @@
 #include <time.h>
 #include <unistd.h>
 #include <algorithm>
+#include <atomic>
 #include "api/replay/data_types.h"
 #include "common/common.h"
 #include "common/formatting.h"
+#include "common/threading.h"
 #include "core/core.h"
 #include "core/settings.h"
 #include "os/os_specific.h"
@@ -682,3 +687,230 @@ uint64_t Process::GetMemoryUsage()
 
   return 0;
 }
+
+// write watches are kept in a fixed table so that the fault handler can look them up without
+// locking or allocating. Only active watches claim faults - once a watch is unregistered its
+// address range may be reused by any other mapping, and faults there must reach the old handler.
+// Writing to memory while it is being unmapped isn't valid, so a fault can't race the unregister.
+static const uint32_t MaxWriteWatches = 1024;
+
+struct WriteWatch
+{
+  // page-aligned extent of the watched memory
+  std::atomic<uintptr_t> start;
+  std::atomic<uintptr_t> end;
+  // the region as registered, that ranges are returned relative to
+  uintptr_t base;
+  size_t size;
+  // one byte per page, set by the fault handler when a page is written. Bytes rather than bits so
+  // that the handler never needs an atomic read-modify-write
+  volatile uint8_t *written;
+  size_t writtenCapacity;
+  std::atomic<bool> active;
+};
+
+static WriteWatch writeWatches[MaxWriteWatches];
+static Threading::SpinLock writeWatchLock;
+static struct sigaction oldSegvAction;
+static uintptr_t pageSize = 0;
+
+static void WriteWatchFault(int signum, siginfo_t *info, void *context)
+{
+  int saved_errno = errno;
+
+  const uintptr_t addr = (uintptr_t)info->si_addr;
+  bool handled = false;
+
+  if(info->si_code == SEGV_ACCERR)
+  {
+    for(uint32_t i = 0; i < MaxWriteWatches; i++)
+    {
+      WriteWatch &w = writeWatches[i];
+
+      if(!w.active.load(std::memory_order_acquire))
+        continue;
+
+      const uintptr_t end = w.end.load(std::memory_order_acquire);
+      const uintptr_t start = w.start.load(std::memory_order_relaxed);
+
+      if(addr < start || addr >= end)
+        continue;
+
+      handled = true;
+
+      // make the page writable before flagging it. FetchWrittenRanges clears the flag and then
+      // protects the page, so if it runs in between the page is protected again and the write
+      // faults a second time. The other order could leave a writable page with a cleared flag.
+      const uintptr_t page = addr & ~(pageSize - 1);
+      mprotect((void *)page, pageSize, PROT_READ | PROT_WRITE);
+      w.written[(page - start) / pageSize] = 1;
+    }
+  }
+
+  errno = saved_errno;
+
+  if(handled)
+    return;
+
+  // not a write to watched memory, pass it on to whoever was handling faults before us
+  if(oldSegvAction.sa_flags & SA_SIGINFO)
+  {
+    oldSegvAction.sa_sigaction(signum, info, context);
+  }
+  else if(oldSegvAction.sa_handler != SIG_DFL && oldSegvAction.sa_handler != SIG_IGN)
+  {
+    oldSegvAction.sa_handler(signum);
+  }
+  else
+  {
+    // restore the default disposition and return, so the faulting instruction runs again and
+    // crashes the way it would have without us
+    sigaction(SIGSEGV, &oldSegvAction, NULL);
+  }
+}
+
+uint64_t Process::RegisterWriteWatch(void *base, size_t size)
+{
+  if(base == NULL || size == 0)
+    return 0;
+
+  SCOPED_SPINLOCK(writeWatchLock);
+
+  if(pageSize == 0)
+  {
+    pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+
+    struct sigaction new_action = {};
+    sigemptyset(&new_action.sa_mask);
+    new_action.sa_flags = SA_SIGINFO | SA_RESTART | SA_ONSTACK;
+    new_action.sa_sigaction = &WriteWatchFault;
+
+    sigaction(SIGSEGV, &new_action, &oldSegvAction);
+  }
+
+  for(uint32_t i = 0; i < MaxWriteWatches; i++)
+  {
+    WriteWatch &w = writeWatches[i];
+
+    if(w.active.load(std::memory_order_relaxed))
+      continue;
+
+    const uintptr_t start = (uintptr_t)base & ~(pageSize - 1);
+    const uintptr_t end = AlignUp((uintptr_t)base + size, pageSize);
+    const size_t numPages = (end - start) / pageSize;
+
+    // unpublish the slot's old range before changing anything else
+    w.end.store(0, std::memory_order_release);
+
+    if(w.writtenCapacity < numPages)
+    {
+      delete[] w.written;
+      w.written = new uint8_t[numPages];
+      w.writtenCapacity = numPages;
+    }
+
+    memset((void *)w.written, 0, numPages);
+
+    w.base = (uintptr_t)base;
+    w.size = size;
+    w.start.store(start, std::memory_order_relaxed);
+    w.active.store(true, std::memory_order_relaxed);
+    w.end.store(end, std::memory_order_release);
+
+    return i + 1;
+  }
+
+  RDCWARN("Too many write watches registered, falling back to comparisons");
+
+  return 0;
+}
+
+void Process::UnregisterWriteWatch(uint64_t watch)
+{
+  if(watch == 0 || watch > MaxWriteWatches)
+    return;
+
+  SCOPED_SPINLOCK(writeWatchLock);
+
+  WriteWatch &w = writeWatches[watch - 1];
+
+  const uintptr_t start = w.start.load(std::memory_order_relaxed);
+  const uintptr_t end = w.end.load(std::memory_order_relaxed);
+
+  mprotect((void *)start, end - start, PROT_READ | PROT_WRITE);
+
+  w.active.store(false, std::memory_order_release);
+}
+
+bool Process::ResetWriteWatch(uint64_t watch, bool watching)
+{
+  if(watch == 0 || watch > MaxWriteWatches)
+    return false;
+
+  WriteWatch &w = writeWatches[watch - 1];
+
+  const uintptr_t start = w.start.load(std::memory_order_relaxed);
+  const uintptr_t end = w.end.load(std::memory_order_relaxed);
+  const size_t numPages = (end - start) / pageSize;
+
+  // clear the written flags before protecting, so a write in between can't be lost
+  memset((void *)w.written, 0, numPages);
+
+  int ret = mprotect((void *)start, end - start, watching ? PROT_READ : PROT_READ | PROT_WRITE);
+
+  if(ret != 0)
+  {
+    RDCERR("Couldn't change protection of watched memory: %d", errno);
+    return false;
+  }
+
+  return true;
+}
+
+bool Process::FetchWrittenRanges(uint64_t watch, rdcarray<rdcpair<size_t, size_t>> &ranges)
+{
+  ranges.clear();
+
+  if(watch == 0 || watch > MaxWriteWatches)
+    return false;
+
+  WriteWatch &w = writeWatches[watch - 1];
+
+  const uintptr_t start = w.start.load(std::memory_order_relaxed);
+  const uintptr_t end = w.end.load(std::memory_order_relaxed);
+  const size_t numPages = (end - start) / pageSize;
+
+  bool success = true;
+
+  for(size_t page = 0; page < numPages;)
+  {
+    if(!w.written[page])
+    {
+      page++;
+      continue;
+    }
+
+    // find the run of written pages starting here
+    size_t runEnd = page;
+    while(runEnd < numPages && w.written[runEnd])
+      w.written[runEnd++] = 0;
+
+    const uintptr_t runStartAddr = start + page * pageSize;
+    const uintptr_t runEndAddr = start + runEnd * pageSize;
+
+    // protect the run again now that its flags are cleared. A write before this point will be
+    // seen by whoever reads the memory after we return, and a write after it faults again.
+    if(mprotect((void *)runStartAddr, runEndAddr - runStartAddr, PROT_READ) != 0)
+    {
+      RDCERR("Couldn't change protection of watched memory: %d", errno);
+      success = false;
+    }
+
+    ranges.push_back({RDCMAX(runStartAddr, w.base) - w.base,
+                      RDCMIN(runEndAddr, w.base + w.size) - w.base});
+
+    page = runEnd;
+  }
+
+  return success;
+}
@@ -32,6 +32,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/file.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <time.h>
@@ -455,6 +456,79 @@ bool exists(const char *filename)
   return (res == 0);
 }
 
+struct MappedFile
+{
+  void *base;
+  size_t length;
+  size_t offset;
+  int fd;
+};
+
+MappedFile *mmap_open(FILE *f, uint64_t offset, uint64_t length)
+{
+  if(f == NULL || length == 0)
+    return NULL;
+
+  // the offset passed to mmap must be page aligned, so map from the page containing the offset
+  const uint64_t pageSize = (uint64_t)sysconf(_SC_PAGESIZE);
+  const uint64_t alignedOffset = offset - (offset % pageSize);
+  const uint64_t mapLength = length + (offset - alignedOffset);
+
+  // can't map more than the address space, e.g. on 32-bit
+  if(mapLength != (uint64_t)(size_t)mapLength)
+    return NULL;
+
+  // touching any page of the mapping beyond the end of the file raises SIGBUS, so only map what the
+  // file covers right now.
+  struct stat st = {};
+  if(fstat(::fileno(f), &st) != 0 || offset + length > (uint64_t)st.st_size)
+  {
+    RDCWARN("Not mapping %llu bytes at offset %llu beyond the end of the file", length, offset);
+    return NULL;
+  }
+
+  // keep our own descriptor for the mapping's lifetime, so it stays tied to this file whatever
+  // happens to the FILE *
+  int fd = dup(::fileno(f));
+
+  if(fd < 0)
+    return NULL;
+
+  void *base = mmap(NULL, (size_t)mapLength, PROT_READ, MAP_PRIVATE, fd, (off_t)alignedOffset);
+
+  if(base == MAP_FAILED)
+  {
+    RDCWARN("Couldn't map %llu bytes at offset %llu: %d", length, offset, (int)errno);
+    close(fd);
+    return NULL;
+  }
+
+  MappedFile *ret = new MappedFile;
+  ret->base = base;
+  ret->length = (size_t)mapLength;
+  ret->offset = (size_t)(offset - alignedOffset);
+  ret->fd = fd;
+  return ret;
+}
+
+const void *mmap_data(MappedFile *mapping)
+{
+  if(mapping == NULL)
+    return NULL;
+
+  return (const byte *)mapping->base + mapping->offset;
+}
+
+void mmap_close(MappedFile *mapping)
+{
+  if(mapping == NULL)
+    return;
+
+  munmap(mapping->base, mapping->length);
+  close(mapping->fd);
+  delete mapping;
+}
+
 rdcarray<int> logfiles;
 
 // this is used in posix_process.cpp, so that we can close the handle any time that we fork()
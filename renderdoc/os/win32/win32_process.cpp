@@ -192,6 +192,26 @@ uint64_t Process::GetMemoryUsage()
   return ret;
 }
 
+uint64_t Process::RegisterWriteWatch(void *base, size_t size)
+{
+  return 0;
+}
+
+void Process::UnregisterWriteWatch(uint64_t watch)
+{
+}
+
+bool Process::ResetWriteWatch(uint64_t watch, bool watching)
+{
+  return false;
+}
+
+bool Process::FetchWrittenRanges(uint64_t watch, rdcarray<rdcpair<size_t, size_t>> &ranges)
+{
+  ranges.clear();
+  return false;
+}
+
 // helpers for various shims and dlls etc, not part of the public API
 extern "C" __declspec(dllexport) void __cdecl INTERNAL_GetTargetControlIdent(uint32_t *ident)
 {
@@ -653,6 +653,78 @@ int fclose(FILE *f)
   return ::fclose(f);
 }
 
+struct MappedFile
+{
+  void *base;
+  size_t offset;
+};
+
+MappedFile *mmap_open(FILE *f, uint64_t offset, uint64_t length)
+{
+  if(f == NULL || length == 0)
+    return NULL;
+
+  // views must start on an allocation granularity boundary, so map from the boundary before the
+  // offset
+  SYSTEM_INFO sysinfo;
+  GetSystemInfo(&sysinfo);
+
+  const uint64_t granularity = sysinfo.dwAllocationGranularity;
+  const uint64_t alignedOffset = offset - (offset % granularity);
+  const uint64_t mapLength = length + (offset - alignedOffset);
+
+  // can't map more than the address space, e.g. on 32-bit
+  if(mapLength != (uint64_t)(SIZE_T)mapLength)
+    return NULL;
+
+  HANDLE file = (HANDLE)_get_osfhandle(_fileno(f));
+
+  if(file == INVALID_HANDLE_VALUE)
+    return NULL;
+
+  HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+  if(mapping == NULL)
+  {
+    RDCWARN("Couldn't create file mapping: %d", GetLastError());
+    return NULL;
+  }
+
+  void *base = MapViewOfFile(mapping, FILE_MAP_READ, DWORD(alignedOffset >> 32),
+                             DWORD(alignedOffset & 0xffffffff), (SIZE_T)mapLength);
+
+  // the view keeps the mapping object alive, we don't need the handle anymore
+  CloseHandle(mapping);
+
+  if(base == NULL)
+  {
+    RDCWARN("Couldn't map %llu bytes at offset %llu: %d", length, offset, GetLastError());
+    return NULL;
+  }
+
+  MappedFile *ret = new MappedFile;
+  ret->base = base;
+  ret->offset = (size_t)(offset - alignedOffset);
+  return ret;
+}
+
+const void *mmap_data(MappedFile *mapping)
+{
+  if(mapping == NULL)
+    return NULL;
+
+  return (const byte *)mapping->base + mapping->offset;
+}
+
+void mmap_close(MappedFile *mapping)
+{
+  if(mapping == NULL)
+    return;
+
+  UnmapViewOfFile(mapping->base);
+  delete mapping;
+}
+
 LogFileHandle *logfile_open(const char *filename)
 {
   rdcwstr wfn = StringFormat::UTF82Wide(filename);
@@ -151,6 +151,26 @@ void RWLock::ReadUnlock()
   ReleaseSRWLockShared(&m_Data);
 }
 
+Semaphore::SemaphoreTemplate()
+{
+  m_Data = CreateSemaphore(NULL, 0, LONG_MAX, NULL);
+}
+
+Semaphore::~SemaphoreTemplate()
+{
+  CloseHandle(m_Data);
+}
+
+void Semaphore::Wait()
+{
+  WaitForSingleObject(m_Data, INFINITE);
+}
+
+void Semaphore::Signal(uint32_t count)
+{
+  ReleaseSemaphore(m_Data, (LONG)count, NULL);
+}
+
 struct ThreadInitData
 {
   std::function<void()> entryFunc;
@@ -316,6 +336,13 @@ uint64_t GetCurrentID()
   return (uint64_t)::GetCurrentThreadId();
 }
 
+uint32_t GetNumberOfCores()
+{
+  SYSTEM_INFO info = {};
+  GetSystemInfo(&info);
+  return RDCMAX(1U, (uint32_t)info.dwNumberOfProcessors);
+}
+
 void JoinThread(ThreadHandle handle)
 {
   if(handle == 0)
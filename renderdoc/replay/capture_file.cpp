@@ -23,6 +23,7 @@
  ******************************************************************************/
 
 #include "core/core.h"
+#include "core/settings.h"
 #include "jpeg-compressor/jpgd.h"
 #include "jpeg-compressor/jpge.h"
 #include "replay/replay_controller.h"
@@ -32,6 +33,10 @@
 #include "stb/stb_image_resize.h"
 #include "stb/stb_image_write.h"
 
+RDOC_CONFIG(bool, Capture_ZstdDictionary, false,
+            "When converting a capture, compress the frame capture data against a dictionary built "
+            "from its contents. This gives smaller files at the cost of some extra time to convert.");
+
 static void writeToBytebuf(void *context, void *data, int size)
 {
   bytebuf *buf = (bytebuf *)context;
@@ -125,6 +130,15 @@ public:
   ReplayStatus Convert(const char *filename, const char *filetype, const SDFile *file,
                        RENDERDOC_ProgressCallback progress);
 
+  ReplayStatus PackSections(const char *filename, const char *blobStore, uint64_t minBlobSize)
+  {
+    return CopySections(filename, blobStore, true, minBlobSize);
+  }
+  ReplayStatus UnpackSections(const char *filename, const char *blobStore)
+  {
+    return CopySections(filename, blobStore, false, 0);
+  }
+
   rdcarray<CaptureFileFormat> GetCaptureFileFormats()
   {
     return RenderDoc::Inst().GetCaptureFileFormats();
@@ -171,6 +185,8 @@ public:
 
 private:
   ReplayStatus Init();
+  ReplayStatus CopySections(const char *filename, const char *blobStore, bool pack,
+                            uint64_t minBlobSize);
 
   void InitStructuredData(RENDERDOC_ProgressCallback progress = RENDERDOC_ProgressCallback());
 
@@ -361,6 +377,10 @@ rdcpair<ReplayStatus, IReplayController *> CaptureFile::OpenCapture(const Replay
 
   RenderDoc::Inst().SetProgressCallback<LoadProgress>(progress);
 
+  // the replay keeps the frame capture data around for as long as it's open, so read it from a
+  // mapping of the file rather than taking a copy.
+  m_RDC->SetMemoryMapping(true);
+
   ret = render->CreateDevice(m_RDC, opts);
 
   RenderDoc::Inst().SetProgressCallback<LoadProgress>(RENDERDOC_ProgressCallback());
@@ -471,7 +491,9 @@ ReplayStatus CaptureFile::Convert(const char *filename, const char *filetype, co
     }
 
     SectionProperties frameCapture;
-    frameCapture.flags = SectionFlags::ZstdCompressed;
+    frameCapture.flags = SectionFlags::ZstdCompressed | SectionFlags::SeekIndexed;
+    if(Capture_ZstdDictionary())
+      frameCapture.flags |= SectionFlags::ZstdDictionary;
     frameCapture.type = SectionType::FrameCapture;
     frameCapture.name = ToStr(frameCapture.type);
     frameCapture.version = file->version;
@@ -492,7 +514,9 @@ ReplayStatus CaptureFile::Convert(const char *filename, const char *filetype, co
   {
     // otherwise write it straight, but compress it to zstd
     SectionProperties props = m_RDC->GetSectionProperties(frameCaptureIndex);
-    props.flags = SectionFlags::ZstdCompressed;
+    props.flags = SectionFlags::ZstdCompressed | SectionFlags::SeekIndexed;
+    if(Capture_ZstdDictionary())
+      props.flags |= SectionFlags::ZstdDictionary;
 
     StreamWriter *writer = output.WriteSection(props);
     StreamReader *reader = m_RDC->ReadSection(frameCaptureIndex);
@@ -537,6 +561,41 @@ ReplayStatus CaptureFile::Convert(const char *filename, const char *filetype, co
   return ReplayStatus::Succeeded;
 }
 
+ReplayStatus CaptureFile::CopySections(const char *filename, const char *blobStore, bool pack,
+                                       uint64_t minBlobSize)
+{
+  if(!m_RDC)
+  {
+    RDCERR("Data missing for creation of file, set metadata first.");
+    return ReplayStatus::FileCorrupted;
+  }
+
+  RDCFile output;
+
+  output.SetData(m_RDC->GetDriver(), m_RDC->GetDriverName().c_str(), m_RDC->GetMachineIdent(),
+                 &m_RDC->GetThumbnail(), m_RDC->GetTimestampBase(), m_RDC->GetTimestampFrequency());
+
+  output.Create(filename);
+
+  if(output.ErrorCode() != ContainerError::NoError)
+  {
+    switch(output.ErrorCode())
+    {
+      case ContainerError::FileNotFound: return ReplayStatus::FileNotFound;
+      case ContainerError::FileIO: return ReplayStatus::FileIOFailed;
+      default: break;
+    }
+    return ReplayStatus::InternalError;
+  }
+
+  // the blob store is only used for this copy. Sections of the loaded capture that are already in
+  // it are read from it, but the store used for reading the loaded capture otherwise is unchanged.
+  bool success = pack ? m_RDC->PackSections(output, blobStore, minBlobSize)
+                      : m_RDC->UnpackSections(output, blobStore);
+
+  return success ? ReplayStatus::Succeeded : ReplayStatus::FileIOFailed;
+}
+
 Thumbnail CaptureFile::GetThumbnail(FileType type, uint32_t maxsize)
 {
   Thumbnail ret;
@@ -33,6 +33,7 @@
 #include "maths/formatpacking.h"
 #include "miniz/miniz.h"
 #include "replay/replay_driver.h"
+#include "serialise/serialiser.h"
 #include "strings/string_utils.h"
 #include "superluminal/superluminal.h"
 
@@ -434,6 +435,26 @@ extern "C" RENDERDOC_API void *RENDERDOC_CC RENDERDOC_AllocArrayMem(uint64_t sz)
   return ret;
 }
 
+extern "C" RENDERDOC_API void RENDERDOC_CC RENDERDOC_FreeSDObjectMem(void *mem)
+{
+  SDObjectArena::Free(mem);
+}
+
+extern "C" RENDERDOC_API void *RENDERDOC_CC RENDERDOC_AllocSDObjectMem(uint64_t sz)
+{
+  return SDObjectArena::AllocHeap((size_t)sz);
+}
+
+extern "C" RENDERDOC_API void RENDERDOC_CC RENDERDOC_FreeSDFileStorage(SDFileStorage *storage)
+{
+  delete storage;
+}
+
+extern "C" RENDERDOC_API bool RENDERDOC_CC RENDERDOC_IsInternedSDString(const char *str)
+{
+  return IsInternedSDString(str);
+}
+
 extern "C" RENDERDOC_API uint32_t RENDERDOC_CC RENDERDOC_EnumerateRemoteTargets(const char *URL,
                                                                                 uint32_t nextIdent)
 {
@@ -108,6 +108,20 @@ void ReplayController::SetFrameEvent(uint32_t eventId, bool force)
   }
 }
 
+void ReplayController::SetReplayRange(uint32_t startEventId, uint32_t endEventId)
+{
+  CHECK_REPLAY_THREAD();
+  RENDERDOC_PROFILEFUNCTION();
+
+  m_ReplayRangeStart = startEventId;
+  m_ReplayRangeEnd = endEventId;
+
+  m_pDevice->SetReplayRange(startEventId, endEventId);
+
+  // setting up the range replays part of the frame, so restore the current event
+  SetFrameEvent(m_EventID, true);
+}
+
 const D3D11Pipe::State *ReplayController::GetD3D11PipelineState()
 {
   CHECK_REPLAY_THREAD();
@@ -424,7 +438,39 @@ rdcarray<CounterResult> ReplayController::FetchCounters(const rdcarray<GPUCounte
 
   RENDERDOC_PROFILEFUNCTION();
 
-  return m_pDevice->FetchCounters(counters);
+  rdcarray<GPUCounter> uniqueCounters;
+  rdcarray<GPUCounter> missingCounters;
+  for(GPUCounter c : counters)
+  {
+    if(uniqueCounters.contains(c))
+      continue;
+
+    uniqueCounters.push_back(c);
+    if(m_CounterResults.find(c) == m_CounterResults.end())
+      missingCounters.push_back(c);
+  }
+
+  // only fetch the counters we haven't seen before, all in one go so the driver can sample them in
+  // as few passes as possible
+  if(!missingCounters.empty())
+  {
+    rdcarray<CounterResult> results = m_pDevice->FetchCounters(missingCounters);
+
+    for(const CounterResult &r : results)
+      m_CounterResults[r.counter].push_back(r);
+  }
+
+  rdcarray<CounterResult> ret;
+  for(GPUCounter c : uniqueCounters)
+  {
+    auto it = m_CounterResults.find(c);
+    if(it != m_CounterResults.end())
+      ret.append(it->second);
+  }
+
+  std::sort(ret.begin(), ret.end());
+
+  return ret;
 }
 
 rdcarray<GPUCounter> ReplayController::EnumerateCounters()
@@ -1416,16 +1462,18 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
   return success;
 }
 
-rdcarray<PixelModification> ReplayController::PixelHistory(ResourceId target, uint32_t x, uint32_t y,
-                                                           const Subresource &sub, CompType typeCast)
-{
-  CHECK_REPLAY_THREAD();
-
-  RENDERDOC_PROFILEFUNCTION();
-
-  rdcarray<PixelModification> ret;
+// upper bound on the pixels fetched by one PixelHistoryRegion call. Every pixel keeps its whole
+// history, and the per-fragment passes still replay once per pixel that was written to.
+static const uint32_t MaxPixelHistoryRegionPixels = 64 * 64;
 
-  Subresource subresource = sub;
+bool ReplayController::ClampPixelHistoryRegion(ResourceId target, uint32_t x, uint32_t y,
+                                               uint32_t &width, uint32_t &height, Subresource &sub)
+{
+  if(!m_APIProps.pixelHistory)
+  {
+    RDCWARN("Pixel history is not supported on %s", ToStr(m_APIProps.pipelineType).c_str());
+    return false;
+  }
 
   for(size_t t = 0; t < m_Textures.size(); t++)
   {
@@ -1435,36 +1483,44 @@ rdcarray<PixelModification> ReplayController::PixelHistory(ResourceId target, ui
       {
         RDCDEBUG("PixelHistory out of bounds on %s (%u,%u) vs (%u,%u)", ToStr(target).c_str(), x, y,
                  m_Textures[t].width, m_Textures[t].height);
-        return ret;
+        return false;
       }
 
+      width = RDCMIN(width, m_Textures[t].width - x);
+      height = RDCMIN(height, m_Textures[t].height - y);
+
       if(m_Textures[t].msSamp == 1)
-        subresource.sample = ~0U;
+        sub.sample = ~0U;
 
       if(m_Textures[t].dimension == 3)
       {
-        subresource.slice = RDCCLAMP(subresource.slice, 0U, m_Textures[t].depth >> subresource.mip);
+        sub.slice = RDCCLAMP(sub.slice, 0U, m_Textures[t].depth >> sub.mip);
       }
       else
       {
-        subresource.slice = RDCCLAMP(subresource.slice, 0U, m_Textures[t].arraysize);
+        sub.slice = RDCCLAMP(sub.slice, 0U, m_Textures[t].arraysize);
       }
 
-      subresource.mip = RDCCLAMP(subresource.mip, 0U, m_Textures[t].mips - 1);
+      sub.mip = RDCCLAMP(sub.mip, 0U, m_Textures[t].mips - 1);
 
       break;
     }
   }
 
+  return width > 0 && height > 0;
+}
+
+rdcarray<EventUsage> ReplayController::GetPixelHistoryEvents(ResourceId target)
+{
+  rdcarray<EventUsage> events;
+
   ResourceId id = m_pDevice->GetLiveID(target);
 
   if(id == ResourceId())
-    return ret;
+    return events;
 
   rdcarray<EventUsage> usage = m_pDevice->GetUsage(id);
 
-  rdcarray<EventUsage> events;
-
   for(size_t i = 0; i < usage.size(); i++)
   {
     if(usage[i].eventId > m_EventID)
@@ -1529,12 +1585,32 @@ rdcarray<PixelModification> ReplayController::PixelHistory(ResourceId target, ui
   }
 
   if(events.empty())
-  {
     RDCDEBUG("Target %s not written to before %u", ToStr(target).c_str(), m_EventID);
+
+  return events;
+}
+
+rdcarray<PixelModification> ReplayController::PixelHistory(ResourceId target, uint32_t x, uint32_t y,
+                                                           const Subresource &sub, CompType typeCast)
+{
+  CHECK_REPLAY_THREAD();
+
+  RENDERDOC_PROFILEFUNCTION();
+
+  rdcarray<PixelModification> ret;
+
+  Subresource subresource = sub;
+
+  uint32_t width = 1, height = 1;
+  if(!ClampPixelHistoryRegion(target, x, y, width, height, subresource))
     return ret;
-  }
 
-  id = m_pDevice->GetLiveID(target);
+  rdcarray<EventUsage> events = GetPixelHistoryEvents(target);
+
+  if(events.empty())
+    return ret;
+
+  ResourceId id = m_pDevice->GetLiveID(target);
 
   if(id == ResourceId())
     return ret;
@@ -1546,6 +1622,50 @@ rdcarray<PixelModification> ReplayController::PixelHistory(ResourceId target, ui
   return ret;
 }
 
+rdcarray<PixelHistoryResult> ReplayController::PixelHistoryRegion(ResourceId target, uint32_t x,
+                                                                  uint32_t y, uint32_t width,
+                                                                  uint32_t height,
+                                                                  const Subresource &sub,
+                                                                  CompType typeCast)
+{
+  CHECK_REPLAY_THREAD();
+
+  RENDERDOC_PROFILEFUNCTION();
+
+  rdcarray<PixelHistoryResult> ret;
+
+  Subresource subresource = sub;
+
+  if(!ClampPixelHistoryRegion(target, x, y, width, height, subresource))
+    return ret;
+
+  // keep whole rows of the region, as results are returned in row-major order
+  if(width * height > MaxPixelHistoryRegionPixels)
+  {
+    width = RDCMIN(width, MaxPixelHistoryRegionPixels);
+    height = MaxPixelHistoryRegionPixels / width;
+
+    RDCWARN("Pixel history region is limited to %u pixels, truncating to %ux%u",
+            MaxPixelHistoryRegionPixels, width, height);
+  }
+
+  rdcarray<EventUsage> events = GetPixelHistoryEvents(target);
+
+  if(events.empty())
+    return ret;
+
+  ResourceId id = m_pDevice->GetLiveID(target);
+
+  if(id == ResourceId())
+    return ret;
+
+  ret = m_pDevice->PixelHistoryRegion(events, id, x, y, width, height, subresource, typeCast);
+
+  SetFrameEvent(m_EventID, true);
+
+  return ret;
+}
+
 PixelValue ReplayController::PickPixel(ResourceId tex, uint32_t x, uint32_t y,
                                        const Subresource &sub, CompType typeCast)
 {
@@ -1620,6 +1740,19 @@ ShaderDebugTrace *ReplayController::DebugPixel(uint32_t x, uint32_t y, uint32_t
   return ret;
 }
 
+rdcarray<ShaderDebugTrace *> ReplayController::DebugPixels(const rdcarray<DebugPixelInputs> &pixels)
+{
+  CHECK_REPLAY_THREAD();
+
+  RENDERDOC_PROFILEFUNCTION();
+
+  rdcarray<ShaderDebugTrace *> ret = m_pDevice->DebugPixels(m_EventID, pixels);
+
+  SetFrameEvent(m_EventID, true);
+
+  return ret;
+}
+
 ShaderDebugTrace *ReplayController::DebugThread(const uint32_t groupid[3], const uint32_t threadid[3])
 {
   CHECK_REPLAY_THREAD();
@@ -1971,8 +2104,14 @@ void ReplayController::ReplaceResource(ResourceId from, ResourceId to)
 {
   CHECK_REPLAY_THREAD();
 
+  m_CounterResults.clear();
+
   m_pDevice->ReplaceResource(from, to);
 
+  // the range snapshot holds contents rendered with the old resource, so rebuild it
+  if(m_ReplayRangeStart > 0)
+    m_pDevice->SetReplayRange(m_ReplayRangeStart, m_ReplayRangeEnd);
+
   SetFrameEvent(m_EventID, true);
 
   for(size_t i = 0; i < m_Outputs.size(); i++)
@@ -1984,8 +2123,14 @@ void ReplayController::RemoveReplacement(ResourceId id)
 {
   CHECK_REPLAY_THREAD();
 
+  m_CounterResults.clear();
+
   m_pDevice->RemoveReplacement(id);
 
+  // as in ReplaceResource, the range snapshot is stale now
+  if(m_ReplayRangeStart > 0)
+    m_pDevice->SetReplayRange(m_ReplayRangeStart, m_ReplayRangeEnd);
+
   SetFrameEvent(m_EventID, true);
 
   for(size_t i = 0; i < m_Outputs.size(); i++)
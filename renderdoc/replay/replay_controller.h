@@ -25,6 +25,7 @@
 
 #pragma once
 
+#include <map>
 #include <set>
 #include "api/replay/renderdoc_replay.h"
 #include "common/common.h"
@@ -136,6 +137,7 @@ public:
   void FileChanged();
 
   void SetFrameEvent(uint32_t eventId, bool force);
+  void SetReplayRange(uint32_t startEventId, uint32_t endEventId);
 
   const D3D11Pipe::State *GetD3D11PipelineState();
   const D3D12Pipe::State *GetD3D12PipelineState();
@@ -185,8 +187,12 @@ public:
                                   float minval, float maxval, bool channels[4]);
   rdcarray<PixelModification> PixelHistory(ResourceId target, uint32_t x, uint32_t y,
                                            const Subresource &sub, CompType typeCast);
+  rdcarray<PixelHistoryResult> PixelHistoryRegion(ResourceId target, uint32_t x, uint32_t y,
+                                                  uint32_t width, uint32_t height,
+                                                  const Subresource &sub, CompType typeCast);
   ShaderDebugTrace *DebugVertex(uint32_t vertid, uint32_t instid, uint32_t idx, uint32_t view);
   ShaderDebugTrace *DebugPixel(uint32_t x, uint32_t y, uint32_t sample, uint32_t primitive);
+  rdcarray<ShaderDebugTrace *> DebugPixels(const rdcarray<DebugPixelInputs> &pixels);
   ShaderDebugTrace *DebugThread(const uint32_t groupid[3], const uint32_t threadid[3]);
   rdcarray<ShaderDebugState> ContinueDebug(ShaderDebugger *debugger);
   void FreeTrace(ShaderDebugTrace *trace);
@@ -226,6 +232,10 @@ private:
   bool ContainsMarker(const rdcarray<DrawcallDescription> &draws);
   bool PassEquivalent(const DrawcallDescription &a, const DrawcallDescription &b);
 
+  bool ClampPixelHistoryRegion(ResourceId target, uint32_t x, uint32_t y, uint32_t &width,
+                               uint32_t &height, Subresource &sub);
+  rdcarray<EventUsage> GetPixelHistoryEvents(ResourceId target);
+
   IReplayDriver *GetDevice() { return m_pDevice; }
   FrameRecord m_FrameRecord;
   rdcarray<DrawcallDescription *> m_Drawcalls;
@@ -240,6 +250,10 @@ private:
 
   uint32_t m_EventID;
 
+  // the range set with SetReplayRange, so its snapshot can be rebuilt when resources are replaced
+  uint32_t m_ReplayRangeStart = 0;
+  uint32_t m_ReplayRangeEnd = 0;
+
   const D3D11Pipe::State *m_D3D11PipelineState;
   const D3D12Pipe::State *m_D3D12PipelineState;
   const GLPipe::State *m_GLPipelineState;
@@ -257,5 +271,9 @@ private:
   std::set<ResourceId> m_TargetResources;
   std::set<ResourceId> m_CustomShaders;
 
+  // results from previous counter fetches, per counter. The frame doesn't change between fetches so
+  // these stay valid until a resource replacement changes what is replayed.
+  std::map<GPUCounter, rdcarray<CounterResult>> m_CounterResults;
+
   friend struct ReplayOutput;
 };
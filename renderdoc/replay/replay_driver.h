@@ -164,6 +164,7 @@ public:
 
   virtual ReplayStatus ReadLogInitialisation(RDCFile *rdc, bool storeStructuredBuffers) = 0;
   virtual void ReplayLog(uint32_t endEventID, ReplayLogType replayType) = 0;
+  virtual void SetReplayRange(uint32_t startEventID, uint32_t endEventID) = 0;
   virtual const SDFile &GetStructuredFile() = 0;
 
   virtual rdcarray<uint32_t> GetPassEvents(uint32_t eventId) = 0;
@@ -199,10 +200,17 @@ public:
   virtual rdcarray<PixelModification> PixelHistory(rdcarray<EventUsage> events, ResourceId target,
                                                    uint32_t x, uint32_t y, const Subresource &sub,
                                                    CompType typeCast) = 0;
+  virtual rdcarray<PixelHistoryResult> PixelHistoryRegion(rdcarray<EventUsage> events,
+                                                          ResourceId target, uint32_t x, uint32_t y,
+                                                          uint32_t width, uint32_t height,
+                                                          const Subresource &sub,
+                                                          CompType typeCast) = 0;
   virtual ShaderDebugTrace *DebugVertex(uint32_t eventId, uint32_t vertid, uint32_t instid,
                                         uint32_t idx, uint32_t view) = 0;
   virtual ShaderDebugTrace *DebugPixel(uint32_t eventId, uint32_t x, uint32_t y, uint32_t sample,
                                        uint32_t primitive) = 0;
+  virtual rdcarray<ShaderDebugTrace *> DebugPixels(uint32_t eventId,
+                                                   const rdcarray<DebugPixelInputs> &pixels) = 0;
   virtual ShaderDebugTrace *DebugThread(uint32_t eventId, const uint32_t groupid[3],
                                         const uint32_t threadid[3]) = 0;
   virtual rdcarray<ShaderDebugState> ContinueDebug(ShaderDebugger *debugger) = 0;
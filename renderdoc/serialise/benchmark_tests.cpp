@@ -0,0 +1,356 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include <float.h>
+#include "common/threading.h"
+#include "common/timing.h"
+#include "lz4io.h"
+#include "serialiser.h"
+#include "zstdio.h"
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "catch/catch.hpp"
+
+// These benchmarks are hidden from the default test run since they take a while and only report
+// numbers rather than checking correctness. Run them explicitly with:
+//
+//   renderdoccmd test unit "[benchmark]"
+//
+// Each measurement is repeated a few times and the fastest run is reported, to reduce noise from
+// the rest of the system.
+
+namespace
+{
+// loosely modelled on a draw call - a handful of small PODs, a short string and some arrays
+struct BenchDrawParams
+{
+  uint64_t pipeline;
+  uint64_t descriptorSets[4];
+  uint32_t firstVertex;
+  uint32_t vertexCount;
+  uint32_t firstInstance;
+  uint32_t instanceCount;
+  float viewport[6];
+  rdcstr marker;
+  rdcarray<uint32_t> dynamicOffsets;
+};
+
+enum BenchChunk
+{
+  BenchChunk_Draw = 1000,
+  BenchChunk_Buffer,
+};
+
+static const uint32_t benchDrawCount = 100000;
+static const uint32_t benchBufferEvery = 1000;
+static const uint32_t benchBufferSize = 256 * 1024;
+static const int benchRepeats = 3;
+
+void ReportBenchmark(const char *name, double milliseconds, uint64_t bytes, uint64_t chunks)
+{
+  double seconds = RDCMAX(milliseconds, 0.001) / 1000.0;
+
+  rdcstr line = StringFormat::Fmt("%-34s %9.2f ms %10.1f MB/s", name, milliseconds,
+                                  double(bytes) / (1024.0 * 1024.0) / seconds);
+
+  if(chunks > 0)
+    line += StringFormat::Fmt(" %12.0f chunks/s", double(chunks) / seconds);
+
+  line += "\n";
+
+  OSUtility::WriteOutput(OSUtility::Output_StdOut, line.c_str());
+}
+
+template <typename Func>
+double FastestRun(Func func)
+{
+  double best = DBL_MAX;
+
+  for(int i = 0; i < benchRepeats; i++)
+  {
+    PerformanceTimer timer;
+    func();
+    best = RDCMIN(best, timer.GetMilliseconds());
+  }
+
+  return best;
+}
+
+rdcstr BenchChunkName(uint32_t chunkID)
+{
+  return chunkID == BenchChunk_Draw ? "vkCmdDraw" : "vkCmdUpdateBuffer";
+}
+}
+
+DECLARE_REFLECTION_STRUCT(BenchDrawParams);
+
+template <class SerialiserType>
+void DoSerialise(SerialiserType &ser, BenchDrawParams &el)
+{
+  SERIALISE_MEMBER(pipeline);
+  SERIALISE_MEMBER(descriptorSets);
+  SERIALISE_MEMBER(firstVertex);
+  SERIALISE_MEMBER(vertexCount);
+  SERIALISE_MEMBER(firstInstance);
+  SERIALISE_MEMBER(instanceCount);
+  SERIALISE_MEMBER(viewport);
+  SERIALISE_MEMBER(marker);
+  SERIALISE_MEMBER(dynamicOffsets);
+}
+
+// writes a capture-shaped stream of chunks: many small draw chunks with a large buffer upload every
+// so often. Returns the number of chunks written
+static uint32_t WriteBenchChunks(WriteSerialiser &ser, const bytebuf &bufferData)
+{
+  BenchDrawParams draw = {};
+  draw.marker = "Draw";
+  draw.dynamicOffsets = {0, 256, 512};
+
+  uint32_t numChunks = 0;
+
+  for(uint32_t i = 0; i < benchDrawCount; i++)
+  {
+    draw.pipeline = 0x1000 + (i % 16);
+    draw.descriptorSets[0] = 0x2000 + (i % 64);
+    draw.firstVertex = i * 3;
+    draw.vertexCount = 3 + (i % 300);
+    draw.instanceCount = 1;
+    draw.viewport[2] = 1920.0f;
+    draw.viewport[3] = 1080.0f;
+    draw.viewport[5] = 1.0f;
+
+    {
+      SCOPED_SERIALISE_CHUNK(BenchChunk_Draw);
+      SERIALISE_ELEMENT(draw);
+    }
+    numChunks++;
+
+    if((i % benchBufferEvery) == 0)
+    {
+      SCOPED_SERIALISE_CHUNK(BenchChunk_Buffer);
+      uint64_t offset = 0;
+      SERIALISE_ELEMENT(offset);
+      SERIALISE_ELEMENT(bufferData);
+      numChunks++;
+    }
+  }
+
+  return numChunks;
+}
+
+// reads back the stream written by WriteBenchChunks, returning the number of chunks read
+static uint32_t ReadBenchChunks(ReadSerialiser &ser)
+{
+  BenchDrawParams draw;
+  bytebuf bufferData;
+  uint64_t offset = 0;
+
+  uint32_t numChunks = 0;
+
+  while(!ser.GetReader()->AtEnd() && !ser.IsErrored())
+  {
+    uint32_t chunk = ser.ReadChunk<uint32_t>();
+
+    if(chunk == BenchChunk_Draw)
+    {
+      SERIALISE_ELEMENT(draw);
+    }
+    else
+    {
+      SERIALISE_ELEMENT(offset);
+      SERIALISE_ELEMENT(bufferData);
+    }
+
+    ser.EndChunk();
+    numChunks++;
+  }
+
+  return numChunks;
+}
+
+TEST_CASE("Benchmark serialiser chunk throughput", "[.][benchmark][serialiser]")
+{
+  bytebuf bufferData;
+  bufferData.resize(benchBufferSize);
+  for(size_t i = 0; i < bufferData.size(); i++)
+    bufferData[i] = byte((i * 7) ^ (i >> 8));
+
+  StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
+
+  uint32_t numChunks = 0;
+
+  double ms = FastestRun([&]() {
+    buf->Rewind();
+    WriteSerialiser ser(buf, Ownership::Nothing);
+    ser.SetChunkMetadataRecording(WriteSerialiser::ChunkDuration | WriteSerialiser::ChunkTimestamp);
+    numChunks = WriteBenchChunks(ser, bufferData);
+  });
+
+  REQUIRE_FALSE(buf->IsErrored());
+
+  const uint64_t size = buf->GetOffset();
+
+  ReportBenchmark("write chunks", ms, size, numChunks);
+
+  ms = FastestRun([&]() {
+    ReadSerialiser ser(new StreamReader(buf->GetData(), size), Ownership::Stream);
+    CHECK(ReadBenchChunks(ser) == numChunks);
+  });
+
+  ReportBenchmark("read chunks", ms, size, numChunks);
+
+  ms = FastestRun([&]() {
+    ReadSerialiser ser(new StreamReader(buf->GetData(), size), Ownership::Stream);
+    ser.ConfigureStructuredExport(&BenchChunkName, false, 0, 1.0);
+    CHECK(ReadBenchChunks(ser) == numChunks);
+    CHECK(ser.GetStructuredFile().chunks.size() == numChunks);
+  });
+
+  ReportBenchmark("structurise chunks", ms, size, numChunks);
+
+  ms = FastestRun([&]() {
+    ReadSerialiser ser(new StreamReader(buf->GetData(), size), Ownership::Stream);
+    ser.ConfigureStructuredExport(&BenchChunkName, true, 0, 1.0);
+    CHECK(ReadBenchChunks(ser) == numChunks);
+  });
+
+  ReportBenchmark("structurise chunks with buffers", ms, size, numChunks);
+
+  delete buf;
+};
+
+TEST_CASE("Benchmark stream buffering throughput", "[.][benchmark][streamio]")
+{
+  rdcstr filename = FileIO::GetTempFolderFilename() + "/benchmark.bin";
+
+  const uint32_t numWrites = 4 * 1024 * 1024;
+  const uint64_t size = numWrites * sizeof(uint32_t);
+
+  double ms = FastestRun([&]() {
+    StreamWriter writer(StreamWriter::DefaultScratchSize);
+    for(uint32_t i = 0; i < numWrites; i++)
+      writer.Write(i);
+  });
+
+  ReportBenchmark("small writes to memory", ms, size, 0);
+
+  ms = FastestRun([&]() {
+    StreamWriter writer(FileIO::fopen(filename.c_str(), "wb"), Ownership::Stream);
+    for(uint32_t i = 0; i < numWrites; i++)
+      writer.Write(i);
+  });
+
+  ReportBenchmark("small writes to file", ms, size, 0);
+
+  ms = FastestRun([&]() {
+    StreamReader reader(FileIO::fopen(filename.c_str(), "rb"));
+    uint32_t val = 0;
+    for(uint32_t i = 0; i < numWrites; i++)
+      reader.Read(val);
+    CHECK(val == numWrites - 1);
+  });
+
+  ReportBenchmark("small reads from file", ms, size, 0);
+
+  FileIO::Delete(filename.c_str());
+};
+
+TEST_CASE("Benchmark compression throughput", "[.][benchmark][streamio][lz4][zstd]")
+{
+  // compress the output of the chunk benchmark so the data has a realistic mix of headers, small
+  // values and larger blobs
+  StreamWriter chunks(StreamWriter::DefaultScratchSize);
+  {
+    bytebuf bufferData;
+    bufferData.resize(benchBufferSize);
+    for(size_t i = 0; i < bufferData.size(); i++)
+      bufferData[i] = byte((i * 7) ^ (i >> 8));
+
+    WriteSerialiser ser(&chunks, Ownership::Nothing);
+    WriteBenchChunks(ser, bufferData);
+  }
+
+  const uint64_t size = chunks.GetOffset();
+
+  StreamWriter compressed(StreamWriter::DefaultScratchSize);
+
+  // each compressor is measured on a single thread and then across the worker pool, to see what the
+  // batched paths gain. The output format is the same either way. At least two threads are used so
+  // that on a single core machine this shows the overhead of the batched paths instead.
+  const uint32_t numThreads = RDCMAX(2U, Threading::MaxParallelThreads());
+
+  for(uint32_t threads : {1U, numThreads})
+  {
+    rdcstr suffix = threads == 1 ? rdcstr() : StringFormat::Fmt(" (%u threads)", threads);
+
+    double ms = FastestRun([&]() {
+      compressed.Rewind();
+      StreamWriter writer(new LZ4Compressor(&compressed, Ownership::Nothing, threads),
+                          Ownership::Stream);
+      writer.Write(chunks.GetData(), size);
+      writer.Finish();
+    });
+
+    ReportBenchmark(("lz4 compress" + suffix).c_str(), ms, size, 0);
+
+    // lz4 pages depend on the previous page, so decompression is always single threaded
+    if(threads == 1)
+    {
+      ms = FastestRun([&]() {
+        StreamReader reader(new LZ4Decompressor(
+                                new StreamReader(compressed.GetData(), compressed.GetOffset()),
+                                Ownership::Stream),
+                            size, Ownership::Stream);
+        reader.SkipBytes(size);
+        CHECK_FALSE(reader.IsErrored());
+      });
+
+      ReportBenchmark("lz4 decompress", ms, size, 0);
+    }
+
+    ms = FastestRun([&]() {
+      compressed.Rewind();
+      StreamWriter writer(new ZSTDCompressor(&compressed, Ownership::Nothing, threads),
+                          Ownership::Stream);
+      writer.Write(chunks.GetData(), size);
+      writer.Finish();
+    });
+
+    ReportBenchmark(("zstd compress" + suffix).c_str(), ms, size, 0);
+
+    ms = FastestRun([&]() {
+      StreamReader reader(new ZSTDDecompressor(
+                              new StreamReader(compressed.GetData(), compressed.GetOffset()),
+                              Ownership::Stream, threads),
+                          size, Ownership::Stream);
+      reader.SkipBytes(size);
+      CHECK_FALSE(reader.IsErrored());
+    });
+
+    ReportBenchmark(("zstd decompress" + suffix).c_str(), ms, size, 0);
+  }
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -36,6 +36,8 @@ ReplayStatus exportChrome(const char *filename, const RDCFile &rdc, const SDFile
   if(!f)
     return ReplayStatus::FileIOFailed;
 
+  // each event is written out as it's formatted, so nothing proportional to the number of chunks
+  // is held in memory.
   rdcstr str;
 
   // add header, customise this as needed.
@@ -43,6 +45,8 @@ ReplayStatus exportChrome(const char *filename, const RDCFile &rdc, const SDFile
   "displayTimeUnit": "ns",
   "traceEvents": [)";
 
+  FileIO::fwrite(str.data(), 1, str.size(), f);
+
   const char *category = "Initialisation";
 
   // stupid JSON not allowing trailing ,s :(
@@ -56,6 +60,8 @@ ReplayStatus exportChrome(const char *filename, const RDCFile &rdc, const SDFile
     if(chunk->metadata.chunkID == (uint32_t)SystemChunk::FirstDriverChunk + 1)
       category = "Frame Capture";
 
+    str.clear();
+
     if(!first)
       str += ",";
 
@@ -75,6 +81,8 @@ ReplayStatus exportChrome(const char *filename, const RDCFile &rdc, const SDFile
         fmt, chunk->name.c_str(), category, chunk->metadata.timestampMicro, chunk->metadata.threadID,
         chunk->metadata.timestampMicro + chunk->metadata.durationMicro, chunk->metadata.threadID);
 
+    FileIO::fwrite(str.data(), 1, str.size(), f);
+
     if(progress)
       progress(float(i) / float(numChunks));
 
@@ -85,7 +93,7 @@ ReplayStatus exportChrome(const char *filename, const RDCFile &rdc, const SDFile
     progress(1.0f);
 
   // end trace events
-  str += "\n  ]\n}";
+  str = "\n  ]\n}";
 
   FileIO::fwrite(str.data(), 1, str.size(), f);
 
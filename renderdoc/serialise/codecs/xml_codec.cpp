@@ -27,6 +27,7 @@
 #include "common/common.h"
 #include "common/formatting.h"
 #include "serialise/rdcfile.h"
+#include "serialise/serialiser.h"
 #include "strings/string_utils.h"
 
 #include "miniz/miniz.h"
@@ -68,6 +69,17 @@ struct xml_file_writer : pugi::xml_writer
   }
 
   void write(const void *data, size_t size) { stream.Write(data, size); }
+  void write(const char *str) { stream.Write(str, strlen(str)); }
+  // print and discard every child of parent, so only the nodes that haven't been written yet are
+  // kept in memory.
+  void flush(pugi::xml_node parent, unsigned int depth)
+  {
+    while(parent.first_child())
+    {
+      parent.first_child().print(*this, "\t", pugi::format_default, pugi::encoding_auto, depth);
+      parent.remove_child(parent.first_child());
+    }
+  }
 };
 
 // avoid &, <, and > since they throw off the ascii alignment
@@ -278,6 +290,13 @@ static ReplayStatus Structured2XML(const char *filename, const RDCFile &file, ui
                                    const StructuredChunkList &chunks,
                                    RENDERDOC_ProgressCallback progress)
 {
+  xml_file_writer writer(filename);
+
+  // a capture can be enormous when converted to XML, so rather than building the whole document
+  // in memory and saving it at the end, each node under the root is written out as soon as it's
+  // complete. The output is the same as saving the document in one go.
+  writer.write("<?xml version=\"1.0\"?>\n<rdc>\n");
+
   pugi::xml_document doc;
 
   pugi::xml_node xRoot = doc.append_child("rdc");
@@ -323,6 +342,8 @@ static ReplayStatus Structured2XML(const char *filename, const RDCFile &file, ui
   // write all other sections
   for(int i = 0; i < file.NumSections(); i++)
   {
+    writer.flush(xRoot, 1);
+
     const SectionProperties &props = file.GetSectionProperties(i);
 
     if(props.type == SectionType::FrameCapture)
@@ -376,6 +397,10 @@ static ReplayStatus Structured2XML(const char *filename, const RDCFile &file, ui
       xSection.append_attribute("lz4");
     if(props.flags & SectionFlags::ZstdCompressed)
       xSection.append_attribute("zstd");
+    if(props.flags & SectionFlags::SeekIndexed)
+      xSection.append_attribute("seekindex");
+    if(props.flags & SectionFlags::ZstdDictionary)
+      xSection.append_attribute("zstddict");
 
     pugi::xml_node name = xSection.append_child("name");
     name.text() = props.name.c_str();
@@ -409,12 +434,18 @@ static ReplayStatus Structured2XML(const char *filename, const RDCFile &file, ui
     delete reader;
   }
 
+  writer.flush(xRoot, 1);
+
   if(progress)
     progress(StructuredProgress(0.2f));
 
-  pugi::xml_node xChunks = xRoot.append_child("chunks");
+  // pugixml writes an empty node as self-closing
+  if(chunks.empty())
+    writer.write(StringFormat::Fmt("\t<chunks version=\"%llu\" />\n", version).c_str());
+  else
+    writer.write(StringFormat::Fmt("\t<chunks version=\"%llu\">\n", version).c_str());
 
-  xChunks.append_attribute("version") = version;
+  pugi::xml_node xChunks = doc.append_child("chunks");
 
   for(size_t c = 0; c < chunks.size(); c++)
   {
@@ -455,20 +486,28 @@ static ReplayStatus Structured2XML(const char *filename, const RDCFile &file, ui
         Obj2XML(xChunk, *chunk->GetChild(o));
     }
 
+    writer.flush(xChunks, 2);
+
+    // if the chunk's contents can be regenerated on demand, don't keep them around after writing.
+    // This does nothing for files that are shared, such as the replay's own structured file.
+    chunk->ReleaseLazyChildren();
+
     if(progress)
       progress(StructuredProgress(0.2f + 0.8f * (float(c) / float(chunks.size()))));
   }
 
-  xml_file_writer writer(filename);
-  doc.save(writer);
+  if(!chunks.empty())
+    writer.write("\t</chunks>\n");
+
+  writer.write("</rdc>\n");
 
   return writer.stream.IsErrored() ? ReplayStatus::FileIOFailed : ReplayStatus::Succeeded;
 }
 
-static SDObject *XML2Obj(pugi::xml_node &obj)
+static SDObject *XML2Obj(SDFile &file, pugi::xml_node &obj)
 {
-  SDObject *ret = new SDObject(rdcstr(obj.attribute("name").as_string()),
-                               rdcstr(obj.attribute("typename").as_string()));
+  SDObject *ret = new SDObject(InternSDString(file, obj.attribute("name").as_string()),
+                               InternSDString(file, obj.attribute("typename").as_string()));
 
   rdcstr name = obj.name();
 
@@ -516,7 +555,7 @@ static SDObject *XML2Obj(pugi::xml_node &obj)
   {
     for(pugi::xml_node child = obj.first_child(); child; child = child.next_sibling())
     {
-      SDObject *c = ret->AddAndOwnChild(XML2Obj(child));
+      SDObject *c = ret->AddAndOwnChild(XML2Obj(file, child));
 
       if(ret->type.basetype == SDBasic::Array)
         c->name = "$el";
@@ -560,8 +599,7 @@ static SDObject *XML2Obj(pugi::xml_node &obj)
 
 static ReplayStatus XML2Structured(const char *xml, const ThumbTypeAndData &thumb,
                                    const ThumbTypeAndData &extThumb, const bytebuf &logfile,
-                                   const StructuredBufferList &buffers, RDCFile *rdc,
-                                   uint64_t &version, StructuredChunkList &chunks,
+                                   RDCFile *rdc, SDFile &structData,
                                    RENDERDOC_ProgressCallback progress)
 {
   pugi::xml_document doc;
@@ -698,6 +736,10 @@ static ReplayStatus XML2Structured(const char *xml, const ThumbTypeAndData &thum
       props.flags |= SectionFlags::LZ4Compressed;
     if(xSection.attribute("zstd"))
       props.flags |= SectionFlags::ZstdCompressed;
+    if(xSection.attribute("seekindex"))
+      props.flags |= SectionFlags::SeekIndexed;
+    if(xSection.attribute("zstddict"))
+      props.flags |= SectionFlags::ZstdDictionary;
 
     pugi::xml_node name = xSection.child("name");
     if(!name)
@@ -773,7 +815,7 @@ static ReplayStatus XML2Structured(const char *xml, const ThumbTypeAndData &thum
     return ReplayStatus::FileCorrupted;
   }
 
-  version = xChunks.attribute("version").as_ullong();
+  structData.version = xChunks.attribute("version").as_ullong();
 
   size_t chunkIdx = 0;
   size_t numChunks = std::distance(xChunks.begin(), xChunks.end());
@@ -783,7 +825,7 @@ static ReplayStatus XML2Structured(const char *xml, const ThumbTypeAndData &thum
     if(strcmp(xChunk.name(), "chunk") != 0)
       return ReplayStatus::FileCorrupted;
 
-    SDChunk *chunk = new SDChunk(rdcstr(xChunk.attribute("name").as_string()));
+    SDChunk *chunk = new SDChunk(InternSDString(structData, xChunk.attribute("name").as_string()));
 
     chunk->metadata.chunkID = xChunk.attribute("id").as_uint();
     chunk->metadata.length = xChunk.attribute("length").as_uint();
@@ -821,10 +863,10 @@ static ReplayStatus XML2Structured(const char *xml, const ThumbTypeAndData &thum
     else
     {
       for(pugi::xml_node child = xChunk.first_child(); child; child = child.next_sibling())
-        chunk->AddAndOwnChild(XML2Obj(child));
+        chunk->AddAndOwnChild(XML2Obj(structData, child));
     }
 
-    chunks.push_back(chunk);
+    structData.chunks.push_back(chunk);
 
     if(progress)
       progress(StructuredProgress(0.2f + 0.8f * (float(chunkIdx) / float(numChunks))));
@@ -1031,8 +1073,7 @@ ReplayStatus importXMLZ(const char *filename, StreamReader &reader, RDCFile *rdc
   buf.resize((size_t)reader.GetSize());
   reader.Read(buf.data(), buf.size());
 
-  return XML2Structured(buf.c_str(), thumb, extThumb, logfile, structData.buffers, rdc,
-                        structData.version, structData.chunks, progress);
+  return XML2Structured(buf.c_str(), thumb, extThumb, logfile, rdc, structData, progress);
 }
 
 ReplayStatus exportXMLZ(const char *filename, const RDCFile &rdc, const SDFile &structData,
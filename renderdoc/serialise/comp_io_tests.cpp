@@ -190,4 +190,409 @@ TEST_CASE("Test ZSTD compression/decompression", "[streamio][zstd]")
   delete[] randomData;
 };
 
+TEST_CASE("Test multi-threaded compression", "[streamio][lz4][zstd]")
+{
+  // use an odd size so that the last page of the last batch is partial
+  const uint64_t dataSize = 9 * 1024 * 1024 + 1234;
+
+  byte *data = new byte[(size_t)dataSize];
+
+  // a mix of repeated and random data, where the repeats span page boundaries
+  for(uint64_t i = 0; i < dataSize; i++)
+    data[i] = ((i / 100000) % 3) == 0 ? byte(rand() & 0xff) : byte((i * 7) & 0xff);
+
+  byte *readData = new byte[(size_t)dataSize];
+
+  SECTION("LZ4")
+  {
+    StreamWriter buf(StreamWriter::DefaultScratchSize);
+
+    {
+      StreamWriter writer(new LZ4Compressor(&buf, Ownership::Nothing, 4), Ownership::Stream);
+
+      // write in uneven pieces to exercise page spanning
+      writer.Write(data, 1000);
+      writer.Write(data + 1000, dataSize - 1000);
+
+      CHECK(writer.GetOffset() == dataSize);
+      CHECK_FALSE(writer.IsErrored());
+
+      writer.Finish();
+
+      CHECK_FALSE(writer.IsErrored());
+    }
+
+    CHECK(buf.GetOffset() < dataSize / 2);
+
+    StreamReader reader(
+        new LZ4Decompressor(new StreamReader(buf.GetData(), buf.GetOffset()), Ownership::Stream),
+        dataSize, Ownership::Stream);
+
+    reader.Read(readData, dataSize);
+    CHECK_FALSE(memcmp(readData, data, (size_t)dataSize));
+
+    CHECK_FALSE(reader.IsErrored());
+    CHECK(reader.AtEnd());
+  };
+
+  SECTION("ZSTD")
+  {
+    StreamWriter buf(StreamWriter::DefaultScratchSize);
+
+    {
+      StreamWriter writer(new ZSTDCompressor(&buf, Ownership::Nothing, 4), Ownership::Stream);
+
+      writer.Write(data, 1000);
+      writer.Write(data + 1000, dataSize - 1000);
+
+      CHECK(writer.GetOffset() == dataSize);
+      CHECK_FALSE(writer.IsErrored());
+
+      writer.Finish();
+
+      CHECK_FALSE(writer.IsErrored());
+    }
+
+    CHECK(buf.GetOffset() < dataSize / 2);
+
+    SECTION("Single-threaded decompression")
+    {
+      StreamReader reader(new ZSTDDecompressor(new StreamReader(buf.GetData(), buf.GetOffset()),
+                                               Ownership::Stream),
+                          dataSize, Ownership::Stream);
+
+      reader.Read(readData, dataSize);
+      CHECK_FALSE(memcmp(readData, data, (size_t)dataSize));
+
+      CHECK_FALSE(reader.IsErrored());
+      CHECK(reader.AtEnd());
+    };
+
+    SECTION("Multi-threaded decompression")
+    {
+      StreamReader reader(new ZSTDDecompressor(new StreamReader(buf.GetData(), buf.GetOffset()),
+                                               Ownership::Stream, 3),
+                          dataSize, Ownership::Stream);
+
+      // read in uneven pieces to exercise batch boundaries
+      reader.Read(readData, 5000);
+      reader.Read(readData + 5000, dataSize - 5000);
+      CHECK_FALSE(memcmp(readData, data, (size_t)dataSize));
+
+      CHECK_FALSE(reader.IsErrored());
+      CHECK(reader.AtEnd());
+    };
+
+    SECTION("Multi-threaded recompression")
+    {
+      ZSTDDecompressor decomp(new StreamReader(buf.GetData(), buf.GetOffset()), Ownership::Stream,
+                              3);
+
+      StreamWriter recompressed(StreamWriter::DefaultScratchSize);
+      {
+        ZSTDCompressor comp(&recompressed, Ownership::Nothing);
+        CHECK(decomp.Recompress(&comp));
+      }
+
+      StreamReader reader(new ZSTDDecompressor(new StreamReader(recompressed.GetData(),
+                                                                recompressed.GetOffset()),
+                                               Ownership::Stream),
+                          dataSize, Ownership::Stream);
+
+      reader.Read(readData, dataSize);
+      CHECK_FALSE(memcmp(readData, data, (size_t)dataSize));
+
+      CHECK_FALSE(reader.IsErrored());
+      CHECK(reader.AtEnd());
+    };
+  };
+
+  delete[] readData;
+  delete[] data;
+};
+
+TEST_CASE("Test seeking in compressed streams", "[streamio][lz4][zstd]")
+{
+  const uint64_t dataSize = 5 * 1024 * 1024 + 4321;
+
+  byte *data = new byte[(size_t)dataSize];
+
+  for(uint64_t i = 0; i < dataSize; i++)
+    data[i] = ((i / 70000) % 4) == 0 ? byte(rand() & 0xff) : byte((i * 13) & 0xff);
+
+  byte *readData = new byte[(size_t)dataSize];
+
+  // offsets to seek to - the start, page boundaries and points either side of them, points within
+  // pages, and the very end.
+  const uint64_t offsets[] = {
+      0,       1,       65535,           65536,        65537,    128 * 1024,      1024 * 1024,
+      1000000, 3333333, dataSize - 1000, dataSize - 1, dataSize, 1024 * 1024 - 1,
+  };
+
+  for(uint32_t numThreads : {1U, 4U})
+  {
+    for(bool zstd : {false, true})
+    {
+      StreamWriter buf(StreamWriter::DefaultScratchSize);
+
+      {
+        Compressor *comp = NULL;
+        if(zstd)
+          comp = new ZSTDCompressor(&buf, Ownership::Nothing, numThreads);
+        else
+          comp = new LZ4Compressor(&buf, Ownership::Nothing, numThreads);
+
+        comp->EnableSeekIndex();
+
+        StreamWriter writer(comp, Ownership::Stream);
+
+        writer.Write(data, dataSize);
+        writer.Finish();
+
+        CHECK_FALSE(writer.IsErrored());
+      }
+
+      // read the seek index from the end of the stream
+      uint64_t numPoints = 0;
+      memcpy(&numPoints, buf.GetData() + buf.GetOffset() - sizeof(uint64_t), sizeof(uint64_t));
+
+      const uint64_t indexLength = numPoints * sizeof(CompressedSeekPoint) + sizeof(uint64_t);
+      REQUIRE(indexLength < buf.GetOffset());
+
+      const uint64_t compressedLength = buf.GetOffset() - indexLength;
+
+      rdcarray<CompressedSeekPoint> points;
+      points.resize((size_t)numPoints);
+      memcpy(points.data(), buf.GetData() + compressedLength, points.byteSize());
+
+      REQUIRE(numPoints > 1);
+      CHECK(points[0].uncompressedOffset == 0);
+      CHECK(points[0].compressedOffset == 0);
+
+      // sequential reading of the stream should not be affected by the index
+      {
+        Decompressor *decomp = NULL;
+        StreamReader *compReader = new StreamReader(buf.GetData(), compressedLength);
+        if(zstd)
+          decomp = new ZSTDDecompressor(compReader, Ownership::Stream, numThreads);
+        else
+          decomp = new LZ4Decompressor(compReader, Ownership::Stream);
+
+        StreamReader reader(decomp, dataSize, Ownership::Stream);
+
+        reader.Read(readData, dataSize);
+        CHECK_FALSE(memcmp(readData, data, (size_t)dataSize));
+        CHECK_FALSE(reader.IsErrored());
+      }
+
+      {
+        Decompressor *decomp = NULL;
+        StreamReader *compReader = new StreamReader(buf.GetData(), compressedLength);
+        if(zstd)
+          decomp = new ZSTDDecompressor(compReader, Ownership::Stream, numThreads);
+        else
+          decomp = new LZ4Decompressor(compReader, Ownership::Stream);
+
+        decomp->SetSeekPoints(points);
+
+        StreamReader reader(decomp, dataSize, Ownership::Stream);
+
+        for(uint64_t offs : offsets)
+        {
+          reader.SetOffset(offs);
+
+          CHECK(reader.GetOffset() == offs);
+
+          uint64_t len = RDCMIN<uint64_t>(200000, dataSize - offs);
+
+          reader.Read(readData, len);
+          CHECK_FALSE(memcmp(readData, data + offs, (size_t)len));
+          CHECK_FALSE(reader.IsErrored());
+        }
+
+        // seek back to the start and read everything to make sure state is consistent
+        reader.SetOffset(0);
+        reader.Read(readData, dataSize);
+        CHECK_FALSE(memcmp(readData, data, (size_t)dataSize));
+        CHECK_FALSE(reader.IsErrored());
+        CHECK(reader.AtEnd());
+      }
+    }
+  }
+
+  delete[] readData;
+  delete[] data;
+};
+
+TEST_CASE("Test ZSTD dictionary compression", "[streamio][zstd]")
+{
+  // build data that looks vaguely like a capture - many different small structures that each repeat
+  // a few times throughout the data, mostly too far apart to be matched within a page, with some
+  // varying fields in between.
+  const uint32_t numTemplates = 2000;
+  const uint32_t templateSize = 64;
+
+  byte *templates = new byte[numTemplates * templateSize];
+
+  for(uint32_t i = 0; i < numTemplates * templateSize; i++)
+    templates[i] = rand() & 0xff;
+
+  const uint64_t dataSize = 6 * 1024 * 1024 + 1234;
+
+  byte *data = new byte[(size_t)dataSize];
+
+  for(uint64_t i = 0; i < dataSize; i += templateSize + 8)
+  {
+    uint32_t fields[2] = {uint32_t(i), uint32_t(rand())};
+
+    memcpy(data + i, templates + (rand() % numTemplates) * templateSize,
+           (size_t)RDCMIN<uint64_t>(templateSize, dataSize - i));
+    if(i + templateSize < dataSize)
+      memcpy(data + i + templateSize, fields,
+             (size_t)RDCMIN<uint64_t>(sizeof(fields), dataSize - i - templateSize));
+  }
+
+  byte *readData = new byte[(size_t)dataSize];
+
+  StreamWriter plain(StreamWriter::DefaultScratchSize);
+
+  {
+    StreamWriter writer(new ZSTDCompressor(&plain, Ownership::Nothing), Ownership::Stream);
+
+    writer.Write(data, dataSize);
+    writer.Finish();
+
+    CHECK_FALSE(writer.IsErrored());
+  }
+
+  for(uint32_t numThreads : {1U, 4U})
+  {
+    StreamWriter buf(StreamWriter::DefaultScratchSize);
+
+    {
+      ZSTDCompressor *comp = new ZSTDCompressor(&buf, Ownership::Nothing, numThreads);
+      comp->EnableDictionary();
+      comp->EnableSeekIndex();
+
+      StreamWriter writer(comp, Ownership::Stream);
+
+      // write in a few pieces so the data is split across the training set
+      writer.Write(data, 1000);
+      writer.Write(data + 1000, dataSize - 1000);
+      writer.Finish();
+
+      CHECK_FALSE(writer.IsErrored());
+    }
+
+    uint64_t numPoints = 0;
+    memcpy(&numPoints, buf.GetData() + buf.GetOffset() - sizeof(uint64_t), sizeof(uint64_t));
+
+    const uint64_t indexLength = numPoints * sizeof(CompressedSeekPoint) + sizeof(uint64_t);
+    REQUIRE(indexLength < buf.GetOffset());
+
+    const uint64_t compressedLength = buf.GetOffset() - indexLength;
+
+    CHECK(compressedLength < plain.GetOffset());
+
+    rdcarray<CompressedSeekPoint> points;
+    points.resize((size_t)numPoints);
+    memcpy(points.data(), buf.GetData() + compressedLength, points.byteSize());
+
+    REQUIRE(numPoints > 1);
+
+    // the first page comes after the dictionary
+    uint32_t dictSize = 0;
+    memcpy(&dictSize, buf.GetData(), sizeof(dictSize));
+    CHECK(dictSize > 0);
+    CHECK(points[0].compressedOffset == sizeof(dictSize) + dictSize);
+
+    // sequential read
+    {
+      ZSTDDecompressor *decomp = new ZSTDDecompressor(
+          new StreamReader(buf.GetData(), compressedLength), Ownership::Stream, numThreads);
+      decomp->EnableDictionary();
+
+      StreamReader reader(decomp, dataSize, Ownership::Stream);
+
+      reader.Read(readData, dataSize);
+      CHECK_FALSE(memcmp(readData, data, (size_t)dataSize));
+      CHECK_FALSE(reader.IsErrored());
+      CHECK(reader.AtEnd());
+    }
+
+    // seeking, starting before anything has been read so the dictionary hasn't been loaded yet
+    {
+      ZSTDDecompressor *decomp = new ZSTDDecompressor(
+          new StreamReader(buf.GetData(), compressedLength), Ownership::Stream, numThreads);
+      decomp->EnableDictionary();
+      decomp->SetSeekPoints(points);
+
+      StreamReader reader(decomp, dataSize, Ownership::Stream);
+
+      for(uint64_t offs : {(uint64_t)3333333, (uint64_t)100, dataSize - 10})
+      {
+        reader.SetOffset(offs);
+
+        uint64_t len = RDCMIN<uint64_t>(200000, dataSize - offs);
+
+        reader.Read(readData, len);
+        CHECK_FALSE(memcmp(readData, data + offs, (size_t)len));
+        CHECK_FALSE(reader.IsErrored());
+      }
+    }
+
+    // recompressing without the dictionary gives the same result as compressing without it
+    {
+      ZSTDDecompressor decomp(new StreamReader(buf.GetData(), compressedLength), Ownership::Stream,
+                              numThreads);
+      decomp.EnableDictionary();
+
+      StreamWriter recompressed(StreamWriter::DefaultScratchSize);
+      {
+        ZSTDCompressor comp(&recompressed, Ownership::Nothing);
+        CHECK(decomp.Recompress(&comp));
+      }
+
+      CHECK(recompressed.GetOffset() == plain.GetOffset());
+      CHECK_FALSE(memcmp(recompressed.GetData(), plain.GetData(), (size_t)plain.GetOffset()));
+    }
+  }
+
+  // with too little data to build a dictionary from, an empty one is written
+  {
+    StreamWriter buf(StreamWriter::DefaultScratchSize);
+
+    {
+      ZSTDCompressor *comp = new ZSTDCompressor(&buf, Ownership::Nothing);
+      comp->EnableDictionary();
+
+      StreamWriter writer(comp, Ownership::Stream);
+
+      writer.Write(data, 10000);
+      writer.Finish();
+
+      CHECK_FALSE(writer.IsErrored());
+    }
+
+    uint32_t dictSize = ~0U;
+    memcpy(&dictSize, buf.GetData(), sizeof(dictSize));
+    CHECK(dictSize == 0);
+
+    ZSTDDecompressor *decomp =
+        new ZSTDDecompressor(new StreamReader(buf.GetData(), buf.GetOffset()), Ownership::Stream);
+    decomp->EnableDictionary();
+
+    StreamReader reader(decomp, 10000, Ownership::Stream);
+
+    reader.Read(readData, 10000);
+    CHECK_FALSE(memcmp(readData, data, 10000));
+    CHECK_FALSE(reader.IsErrored());
+    CHECK(reader.AtEnd());
+  }
+
+  delete[] readData;
+  delete[] data;
+  delete[] templates;
+};
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -23,9 +23,22 @@
  ******************************************************************************/
 
 #include "lz4io.h"
+#include "common/threading.h"
 
 static const uint64_t lz4BlockSize = 64 * 1024;
 
+// when compressing on multiple threads, how many pages each thread compresses per batch. Each
+// thread has to hash in its preceding page as history before starting, so this amortises that.
+static const uint32_t lz4PagesPerThread = 8;
+
+// the most pages in one batch regardless of the thread count, to bound the memory held for pages
+// in-flight at around 4MB including their compressed copies.
+static const uint32_t lz4MaxBatchPages = 32;
+
+// when building a seek index, how often (in pages) to start a block with no history. Blocks in
+// between reference the previous page as normal, so seeking decompresses at most this many pages.
+static const uint64_t lz4SeekInterval = 16;
+
 LZ4Compressor::LZ4Compressor(StreamWriter *write, Ownership own) : Compressor(write, own)
 {
   m_Page[0] = AllocAlignedBuffer(lz4BlockSize);
@@ -37,12 +50,57 @@ LZ4Compressor::LZ4Compressor(StreamWriter *write, Ownership own) : Compressor(wr
   m_LZ4Comp = LZ4_createStream();
 }
 
-LZ4Compressor::~LZ4Compressor()
+LZ4Compressor::LZ4Compressor(StreamWriter *write, Ownership own, uint32_t numThreads)
+    : LZ4Compressor(write, own)
 {
+  if(numThreads <= 1)
+    return;
+
+  m_NumThreads = numThreads;
+
+  // m_Page[0] will point into the batch, so release the page we allocated for it
   FreeAlignedBuffer(m_Page[0]);
+
+  const uint32_t batchSize = RDCMIN(m_NumThreads * lz4PagesPerThread, lz4MaxBatchPages);
+
+  m_BatchPages.resize(batchSize);
+  m_BatchCompressed.resize(batchSize);
+  m_BatchLengths.resize(batchSize);
+  m_BatchCompSizes.resize(batchSize);
+
+  for(uint32_t i = 0; i < batchSize; i++)
+  {
+    m_BatchPages[i] = AllocAlignedBuffer(lz4BlockSize);
+    m_BatchCompressed[i] = AllocAlignedBuffer(LZ4_COMPRESSBOUND(lz4BlockSize));
+  }
+
+  m_Page[0] = m_BatchPages[0];
+}
+
+LZ4Compressor::~LZ4Compressor()
+{
+  FreeBuffers();
+  LZ4_freeStream(m_LZ4Comp);
+}
+
+void LZ4Compressor::FreeBuffers()
+{
+  if(m_NumThreads > 1)
+  {
+    for(byte *page : m_BatchPages)
+      FreeAlignedBuffer(page);
+    for(byte *page : m_BatchCompressed)
+      FreeAlignedBuffer(page);
+    m_BatchPages.clear();
+    m_BatchCompressed.clear();
+  }
+  else
+  {
+    FreeAlignedBuffer(m_Page[0]);
+  }
   FreeAlignedBuffer(m_Page[1]);
   FreeAlignedBuffer(m_CompressBuffer);
-  LZ4_freeStream(m_LZ4Comp);
+  m_Page[0] = m_Page[1] = m_CompressBuffer = NULL;
 }
 
 bool LZ4Compressor::Write(const void *data, uint64_t numBytes)
@@ -115,7 +173,16 @@ bool LZ4Compressor::Finish()
   // precisely 64kb in size
   // only the last one can be smaller, so we only write a partial page when finishing.
   // Calling Write() after Finish() is illegal
-  return FlushPage0();
+  bool success = FlushPage0();
+
+  // compress whatever is left in a partial batch
+  if(success && m_NumThreads > 1 && m_BatchCount > 0)
+    success &= CompressBatch();
+
+  if(success)
+    success &= WriteSeekIndex();
+
+  return success;
 }
 
 bool LZ4Compressor::FlushPage0()
@@ -124,6 +191,29 @@ bool LZ4Compressor::FlushPage0()
   if(!m_CompressBuffer)
     return false;
 
+  if(m_NumThreads > 1)
+  {
+    // queue this page in the batch and move on to the next one, only compressing once the batch is
+    // full.
+    m_BatchLengths[m_BatchCount] = m_PageOffset;
+    m_BatchCount++;
+
+    m_PageOffset = 0;
+
+    if(m_BatchCount == m_BatchPages.size())
+      return CompressBatch();
+
+    m_Page[0] = m_BatchPages[m_BatchCount];
+
+    return true;
+  }
+
+  // if we're building a seek index, regularly start a block with no history
+  const bool seekPoint = m_SeekIndex && (m_NumPages % lz4SeekInterval) == 0;
+
+  if(seekPoint)
+    LZ4_loadDict(m_LZ4Comp, NULL, 0);
+
   // m_PageOffset is the amount written, usually equal to lz4BlockSize except the last block.
   int32_t compSize =
       LZ4_compress_fast_continue(m_LZ4Comp, (const char *)m_Page[0], (char *)m_CompressBuffer,
@@ -132,13 +222,15 @@ bool LZ4Compressor::FlushPage0()
   if(compSize < 0)
   {
     RDCERR("Error compressing: %i", compSize);
-    FreeAlignedBuffer(m_Page[0]);
-    FreeAlignedBuffer(m_Page[1]);
-    FreeAlignedBuffer(m_CompressBuffer);
-    m_Page[0] = m_Page[1] = m_CompressBuffer = NULL;
+    FreeBuffers();
     return false;
   }
 
+  if(seekPoint)
+    AddSeekPoint(m_NumPages * lz4BlockSize);
+
+  m_NumPages++;
+
   bool success = true;
 
   success &= m_Write->Write(compSize);
@@ -153,6 +245,75 @@ bool LZ4Compressor::FlushPage0()
   return success;
 }
 
+bool LZ4Compressor::IsSeekPage(uint32_t batchIndex) const
+{
+  return m_SeekIndex && ((m_NumPages + batchIndex) % lz4SeekInterval) == 0;
+}
+
+bool LZ4Compressor::CompressBatch()
+{
+  // lz4 blocks aren't independent - each one can reference the previous 64kb of uncompressed data.
+  // Since all pages before the last are full, each range of pages handed to a thread can start a
+  // fresh stream with its preceding page loaded as the dictionary, and the blocks it produces will
+  // decompress exactly as if they came from one continuous stream.
+  const byte *history = m_HasHistory ? m_Page[1] : NULL;
+
+  Threading::ParallelForRanges(m_BatchCount, m_NumThreads, [this, history](uint32_t begin,
+                                                                            uint32_t end) {
+    LZ4_stream_t *comp = LZ4_createStream();
+
+    for(uint32_t i = begin; i < end; i++)
+    {
+      if(IsSeekPage(i))
+      {
+        LZ4_loadDict(comp, NULL, 0);
+      }
+      else if(i == begin)
+      {
+        const byte *dict = begin == 0 ? history : m_BatchPages[begin - 1];
+        LZ4_loadDict(comp, (const char *)dict, dict ? (int)lz4BlockSize : 0);
+      }
+
+      m_BatchCompSizes[i] = LZ4_compress_fast_continue(
+          comp, (const char *)m_BatchPages[i], (char *)m_BatchCompressed[i],
+          (int)m_BatchLengths[i], (int)LZ4_COMPRESSBOUND(lz4BlockSize), 20);
+    }
+
+    LZ4_freeStream(comp);
+  });
+
+  bool success = true;
+
+  for(uint32_t i = 0; i < m_BatchCount; i++)
+  {
+    int32_t compSize = m_BatchCompSizes[i];
+
+    if(compSize < 0)
+    {
+      RDCERR("Error compressing: %i", compSize);
+      FreeBuffers();
+      return false;
+    }
+
+    if(IsSeekPage(i))
+      AddSeekPoint((m_NumPages + i) * lz4BlockSize);
+
+    success &= m_Write->Write(compSize);
+    success &= m_Write->Write(m_BatchCompressed[i], compSize);
+  }
+
+  m_NumPages += m_BatchCount;
+
+  // the last page becomes the history for the next batch
+  std::swap(m_BatchPages[m_BatchCount - 1], m_Page[1]);
+  m_HasHistory = true;
+
+  m_BatchCount = 0;
+  m_Page[0] = m_BatchPages[0];
+
+  return success;
+}
+
 LZ4Decompressor::LZ4Decompressor(StreamReader *read, Ownership own) : Decompressor(read, own)
 {
   m_Page[0] = AllocAlignedBuffer(lz4BlockSize);
@@ -251,6 +412,36 @@ bool LZ4Decompressor::Read(void *data, uint64_t numBytes)
   return success;
 }
 
+bool LZ4Decompressor::Seek(uint64_t offset)
+{
+  // if we encountered a stream error this will be NULL
+  if(!m_CompressBuffer)
+    return false;
+
+  uint64_t pointOffset = 0;
+  if(!SeekToPoint(offset, pointOffset))
+    return false;
+
+  // the block at the seek point was compressed with no history, so start a fresh stream
+  LZ4_setStreamDecode(m_LZ4Decomp, NULL, 0);
+
+  m_PageOffset = 0;
+  m_PageLength = 0;
+
+  // decompress up to the page containing the offset, and consume data up to the offset in it.
+  uint64_t skip = offset - pointOffset;
+  while(skip > 0)
+  {
+    if(!FillPage0() || m_PageLength == 0)
+      return false;
+
+    m_PageOffset = RDCMIN(skip, m_PageLength);
+    skip -= m_PageOffset;
+  }
+
+  return true;
+}
+
 bool LZ4Decompressor::FillPage0()
 {
   // swap pages
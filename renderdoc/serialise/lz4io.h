@@ -31,6 +31,9 @@ class LZ4Compressor : public Compressor
 {
 public:
   LZ4Compressor(StreamWriter *write, Ownership own);
+  // compresses batches of pages across up to numThreads threads. The output is identical in format
+  // to the single-threaded compressor and decompresses with LZ4Decompressor as normal.
+  LZ4Compressor(StreamWriter *write, Ownership own, uint32_t numThreads);
   ~LZ4Compressor();
 
   bool Write(const void *data, uint64_t numBytes);
@@ -38,12 +41,26 @@ public:
 
 private:
   bool FlushPage0();
+  bool CompressBatch();
+  void FreeBuffers();
+  bool IsSeekPage(uint32_t batchIndex) const;
 
   byte *m_Page[2];
   byte *m_CompressBuffer;
   uint64_t m_PageOffset;
+  uint64_t m_NumPages = 0;
 
   LZ4_stream_t *m_LZ4Comp;
+
+  // only used when compressing on multiple threads. m_Page[0] points into m_BatchPages at the page
+  // currently being written, and m_Page[1] holds the last page of the previous batch as history.
+  uint32_t m_NumThreads = 1;
+  uint32_t m_BatchCount = 0;
+  bool m_HasHistory = false;
+  rdcarray<byte *> m_BatchPages;
+  rdcarray<uint64_t> m_BatchLengths;
+  rdcarray<byte *> m_BatchCompressed;
+  rdcarray<int32_t> m_BatchCompSizes;
 };
 
 class LZ4Decompressor : public Decompressor
@@ -54,6 +71,7 @@ public:
 
   bool Recompress(Compressor *comp);
   bool Read(void *data, uint64_t numBytes);
+  bool Seek(uint64_t offset);
 
 private:
   bool FillPage0();
@@ -27,11 +27,18 @@
 #include "api/replay/version.h"
 #include "common/dds_readwrite.h"
 #include "common/formatting.h"
+#include "common/threading.h"
+#include "core/settings.h"
 #include "jpeg-compressor/jpge.h"
 #include "stb/stb_image.h"
+#include "zstd/xxhash.h"
 #include "lz4io.h"
 #include "zstdio.h"
 
+RDOC_CONFIG(rdcstr, Capture_BlobStorePath, "",
+            "The directory holding the blob store for captures that have been packed with "
+            "renderdoccmd pack, used to find the contents of sections stored in it.");
+
 // not provided by tinyexr, just do by hand
 bool is_exr_file(FILE *f)
 {
@@ -133,6 +140,30 @@ bool is_exr_file(FILE *f)
      char sectionName[sectionNameLength]; // UTF-8 string name of section, optional.
 
      byte sectiondata[length]; // actual contents of the section
+
+     // the following flags change the layout of sectiondata and are only valid from version 0x103.
+     //
+     // if sectionFlags contains BlobReference, sectiondata is only a reference to a blob in a
+     // content-addressed blob store outside the file. The blob holds what sectiondata would have
+     // been and the other flags apply to it as normal:
+     // {
+     //   uint64_t hash;   // XXH64 hash of the blob contents
+     //   uint64_t length; // byte length of the blob
+     // }
+     //
+     // if sectionFlags contains ZstdDictionary, sectiondata begins with the dictionary that each
+     // page was compressed against. Any seek points are offsets past the dictionary:
+     // {
+     //   uint32_t dictionaryLength; // may be 0 if the section was too small to build one
+     //   byte dictionary[dictionaryLength];
+     // }
+     //
+     // if sectionFlags contains SeekIndexed, the last bytes of sectiondata are not part of the
+     // compressed stream but an index of points where decompression can begin:
+     // {
+     //   CompressedSeekPoint points[numPoints]; // uncompressed and compressed offsets
+     //   uint64_t numPoints;
+     // }
    }
  };
 
@@ -229,7 +260,21 @@ struct BinarySectionHeader
   // char name[sectionNameLength];
   // byte data[sectionLength];
 };
+
+// stored as the section data for sections with SectionFlags::BlobReference
+struct BlobReference
+{
+  // XXH64 hash of the blob contents
+  uint64_t hash;
+  // byte length of the blob
+  uint64_t length;
 };
+};
+
+static rdcstr GetBlobFilename(const rdcstr &blobStore, uint64_t hash, uint64_t length)
+{
+  return blobStore + StringFormat::Fmt("/%016llx-%llu", hash, length);
+}
 
 #define SETERROR(error, ...)                        \
   {                                                 \
@@ -344,8 +389,10 @@ void RDCFile::Init(StreamReader &reader)
   m_SerVer = header.version;
 
   // in v1.1 we changed chunk flags such that we could support 64-bit length. This is a backwards
-  // compatible change
-  if(m_SerVer != SERIALISE_VERSION && m_SerVer != V1_0_VERSION && m_SerVer != V1_1_VERSION)
+  // compatible change. v1.3 added section flags that change the layout of the section data, which
+  // older versions would misread so they must reject the file.
+  if(m_SerVer != SERIALISE_VERSION && m_SerVer != V1_0_VERSION && m_SerVer != V1_1_VERSION &&
+     m_SerVer != V1_2_VERSION)
   {
     if(header.version < V1_0_VERSION)
     {
@@ -819,13 +866,79 @@ int RDCFile::SectionIndex(const char *name) const
   return -1;
 }
 
+rdcstr RDCFile::GetBlobStore() const
+{
+  return m_BlobStore.empty() ? Capture_BlobStorePath() : m_BlobStore;
+}
+
+bool RDCFile::ReadBlobReference(int index, uint64_t &hash, uint64_t &length) const
+{
+  BlobReference ref = {};
+
+  FileIO::fseek64(m_File, m_SectionLocations[index].dataOffset, SEEK_SET);
+
+  if(m_SectionLocations[index].diskLength != sizeof(ref) ||
+     FileIO::fread(&ref, 1, sizeof(ref), m_File) != sizeof(ref))
+  {
+    RDCERR("Invalid blob reference in section %d", index);
+    return false;
+  }
+
+  hash = ref.hash;
+  length = ref.length;
+
+  return true;
+}
+
+FILE *RDCFile::OpenBlob(int index, const rdcstr &blobStore, uint64_t &length) const
+{
+  BlobReference ref = {};
+
+  if(!ReadBlobReference(index, ref.hash, ref.length))
+    return NULL;
+
+  if(blobStore.empty())
+  {
+    RDCERR("Section %d is stored in a blob store, but no blob store is configured", index);
+    return NULL;
+  }
+
+  rdcstr filename = GetBlobFilename(blobStore, ref.hash, ref.length);
+
+  if(FileIO::GetFileSize(filename) != ref.length)
+  {
+    RDCERR("Blob '%s' for section %d is missing or the wrong size", filename.c_str(), index);
+    return NULL;
+  }
+
+  length = ref.length;
+
+  return FileIO::fopen(filename.c_str(), "rb");
+}
+
 StreamReader *RDCFile::ReadSection(int index) const
+{
+  return OpenSectionReader(index, false, GetBlobStore());
+}
+
+StreamReader *RDCFile::ReadRawSection(int index) const
+{
+  return OpenSectionReader(index, true, GetBlobStore());
+}
+
+StreamReader *RDCFile::OpenSectionReader(int index, bool raw, const rdcstr &blobStore) const
 {
   if(m_Error != ContainerError::NoError)
     return new StreamReader(StreamReader::InvalidStream);
 
   if(m_File == NULL)
   {
+    if(raw)
+    {
+      RDCERR("Raw section data isn't available for sections in memory.");
+      return new StreamReader(StreamReader::InvalidStream);
+    }
+
     if(index < (int)m_MemorySections.size())
       return new StreamReader(m_MemorySections[index]);
 
@@ -835,23 +948,126 @@ StreamReader *RDCFile::ReadSection(int index) const
 
   const SectionProperties &props = m_Sections[index];
   SectionLocation offsetSize = m_SectionLocations[index];
-  FileIO::fseek64(m_File, offsetSize.dataOffset, SEEK_SET);
 
-  StreamReader *fileReader = new StreamReader(m_File, offsetSize.diskLength, Ownership::Nothing);
+  FILE *file = m_File;
+
+  // if the section is in the blob store, read everything from the blob instead
+  if(props.flags & SectionFlags::BlobReference)
+  {
+    file = OpenBlob(index, blobStore, offsetSize.diskLength);
+
+    if(file == NULL)
+      return new StreamReader(StreamReader::InvalidStream);
+
+    offsetSize.dataOffset = 0;
+  }
+
+  const Ownership fileOwnership = file == m_File ? Ownership::Nothing : Ownership::Stream;
+
+  if(raw)
+  {
+    FileIO::fseek64(file, offsetSize.dataOffset, SEEK_SET);
+
+    return new StreamReader(file, offsetSize.diskLength, fileOwnership);
+  }
+
+  rdcarray<CompressedSeekPoint> seekPoints;
+
+  if((props.flags & SectionFlags::SeekIndexed) &&
+     (props.flags & (SectionFlags::LZ4Compressed | SectionFlags::ZstdCompressed)))
+  {
+    // the seek index is at the end of the section data, with the number of points last
+    uint64_t numPoints = 0;
+
+    bool valid = false;
+
+    // check the section can hold the count before seeking to it, and fail on any short read
+    if(offsetSize.diskLength >= sizeof(uint64_t))
+    {
+      const uint64_t countOffset = offsetSize.dataOffset + offsetSize.diskLength - sizeof(uint64_t);
+      const uint64_t maxPoints =
+          (offsetSize.diskLength - sizeof(uint64_t)) / sizeof(CompressedSeekPoint);
+
+      FileIO::fseek64(file, countOffset, SEEK_SET);
+      valid = FileIO::fread(&numPoints, 1, sizeof(numPoints), file) == sizeof(numPoints) &&
+              numPoints <= maxPoints;
+
+      if(valid)
+      {
+        seekPoints.resize((size_t)numPoints);
+
+        FileIO::fseek64(file, countOffset - seekPoints.byteSize(), SEEK_SET);
+        valid = FileIO::fread(seekPoints.data(), 1, seekPoints.byteSize(), file) ==
+                seekPoints.byteSize();
+      }
+    }
+
+    if(!valid)
+    {
+      RDCERR("Invalid seek index in section %d", index);
+      if(file != m_File)
+        FileIO::fclose(file);
+      return new StreamReader(StreamReader::InvalidStream);
+    }
+
+    const uint64_t indexLength = seekPoints.byteSize() + sizeof(uint64_t);
+
+    // the compressed stream is only what comes before the index
+    offsetSize.diskLength -= indexLength;
+  }
+
+  if(m_MemoryMapping &&
+     !(props.flags & (SectionFlags::LZ4Compressed | SectionFlags::ZstdCompressed)))
+  {
+    FileIO::MappedFile *mapping =
+        FileIO::mmap_open(file, offsetSize.dataOffset, offsetSize.diskLength);
+
+    if(mapping)
+    {
+      // the mapping stays valid without the file
+      if(file != m_File)
+        FileIO::fclose(file);
+
+      return new StreamReader(mapping, offsetSize.diskLength);
+    }
+
+    // if the mapping failed (e.g. not enough address space) fall back to reading from the file
+  }
+
+  FileIO::fseek64(file, offsetSize.dataOffset, SEEK_SET);
+
+  StreamReader *fileReader = new StreamReader(file, offsetSize.diskLength, fileOwnership);
 
   StreamReader *compReader = NULL;
 
+  Decompressor *decompressor = NULL;
+
   if(props.flags & SectionFlags::LZ4Compressed)
   {
-    // the user will delete the compressed reader, and then it will delete the compressor and the
-    // file reader
-    compReader = new StreamReader(new LZ4Decompressor(fileReader, Ownership::Stream),
-                                  props.uncompressedSize, Ownership::Stream);
+    decompressor = new LZ4Decompressor(fileReader, Ownership::Stream);
   }
   else if(props.flags & SectionFlags::ZstdCompressed)
   {
-    compReader = new StreamReader(new ZSTDDecompressor(fileReader, Ownership::Stream),
-                                  props.uncompressedSize, Ownership::Stream);
+    // zstd pages are independent so we can read ahead and decompress several at once. LZ4 pages
+    // each depend on the previous page's contents so they must be decompressed in order.
+    const uint32_t numThreads = Threading::MaxParallelThreads();
+
+    ZSTDDecompressor *zstd = new ZSTDDecompressor(fileReader, Ownership::Stream, numThreads);
+
+    if(props.flags & SectionFlags::ZstdDictionary)
+      zstd->EnableDictionary();
+
+    decompressor = zstd;
+  }
+
+  if(decompressor)
+  {
+    if(!seekPoints.empty())
+      decompressor->SetSeekPoints(seekPoints);
+
+    // the user will delete the compressed reader, and then it will delete the decompressor and
+    // the file reader
+    compReader = new StreamReader(decompressor, props.uncompressedSize, Ownership::Stream);
   }
 
   // if we're compressing return that writer, otherwise return the file writer directly
@@ -859,12 +1075,28 @@ StreamReader *RDCFile::ReadSection(int index) const
 }
 
 StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
+{
+  return OpenSectionWriter(props, false);
+}
+
+StreamWriter *RDCFile::WriteRawSection(const SectionProperties &props)
+{
+  return OpenSectionWriter(props, true);
+}
+
+StreamWriter *RDCFile::OpenSectionWriter(const SectionProperties &props, bool raw)
 {
   if(m_Error != ContainerError::NoError)
     return new StreamWriter(StreamWriter::InvalidStream);
 
   RDCASSERT((size_t)props.type < (size_t)SectionType::Count);
 
+  if(m_File == NULL && raw)
+  {
+    RDCERR("Raw section data can't be written to sections in memory.");
+    return new StreamWriter(StreamWriter::InvalidStream);
+  }
+
   if(m_File == NULL)
   {
     // if we have no file to write to, we just cache it in memory for future use (e.g. later writing
@@ -1129,6 +1361,11 @@ StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
 
   uint64_t headerOffset = FileIO::ftell64(m_File);
 
+  // only raw data can be a blob reference, anything else is written into the file
+  SectionFlags flags = props.flags;
+  if(!raw)
+    flags &= ~SectionFlags::BlobReference;
+
   size_t numWritten;
 
   // write section header
@@ -1145,7 +1382,7 @@ StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
                                 // sectionVersion
                                 props.version,
                                 // sectionFlags
-                                props.flags,
+                                flags,
                                 // sectionNameLength
                                 uint32_t(name.length() + 1)};
 
@@ -1164,35 +1401,58 @@ StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
 
   StreamWriter *compWriter = NULL;
 
-  if(props.flags & SectionFlags::LZ4Compressed)
+  // compress pages on the shared worker pool. The compressors bound the memory for pages in-flight
+  // themselves.
+  const uint32_t numThreads = Threading::MaxParallelThreads();
+
+  Compressor *compressor = NULL;
+
+  // raw data is written exactly as it's given
+  if(raw)
+    compressor = NULL;
+  else if(props.flags & SectionFlags::LZ4Compressed)
+    compressor = new LZ4Compressor(fileWriter, Ownership::Stream, numThreads);
+  else if(props.flags & SectionFlags::ZstdCompressed)
   {
-    // the user will delete the compressed writer, and then it will delete the compressor and the
-    // file writer
-    compWriter =
-        new StreamWriter(new LZ4Compressor(fileWriter, Ownership::Stream), Ownership::Stream);
+    ZSTDCompressor *zstd = new ZSTDCompressor(fileWriter, Ownership::Stream, numThreads);
+
+    if(props.flags & SectionFlags::ZstdDictionary)
+      zstd->EnableDictionary();
+
+    compressor = zstd;
   }
-  else if(props.flags & SectionFlags::ZstdCompressed)
+
+  if(compressor)
   {
-    compWriter =
-        new StreamWriter(new ZSTDCompressor(fileWriter, Ownership::Stream), Ownership::Stream);
+    if(props.flags & SectionFlags::SeekIndexed)
+      compressor->EnableSeekIndex();
+
+    // the user will delete the compressed writer, and then it will delete the compressor and the
+    // file writer
+    compWriter = new StreamWriter(compressor, Ownership::Stream);
   }
 
   uint64_t dataOffset = FileIO::ftell64(m_File);
 
   m_CurrentWritingProps = props;
   m_CurrentWritingProps.name = name;
+  m_CurrentWritingProps.flags = flags;
 
   // register a destroy callback to tidy up the section at the end
-  fileWriter->AddCloseCallback([this, type, name, headerOffset, dataOffset, fileWriter, compWriter]() {
+  fileWriter->AddCloseCallback([this, type, name, headerOffset, dataOffset, fileWriter, compWriter,
+                                raw]() {
     FileIO::fflush(m_File);
 
     // the offset of the file writer is how many bytes were written to disk - the compressed length.
     uint64_t compressedLength = fileWriter->GetOffset();
 
-    // if there was no compression, this is also the uncompressed length.
+    // if there was no compression, this is also the uncompressed length. Raw data was compressed
+    // already, so it came with its uncompressed length
     uint64_t uncompressedLength = compressedLength;
     if(compWriter)
       uncompressedLength = compWriter->GetOffset();
+    else if(raw)
+      uncompressedLength = m_CurrentWritingProps.uncompressedSize;
 
     RDCLOG("Finishing write to section %u (%s). Compressed from %llu bytes to %llu (%.2f %%)", type,
            name.c_str(), uncompressedLength, compressedLength,
@@ -1257,3 +1517,184 @@ FILE *RDCFile::StealImageFileHandle(rdcstr &filename)
   m_File = NULL;
   return ret;
 }
+
+// copy all of reader into writer, and return the hash of the data copied. If writer is NULL the
+// data is only hashed
+static uint64_t HashedTransfer(StreamWriter *writer, StreamReader *reader)
+{
+  XXH64_state_t *state = XXH64_createState();
+  XXH64_reset(state, 0);
+
+  const uint64_t bufSize = 1024 * 1024;
+  byte *buf = new byte[(size_t)bufSize];
+
+  uint64_t remaining = reader->GetSize();
+
+  while(remaining > 0 && !reader->IsErrored() && (writer == NULL || !writer->IsErrored()))
+  {
+    uint64_t payloadLength = RDCMIN(bufSize, remaining);
+
+    reader->Read(buf, payloadLength);
+    if(writer)
+      writer->Write(buf, payloadLength);
+
+    XXH64_update(state, buf, (size_t)payloadLength);
+
+    remaining -= payloadLength;
+  }
+
+  delete[] buf;
+
+  uint64_t hash = XXH64_digest(state);
+  XXH64_freeState(state);
+
+  return hash;
+}
+
+bool RDCFile::HashSection(int index, uint64_t &hash) const
+{
+  if(index < 0 || index >= NumSections())
+    return false;
+
+  // blob references already store the hash of the raw data they refer to
+  if(m_File && (m_Sections[index].flags & SectionFlags::BlobReference))
+  {
+    uint64_t length = 0;
+    return ReadBlobReference(index, hash, length);
+  }
+
+  StreamReader *reader = ReadRawSection(index);
+
+  if(reader->IsErrored())
+  {
+    delete reader;
+    return false;
+  }
+
+  hash = HashedTransfer(NULL, reader);
+
+  bool ret = !reader->IsErrored();
+
+  delete reader;
+
+  return ret;
+}
+
+bool RDCFile::PackSections(RDCFile &dst, const rdcstr &blobStore, uint64_t minBlobSize) const
+{
+  if(blobStore.empty())
+  {
+    RDCERR("No blob store configured to pack sections into");
+    return false;
+  }
+
+  // creates the blob store directory itself
+  FileIO::CreateParentDirectory(blobStore + "/blob");
+
+  return CopySections(dst, blobStore, minBlobSize);
+}
+
+bool RDCFile::UnpackSections(RDCFile &dst, const rdcstr &blobStore) const
+{
+  return CopySections(dst, blobStore, ~0ULL);
+}
+
+bool RDCFile::CopySections(RDCFile &dst, const rdcstr &blobStore, uint64_t minBlobSize) const
+{
+  // several threads or processes may be packing into the same store at once, so temporary files
+  // are named by the process and a per-process counter
+  static int32_t tempCounter = 0;
+
+  for(int i = 0; i < NumSections(); i++)
+  {
+    SectionProperties props = m_Sections[i];
+
+    // sections are copied in their stored form, so nothing is decompressed or recompressed
+    StreamReader *reader = OpenSectionReader(i, true, blobStore);
+
+    const uint64_t length = reader->GetSize();
+
+    bool success = !reader->IsErrored();
+
+    if(success && length >= minBlobSize)
+    {
+      // we don't know the blob's name until it's been hashed, so write to a temporary file in the
+      // blob store first
+      rdcstr tempFilename = blobStore + StringFormat::Fmt("/incoming-%u-%d.tmp",
+                                                          Process::GetCurrentPID(),
+                                                          Atomic::Inc32(&tempCounter));
+
+      uint64_t hash = 0;
+
+      FILE *f = FileIO::fopen(tempFilename.c_str(), "wb");
+
+      if(f)
+      {
+        StreamWriter blobWriter(f, Ownership::Stream);
+        hash = HashedTransfer(&blobWriter, reader);
+        success = !blobWriter.IsErrored() && !reader->IsErrored();
+      }
+      else
+      {
+        RDCERR("Couldn't create '%s' in blob store", tempFilename.c_str());
+        success = false;
+      }
+
+      rdcstr blobFilename = GetBlobFilename(blobStore, hash, length);
+
+      // if identical data is already in the store, we can share it
+      if(success && FileIO::exists(blobFilename.c_str()))
+        FileIO::Delete(tempFilename.c_str());
+      else if(success)
+        success = FileIO::Move(tempFilename.c_str(), blobFilename.c_str(), false);
+      else
+        FileIO::Delete(tempFilename.c_str());
+
+      if(success)
+      {
+        BlobReference ref = {hash, length};
+
+        props.flags |= SectionFlags::BlobReference;
+
+        StreamWriter *writer = dst.WriteRawSection(props);
+        writer->Write(ref);
+        writer->Finish();
+
+        success = !writer->IsErrored();
+
+        delete writer;
+      }
+    }
+    else if(success)
+    {
+      props.flags &= ~SectionFlags::BlobReference;
+
+      StreamWriter *writer = dst.WriteRawSection(props);
+      uint64_t hash = HashedTransfer(writer, reader);
+      writer->Finish();
+
+      success = !writer->IsErrored() && !reader->IsErrored();
+
+      delete writer;
+
+      // make sure the blob we copied from the store was intact
+      uint64_t refHash = 0, refLength = 0;
+      if(success && (m_Sections[i].flags & SectionFlags::BlobReference) &&
+         ReadBlobReference(i, refHash, refLength) && refHash != hash)
+      {
+        RDCERR("Blob for section %d doesn't match its hash", i);
+        success = false;
+      }
+    }
+
+    delete reader;
+
+    if(!success)
+    {
+      RDCERR("Failed to copy section %d (%s)", i, props.name.c_str());
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -60,13 +60,14 @@ public:
   // version number of overall file format or chunk organisation. If the contents/meaning/order of
   // chunks have changed this does not need to be bumped, there are version numbers within each
   // API that interprets the stream that can be bumped.
-  static const uint32_t SERIALISE_VERSION = 0x00000102;
+  static const uint32_t SERIALISE_VERSION = 0x00000103;
 
   // this must never be changed - files before this were in the v0.x series and didn't have embedded
   // version numbers
   static const uint32_t V1_0_VERSION = 0x00000100;
   static const uint32_t V1_1_VERSION = 0x00000101;
   static const uint32_t V1_2_VERSION = 0x00000102;
+  static const uint32_t V1_3_VERSION = 0x00000103;
 
   ~RDCFile();
 
@@ -98,12 +99,47 @@ public:
   StreamReader *ReadSection(int index) const;
   StreamWriter *WriteSection(const SectionProperties &props);
 
+  // read or write a section's data exactly as it's stored, e.g. still compressed. Any blob
+  // reference is resolved when reading, and a raw section must be written with its
+  // uncompressedSize already set.
+  StreamReader *ReadRawSection(int index) const;
+  StreamWriter *WriteRawSection(const SectionProperties &props);
+
+  // calculates a hash of a section's data as it's stored, so the same contents compressed the same
+  // way always give the same hash whether or not the section is in a blob store. For sections in a
+  // blob store the data doesn't need to be read at all.
+  bool HashSection(int index, uint64_t &hash) const;
+
+  // sections can be stored in a content-addressed blob store directory, with only a reference to
+  // the blob stored in the file. This sets the store used when reading sections. Without one set,
+  // the Capture.BlobStorePath setting is used.
+  void SetBlobStore(const rdcstr &path) { m_BlobStore = path; }
+  // write every section into dst, moving any stored with at least minBlobSize bytes into blobStore.
+  // Sections already in a blob store are read from blobStore too, regardless of SetBlobStore(). dst
+  // must have been created with Create() and have no sections yet.
+  bool PackSections(RDCFile &dst, const rdcstr &blobStore, uint64_t minBlobSize) const;
+  // write every section into dst, replacing any blob references with the contents from blobStore.
+  bool UnpackSections(RDCFile &dst, const rdcstr &blobStore) const;
+
+  // when enabled, uncompressed sections are read straight out of a memory mapping of the file
+  // instead of through the FILE *, so readers don't allocate and copy the section data. Compressed
+  // sections are still decompressed into memory, and structured export still copies any buffers
+  // it exports. While any such reader (or one created from it) is alive the file must not be
+  // truncated in place, see FileIO::mmap_open. Deleting it or renaming over it is fine.
+  void SetMemoryMapping(bool enabled) { m_MemoryMapping = enabled; }
+
   // Only valid if GetDriver returns RDCDriver::Image, passes over the underlying FILE * for use
   // loading the image directly, since the RDC container isn't there to read from a section.
   FILE *StealImageFileHandle(rdcstr &filename);
 
 private:
   void Init(StreamReader &reader);
+  StreamReader *OpenSectionReader(int index, bool raw, const rdcstr &blobStore) const;
+  StreamWriter *OpenSectionWriter(const SectionProperties &props, bool raw);
+  rdcstr GetBlobStore() const;
+  bool ReadBlobReference(int index, uint64_t &hash, uint64_t &length) const;
+  FILE *OpenBlob(int index, const rdcstr &blobStore, uint64_t &length) const;
+  bool CopySections(RDCFile &dst, const rdcstr &blobStore, uint64_t minBlobSize) const;
 
   FILE *m_File = NULL;
   rdcstr m_Filename;
@@ -120,6 +156,10 @@ private:
   double m_TimeFrequency = 1.0;
   RDCThumb m_Thumb;
 
+  bool m_MemoryMapping = false;
+
+  rdcstr m_BlobStore;
+
   ContainerError m_Error = ContainerError::NoError;
   rdcstr m_ErrorString;
 
@@ -0,0 +1,378 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "rdcfile.h"
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "catch/catch.hpp"
+
+static bytebuf ReadSectionContents(const RDCFile &rdc, int index)
+{
+  bytebuf ret;
+
+  StreamReader *reader = rdc.ReadSection(index);
+  if(!reader->IsErrored())
+  {
+    ret.resize((size_t)reader->GetSize());
+    reader->Read(ret.data(), ret.size());
+  }
+  if(reader->IsErrored())
+    ret.clear();
+  delete reader;
+
+  return ret;
+}
+
+static bool HasFlag(SectionFlags flags, SectionFlags flag)
+{
+  return bool(flags & flag);
+}
+
+static size_t CountBlobs(const rdcstr &blobStore)
+{
+  rdcarray<PathEntry> entries;
+  FileIO::GetFilesInDirectory(blobStore.c_str(), entries);
+
+  size_t ret = 0;
+  for(const PathEntry &e : entries)
+    if(!(e.flags & PathProperty::ErrorInvalidPath) && !(e.flags & PathProperty::Directory))
+      ret++;
+  return ret;
+}
+
+TEST_CASE("Pack and unpack capture sections in a blob store", "[rdcfile]")
+{
+  const rdcstr tempDir = FileIO::GetTempFolderFilename();
+  const rdcstr blobStore = tempDir + "/rdoc_blob_store_test";
+  const rdcstr original = tempDir + "/rdoc_blob_original.rdc";
+  const rdcstr packed = tempDir + "/rdoc_blob_packed.rdc";
+  const rdcstr packed2 = tempDir + "/rdoc_blob_packed2.rdc";
+  const rdcstr unpacked = tempDir + "/rdoc_blob_unpacked.rdc";
+
+  // start with an empty store
+  {
+    rdcarray<PathEntry> entries;
+    FileIO::GetFilesInDirectory(blobStore.c_str(), entries);
+    for(const PathEntry &e : entries)
+      FileIO::Delete((blobStore + "/" + e.filename).c_str());
+  }
+
+  bytebuf frameData, bigData, smallData;
+
+  frameData.resize(300 * 1024);
+  for(size_t i = 0; i < frameData.size(); i++)
+    frameData[i] = byte(((i / 1000) + (rand() & 0x3f)) & 0xff);
+
+  bigData.resize(200 * 1024);
+  for(size_t i = 0; i < bigData.size(); i++)
+    bigData[i] = byte(rand() & 0xff);
+
+  smallData.resize(100);
+  for(size_t i = 0; i < smallData.size(); i++)
+    smallData[i] = byte(i);
+
+  {
+    RDCFile rdc;
+    rdc.SetData(RDCDriver::Vulkan, "Vulkan", 0, NULL, 0, 1.0);
+    rdc.Create(original.c_str());
+    REQUIRE((rdc.ErrorCode() == ContainerError::NoError));
+
+    SectionProperties props;
+    props.type = SectionType::FrameCapture;
+    props.flags = SectionFlags::ZstdCompressed | SectionFlags::SeekIndexed;
+
+    StreamWriter *writer = rdc.WriteSection(props);
+    writer->Write(frameData.data(), frameData.size());
+    writer->Finish();
+    delete writer;
+
+    props = SectionProperties();
+    props.type = SectionType::ResourceRenames;
+
+    writer = rdc.WriteSection(props);
+    writer->Write(bigData.data(), bigData.size());
+    writer->Finish();
+    delete writer;
+
+    props = SectionProperties();
+    props.type = SectionType::Notes;
+
+    writer = rdc.WriteSection(props);
+    writer->Write(smallData.data(), smallData.size());
+    writer->Finish();
+    delete writer;
+  }
+
+  uint64_t sectionHashes[3] = {};
+
+  {
+    RDCFile rdc;
+    rdc.Open(original.c_str());
+    REQUIRE((rdc.ErrorCode() == ContainerError::NoError));
+
+    for(int i = 0; i < 3; i++)
+      CHECK(rdc.HashSection(i, sectionHashes[i]));
+
+    RDCFile dst;
+    dst.SetData(rdc.GetDriver(), rdc.GetDriverName().c_str(), rdc.GetMachineIdent(),
+                &rdc.GetThumbnail(), rdc.GetTimestampBase(), rdc.GetTimestampFrequency());
+    dst.Create(packed.c_str());
+
+    CHECK(rdc.PackSections(dst, blobStore, 64 * 1024));
+  }
+
+  // the two large sections are now in the store, and the capture only holds the small one
+  CHECK(CountBlobs(blobStore) == 2);
+  CHECK(FileIO::GetFileSize(packed) < FileIO::GetFileSize(original));
+
+  // packing the same capture again shares the same blobs
+  {
+    RDCFile rdc;
+    rdc.Open(original.c_str());
+
+    RDCFile dst;
+    dst.SetData(rdc.GetDriver(), rdc.GetDriverName().c_str(), rdc.GetMachineIdent(),
+                &rdc.GetThumbnail(), rdc.GetTimestampBase(), rdc.GetTimestampFrequency());
+    dst.Create(packed2.c_str());
+
+    CHECK(rdc.PackSections(dst, blobStore, 64 * 1024));
+  }
+
+  CHECK(CountBlobs(blobStore) == 2);
+
+  {
+    RDCFile rdc;
+    rdc.Open(packed.c_str());
+    REQUIRE((rdc.ErrorCode() == ContainerError::NoError));
+    REQUIRE(rdc.NumSections() == 3);
+
+    CHECK(HasFlag(rdc.GetSectionProperties(0).flags, SectionFlags::BlobReference));
+    CHECK(HasFlag(rdc.GetSectionProperties(0).flags, SectionFlags::ZstdCompressed));
+    CHECK(HasFlag(rdc.GetSectionProperties(1).flags, SectionFlags::BlobReference));
+    CHECK_FALSE(HasFlag(rdc.GetSectionProperties(2).flags, SectionFlags::BlobReference));
+
+    // without the blob store, only the small section can be read
+    CHECK(ReadSectionContents(rdc, 0).empty());
+    CHECK(ReadSectionContents(rdc, 2) == smallData);
+
+    // but every section's hash is still available and matches the original
+    for(int i = 0; i < 3; i++)
+    {
+      uint64_t hash = 0;
+      CHECK(rdc.HashSection(i, hash));
+      CHECK(hash == sectionHashes[i]);
+    }
+
+    rdc.SetBlobStore(blobStore);
+
+    CHECK(ReadSectionContents(rdc, 0) == frameData);
+    CHECK(ReadSectionContents(rdc, 1) == bigData);
+    CHECK(ReadSectionContents(rdc, 2) == smallData);
+
+    RDCFile dst;
+    dst.SetData(rdc.GetDriver(), rdc.GetDriverName().c_str(), rdc.GetMachineIdent(),
+                &rdc.GetThumbnail(), rdc.GetTimestampBase(), rdc.GetTimestampFrequency());
+    dst.Create(unpacked.c_str());
+
+    CHECK(rdc.UnpackSections(dst, blobStore));
+  }
+
+  {
+    RDCFile rdc;
+    rdc.Open(unpacked.c_str());
+    REQUIRE((rdc.ErrorCode() == ContainerError::NoError));
+    REQUIRE(rdc.NumSections() == 3);
+
+    for(int i = 0; i < rdc.NumSections(); i++)
+      CHECK_FALSE(HasFlag(rdc.GetSectionProperties(i).flags, SectionFlags::BlobReference));
+
+    CHECK(HasFlag(rdc.GetSectionProperties(0).flags, SectionFlags::ZstdCompressed));
+
+    CHECK(ReadSectionContents(rdc, 0) == frameData);
+    CHECK(ReadSectionContents(rdc, 1) == bigData);
+    CHECK(ReadSectionContents(rdc, 2) == smallData);
+
+    for(int i = 0; i < 3; i++)
+    {
+      uint64_t hash = 0;
+      CHECK(rdc.HashSection(i, hash));
+      CHECK(hash == sectionHashes[i]);
+    }
+  }
+
+  CHECK(FileIO::GetFileSize(unpacked) == FileIO::GetFileSize(original));
+
+  {
+    rdcarray<PathEntry> entries;
+    FileIO::GetFilesInDirectory(blobStore.c_str(), entries);
+    for(const PathEntry &e : entries)
+      FileIO::Delete((blobStore + "/" + e.filename).c_str());
+  }
+
+  FileIO::Delete(original.c_str());
+  FileIO::Delete(packed.c_str());
+  FileIO::Delete(packed2.c_str());
+  FileIO::Delete(unpacked.c_str());
+};
+
+TEST_CASE("Reject invalid section seek indices", "[rdcfile]")
+{
+  const rdcstr filename = FileIO::GetTempFolderFilename() + "/rdoc_seek_index_test.rdc";
+
+  // a section too short to hold the point count, and one whose count claims more points than fit
+  const uint64_t bogusCount = 1000;
+  bytebuf tooShort = {1, 2, 3, 4};
+  bytebuf tooMany;
+  tooMany.resize(16);
+  tooMany.append((const byte *)&bogusCount, sizeof(bogusCount));
+
+  {
+    RDCFile rdc;
+    rdc.SetData(RDCDriver::Vulkan, "Vulkan", 0, NULL, 0, 1.0);
+    rdc.Create(filename.c_str());
+    REQUIRE((rdc.ErrorCode() == ContainerError::NoError));
+
+    // captures must have a frame to be opened
+    {
+      SectionProperties props;
+      props.type = SectionType::FrameCapture;
+
+      StreamWriter *writer = rdc.WriteSection(props);
+      writer->Write(tooShort.data(), tooShort.size());
+      writer->Finish();
+      delete writer;
+    }
+
+    for(const bytebuf &data : {tooShort, tooMany})
+    {
+      SectionProperties props;
+      props.type = SectionType::Unknown;
+      props.name = data.size() == tooShort.size() ? "short" : "many";
+      props.flags = SectionFlags::ZstdCompressed | SectionFlags::SeekIndexed;
+      props.uncompressedSize = 1024;
+
+      StreamWriter *writer = rdc.WriteRawSection(props);
+      writer->Write(data.data(), data.size());
+      writer->Finish();
+      delete writer;
+    }
+  }
+
+  {
+    RDCFile rdc;
+    rdc.Open(filename.c_str());
+    REQUIRE((rdc.ErrorCode() == ContainerError::NoError));
+    REQUIRE(rdc.NumSections() == 3);
+
+    for(int i = 1; i < rdc.NumSections(); i++)
+    {
+      StreamReader *reader = rdc.ReadSection(i);
+      CHECK(reader->IsErrored());
+      delete reader;
+    }
+  }
+
+  FileIO::Delete(filename.c_str());
+}
+
+TEST_CASE("Read seek indexed sections with the index flag masked off", "[rdcfile]")
+{
+  const rdcstr indexed = FileIO::GetTempFolderFilename() + "/rdoc_seek_indexed.rdc";
+  const rdcstr masked = FileIO::GetTempFolderFilename() + "/rdoc_seek_masked.rdc";
+
+  // large enough for several pages, so there's more than one seek point
+  bytebuf data;
+  data.resize(5 * 1024 * 1024 + 123);
+  for(size_t i = 0; i < data.size(); i++)
+    data[i] = byte(((i / 1000) + (rand() & 0x3f)) & 0xff);
+
+  for(SectionFlags compression : {SectionFlags::LZ4Compressed, SectionFlags::ZstdCompressed})
+  {
+    INFO("compression: " << ToStr(compression));
+
+    {
+      RDCFile rdc;
+      rdc.SetData(RDCDriver::Vulkan, "Vulkan", 0, NULL, 0, 1.0);
+      rdc.Create(indexed.c_str());
+      REQUIRE((rdc.ErrorCode() == ContainerError::NoError));
+
+      SectionProperties props;
+      props.type = SectionType::FrameCapture;
+      props.flags = compression | SectionFlags::SeekIndexed;
+
+      StreamWriter *writer = rdc.WriteSection(props);
+      writer->Write(data.data(), data.size());
+      writer->Finish();
+      delete writer;
+    }
+
+    // copy the section's data as-is, but without the flag. The index is left after the compressed
+    // stream where a reader that doesn't know about it won't get to it.
+    {
+      RDCFile rdc;
+      rdc.Open(indexed.c_str());
+      REQUIRE((rdc.ErrorCode() == ContainerError::NoError));
+      REQUIRE(rdc.NumSections() == 1);
+
+      CHECK(ReadSectionContents(rdc, 0) == data);
+
+      SectionProperties props = rdc.GetSectionProperties(0);
+      props.flags &= ~SectionFlags::SeekIndexed;
+
+      bytebuf raw;
+      StreamReader *reader = rdc.ReadRawSection(0);
+      raw.resize((size_t)reader->GetSize());
+      reader->Read(raw.data(), raw.size());
+      CHECK_FALSE(reader->IsErrored());
+      delete reader;
+
+      RDCFile dst;
+      dst.SetData(rdc.GetDriver(), rdc.GetDriverName().c_str(), rdc.GetMachineIdent(),
+                  &rdc.GetThumbnail(), rdc.GetTimestampBase(), rdc.GetTimestampFrequency());
+      dst.Create(masked.c_str());
+      REQUIRE((dst.ErrorCode() == ContainerError::NoError));
+
+      StreamWriter *writer = dst.WriteRawSection(props);
+      writer->Write(raw.data(), raw.size());
+      writer->Finish();
+      delete writer;
+    }
+
+    {
+      RDCFile rdc;
+      rdc.Open(masked.c_str());
+      REQUIRE((rdc.ErrorCode() == ContainerError::NoError));
+      REQUIRE(rdc.NumSections() == 1);
+
+      CHECK_FALSE(HasFlag(rdc.GetSectionProperties(0).flags, SectionFlags::SeekIndexed));
+      CHECK(ReadSectionContents(rdc, 0) == data);
+    }
+  }
+
+  FileIO::Delete(indexed.c_str());
+  FileIO::Delete(masked.c_str());
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
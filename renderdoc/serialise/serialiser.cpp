@@ -26,9 +26,15 @@
 #define SERIALISER_IMPL
 
 #include "serialiser.h"
+#include "common/threading.h"
 #include "core/core.h"
+#include "core/settings.h"
 #include "strings/string_utils.h"
 
+RDOC_CONFIG(uint32_t, Capture_ChunkPagePoolMB, 64,
+            "The maximum amount of memory in MB to keep in a pool of unused chunk allocator pages, "
+            "for reuse when recording command buffers rather than allocating new pages.");
+
 #if ENABLED(RDOC_DEVEL)
 
 int64_t Chunk::m_LiveChunks = 0;
@@ -83,6 +89,306 @@ void DumpChunk(bool reading, FileIO::LogFileHandle *log, SDChunk *chunk)
   DumpObject(log, "  ", chunk);
 }
 
+/////////////////////////////////////////////////////////////
+// Structured object allocation
+
+// big enough that blocks are rarely allocated, small enough that a block kept alive by a few
+// long-lived objects doesn't waste much
+static const size_t SDObjectArenaBlockSize = 256 * 1024;
+
+SDObjectArena::~SDObjectArena()
+{
+  if(m_Block)
+    ReleaseBlock(m_Block);
+}
+
+void *SDObjectArena::Alloc(size_t size)
+{
+  const size_t allocSize = AlignUp16(sizeof(Header) + size);
+
+  // anything unusually large just goes on the heap
+  if(allocSize > SDObjectArenaBlockSize / 16)
+    return AllocHeap(size);
+
+  if(m_Block == NULL || m_Head + allocSize > m_End)
+  {
+    if(m_Block)
+      ReleaseBlock(m_Block);
+
+    byte *mem = (byte *)malloc(SDObjectArenaBlockSize);
+    if(mem == NULL)
+      RENDERDOC_OutOfMemory(SDObjectArenaBlockSize);
+
+    // the arena holds a reference on its current block until it moves on to the next one
+    m_Block = (Block *)mem;
+    m_Block->refcount = 1;
+
+    m_Head = mem + AlignUp16(sizeof(Block));
+    m_End = mem + SDObjectArenaBlockSize;
+  }
+
+  Header *header = (Header *)m_Head;
+  header->block = m_Block;
+  Atomic::Inc32(&m_Block->refcount);
+
+  m_Head += allocSize;
+
+  return header + 1;
+}
+
+void *SDObjectArena::AllocHeap(size_t size)
+{
+  Header *header = (Header *)malloc(sizeof(Header) + size);
+  if(header == NULL)
+    RENDERDOC_OutOfMemory(sizeof(Header) + size);
+
+  header->block = NULL;
+
+  return header + 1;
+}
+
+void SDObjectArena::Free(void *mem)
+{
+  if(mem == NULL)
+    return;
+
+  Header *header = ((Header *)mem) - 1;
+
+  if(header->block)
+    ReleaseBlock(header->block);
+  else
+    free(header);
+}
+
+void SDObjectArena::ReleaseBlock(Block *block)
+{
+  if(Atomic::Dec32(&block->refcount) == 0)
+    free(block);
+}
+
+SDFileStorage &GetSDFileStorage(SDFile &file)
+{
+  if(file.m_Storage == NULL)
+    file.m_Storage = new SDFileStorage;
+
+  return *file.m_Storage;
+}
+
+// every string interned in any file, so that a copy of an object can tell which of its names it
+// can share and which it must copy
+struct InternedStrings
+{
+  Threading::CriticalSection lock;
+  std::set<const char *> strings;
+};
+
+static InternedStrings &GetInternedStrings()
+{
+  static InternedStrings interned;
+  return interned;
+}
+
+// lets lookups return early without locking when nothing is interned, which is the common case
+static int32_t numInternedStrings = 0;
+
+SDFileStorage::~SDFileStorage()
+{
+  if(strings.empty())
+    return;
+
+  InternedStrings &interned = GetInternedStrings();
+
+  SCOPED_LOCK(interned.lock);
+
+  for(const rdcstr &str : strings)
+  {
+    interned.strings.erase(str.c_str());
+    Atomic::Dec32(&numInternedStrings);
+  }
+}
+
+rdcliteral InternSDString(SDFile &file, const rdcstr &str)
+{
+  std::set<rdcstr> &strings = GetSDFileStorage(file).strings;
+
+  auto it = strings.insert(str);
+  const rdcstr &interned = *it.first;
+
+  if(it.second)
+  {
+    InternedStrings &registry = GetInternedStrings();
+
+    SCOPED_LOCK(registry.lock);
+    registry.strings.insert(interned.c_str());
+    Atomic::Inc32(&numInternedStrings);
+  }
+
+  // the interned string isn't freed until the file is, so it can be referenced like a literal
+  return operator"" _lit(interned.c_str(), interned.size());
+}
+
+bool IsInternedSDString(const char *str)
+{
+  if(Atomic::CmpExch32(&numInternedStrings, 0, 0) == 0)
+    return false;
+
+  InternedStrings &interned = GetInternedStrings();
+
+  SCOPED_LOCK(interned.lock);
+  return interned.strings.find(str) != interned.strings.end();
+}
+
+/////////////////////////////////////////////////////////////
+// Lazy structured export
+
+struct LazyChunkState;
+
+// a single lazily exported chunk
+struct LazyChunkEntry
+{
+  LazyChunkState *state;
+  SDChunk *chunk;
+  uint64_t offset;
+  uint64_t length;
+  // the value of LazyChunkState::useCounter when the chunk was last accessed
+  uint64_t lastUse;
+  int32_t refcount;
+};
+
+// state shared by all chunks exported lazily from one stream
+struct LazyChunkState
+{
+  const byte *data = NULL;
+  LazyChunkStructuriser structuriser;
+  uint32_t budget = 0;
+
+  int32_t refcount = 1;
+
+  // held while checking, populating, or releasing any chunk's children
+  Threading::CriticalSection lock;
+  // incremented on every access to a chunk, to find the least recently used one
+  uint64_t useCounter = 0;
+  // chunks currently structurised. Only tracked if there's a budget to enforce
+  rdcarray<LazyChunkEntry *> populated;
+
+  void AddRef() { Atomic::Inc32(&refcount); }
+  void Release()
+  {
+    if(Atomic::Dec32(&refcount) == 0)
+      delete this;
+  }
+
+  void Evict()
+  {
+    while(populated.size() > budget)
+    {
+      size_t lru = 0;
+      for(size_t i = 1; i < populated.size(); i++)
+        if(populated[i]->lastUse < populated[lru]->lastUse)
+          lru = i;
+
+      populated.takeAt(lru)->chunk->FreeLazyChildren();
+    }
+  }
+};
+
+// the generator for a single lazy chunk. std::function copies its generator around so copies share
+// a refcounted entry, and only when the last copy goes away do we know the chunk itself is gone.
+class LazyChunkGenerator
+{
+public:
+  LazyChunkGenerator(LazyChunkState *state, SDChunk *chunk, uint64_t offset, uint64_t length)
+  {
+    m_Entry = new LazyChunkEntry;
+    m_Entry->state = state;
+    m_Entry->chunk = chunk;
+    m_Entry->offset = offset;
+    m_Entry->length = length;
+    m_Entry->lastUse = 0;
+    m_Entry->refcount = 1;
+
+    state->AddRef();
+  }
+  LazyChunkGenerator(const LazyChunkGenerator &other) : m_Entry(other.m_Entry)
+  {
+    Atomic::Inc32(&m_Entry->refcount);
+  }
+  LazyChunkGenerator &operator=(const LazyChunkGenerator &) = delete;
+  ~LazyChunkGenerator()
+  {
+    if(Atomic::Dec32(&m_Entry->refcount) == 0)
+    {
+      LazyChunkState *state = m_Entry->state;
+
+      if(state->budget > 0)
+      {
+        SCOPED_LOCK(state->lock);
+        state->populated.removeOne(m_Entry);
+      }
+
+      delete m_Entry;
+
+      state->Release();
+    }
+  }
+
+  void operator()(SDObject *) const
+  {
+    LazyChunkState *state = m_Entry->state;
+    SDChunk *chunk = m_Entry->chunk;
+
+    SCOPED_LOCK(state->lock);
+
+    m_Entry->lastUse = ++state->useCounter;
+
+    if(chunk->IsLazyChildrenPopulated())
+      return;
+
+    StreamReader reader(state->data + m_Entry->offset, m_Entry->length);
+
+    StructuredObjectList children;
+
+    SDChunk *structured = state->structuriser(reader);
+
+    if(structured)
+    {
+      structured->TakeAllChildren(children);
+      delete structured;
+    }
+    else
+    {
+      RDCERR("Failed to structurise %s chunk on demand", chunk->name.c_str());
+    }
+
+    chunk->SetLazyChildrenPopulated(children);
+
+    // this chunk was just used so it's never the one evicted
+    if(state->budget > 0)
+    {
+      state->populated.push_back(m_Entry);
+      state->Evict();
+    }
+  }
+
+  void Release() const
+  {
+    LazyChunkState *state = m_Entry->state;
+
+    // without a budget the structured file is shared, so anyone could be holding on to the
+    // children. They're kept until the file is destroyed
+    if(state->budget == 0)
+      return;
+
+    SCOPED_LOCK(state->lock);
+
+    state->populated.removeOne(m_Entry);
+    m_Entry->chunk->FreeLazyChildren();
+  }
+
+private:
+  LazyChunkEntry *m_Entry;
+};
+
 /////////////////////////////////////////////////////////////
 // Read Serialiser functions
 
@@ -102,10 +408,43 @@ Serialiser<SerialiserMode::Reading>::Serialiser(StreamReader *reader, Ownership
 template <>
 Serialiser<SerialiserMode::Reading>::~Serialiser()
 {
+  if(m_LazyChunks)
+    m_LazyChunks->Release();
+
   if(m_Ownership == Ownership::Stream && m_Read)
     delete m_Read;
 }
 
+template <>
+bool Serialiser<SerialiserMode::Reading>::ConfigureLazyStructuredExport(
+    ChunkLookup lookup, LazyChunkStructuriser structuriser, uint32_t budget, uint64_t timeBase,
+    double timeFreq)
+{
+  const byte *data = m_Read->GetMemoryData();
+
+  if(data == NULL || lookup == NULL || !structuriser)
+  {
+    ConfigureStructuredExport(lookup, false, timeBase, timeFreq);
+    return false;
+  }
+
+  m_ChunkLookup = lookup;
+  m_ExportBuffers = false;
+  m_ExportStructured = false;
+  m_TimerBase = timeBase;
+  m_TimerFrequency = timeFreq;
+
+  if(m_LazyChunks)
+    m_LazyChunks->Release();
+
+  m_LazyChunks = new LazyChunkState;
+  m_LazyChunks->data = data;
+  m_LazyChunks->structuriser = structuriser;
+  m_LazyChunks->budget = budget;
+
+  return true;
+}
+
 template <>
 uint32_t Serialiser<SerialiserMode::Reading>::BeginChunk(uint32_t, uint64_t)
 {
@@ -113,6 +452,9 @@ uint32_t Serialiser<SerialiserMode::Reading>::BeginChunk(uint32_t, uint64_t)
 
   m_ChunkMetadata = SDChunkMetaData();
 
+  if(m_LazyChunks)
+    m_LazyChunkOffset = m_Read->GetOffset();
+
   {
     uint32_t c = 0;
     bool success = m_Read->Read(c);
@@ -181,20 +523,29 @@ uint32_t Serialiser<SerialiserMode::Reading>::BeginChunk(uint32_t, uint64_t)
     m_LastChunkOffset = m_Read->GetOffset();
   }
 
-  if(ExportStructure())
+  if(ExportStructure() || m_LazyChunks)
   {
     rdcstr name = m_ChunkLookup ? m_ChunkLookup(chunkID) : "";
 
     if(name.empty())
       name = "<Unknown Chunk>";
 
-    SDChunk *chunk = new SDChunk(name);
+    SDChunk *chunk = new(AllocChunk()) SDChunk(name);
     chunk->metadata = m_ChunkMetadata;
 
     m_StructuredFile->chunks.push_back(chunk);
-    m_StructureStack.push_back(chunk);
 
-    m_InternalElement = 0;
+    // when exporting lazily the contents aren't structurised now, see EndChunk
+    if(m_LazyChunks)
+    {
+      m_LazyChunk = chunk;
+    }
+    else
+    {
+      m_StructureStack.push_back(chunk);
+
+      m_InternalElement = 0;
+    }
   }
 
   return chunkID;
@@ -210,7 +561,8 @@ void Serialiser<SerialiserMode::Reading>::SkipCurrentChunk()
 
     SDObject &current = *m_StructureStack.back();
 
-    SDObject &obj = *current.AddAndOwnChild(new SDObject("Opaque chunk"_lit, "Byte Buffer"_lit));
+    SDObject &obj =
+        *current.AddAndOwnChild(new(AllocObject()) SDObject("Opaque chunk"_lit, "Byte Buffer"_lit));
 
     obj.type.basetype = SDBasic::Buffer;
     obj.type.byteSize = m_ChunkMetadata.length;
@@ -221,6 +573,10 @@ void Serialiser<SerialiserMode::Reading>::SkipCurrentChunk()
       chunk->metadata.flags |= SDChunkFlags::OpaqueChunk;
     }
   }
+  else if(m_LazyChunk)
+  {
+    m_LazyChunk->metadata.flags |= SDChunkFlags::OpaqueChunk;
+  }
 
   {
     uint64_t readBytes = m_Read->GetOffset() - m_LastChunkOffset;
@@ -305,6 +661,23 @@ void Serialiser<SerialiserMode::Reading>::EndChunk()
 
   // align to the natural chunk alignment
   m_Read->AlignTo<ChunkAlignment>();
+
+  if(m_LazyChunk)
+  {
+    m_LazyChunk->type.byteSize = m_ChunkMetadata.length;
+
+    // the whole chunk including its header is re-read when it's needed. If something already added
+    // children directly there's nothing left to structurise.
+    if(m_LazyChunk->NumChildren() == 0 && !m_Read->IsErrored())
+    {
+      LazyChunkGenerator generator(m_LazyChunks, m_LazyChunk, m_LazyChunkOffset,
+                                   m_Read->GetOffset() - m_LazyChunkOffset);
+
+      m_LazyChunk->SetLazyChildren(generator, [generator](SDObject *) { generator.Release(); });
+    }
+
+    m_LazyChunk = NULL;
+  }
 }
 
 /////////////////////////////////////////////////////////////
@@ -446,7 +819,7 @@ uint32_t Serialiser<SerialiserMode::Writing>::BeginChunk(uint32_t chunkID, uint6
     if(name.empty())
       name = "<Unknown Chunk>";
 
-    SDChunk *chunk = new SDChunk(name);
+    SDChunk *chunk = new(AllocChunk()) SDChunk(name);
     chunk->metadata = m_ChunkMetadata;
 
     m_StructuredFile->chunks.push_back(chunk);
@@ -734,6 +1107,11 @@ void DoSerialise(SerialiserType &ser, SDObject &el)
 template <class SerialiserType>
 void DoSerialise(SerialiserType &ser, SDChunk &el)
 {
+  if(ser.IsWriting())
+  {
+    el.PopulateAllChildren();
+  }
+
   SERIALISE_MEMBER(name);
   SERIALISE_MEMBER(type);
   SERIALISE_MEMBER(data);
@@ -1046,19 +1424,96 @@ Chunk *Chunk::Create(Serialiser<SerialiserMode::Writing> &ser, uint16_t chunkTyp
   return ret;
 }
 
-ChunkAllocator::~ChunkAllocator()
+struct PooledPage
 {
-  for(Page &p : freePages)
+  size_t bufferSize;
+  byte *bufferBase;
+  byte *chunkBase;
+};
+
+static Threading::SpinLock pagePoolLock;
+static int64_t allocatedPageMemory = 0;
+static int64_t pooledPageMemory = 0;
+
+// allocated on first use and never freed, so that allocators destroyed during static destruction
+// can still release their pages safely
+static rdcarray<PooledPage> &GetPagePool()
+{
+  static rdcarray<PooledPage> *pool = new rdcarray<PooledPage>();
+  return *pool;
+}
+
+uint64_t ChunkAllocator::AllocatedPageMemory()
+{
+  return (uint64_t)allocatedPageMemory;
+}
+
+uint64_t ChunkAllocator::PooledPageMemory()
+{
+  return (uint64_t)pooledPageMemory;
+}
+
+void ChunkAllocator::AcquirePage(Page &p)
+{
+  p.bufferBase = p.chunkBase = NULL;
+
   {
-    FreeAlignedBuffer(p.chunkBase);
-    FreeAlignedBuffer(p.bufferBase);
+    SCOPED_SPINLOCK(pagePoolLock);
+
+    rdcarray<PooledPage> &pool = GetPagePool();
+
+    // take the most recently released page of our size, as it's the most likely to be in cache
+    for(size_t i = pool.size(); i > 0; i--)
+    {
+      if(pool[i - 1].bufferSize == BufferPageSize)
+      {
+        p.bufferBase = pool[i - 1].bufferBase;
+        p.chunkBase = pool[i - 1].chunkBase;
+        pool.erase(i - 1);
+        pooledPageMemory -= int64_t(BufferPageSize + ChunkPageSize);
+        break;
+      }
+    }
   }
 
-  for(Page &p : fullPages)
+  if(p.bufferBase == NULL)
   {
-    FreeAlignedBuffer(p.chunkBase);
-    FreeAlignedBuffer(p.bufferBase);
+    p.bufferBase = ::AllocAlignedBuffer(BufferPageSize);
+    p.chunkBase = ::AllocAlignedBuffer(ChunkPageSize);
+    Atomic::ExchAdd64(&allocatedPageMemory, int64_t(BufferPageSize + ChunkPageSize));
   }
+
+  p.bufferHead = p.bufferBase;
+  p.chunkHead = p.chunkBase;
+}
+
+void ChunkAllocator::ReleasePage(Page &p)
+{
+  const int64_t pageMemory = int64_t(BufferPageSize + ChunkPageSize);
+
+  {
+    SCOPED_SPINLOCK(pagePoolLock);
+
+    if(pooledPageMemory + pageMemory <= int64_t(Capture_ChunkPagePoolMB()) * 1024 * 1024)
+    {
+      GetPagePool().push_back({BufferPageSize, p.bufferBase, p.chunkBase});
+      pooledPageMemory += pageMemory;
+      return;
+    }
+  }
+
+  FreeAlignedBuffer(p.chunkBase);
+  FreeAlignedBuffer(p.bufferBase);
+  Atomic::ExchAdd64(&allocatedPageMemory, -pageMemory);
+}
+
+ChunkAllocator::~ChunkAllocator()
+{
+  for(Page &p : freePages)
+    ReleasePage(p);
+
+  for(Page &p : fullPages)
+    ReleasePage(p);
 }
 
 byte *ChunkAllocator::AllocAlignedBuffer(uint64_t size)
@@ -1076,10 +1531,7 @@ byte *ChunkAllocator::AllocChunk()
 void ChunkAllocator::Trim()
 {
   for(Page &p : freePages)
-  {
-    FreeAlignedBuffer(p.chunkBase);
-    FreeAlignedBuffer(p.bufferBase);
-  }
+    ReleasePage(p);
 
   freePages.clear();
 }
@@ -1156,15 +1608,14 @@ byte *ChunkAllocator::AllocateFromPages(bool chunkAlloc, size_t size)
     }
   }
 
-  // if there are no free pages, allocate a new one
+  // if there are no free pages, get a new one. IDs are never reused, since pages may have been
+  // trimmed while others remain in use
   if(freePages.empty())
   {
-    // the first free ID is the sum of the free and full lists, because all pages are in one or the
-    // other
-    uint32_t ID = uint32_t(freePages.size() + fullPages.size());
-    byte *buffers = ::AllocAlignedBuffer(BufferPageSize);
-    byte *chunks = ::AllocAlignedBuffer(ChunkPageSize);
-    freePages.push_back({ID, buffers, buffers, chunks, chunks});
+    Page p;
+    p.ID = nextPageID++;
+    AcquirePage(p);
+    freePages.push_back(p);
   }
 
   Page &p = freePages.back();
@@ -51,6 +51,12 @@ void Deserialise(const T &el)
 
 typedef rdcstr (*ChunkLookup)(uint32_t chunkType);
 
+// reads a single chunk from the given stream and returns it fully structured. Used to structurise
+// chunks on demand, see ConfigureLazyStructuredExport.
+typedef std::function<SDChunk *(StreamReader &reader)> LazyChunkStructuriser;
+
+struct LazyChunkState;
+
 enum class SerialiserFlags
 {
   NoFlags = 0x0,
@@ -80,6 +86,67 @@ enum class SerialiserMode
 
 struct CompressedFileIO;
 
+// a bump allocator for SDObjects, so that structurising huge files doesn't need a heap allocation
+// per object. Each block is refcounted by the objects allocated from it, so objects can be moved
+// between files and outlive the arena as normal, and a block is freed in one go once all of its
+// objects have been deleted.
+class SDObjectArena
+{
+public:
+  SDObjectArena() = default;
+  ~SDObjectArena();
+  SDObjectArena(const SDObjectArena &) = delete;
+  SDObjectArena &operator=(const SDObjectArena &) = delete;
+
+  void *Alloc(size_t size);
+
+  // allocate an object outside of any arena, and free an object allocated either way
+  static void *AllocHeap(size_t size);
+  static void Free(void *mem);
+
+private:
+  struct Block
+  {
+    int32_t refcount;
+  };
+
+  // precedes every allocation, padded to keep objects 16-byte aligned. The block is NULL for heap
+  // allocations
+  struct Header
+  {
+    Block *block;
+    uint64_t padding;
+  };
+
+  static void ReleaseBlock(Block *block);
+
+  Block *m_Block = NULL;
+  byte *m_Head = NULL;
+  byte *m_End = NULL;
+};
+
+// the storage an SDFile owns for the structured objects built into it. Objects are allocated from
+// the arena, and names repeated across many objects are interned so they can be shared instead of
+// copied. Both live until the file is destroyed, or until their last object is for arena blocks.
+struct SDFileStorage
+{
+  ~SDFileStorage();
+
+  SDObjectArena arena;
+  std::set<rdcstr> strings;
+};
+
+// returns the file's storage, creating it the first time it's needed
+SDFileStorage &GetSDFileStorage(SDFile &file);
+
+// returns a string with the same contents which stays alive as long as the file, to use for the
+// names of objects in that file. Objects referring to it must not outlive the file, which is why
+// Duplicate() copies these names where it shares literals.
+rdcliteral InternSDString(SDFile &file, const rdcstr &str);
+
+// returns true if str is a string returned by InternSDString for any file that's still alive
+bool IsInternedSDString(const char *str);
+
 template <SerialiserMode sertype>
 class Serialiser
 {
@@ -173,6 +240,17 @@ public:
     m_TimerFrequency = timeFreq;
   }
 
+  // like ConfigureStructuredExport, but chunks are only exported with their metadata and their
+  // contents are structurised by the structuriser the first time they're accessed, from any thread.
+  // This is only possible when the stream is entirely in memory, which must then outlive the
+  // structured data, otherwise we fall back to exporting everything up-front and return false.
+  // Without a budget, structurised contents are kept until the file is destroyed. A non-zero
+  // budget means the caller is the only owner of the structured file: at most that many chunks
+  // are kept structurised, and the least recently used are freed and regenerated on the next
+  // access, so nothing may hold on to their children.
+  bool ConfigureLazyStructuredExport(ChunkLookup lookup, LazyChunkStructuriser structuriser,
+                                     uint32_t budget, uint64_t timeBase, double timeFreq);
+
   uint32_t BeginChunk(uint32_t chunkID, uint64_t byteLength);
   void EndChunk();
 
@@ -226,7 +304,7 @@ public:
 
       SDObject &current = *m_StructureStack.back();
 
-      SDObject &obj = *current.AddAndOwnChild(new SDObject(name, TypeName<T>()));
+      SDObject &obj = *current.AddAndOwnChild(new(AllocObject()) SDObject(name, TypeName<T>()));
       m_StructureStack.push_back(&obj);
 
       obj.type.byteSize = sizeof(T);
@@ -271,7 +349,7 @@ public:
 
       SDObject &current = *m_StructureStack.back();
 
-      SDObject &obj = *current.AddAndOwnChild(new SDObject(name, "Byte Buffer"_lit));
+      SDObject &obj = *current.AddAndOwnChild(new(AllocObject()) SDObject(name, "Byte Buffer"_lit));
       m_StructureStack.push_back(&obj);
 
       obj.type.basetype = SDBasic::Buffer;
@@ -279,6 +357,7 @@ public:
     }
 
     byte *tempAlloc = NULL;
+    const byte *exportData = NULL;
 
     {
       if(IsWriting())
@@ -308,19 +387,21 @@ public:
             el = NULL;
         }
 
-        // if we're exporting the buffers, make sure to always alloc space to read the data, so we
-        // can save it out, even if the external code has no use for it and has asked for no
-        // allocation.
-        if(el == NULL && ExportStructure() && m_ExportBuffers)
+        // if we're exporting the buffers, make sure to always get the data, so we can save it out,
+        // even if the external code has no use for it and has asked for no allocation. If the
+        // reader is backed by memory we can copy from it in place, otherwise alloc space to read
+        // into.
+        if(el == NULL && ExportStructure() && m_ExportBuffers && byteSize > 0)
         {
-          if(byteSize > 0)
+          exportData = m_Read->ReadDirect(byteSize);
+
+          if(exportData == NULL)
             el = tempAlloc = AllocAlignedBuffer(byteSize);
-          else
-            el = NULL;
         }
 #endif
 
-        m_Read->Read(el, byteSize);
+        if(exportData == NULL)
+          m_Read->Read(el, byteSize);
       }
     }
 
@@ -332,10 +413,13 @@ public:
 
         obj.data.basic.u = m_StructuredFile->buffers.size();
 
+        if(el)
+          exportData = el;
+
         bytebuf *alloc = new bytebuf;
         alloc->resize((size_t)byteSize);
-        if(el)
-          memcpy(alloc->data(), el, (size_t)byteSize);
+        if(exportData)
+          memcpy(alloc->data(), exportData, (size_t)byteSize);
 
         m_StructuredFile->buffers.push_back(alloc);
       }
@@ -380,7 +464,7 @@ public:
 
       SDObject &current = *m_StructureStack.back();
 
-      SDObject &obj = *current.AddAndOwnChild(new SDObject(name, "Byte Buffer"_lit));
+      SDObject &obj = *current.AddAndOwnChild(new(AllocObject()) SDObject(name, "Byte Buffer"_lit));
       m_StructureStack.push_back(&obj);
 
       obj.type.basetype = SDBasic::Buffer;
@@ -492,7 +576,7 @@ public:
 
       SDObject &parent = *m_StructureStack.back();
 
-      SDObject &arr = *parent.AddAndOwnChild(new SDObject(name, TypeName<T>()));
+      SDObject &arr = *parent.AddAndOwnChild(new(AllocObject()) SDObject(name, TypeName<T>()));
       m_StructureStack.push_back(&arr);
 
       arr.type.basetype = SDBasic::Array;
@@ -503,7 +587,7 @@ public:
 
       for(size_t i = 0; i < N; i++)
       {
-        SDObject &obj = *arr.AddAndOwnChild(new SDObject("$el"_lit, TypeName<T>()));
+        SDObject &obj = *arr.AddAndOwnChild(new(AllocObject()) SDObject("$el"_lit, TypeName<T>()));
         m_StructureStack.push_back(&obj);
 
         // default to struct. This will be overwritten if appropriate
@@ -609,7 +693,7 @@ public:
 
       SDObject &parent = *m_StructureStack.back();
 
-      SDObject &arr = *parent.AddAndOwnChild(new SDObject(name, TypeName<T>()));
+      SDObject &arr = *parent.AddAndOwnChild(new(AllocObject()) SDObject(name, TypeName<T>()));
       m_StructureStack.push_back(&arr);
 
       arr.type.basetype = SDBasic::Array;
@@ -645,7 +729,8 @@ public:
       {
         for(uint64_t i = 0; el && i < arrayCount; i++)
         {
-          SDObject &obj = *arr.AddAndOwnChild(new SDObject("$el"_lit, TypeName<T>()));
+          SDObject &obj =
+              *arr.AddAndOwnChild(new(AllocObject()) SDObject("$el"_lit, TypeName<T>()));
           m_StructureStack.push_back(&obj);
 
           // default to struct. This will be overwritten if appropriate
@@ -712,7 +797,7 @@ public:
 
       SDObject &parent = *m_StructureStack.back();
 
-      SDObject &arr = *parent.AddAndOwnChild(new SDObject(name, TypeName<U>()));
+      SDObject &arr = *parent.AddAndOwnChild(new(AllocObject()) SDObject(name, TypeName<U>()));
       m_StructureStack.push_back(&arr);
 
       arr.type.basetype = SDBasic::Array;
@@ -738,7 +823,8 @@ public:
       {
         for(size_t i = 0; i < (size_t)size; i++)
         {
-          SDObject &obj = *arr.AddAndOwnChild(new SDObject("$el"_lit, TypeName<U>()));
+          SDObject &obj =
+              *arr.AddAndOwnChild(new(AllocObject()) SDObject("$el"_lit, TypeName<U>()));
           m_StructureStack.push_back(&obj);
 
           // default to struct. This will be overwritten if appropriate
@@ -779,7 +865,7 @@ public:
 
       SDObject &parent = *m_StructureStack.back();
 
-      SDObject &arr = *parent.AddAndOwnChild(new SDObject(name, "pair"_lit));
+      SDObject &arr = *parent.AddAndOwnChild(new(AllocObject()) SDObject(name, "pair"_lit));
       m_StructureStack.push_back(&arr);
 
       arr.type.basetype = SDBasic::Struct;
@@ -788,7 +874,8 @@ public:
       arr.ReserveChildren(2);
 
       {
-        SDObject &obj = *arr.AddAndOwnChild(new SDObject("first"_lit, TypeName<U>()));
+        SDObject &obj =
+            *arr.AddAndOwnChild(new(AllocObject()) SDObject("first"_lit, TypeName<U>()));
         m_StructureStack.push_back(&obj);
 
         // default to struct. This will be overwritten if appropriate
@@ -801,7 +888,8 @@ public:
       }
 
       {
-        SDObject &obj = *arr.AddAndOwnChild(new SDObject("second"_lit, TypeName<V>()));
+        SDObject &obj =
+            *arr.AddAndOwnChild(new(AllocObject()) SDObject("second"_lit, TypeName<V>()));
         m_StructureStack.push_back(&obj);
 
         // default to struct. This will be overwritten if appropriate
@@ -891,7 +979,8 @@ public:
       {
         SDObject &parent = *m_StructureStack.back();
 
-        SDObject &nullable = *parent.AddAndOwnChild(new SDObject(name, TypeName<T>()));
+        SDObject &nullable =
+            *parent.AddAndOwnChild(new(AllocObject()) SDObject(name, TypeName<T>()));
 
         nullable.type.basetype = SDBasic::Null;
         nullable.type.byteSize = 0;
@@ -977,7 +1066,7 @@ public:
 
       SDObject &current = *m_StructureStack.back();
 
-      SDObject &obj = *current.AddAndOwnChild(new SDObject(name, "Byte Buffer"_lit));
+      SDObject &obj = *current.AddAndOwnChild(new(AllocObject()) SDObject(name, "Byte Buffer"_lit));
       m_StructureStack.push_back(&obj);
 
       obj.type.basetype = SDBasic::Buffer;
@@ -1355,6 +1444,9 @@ private:
     };
   }
 
+  // structured objects are allocated from the structured file's arena while exporting
+  void *AllocObject() { return GetSDFileStorage(*m_StructuredFile).arena.Alloc(sizeof(SDObject)); }
+  void *AllocChunk() { return GetSDFileStorage(*m_StructuredFile).arena.Alloc(sizeof(SDChunk)); }
   void *m_pUserData = NULL;
   uint64_t m_Version = 0;
 
@@ -1377,6 +1469,10 @@ private:
   bool m_ExportBuffers = false;
   int m_InternalElement = 0;
   uint32_t m_LazyThreshold = 0;
+  // see ConfigureLazyStructuredExport
+  LazyChunkState *m_LazyChunks = NULL;
+  SDChunk *m_LazyChunk = NULL;
+  uint64_t m_LazyChunkOffset = 0;
   SDFile m_StructData;
   SDFile *m_StructuredFile = &m_StructData;
   rdcarray<SDObject *> m_StructureStack;
@@ -1533,7 +1629,7 @@ public:
   byte *AllocAlignedBuffer(uint64_t size);
   byte *AllocChunk();
 
-  // really free any unused pages
+  // release any unused pages to the shared page pool
   void Trim();
 
   // reset all pages to free
@@ -1548,10 +1644,21 @@ public:
   // page it will be marked as full so it can be freed without another allocation overlapping).
   rdcarray<uint32_t> GetPageSet();
 
+  // pages released by an allocator, when it's trimmed or destroyed, go into a pool shared by all
+  // allocators so they can be reused without going back to the system. The pool holds up to
+  // Capture_ChunkPagePoolMB of pages and anything beyond that is freed.
+  // These return how much page memory is currently allocated in total, and how much of that is
+  // sitting unused in the pool.
+  static uint64_t AllocatedPageMemory();
+  static uint64_t PooledPageMemory();
+
 private:
   size_t BufferPageSize;
   size_t ChunkPageSize;
 
+  // the ID to give the next page we allocate
+  uint32_t nextPageID = 0;
+
   struct Page
   {
     // this is an ID we can use to find this page in a pageset
@@ -1594,6 +1701,8 @@ private:
     return ChunkPageSize - (p.chunkHead - p.chunkBase);
   }
   byte *AllocateFromPages(bool chunkAlloc, size_t size);
+  void AcquirePage(Page &p);
+  void ReleasePage(Page &p);
 };
 
 // holds the memory, length and type for a given chunk, so that it can be
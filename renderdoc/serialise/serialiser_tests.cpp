@@ -23,6 +23,7 @@
  ******************************************************************************/
 
 #include "serialiser.h"
+#include "common/threading.h"
 
 #if ENABLED(ENABLE_UNIT_TESTS)
 
@@ -682,6 +683,304 @@ TEST_CASE("Read/write chunk metadata", "[serialiser]")
   delete buf;
 };
 
+TEST_CASE("Read chunks with lazy structured export", "[serialiser][structured]")
+{
+  StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
+
+  {
+    WriteSerialiser ser(buf, Ownership::Nothing);
+
+    for(uint32_t i = 0; i < 4; i++)
+    {
+      ser.WriteChunk(1 + i);
+
+      uint32_t value = 100 + i;
+      ser.Serialise("value"_lit, value);
+
+      ser.EndChunk();
+    }
+
+    REQUIRE_FALSE(ser.IsErrored());
+  }
+
+  ChunkLookup testChunkLoop = [](uint32_t) -> rdcstr { return "TestChunk"; };
+
+  int structurised = 0;
+
+  LazyChunkStructuriser structuriser = [testChunkLoop, &structurised](StreamReader &reader) {
+    ReadSerialiser ser(&reader, Ownership::Nothing);
+
+    ser.ConfigureStructuredExport(testChunkLoop, false, 0, 1.0);
+
+    ser.ReadChunk<uint32_t>();
+
+    uint32_t value;
+    ser.Serialise("value"_lit, value);
+
+    ser.EndChunk();
+
+    structurised++;
+
+    return ser.GetStructuredFile().chunks.takeAt(0);
+  };
+
+  SECTION("Unlimited budget")
+  {
+    SDFile file;
+
+    {
+      ReadSerialiser ser(new StreamReader(buf->GetData(), buf->GetOffset()), Ownership::Stream);
+
+      REQUIRE(ser.ConfigureLazyStructuredExport(testChunkLoop, structuriser, 0, 0, 1.0));
+
+      for(uint32_t i = 0; i < 4; i++)
+      {
+        CHECK(ser.ReadChunk<uint32_t>() == 1 + i);
+
+        uint32_t value;
+        ser.Serialise("value"_lit, value);
+
+        CHECK(value == 100 + i);
+
+        ser.EndChunk();
+      }
+
+      REQUIRE_FALSE(ser.IsErrored());
+      CHECK(ser.GetReader()->AtEnd());
+
+      ser.GetStructuredFile().Swap(file);
+    }
+
+    REQUIRE(file.chunks.size() == 4);
+    CHECK(structurised == 0);
+
+    CHECK(file.chunks[2]->metadata.chunkID == 3);
+    CHECK(file.chunks[2]->name == "TestChunk");
+    CHECK(structurised == 0);
+
+    REQUIRE(file.chunks[2]->NumChildren() == 1);
+    CHECK(structurised == 1);
+    CHECK(file.chunks[2]->GetChild(0)->name == "value");
+    CHECK(file.chunks[2]->GetChild(0)->AsUInt32() == 102);
+
+    CHECK(file.chunks[2]->FindChild("value") != NULL);
+    CHECK(structurised == 1);
+
+    for(uint32_t i = 0; i < 4; i++)
+      CHECK(file.chunks[i]->FindChild("value")->AsUInt32() == 100 + i);
+
+    CHECK(structurised == 4);
+
+    // the file is shared, so releasing the children does nothing
+    const SDObject *value = file.chunks[1]->GetChild(0);
+    file.chunks[1]->ReleaseLazyChildren();
+    CHECK(file.chunks[1]->IsLazyChildrenPopulated());
+    CHECK(file.chunks[1]->GetChild(0) == value);
+    CHECK(value->AsUInt32() == 101);
+    CHECK(structurised == 4);
+  }
+
+  SECTION("Limited budget")
+  {
+    SDFile file;
+
+    {
+      ReadSerialiser ser(new StreamReader(buf->GetData(), buf->GetOffset()), Ownership::Stream);
+
+      REQUIRE(ser.ConfigureLazyStructuredExport(testChunkLoop, structuriser, 2, 0, 1.0));
+
+      for(uint32_t i = 0; i < 4; i++)
+      {
+        ser.ReadChunk<uint32_t>();
+        ser.SkipCurrentChunk();
+        ser.EndChunk();
+      }
+
+      ser.GetStructuredFile().Swap(file);
+    }
+
+    REQUIRE(file.chunks.size() == 4);
+
+    for(uint32_t i = 0; i < 4; i++)
+      CHECK(file.chunks[i]->FindChild("value")->AsUInt32() == 100 + i);
+
+    CHECK(structurised == 4);
+
+    // only the two most recent chunks are still structurised
+    CHECK_FALSE(file.chunks[0]->IsLazyChildrenPopulated());
+    CHECK_FALSE(file.chunks[1]->IsLazyChildrenPopulated());
+    CHECK(file.chunks[2]->IsLazyChildrenPopulated());
+    CHECK(file.chunks[3]->IsLazyChildrenPopulated());
+
+    CHECK(file.chunks[0]->FindChild("value")->AsUInt32() == 100);
+    CHECK(structurised == 5);
+    CHECK_FALSE(file.chunks[2]->IsLazyChildrenPopulated());
+
+    // accessing a chunk again makes it the most recently used, so it's kept over the chunk that was
+    // structurised after it
+    CHECK(file.chunks[3]->FindChild("value")->AsUInt32() == 103);
+    CHECK(file.chunks[1]->FindChild("value")->AsUInt32() == 101);
+    CHECK(structurised == 6);
+    CHECK_FALSE(file.chunks[0]->IsLazyChildrenPopulated());
+    CHECK(file.chunks[1]->IsLazyChildrenPopulated());
+    CHECK(file.chunks[3]->IsLazyChildrenPopulated());
+
+    // releasing a chunk stops it counting against the budget, however many times it's repopulated
+    for(int i = 0; i < 3; i++)
+    {
+      file.chunks[1]->ReleaseLazyChildren();
+      CHECK_FALSE(file.chunks[1]->IsLazyChildrenPopulated());
+      CHECK(file.chunks[1]->FindChild("value")->AsUInt32() == 101);
+    }
+
+    CHECK(structurised == 9);
+
+    file.chunks[3]->ReleaseLazyChildren();
+    CHECK(file.chunks[0]->FindChild("value")->AsUInt32() == 100);
+    CHECK(structurised == 10);
+
+    CHECK(file.chunks[0]->IsLazyChildrenPopulated());
+    CHECK(file.chunks[1]->IsLazyChildrenPopulated());
+  }
+
+  SECTION("Concurrent access")
+  {
+    SDFile file;
+
+    {
+      ReadSerialiser ser(new StreamReader(buf->GetData(), buf->GetOffset()), Ownership::Stream);
+
+      REQUIRE(ser.ConfigureLazyStructuredExport(testChunkLoop, structuriser, 0, 0, 1.0));
+
+      for(uint32_t i = 0; i < 4; i++)
+      {
+        ser.ReadChunk<uint32_t>();
+        ser.SkipCurrentChunk();
+        ser.EndChunk();
+      }
+
+      ser.GetStructuredFile().Swap(file);
+    }
+
+    REQUIRE(file.chunks.size() == 4);
+
+    int32_t mismatches = 0;
+
+    rdcarray<Threading::ThreadHandle> threads;
+    for(int t = 0; t < 4; t++)
+    {
+      threads.push_back(Threading::CreateThread([&file, &mismatches]() {
+        for(uint32_t i = 0; i < 4; i++)
+        {
+          const SDObject *value = file.chunks[i]->FindChild("value");
+          if(value == NULL || value->AsUInt32() != 100 + i)
+            Atomic::Inc32(&mismatches);
+        }
+      }));
+    }
+
+    for(Threading::ThreadHandle t : threads)
+    {
+      Threading::JoinThread(t);
+      Threading::CloseThread(t);
+    }
+
+    CHECK(mismatches == 0);
+
+    // each chunk was only structurised once, however many threads raced to access it
+    CHECK(structurised == 4);
+  }
+
+  delete buf;
+};
+
+TEST_CASE("Structured objects allocated from an arena", "[serialiser][structured]")
+{
+  SDObject *parent = NULL;
+
+  {
+    SDObjectArena arena;
+
+    parent = new(arena.Alloc(sizeof(SDObject))) SDObject("parent"_lit, "struct"_lit);
+
+    // enough objects to need several blocks
+    for(uint32_t i = 0; i < 100000; i++)
+    {
+      SDObject *child = new(arena.Alloc(sizeof(SDObject))) SDObject("child"_lit, "uint32_t"_lit);
+      child->type.basetype = SDBasic::UnsignedInteger;
+      child->data.basic.u = i;
+
+      CHECK(((uintptr_t)child & 0xf) == 0);
+
+      parent->AddAndOwnChild(child);
+    }
+
+    // a heap-allocated object can be mixed in freely
+    parent->AddAndOwnChild(new SDObject("heap"_lit, "uint32_t"_lit));
+  }
+
+  // the objects outlive the arena
+  REQUIRE(parent->NumChildren() == 100001);
+  CHECK(parent->GetChild(12345)->AsUInt32() == 12345);
+  CHECK(parent->GetChild(100000)->name == "heap");
+
+  SDObject *dup = parent->Duplicate();
+
+  delete parent;
+
+  CHECK(dup->GetChild(99999)->AsUInt32() == 99999);
+
+  delete dup;
+
+  SDFile file;
+
+  rdcliteral a = InternSDString(file, "interned name");
+  rdcliteral b = InternSDString(file, rdcstr("interned ") + "name");
+
+  CHECK(a.c_str() == b.c_str());
+  CHECK(rdcstr(a) == "interned name");
+
+  // a copy of an object with interned names doesn't depend on the file
+  SDChunk *chunk = new SDChunk(a);
+  chunk->AddAndOwnChild(new SDObject(b, InternSDString(file, "type name")));
+  file.chunks.push_back(chunk);
+
+  SDChunk *chunkDup = chunk->Duplicate();
+
+  CHECK(chunkDup->name.c_str() != a.c_str());
+  CHECK(chunkDup->GetChild(0)->name.c_str() != b.c_str());
+
+  // literal names are still shared
+  {
+    SDObject *obj = new SDObject("literal name"_lit, "literal type"_lit);
+    obj->AddAndOwnChild(new SDObject(rdcstr("heap name"), "literal type"_lit));
+
+    SDObject *objDup = obj->Duplicate();
+
+    CHECK(objDup->name.c_str() == obj->name.c_str());
+    CHECK(objDup->type.name.c_str() == obj->type.name.c_str());
+    CHECK(objDup->GetChild(0)->name.c_str() != obj->GetChild(0)->name.c_str());
+    CHECK(objDup->GetChild(0)->name == "heap name");
+
+    delete obj;
+    delete objDup;
+  }
+
+  {
+    SDFile other;
+    other.Swap(file);
+
+    // the interned names move with the chunks
+    CHECK(rdcstr(other.chunks[0]->GetChild(0)->type.name) == "type name");
+  }
+
+  CHECK(file.chunks.empty());
+  CHECK(chunkDup->name == "interned name");
+  CHECK(chunkDup->GetChild(0)->type.name == "type name");
+
+  delete chunkDup;
+};
+
 TEST_CASE("Verify multiple chunks can be merged", "[serialiser][chunks]")
 {
   StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
@@ -1613,4 +1912,54 @@ TEST_CASE("Test stringification works as expected", "[tostr]")
   };
 };
 
+TEST_CASE("Chunk allocator pages are pooled", "[serialiser]")
+{
+  // use an unusual page size so no other allocator's pages can satisfy ours
+  const size_t pageSize = 12 * 1024;
+  const uint64_t pageMemory = pageSize + pageSize / 4;
+
+  const uint64_t allocated = ChunkAllocator::AllocatedPageMemory();
+  const uint64_t pooled = ChunkAllocator::PooledPageMemory();
+
+  {
+    ChunkAllocator alloc(pageSize);
+
+    // fill three pages
+    for(int i = 0; i < 3; i++)
+      CHECK(alloc.AllocAlignedBuffer(pageSize) != NULL);
+
+    CHECK(ChunkAllocator::AllocatedPageMemory() == allocated + pageMemory * 3);
+    CHECK(ChunkAllocator::PooledPageMemory() == pooled);
+
+    // retire the pages, then trimming releases them to the pool
+    alloc.Reset();
+    alloc.Trim();
+
+    CHECK(ChunkAllocator::AllocatedPageMemory() == allocated + pageMemory * 3);
+    CHECK(ChunkAllocator::PooledPageMemory() == pooled + pageMemory * 3);
+  }
+
+  {
+    ChunkAllocator alloc(pageSize);
+
+    // pages come back out of the pool without any new allocations
+    for(int i = 0; i < 3; i++)
+      CHECK(alloc.AllocAlignedBuffer(pageSize) != NULL);
+
+    CHECK(ChunkAllocator::AllocatedPageMemory() == allocated + pageMemory * 3);
+    CHECK(ChunkAllocator::PooledPageMemory() == pooled);
+
+    rdcarray<uint32_t> pageSet = alloc.GetPageSet();
+
+    // page IDs are unique even after trimming
+    CHECK(pageSet.size() == 3);
+    CHECK(pageSet[0] != pageSet[1]);
+    CHECK(pageSet[1] != pageSet[2]);
+    CHECK(pageSet[0] != pageSet[2]);
+  }
+
+  // the destructor returns the pages to the pool
+  CHECK(ChunkAllocator::PooledPageMemory() == pooled + pageMemory * 3);
+};
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -33,15 +33,68 @@ Compressor::~Compressor()
     delete m_Write;
 }
 
+void Compressor::AddSeekPoint(uint64_t uncompressedOffset)
+{
+  m_SeekPoints.push_back({uncompressedOffset, m_Write->GetOffset()});
+}
+
+bool Compressor::WriteSeekIndex()
+{
+  if(!m_SeekIndex)
+    return true;
+
+  bool success = true;
+
+  success &= m_Write->Write(m_SeekPoints.data(), m_SeekPoints.byteSize());
+  success &= m_Write->Write((uint64_t)m_SeekPoints.size());
+
+  return success;
+}
+
 Decompressor::~Decompressor()
 {
   if(m_Ownership == Ownership::Stream && m_Read)
     delete m_Read;
 }
 
+bool Decompressor::SeekToPoint(uint64_t offset, uint64_t &pointOffset)
+{
+  if(m_SeekPoints.empty() || m_SeekPoints[0].uncompressedOffset > offset)
+  {
+    RDCERR("No seek point available for offset %llu", offset);
+    return false;
+  }
+
+  // binary search for the last seek point at or before the offset
+  size_t first = 0, last = m_SeekPoints.size();
+  while(last - first > 1)
+  {
+    size_t mid = first + (last - first) / 2;
+    if(m_SeekPoints[mid].uncompressedOffset <= offset)
+      first = mid;
+    else
+      last = mid;
+  }
+
+  m_Read->SetOffset(m_SeekPoints[first].compressedOffset);
+
+  if(m_Read->IsErrored())
+    return false;
+
+  pointOffset = m_SeekPoints[first].uncompressedOffset;
+
+  return true;
+}
+
 static const uint64_t initialBufferSize = 64 * 1024;
 const byte StreamWriter::empty[128] = {};
 
+struct StreamReader::SharedMapping
+{
+  FileIO::MappedFile *file;
+  int32_t refcount;
+};
+
 StreamReader::StreamReader(const byte *buffer, uint64_t bufferSize)
 {
   m_InputSize = m_BufferSize = bufferSize;
@@ -114,6 +167,7 @@ StreamReader::StreamReader(FILE *file, uint64_t fileSize, Ownership own)
   }
 
   m_File = file;
+  m_FileOffset = FileIO::ftell64(file);
   m_InputSize = fileSize;
 
   m_BufferSize = initialBufferSize;
@@ -154,11 +208,28 @@ StreamReader::StreamReader(FILE *file)
 StreamReader::StreamReader(StreamReader *reader, uint64_t bufferSize)
 {
   m_InputSize = m_BufferSize = bufferSize;
+
+  m_Ownership = Ownership::Nothing;
+
+  // if the source is a file mapping, point into the mapping rather than copying the data out. This
+  // lets the data stay in the page cache instead of taking up memory for as long as we exist.
+  if(reader->m_Mapping)
+  {
+    const byte *data = reader->ReadDirect(bufferSize);
+
+    if(data)
+    {
+      m_Mapping = reader->m_Mapping;
+      Atomic::Inc32(&m_Mapping->refcount);
+
+      m_BufferHead = m_BufferBase = (byte *)data;
+      return;
+    }
+  }
+
   m_BufferHead = m_BufferBase = AllocAlignedBuffer(m_BufferSize);
 
   reader->Read(m_BufferBase, bufferSize);
-
-  m_Ownership = Ownership::Nothing;
 }
 
 StreamReader::StreamReader(Decompressor *decompressor, uint64_t uncompressedSize, Ownership own)
@@ -174,12 +245,44 @@ StreamReader::StreamReader(Decompressor *decompressor, uint64_t uncompressedSize
   ReadFromExternal(m_BufferBase, RDCMIN(uncompressedSize, m_BufferSize));
 }
 
+StreamReader::StreamReader(FileIO::MappedFile *mapping, uint64_t mappedSize)
+{
+  m_InputSize = m_BufferSize = mappedSize;
+
+  m_Ownership = Ownership::Nothing;
+
+  if(mapping == NULL)
+  {
+    m_InputSize = m_BufferSize = 0;
+    m_BufferHead = m_BufferBase = NULL;
+    m_HasError = true;
+    return;
+  }
+
+  m_Mapping = new SharedMapping;
+  m_Mapping->file = mapping;
+  m_Mapping->refcount = 1;
+
+  m_BufferHead = m_BufferBase = (byte *)FileIO::mmap_data(mapping);
+}
+
 StreamReader::~StreamReader()
 {
   for(StreamCloseCallback cb : m_Callbacks)
     cb();
 
-  FreeAlignedBuffer(m_BufferBase);
+  if(m_Mapping)
+  {
+    if(Atomic::Dec32(&m_Mapping->refcount) == 0)
+    {
+      FileIO::mmap_close(m_Mapping->file);
+      delete m_Mapping;
+    }
+  }
+  else
+  {
+    FreeAlignedBuffer(m_BufferBase);
+  }
 
   if(m_Ownership == Ownership::Stream)
   {
@@ -195,7 +298,41 @@ void StreamReader::SetOffset(uint64_t offs)
 {
   if(m_File || m_Decompressor)
   {
-    RDCERR("File and decompress stream readers do not support seeking");
+    if(m_HasError)
+      return;
+
+    if(offs > m_InputSize)
+    {
+      RDCERR("Seeking to %llu past the end of the stream", offs);
+      m_HasError = true;
+      return;
+    }
+
+    // reposition the source, then discard the current window and refill it from the new offset
+    if(m_Decompressor)
+    {
+      if(!m_Decompressor->Seek(offs))
+      {
+        RDCERR("Couldn't seek decompression stream to %llu", offs);
+        m_HasError = true;
+        return;
+      }
+    }
+    else
+    {
+      FileIO::fseek64(m_File, m_FileOffset + offs, SEEK_SET);
+    }
+
+    m_ReadOffset = offs;
+    m_BufferHead = m_BufferBase;
+
+    ReadFromExternal(m_BufferBase, RDCMIN(m_InputSize - offs, m_BufferSize));
+    return;
+  }
+
+  if(m_Sock)
+  {
+    RDCERR("Socket stream readers do not support seeking");
     return;
   }
 
@@ -40,6 +40,13 @@ class StreamReader;
 
 typedef std::function<void()> StreamCloseCallback;
 
+// a point in a compressed stream where decompression can begin without any prior history.
+struct CompressedSeekPoint
+{
+  uint64_t uncompressedOffset;
+  uint64_t compressedOffset;
+};
+
 class Compressor
 {
 public:
@@ -48,9 +55,19 @@ public:
   virtual bool Write(const void *data, uint64_t numBytes) = 0;
   virtual bool Finish() = 0;
 
+  // when enabled the compressor regularly starts blocks that can be decompressed independently and
+  // records where they are. The list of seek points is written after the compressed data on
+  // Finish(), followed by a uint64_t count of how many there are.
+  void EnableSeekIndex() { m_SeekIndex = true; }
 protected:
+  void AddSeekPoint(uint64_t uncompressedOffset);
+  bool WriteSeekIndex();
+
   StreamWriter *m_Write;
   Ownership m_Ownership;
+
+  bool m_SeekIndex = false;
+  rdcarray<CompressedSeekPoint> m_SeekPoints;
 };
 
 class Decompressor
@@ -61,9 +78,17 @@ public:
   virtual bool Recompress(Compressor *comp) = 0;
   virtual bool Read(void *data, uint64_t numBytes) = 0;
 
+  // positions the decompressor so that the next Read() returns data from the given uncompressed
+  // offset. Only possible when seek points have been provided from the stream's index.
+  virtual bool Seek(uint64_t offset) = 0;
+  void SetSeekPoints(const rdcarray<CompressedSeekPoint> &points) { m_SeekPoints = points; }
 protected:
+  bool SeekToPoint(uint64_t offset, uint64_t &pointOffset);
+
   StreamReader *m_Read;
   Ownership m_Ownership;
+
+  rdcarray<CompressedSeekPoint> m_SeekPoints;
 };
 
 class StreamReader
@@ -88,6 +113,9 @@ public:
   StreamReader(FILE *file);
   StreamReader(StreamReader *reader, uint64_t bufferSize);
   StreamReader(Decompressor *decompressor, uint64_t uncompressedSize, Ownership own);
+  // reads directly out of a file mapping without copying it. The reader takes ownership of the
+  // mapping, which is kept alive as long as this reader or any created from it exist.
+  StreamReader(FileIO::MappedFile *mapping, uint64_t mappedSize);
 
   ~StreamReader();
 
@@ -229,6 +257,33 @@ public:
     return Read(&data, sizeof(T));
   }
 
+  // for readers backed entirely by memory, including memory-mapped files, returns a pointer to the
+  // start of the stream which is valid as long as the reader. Returns NULL otherwise, or on error.
+  const byte *GetMemoryData()
+  {
+    if(m_File || m_Sock || m_Decompressor || m_Dummy || m_HasError)
+      return NULL;
+
+    return m_BufferBase;
+  }
+
+  // for readers backed entirely by memory, including memory-mapped files, returns a pointer to the
+  // next numBytes bytes and advances past them without copying anything. The pointer is valid as
+  // long as the reader. Returns NULL if the reader isn't backed by memory, or on error, in which
+  // case the stream is untouched and Read() should be used instead.
+  const byte *ReadDirect(uint64_t numBytes)
+  {
+    if(GetMemoryData() == NULL)
+      return NULL;
+
+    if(GetOffset() + numBytes > GetSize())
+      return NULL;
+
+    const byte *ret = m_BufferHead;
+    m_BufferHead += numBytes;
+    return ret;
+  }
+
   void AddCloseCallback(StreamCloseCallback callback) { m_Callbacks.push_back(callback); }
 private:
   inline uint64_t Available()
@@ -264,9 +319,17 @@ private:
   // the decompressor, if reading from it
   Decompressor *m_Decompressor = NULL;
 
+  // the file mapping, if we're reading from one. The buffer then points into the mapping instead of
+  // being allocated, and the mapping is shared with any readers created from this one.
+  struct SharedMapping;
+  SharedMapping *m_Mapping = NULL;
+
   // the offset in the file/decompressor that corresponds to the start of m_BufferBase
   uint64_t m_ReadOffset = 0;
 
+  // the position in the file where this stream begins, for seeking
+  uint64_t m_FileOffset = 0;
+
   // flag indicating if an error has been encountered and the stream is now invalid
   bool m_HasError = false;
 
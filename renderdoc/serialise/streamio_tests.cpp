@@ -94,6 +94,104 @@ TEST_CASE("Test basic stream I/O operations", "[streamio]")
   CHECK(reader.IsErrored());
 };
 
+TEST_CASE("Test reading from a mapped file", "[streamio]")
+{
+  rdcstr filename = FileIO::GetTempFolderFilename() + "/mapped_scratch.bin";
+
+  // write a header that isn't a multiple of any page size, followed by the data we'll map
+  const uint64_t headerSize = 1234;
+  const uint64_t dataSize = 100 * 1024;
+
+  rdcarray<uint32_t> data;
+  data.resize(dataSize / sizeof(uint32_t));
+  for(size_t i = 0; i < data.size(); i++)
+    data[i] = uint32_t(i * 7);
+
+  {
+    bytebuf header;
+    header.resize(headerSize);
+
+    FILE *f = FileIO::fopen(filename.c_str(), "wb");
+    REQUIRE(f);
+    FileIO::fwrite(header.data(), 1, header.size(), f);
+    FileIO::fwrite(data.data(), 1, data.byteSize(), f);
+    FileIO::fclose(f);
+  }
+
+  FILE *f = FileIO::fopen(filename.c_str(), "rb");
+  REQUIRE(f);
+
+  // nothing beyond the end of the file can be mapped
+  CHECK(FileIO::mmap_open(f, headerSize, dataSize + 1) == NULL);
+  CHECK(FileIO::mmap_open(f, headerSize + dataSize, 4) == NULL);
+
+  FileIO::MappedFile *mapping = FileIO::mmap_open(f, headerSize, dataSize);
+
+  // the mapping is independent of the file handle
+  FileIO::fclose(f);
+
+  REQUIRE(mapping);
+  CHECK(memcmp(FileIO::mmap_data(mapping), data.data(), (size_t)dataSize) == 0);
+
+  StreamReader *reader = new StreamReader(mapping, dataSize);
+
+  CHECK(reader->GetSize() == dataSize);
+
+  uint32_t test = 0;
+  reader->Read(test);
+  CHECK(test == data[0]);
+  reader->Read(test);
+  CHECK(test == data[1]);
+
+  // direct reads point into the mapping and advance the stream
+  const byte *direct = reader->ReadDirect(sizeof(uint32_t) * 2);
+  REQUIRE(direct);
+  CHECK(memcmp(direct, &data[2], sizeof(uint32_t) * 2) == 0);
+  CHECK(reader->GetOffset() == sizeof(uint32_t) * 4);
+
+  // a direct read off the end fails without moving the stream
+  CHECK(reader->ReadDirect(dataSize) == NULL);
+  CHECK(reader->GetOffset() == sizeof(uint32_t) * 4);
+  CHECK_FALSE(reader->IsErrored());
+
+  // a sub-reader shares the mapping and stays valid after the original reader is gone
+  const uint64_t subSize = 1024 * sizeof(uint32_t);
+  StreamReader *subReader = new StreamReader(reader, subSize);
+
+  CHECK(reader->GetOffset() == sizeof(uint32_t) * 4 + subSize);
+  reader->Read(test);
+  CHECK(test == data[1028]);
+
+  delete reader;
+
+  // replacing the file doesn't affect the mapping
+  FileIO::Delete(filename.c_str());
+
+  {
+    FILE *replacement = FileIO::fopen(filename.c_str(), "wb");
+    REQUIRE(replacement);
+    FileIO::fwrite(&test, 1, sizeof(test), replacement);
+    FileIO::fclose(replacement);
+  }
+
+  CHECK(subReader->GetSize() == subSize);
+
+  rdcarray<uint32_t> subData;
+  subData.resize(1024);
+  subReader->Read(subData.data(), subSize);
+  CHECK_FALSE(subReader->IsErrored());
+  CHECK(subReader->AtEnd());
+  CHECK(memcmp(subData.data(), &data[4], (size_t)subSize) == 0);
+
+  subReader->SetOffset(4);
+  subReader->Read(test);
+  CHECK(test == data[5]);
+
+  delete subReader;
+
+  FileIO::Delete(filename.c_str());
+};
+
 TEST_CASE("Test stream I/O operations over the network", "[streamio][network]")
 {
   uint16_t port = 8235;
@@ -24,10 +24,113 @@
 
 #define ZSTD_STATIC_LINKING_ONLY
 #include "zstdio.h"
+#include "common/threading.h"
 
 static const uint64_t zstdBlockSize = 128 * 1024;
 static const uint64_t compressBlockSize = ZSTD_compressBound(zstdBlockSize);
 
+// when compressing on multiple threads, how many pages each thread compresses per batch.
+static const uint32_t zstdPagesPerThread = 4;
+
+// the most pages in one batch regardless of the thread count, to bound the memory held for pages
+// in-flight at around 4MB including their compressed copies.
+static const uint32_t zstdMaxBatchPages = 16;
+
+static const int zstdCompressionLevel = 7;
+
+// when compressing with a dictionary, how much data is gathered up front to build it from, and the
+// largest dictionary that will be built. Sections smaller than a couple of pages don't get a
+// dictionary at all since there is little repetition between pages to exploit.
+static const uint64_t zstdDictTrainingSize = 32 * zstdBlockSize;
+static const uint64_t zstdDictMinTrainingSize = 2 * zstdBlockSize;
+static const uint32_t zstdMaxDictSize = 64 * 1024;
+
+// the dictionary is assembled from segments of this size, and segments are scored by how common the
+// runs of zstdDictMatchLength bytes they contain are in the training data.
+static const uint32_t zstdDictSegmentSize = 1024;
+static const uint32_t zstdDictSegmentStride = 64;
+static const uint32_t zstdDictMatchLength = 8;
+static const uint32_t zstdDictHashBits = 18;
+
+static uint32_t HashDictMatch(const byte *data)
+{
+  uint64_t val;
+  memcpy(&val, data, sizeof(val));
+  return uint32_t((val * 0x9E3779B185EBCA87ULL) >> (64 - zstdDictHashBits));
+}
+
+// the bundled zstd doesn't include the dictionary builder, so we build a raw content dictionary
+// ourselves. This follows the same idea as zstd's COVER algorithm in a simpler form: the training
+// data is split into one epoch per segment in the dictionary, and from each epoch we take the
+// segment that contains the most commonly repeated data. Once a segment is picked its contents no
+// longer count towards the score, so later epochs favour data the dictionary doesn't cover yet.
+static bytebuf BuildDictionary(const bytebuf &samples)
+{
+  bytebuf dict;
+
+  if(samples.size() < zstdDictMinTrainingSize)
+    return dict;
+
+  const size_t dictSize = RDCMIN((size_t)zstdMaxDictSize, samples.size() / 16);
+  const size_t numEpochs = dictSize / zstdDictSegmentSize;
+  const size_t epochSize = samples.size() / numEpochs;
+
+  if(numEpochs == 0 || epochSize < zstdDictSegmentSize)
+    return dict;
+
+  rdcarray<uint32_t> freq;
+  freq.resize(1 << zstdDictHashBits);
+
+  for(size_t i = 0; i + zstdDictMatchLength <= samples.size(); i++)
+    freq[HashDictMatch(samples.data() + i)]++;
+
+  // segments are placed from the end of the dictionary backwards, so the best segments get the
+  // smallest offsets from the data being compressed.
+  dict.resize(numEpochs * zstdDictSegmentSize);
+  size_t dictOffset = dict.size();
+
+  for(size_t e = 0; e < numEpochs; e++)
+  {
+    const size_t epochBegin = e * epochSize;
+    const size_t epochEnd = epochBegin + epochSize - zstdDictSegmentSize;
+
+    uint64_t bestScore = 0;
+    size_t bestSegment = 0;
+
+    for(size_t seg = epochBegin; seg <= epochEnd; seg += zstdDictSegmentStride)
+    {
+      uint64_t score = 0;
+
+      // data that's only seen once won't help anything compress
+      for(size_t i = 0; i + zstdDictMatchLength <= zstdDictSegmentSize; i++)
+      {
+        uint32_t count = freq[HashDictMatch(samples.data() + seg + i)];
+        if(count > 1)
+          score += count;
+      }
+
+      if(score > bestScore)
+      {
+        bestScore = score;
+        bestSegment = seg;
+      }
+    }
+
+    if(bestScore == 0)
+      continue;
+
+    for(size_t i = 0; i + zstdDictMatchLength <= zstdDictSegmentSize; i++)
+      freq[HashDictMatch(samples.data() + bestSegment + i)] = 0;
+
+    dictOffset -= zstdDictSegmentSize;
+    memcpy(dict.data() + dictOffset, samples.data() + bestSegment, zstdDictSegmentSize);
+  }
+
+  dict.erase(0, dictOffset);
+
+  return dict;
+}
+
 ZSTDCompressor::ZSTDCompressor(StreamWriter *write, Ownership own) : Compressor(write, own)
 {
   m_Page = AllocAlignedBuffer(zstdBlockSize);
@@ -38,12 +141,58 @@ ZSTDCompressor::ZSTDCompressor(StreamWriter *write, Ownership own) : Compressor(
   m_Stream = ZSTD_createCStream();
 }
 
+ZSTDCompressor::ZSTDCompressor(StreamWriter *write, Ownership own, uint32_t numThreads)
+    : ZSTDCompressor(write, own)
+{
+  if(numThreads <= 1)
+    return;
+
+  m_NumThreads = numThreads;
+
+  // m_Page will point into the batch, so release the page we allocated for it
+  FreeAlignedBuffer(m_Page);
+
+  const uint32_t batchSize = RDCMIN(m_NumThreads * zstdPagesPerThread, zstdMaxBatchPages);
+
+  m_BatchPages.resize(batchSize);
+  m_BatchCompressed.resize(batchSize);
+  m_BatchLengths.resize(batchSize);
+  m_BatchCompSizes.resize(batchSize);
+
+  for(uint32_t i = 0; i < batchSize; i++)
+  {
+    m_BatchPages[i] = AllocAlignedBuffer(zstdBlockSize);
+    m_BatchCompressed[i] = AllocAlignedBuffer(compressBlockSize);
+  }
+
+  m_Page = m_BatchPages[0];
+}
+
 ZSTDCompressor::~ZSTDCompressor()
 {
   ZSTD_freeCStream(m_Stream);
+  ZSTD_freeCDict(m_Dict);
 
-  FreeAlignedBuffer(m_Page);
+  FreeBuffers();
+}
+
+void ZSTDCompressor::FreeBuffers()
+{
+  if(m_NumThreads > 1)
+  {
+    for(byte *page : m_BatchPages)
+      FreeAlignedBuffer(page);
+    for(byte *page : m_BatchCompressed)
+      FreeAlignedBuffer(page);
+    m_BatchPages.clear();
+    m_BatchCompressed.clear();
+  }
+  else
+  {
+    FreeAlignedBuffer(m_Page);
+  }
   FreeAlignedBuffer(m_CompressBuffer);
+  m_Page = m_CompressBuffer = NULL;
 }
 
 bool ZSTDCompressor::Write(const void *data, uint64_t numBytes)
@@ -55,6 +204,17 @@ bool ZSTDCompressor::Write(const void *data, uint64_t numBytes)
   if(numBytes == 0)
     return true;
 
+  // hold everything back until we have enough data to build the dictionary
+  if(m_DictionaryPending)
+  {
+    m_TrainingData.append((const byte *)data, (size_t)numBytes);
+
+    if(m_TrainingData.size() < zstdDictTrainingSize)
+      return true;
+
+    return WriteDictionary();
+  }
+
   // this is largely similar to LZ4Compressor, so check the comments there for more details.
   // The only difference is that the lz4 streaming compression assumes a history of 64kb, where
   // here we use a larger block size but no history must be maintained.
@@ -112,7 +272,22 @@ bool ZSTDCompressor::Finish()
   // only the last one can be smaller, so we only write a partial page when finishing.
   // Calling Write() after Finish() is illegal
 
-  return FlushPage();
+  bool success = true;
+
+  // if the data was too small to fill the training set, build the dictionary from what we have
+  if(m_DictionaryPending)
+    success &= WriteDictionary();
+
+  success &= FlushPage();
+
+  // compress whatever is left in a partial batch
+  if(success && m_NumThreads > 1 && m_BatchCount > 0)
+    success &= CompressBatch();
+
+  if(success)
+    success &= WriteSeekIndex();
+
+  return success;
 }
 
 bool ZSTDCompressor::FlushPage()
@@ -121,16 +296,40 @@ bool ZSTDCompressor::FlushPage()
   if(!m_CompressBuffer)
     return false;
 
-  ZSTD_inBuffer in = {m_Page, (size_t)m_PageOffset, 0};
-  ZSTD_outBuffer out = {m_CompressBuffer, ZSTD_CStreamOutSize(), 0};
+  if(m_NumThreads > 1)
+  {
+    // queue this page in the batch and move on to the next one, only compressing once the batch is
+    // full.
+    m_BatchLengths[m_BatchCount] = m_PageOffset;
+    m_BatchCount++;
 
-  bool success = true;
+    m_PageOffset = 0;
+
+    if(m_BatchCount == m_BatchPages.size())
+      return CompressBatch();
+
+    m_Page = m_BatchPages[m_BatchCount];
+
+    return true;
+  }
 
-  success &= CompressZSTDFrame(in, out);
+  ZSTD_inBuffer in = {m_Page, (size_t)m_PageOffset, 0};
+  ZSTD_outBuffer out = {m_CompressBuffer, ZSTD_CStreamOutSize(), 0};
 
   // if there was an error, bail
-  if(!m_CompressBuffer)
+  if(!CompressZSTDFrame(m_Stream, m_Dict, in, out))
+  {
+    FreeBuffers();
     return false;
+  }
+
+  // every page is independent, so every page is a seek point
+  if(m_SeekIndex)
+    AddSeekPoint(m_NumPages * zstdBlockSize);
+
+  m_NumPages++;
+
+  bool success = true;
 
   // a bit redundant to write this but it means we can read the entire frame without
   // doing multiple reads
@@ -143,16 +342,103 @@ bool ZSTDCompressor::FlushPage()
   return success;
 }
 
-bool ZSTDCompressor::CompressZSTDFrame(ZSTD_inBuffer &in, ZSTD_outBuffer &out)
+bool ZSTDCompressor::CompressBatch()
+{
+  // every page is compressed as its own frame with no shared history, so the pages can be split
+  // arbitrarily between threads.
+  bool success = true;
+
+  Threading::ParallelForRanges(m_BatchCount, m_NumThreads, [this](uint32_t begin, uint32_t end) {
+    ZSTD_CStream *stream = ZSTD_createCStream();
+
+    for(uint32_t i = begin; i < end; i++)
+    {
+      ZSTD_inBuffer in = {m_BatchPages[i], (size_t)m_BatchLengths[i], 0};
+      ZSTD_outBuffer out = {m_BatchCompressed[i], (size_t)compressBlockSize, 0};
+
+      // use ~0 to mark a failed page, it can never be a valid compressed size
+      if(CompressZSTDFrame(stream, m_Dict, in, out))
+        m_BatchCompSizes[i] = out.pos;
+      else
+        m_BatchCompSizes[i] = ~0ULL;
+    }
+
+    ZSTD_freeCStream(stream);
+  });
+
+  for(uint32_t i = 0; i < m_BatchCount; i++)
+  {
+    if(m_BatchCompSizes[i] == ~0ULL)
+    {
+      FreeBuffers();
+      return false;
+    }
+
+    if(m_SeekIndex)
+      AddSeekPoint((m_NumPages + i) * zstdBlockSize);
+
+    success &= m_Write->Write((uint32_t)m_BatchCompSizes[i]);
+    success &= m_Write->Write(m_BatchCompressed[i], m_BatchCompSizes[i]);
+  }
+
+  m_NumPages += m_BatchCount;
+
+  m_BatchCount = 0;
+  m_Page = m_BatchPages[0];
+
+  return success;
+}
+
+bool ZSTDCompressor::WriteDictionary()
+{
+  // if we encountered a stream error this will be NULL
+  if(!m_CompressBuffer)
+    return false;
+
+  m_DictionaryPending = false;
+
+  bytebuf dict = BuildDictionary(m_TrainingData);
+
+  // an empty dictionary is still written so the reader knows to compress without one
+  bool success = true;
+
+  success &= m_Write->Write((uint32_t)dict.size());
+  success &= m_Write->Write(dict.data(), dict.size());
+
+  if(!success)
+    return false;
+
+  if(!dict.empty())
+  {
+    // the dictionary is shared read-only between all the threads compressing pages
+    m_Dict = ZSTD_createCDict_advanced(
+        dict.data(), dict.size(), ZSTD_dlm_byCopy, ZSTD_dct_rawContent,
+        ZSTD_getCParams(zstdCompressionLevel, zstdBlockSize, dict.size()), ZSTD_defaultCMem);
+
+    if(!m_Dict)
+    {
+      RDCERR("Error creating compression dictionary");
+      FreeBuffers();
+      return false;
+    }
+  }
+
+  // now compress everything we held back as normal
+  bytebuf data;
+  data.swap(m_TrainingData);
+
+  return Write(data.data(), data.size());
+}
+
+bool ZSTDCompressor::CompressZSTDFrame(ZSTD_CStream *stream, const ZSTD_CDict *dict,
+                                       ZSTD_inBuffer &in, ZSTD_outBuffer &out)
 {
-  size_t err = ZSTD_initCStream(m_Stream, 7);
+  size_t err = dict ? ZSTD_initCStream_usingCDict(stream, dict)
+                    : ZSTD_initCStream(stream, zstdCompressionLevel);
 
   if(ZSTD_isError(err))
   {
     RDCERR("Error compressing: %s", ZSTD_getErrorName(err));
-    FreeAlignedBuffer(m_Page);
-    FreeAlignedBuffer(m_CompressBuffer);
-    m_Page = m_CompressBuffer = NULL;
     return false;
   }
 
@@ -162,7 +448,7 @@ bool ZSTDCompressor::CompressZSTDFrame(ZSTD_inBuffer &in, ZSTD_outBuffer &out)
     size_t inpos = in.pos;
     size_t outpos = out.pos;
 
-    err = ZSTD_compressStream(m_Stream, &out, &in);
+    err = ZSTD_compressStream(stream, &out, &in);
 
     if(ZSTD_isError(err) || (inpos == in.pos && outpos == out.pos))
     {
@@ -170,14 +456,11 @@ bool ZSTDCompressor::CompressZSTDFrame(ZSTD_inBuffer &in, ZSTD_outBuffer &out)
         RDCERR("Error compressing: %s", ZSTD_getErrorName(err));
       else
         RDCERR("Error compressing, no progress made");
-      FreeAlignedBuffer(m_Page);
-      FreeAlignedBuffer(m_CompressBuffer);
-      m_Page = m_CompressBuffer = NULL;
       return false;
     }
   }
 
-  err = ZSTD_endStream(m_Stream, &out);
+  err = ZSTD_endStream(stream, &out);
 
   if(ZSTD_isError(err) || err != 0)
   {
@@ -185,9 +468,6 @@ bool ZSTDCompressor::CompressZSTDFrame(ZSTD_inBuffer &in, ZSTD_outBuffer &out)
       RDCERR("Error compressing: %s", ZSTD_getErrorName(err));
     else
       RDCERR("Error compressing, couldn't end stream");
-    FreeAlignedBuffer(m_Page);
-    FreeAlignedBuffer(m_CompressBuffer);
-    m_Page = m_CompressBuffer = NULL;
     return false;
   }
 
@@ -205,18 +485,80 @@ ZSTDDecompressor::ZSTDDecompressor(StreamReader *read, Ownership own) : Decompre
   m_Stream = ZSTD_createDStream();
 }
 
+ZSTDDecompressor::ZSTDDecompressor(StreamReader *read, Ownership own, uint32_t numThreads)
+    : ZSTDDecompressor(read, own)
+{
+  if(numThreads <= 1)
+    return;
+
+  m_NumThreads = numThreads;
+
+  // m_Page will point into a batch, so release the page we allocated for it
+  FreeAlignedBuffer(m_Page);
+
+  // two batches are in flight at once, so each gets half of the usual bound
+  const uint32_t batchSize = RDCMIN(m_NumThreads * zstdPagesPerThread, zstdMaxBatchPages / 2);
+
+  for(PageBatch &batch : m_Batches)
+  {
+    batch.pages.resize(batchSize);
+    batch.compressed.resize(batchSize);
+    batch.lengths.resize(batchSize);
+    batch.compSizes.resize(batchSize);
+
+    for(uint32_t i = 0; i < batchSize; i++)
+    {
+      batch.pages[i] = AllocAlignedBuffer(zstdBlockSize);
+      batch.compressed[i] = AllocAlignedBuffer(compressBlockSize);
+    }
+  }
+
+  m_Page = m_Current->pages[0];
+}
+
 ZSTDDecompressor::~ZSTDDecompressor()
 {
+  // this stops any background decompression before the dictionary it uses is freed
+  FreeBuffers();
   ZSTD_freeDStream(m_Stream);
-  FreeAlignedBuffer(m_Page);
+  ZSTD_freeDDict(m_Dict);
+}
+
+void ZSTDDecompressor::FreeBuffers()
+{
+  if(m_NumThreads > 1)
+  {
+    for(PageBatch &batch : m_Batches)
+    {
+      batch.decompress.Cancel();
+
+      for(byte *page : batch.pages)
+        FreeAlignedBuffer(page);
+      for(byte *page : batch.compressed)
+        FreeAlignedBuffer(page);
+      batch.pages.clear();
+      batch.compressed.clear();
+      batch.count = 0;
+    }
+  }
+  else
+  {
+    FreeAlignedBuffer(m_Page);
+  }
   FreeAlignedBuffer(m_CompressBuffer);
+  m_Page = m_CompressBuffer = NULL;
 }
 
 bool ZSTDDecompressor::Recompress(Compressor *comp)
 {
   bool success = true;
 
-  while(success && !m_Read->AtEnd())
+  // read the dictionary first, the stream might not contain anything after it
+  if(m_DictionaryPending)
+    success &= ReadDictionary();
+
+  // pages may already have been read ahead and be waiting in a batch
+  while(success && (!m_Read->AtEnd() || m_BatchIndex < m_Current->count || m_Next->count > 0))
   {
     success &= FillPage();
     if(success)
@@ -286,8 +628,70 @@ bool ZSTDDecompressor::Read(void *data, uint64_t numBytes)
   return success;
 }
 
+bool ZSTDDecompressor::Seek(uint64_t offset)
+{
+  // if we encountered a stream error this will be NULL
+  if(!m_CompressBuffer)
+    return false;
+
+  // the dictionary must be read before jumping past it
+  if(m_DictionaryPending && !ReadDictionary())
+    return false;
+
+  uint64_t pointOffset = 0;
+  if(!SeekToPoint(offset, pointOffset))
+    return false;
+
+  // discard anything we'd read ahead, skipping any pages the background job hasn't started on. Only
+  // the page we seek to is decompressed, in case the caller seeks again rather than reading on.
+  if(m_NumThreads > 1)
+  {
+    for(PageBatch &batch : m_Batches)
+    {
+      batch.decompress.Cancel();
+      batch.count = 0;
+    }
+
+    m_BatchIndex = 0;
+    m_SinglePage = true;
+  }
+
+  m_PageOffset = 0;
+  m_PageLength = 0;
+
+  // every page is a seek point so this will only consume data within one page.
+  uint64_t skip = offset - pointOffset;
+  while(skip > 0)
+  {
+    if(!FillPage() || m_PageLength == 0)
+      return false;
+
+    m_PageOffset = RDCMIN(skip, m_PageLength);
+    skip -= m_PageOffset;
+  }
+
+  return true;
+}
+
 bool ZSTDDecompressor::FillPage()
 {
+  if(m_DictionaryPending && !ReadDictionary())
+    return false;
+
+  if(m_NumThreads > 1)
+  {
+    // if we've handed out every page in the current batch, move on to the next one
+    if(m_BatchIndex >= m_Current->count && !NextBatch())
+      return false;
+
+    m_Page = m_Current->pages[m_BatchIndex];
+    m_PageLength = m_Current->lengths[m_BatchIndex];
+    m_PageOffset = 0;
+    m_BatchIndex++;
+
+    return true;
+  }
+
   uint32_t compSize = 0;
 
   bool success = true;
@@ -297,33 +701,223 @@ bool ZSTDDecompressor::FillPage()
 
   if(!success)
   {
-    FreeAlignedBuffer(m_Page);
-    FreeAlignedBuffer(m_CompressBuffer);
-    m_Page = m_CompressBuffer = NULL;
+    FreeBuffers();
+    return false;
+  }
+
+  ZSTD_inBuffer in = {m_CompressBuffer, compSize, 0};
+  ZSTD_outBuffer out = {m_Page, zstdBlockSize, 0};
+
+  if(!DecompressZSTDFrame(m_Stream, m_Dict, in, out))
+  {
+    FreeBuffers();
+    return false;
+  }
+
+  m_PageOffset = 0;
+  m_PageLength = out.pos;
+
+  return success;
+}
+
+bool ZSTDDecompressor::NextBatch()
+{
+  // if we encountered a stream error this will be NULL
+  if(!m_CompressBuffer)
+    return false;
+
+  m_BatchIndex = 0;
+
+  if(m_SinglePage)
+  {
+    m_SinglePage = false;
+
+    if(!ReadBatch(*m_Current, 1))
+      return false;
+
+    DecompressPages(*m_Current, 0, 1);
+
+    return CheckBatch(*m_Current);
+  }
+
+  if(m_Next->count > 0)
+  {
+    // the batch was prefetched, so wait for whatever is left of it to finish
+    m_Next->decompress.Wait();
+    std::swap(m_Current, m_Next);
+    m_Next->count = 0;
+  }
+  else
+  {
+    if(!ReadBatch(*m_Current, (uint32_t)m_Current->pages.size()))
+      return false;
+
+    PageBatch *batch = m_Current;
+    Threading::ParallelForRanges(batch->count, m_NumThreads, [this, batch](uint32_t begin,
+                                                                           uint32_t end) {
+      DecompressPages(*batch, begin, end);
+    });
+  }
+
+  if(!CheckBatch(*m_Current))
+    return false;
+
+  // start decompressing the batch after this one in the background while this one is read.
+  // Reading the compressed data is cheap compared to decompressing it so that's done here, which
+  // also keeps all access to the stream on this thread.
+  if(!m_Read->AtEnd())
+  {
+    if(!ReadBatch(*m_Next, (uint32_t)m_Next->pages.size()))
+      return false;
+
+    PageBatch *batch = m_Next;
+    batch->decompress.Start(batch->count, m_NumThreads, [this, batch](uint32_t begin, uint32_t end) {
+      DecompressPages(*batch, begin, end);
+    });
+  }
+
+  return true;
+}
+
+bool ZSTDDecompressor::ReadBatch(PageBatch &batch, uint32_t maxPages)
+{
+  batch.count = 0;
+
+  while(batch.count < maxPages && !m_Read->AtEnd())
+  {
+    uint32_t compSize = 0;
+
+    bool success = true;
+
+    success &= m_Read->Read(compSize);
+    if(!success || compSize > compressBlockSize)
+    {
+      RDCERR("Error reading size: %u", compSize);
+      FreeBuffers();
+      return false;
+    }
+
+    success &= m_Read->Read(batch.compressed[batch.count], compSize);
+
+    if(!success)
+    {
+      FreeBuffers();
+      return false;
+    }
+
+    batch.compSizes[batch.count] = compSize;
+    batch.count++;
+  }
+
+  if(batch.count == 0)
+  {
+    RDCERR("Reading past the end of compressed stream");
+    FreeBuffers();
+    return false;
+  }
+
+  return true;
+}
+
+void ZSTDDecompressor::DecompressPages(PageBatch &batch, uint32_t begin, uint32_t end)
+{
+  ZSTD_DStream *stream = ZSTD_createDStream();
+
+  for(uint32_t i = begin; i < end; i++)
+  {
+    ZSTD_inBuffer in = {batch.compressed[i], batch.compSizes[i], 0};
+    ZSTD_outBuffer out = {batch.pages[i], zstdBlockSize, 0};
+
+    // use ~0 to mark a failed page, it can never be a valid page length
+    if(DecompressZSTDFrame(stream, m_Dict, in, out))
+      batch.lengths[i] = out.pos;
+    else
+      batch.lengths[i] = ~0ULL;
+  }
+
+  ZSTD_freeDStream(stream);
+}
+
+bool ZSTDDecompressor::CheckBatch(PageBatch &batch)
+{
+  for(uint32_t i = 0; i < batch.count; i++)
+  {
+    if(batch.lengths[i] == ~0ULL)
+    {
+      FreeBuffers();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool ZSTDDecompressor::ReadDictionary()
+{
+  // if we encountered a stream error this will be NULL
+  if(!m_CompressBuffer)
+    return false;
+
+  m_DictionaryPending = false;
+
+  uint32_t dictSize = 0;
+
+  bool success = true;
+
+  success &= m_Read->Read(dictSize);
+  if(!success || dictSize > zstdMaxDictSize)
+  {
+    RDCERR("Error reading dictionary size: %u", dictSize);
+    FreeBuffers();
+    return false;
+  }
+
+  // an empty dictionary means the pages were compressed without one
+  if(dictSize == 0)
+    return true;
+
+  bytebuf dict;
+  dict.resize(dictSize);
+
+  success &= m_Read->Read(dict.data(), dict.size());
+
+  if(!success)
+  {
+    FreeBuffers();
+    return false;
+  }
+
+  m_Dict = ZSTD_createDDict_advanced(dict.data(), dict.size(), ZSTD_dlm_byCopy,
+                                     ZSTD_dct_rawContent, ZSTD_defaultCMem);
+
+  if(!m_Dict)
+  {
+    RDCERR("Error creating decompression dictionary");
+    FreeBuffers();
     return false;
   }
 
-  size_t err = ZSTD_initDStream(m_Stream);
+  return true;
+}
+
+bool ZSTDDecompressor::DecompressZSTDFrame(ZSTD_DStream *stream, const ZSTD_DDict *dict,
+                                           ZSTD_inBuffer &in, ZSTD_outBuffer &out)
+{
+  size_t err = dict ? ZSTD_initDStream_usingDDict(stream, dict) : ZSTD_initDStream(stream);
 
   if(ZSTD_isError(err))
   {
     RDCERR("Error decompressing: %s", ZSTD_getErrorName(err));
-    FreeAlignedBuffer(m_Page);
-    FreeAlignedBuffer(m_CompressBuffer);
-    m_Page = m_CompressBuffer = NULL;
     return false;
   }
 
-  ZSTD_inBuffer in = {m_CompressBuffer, compSize, 0};
-  ZSTD_outBuffer out = {m_Page, zstdBlockSize, 0};
-
   // keep calling compressStream until everything is consumed
   while(in.pos < in.size)
   {
     size_t inpos = in.pos;
     size_t outpos = out.pos;
 
-    err = ZSTD_decompressStream(m_Stream, &out, &in);
+    err = ZSTD_decompressStream(stream, &out, &in);
 
     if(ZSTD_isError(err) || (inpos == in.pos && outpos == out.pos))
     {
@@ -331,15 +925,9 @@ bool ZSTDDecompressor::FillPage()
         RDCERR("Error decompressing: %s", ZSTD_getErrorName(err));
       else
         RDCERR("Error decompressing, no progress made");
-      FreeAlignedBuffer(m_Page);
-      FreeAlignedBuffer(m_CompressBuffer);
-      m_Page = m_CompressBuffer = NULL;
       return false;
     }
   }
 
-  m_PageOffset = 0;
-  m_PageLength = out.pos;
-
-  return success;
+  return true;
 }
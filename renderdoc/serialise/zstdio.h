@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include "common/threading.h"
 #include "zstd/zstd.h"
 #include "streamio.h"
 
@@ -31,34 +32,79 @@ class ZSTDCompressor : public Compressor
 {
 public:
   ZSTDCompressor(StreamWriter *write, Ownership own);
+  // compresses batches of pages across up to numThreads threads. Pages are compressed as
+  // independent frames either way so the output is identical in format.
+  ZSTDCompressor(StreamWriter *write, Ownership own, uint32_t numThreads);
   ~ZSTDCompressor();
 
+  // compress pages against a dictionary built from the first data written. The dictionary is
+  // stored at the start of the stream, so this must be called before anything is written.
+  void EnableDictionary() { m_DictionaryPending = true; }
   bool Write(const void *data, uint64_t numBytes);
   bool Finish();
 
 private:
   bool FlushPage();
+  bool CompressBatch();
+  bool WriteDictionary();
+  void FreeBuffers();
 
-  bool CompressZSTDFrame(ZSTD_inBuffer &in, ZSTD_outBuffer &out);
+  static bool CompressZSTDFrame(ZSTD_CStream *stream, const ZSTD_CDict *dict, ZSTD_inBuffer &in,
+                                ZSTD_outBuffer &out);
 
   byte *m_Page;
   byte *m_CompressBuffer;
   uint64_t m_PageOffset;
+  uint64_t m_NumPages = 0;
 
   ZSTD_CStream *m_Stream;
+
+  // while m_DictionaryPending is set, written data is held in m_TrainingData until there's enough
+  // to build the dictionary from.
+  bool m_DictionaryPending = false;
+  bytebuf m_TrainingData;
+  ZSTD_CDict *m_Dict = NULL;
+
+  // only used when compressing on multiple threads, m_Page points into m_BatchPages at the page
+  // currently being written.
+  uint32_t m_NumThreads = 1;
+  uint32_t m_BatchCount = 0;
+  rdcarray<byte *> m_BatchPages;
+  rdcarray<uint64_t> m_BatchLengths;
+  rdcarray<byte *> m_BatchCompressed;
+  rdcarray<uint64_t> m_BatchCompSizes;
 };
 
 class ZSTDDecompressor : public Decompressor
 {
 public:
   ZSTDDecompressor(StreamReader *read, Ownership own);
+  // decompresses a batch of pages at a time across up to numThreads threads, and while a batch is
+  // being read the next one is decompressed in the background. Since this reads past what has been
+  // requested, it must only be used on streams that are fully available like files or memory - not
+  // sockets.
+  ZSTDDecompressor(StreamReader *read, Ownership own, uint32_t numThreads);
   ~ZSTDDecompressor();
 
+  // the stream was written with ZSTDCompressor::EnableDictionary(), and begins with the dictionary
+  void EnableDictionary() { m_DictionaryPending = true; }
   bool Recompress(Compressor *comp);
   bool Read(void *data, uint64_t numBytes);
+  bool Seek(uint64_t offset);
 
 private:
+  struct PageBatch;
+
   bool FillPage();
+  bool NextBatch();
+  bool ReadBatch(PageBatch &batch, uint32_t maxPages);
+  void DecompressPages(PageBatch &batch, uint32_t begin, uint32_t end);
+  bool CheckBatch(PageBatch &batch);
+  bool ReadDictionary();
+  void FreeBuffers();
+
+  static bool DecompressZSTDFrame(ZSTD_DStream *stream, const ZSTD_DDict *dict, ZSTD_inBuffer &in,
+                                  ZSTD_outBuffer &out);
 
   byte *m_Page;
   byte *m_CompressBuffer;
@@ -66,4 +112,30 @@ private:
   uint64_t m_PageLength;
 
   ZSTD_DStream *m_Stream;
+
+  bool m_DictionaryPending = false;
+  ZSTD_DDict *m_Dict = NULL;
+
+  // only used when decompressing on multiple threads. Pages are handed out from m_Current, with
+  // m_Page pointing at the page currently being read and m_BatchIndex the next one to hand out.
+  // If m_Next has any pages they are being decompressed in the background by its job.
+  struct PageBatch
+  {
+    uint32_t count = 0;
+    rdcarray<byte *> pages;
+    rdcarray<uint64_t> lengths;
+    rdcarray<byte *> compressed;
+    rdcarray<uint32_t> compSizes;
+    Threading::AsyncParallelFor decompress;
+  };
+
+  uint32_t m_NumThreads = 1;
+  uint32_t m_BatchIndex = 0;
+  PageBatch m_Batches[2];
+  PageBatch *m_Current = &m_Batches[0];
+  PageBatch *m_Next = &m_Batches[1];
+
+  // set after a seek, so that only the page seeked to is decompressed. Batches and prefetching
+  // resume once reading carries on past it.
+  bool m_SinglePage = false;
 };
@@ -687,6 +687,7 @@ private:
   std::string outfile;
   std::string infmt;
   std::string outfmt;
+  bool zstd_dictionary = false;
 
 public:
   ConvertCommand() : Command() {}
@@ -699,6 +700,9 @@ public:
     parser.add<std::string>("convert-format", 'c', "The format of the output file.", false, "",
                             formats_reader(false));
     parser.add("list-formats", '\0', "Print a list of target formats.");
+    parser.add("zstd-dictionary", '\0',
+               "When writing an rdc, compress the capture data against a dictionary built from it. "
+               "Gives smaller files but takes longer to convert.");
     parser.stop_at_rest(true);
   }
   virtual const char *Description() { return "Convert between capture formats."; }
@@ -730,6 +734,7 @@ public:
 
     infmt = parser.get<std::string>("input-format");
     outfmt = parser.get<std::string>("convert-format");
+    zstd_dictionary = parser.exist("zstd-dictionary");
 
     return true;
   }
@@ -810,6 +815,13 @@ public:
       return 1;
     }
 
+    if(zstd_dictionary)
+    {
+      SDObject *setting = RENDERDOC_SetConfigSetting("Capture.ZstdDictionary");
+      if(setting)
+        setting->data.basic.b = true;
+    }
+
     st = file->Convert(outfile.c_str(), outfmt.c_str(), NULL, NULL);
 
     if(st != ReplayStatus::Succeeded)
@@ -1252,6 +1264,83 @@ public:
   }
 };
 
+struct BlobStoreCommand : public Command
+{
+private:
+  bool m_Pack = false;
+  std::string infile;
+  std::string outfile;
+  std::string store;
+  uint32_t min_size = 0;
+
+public:
+  BlobStoreCommand(bool pack) : Command() { m_Pack = pack; }
+  virtual void AddOptions(cmdline::parser &parser)
+  {
+    parser.add<std::string>("filename", 'f',
+                            m_Pack ? "The capture to pack." : "The capture to unpack.", true);
+    parser.add<std::string>("output", 'o', "The file to write the new capture to.", true);
+    parser.add<std::string>("store", 's', "The directory containing the blob store.", true);
+
+    if(m_Pack)
+      parser.add<uint32_t>("min-size", 0,
+                           "The smallest section in bytes to move into the blob store.", false,
+                           64 * 1024);
+  }
+  virtual const char *Description()
+  {
+    if(m_Pack)
+      return "Move large sections of a capture into a shared blob store.";
+    else
+      return "Restore sections of a capture from a shared blob store.";
+  }
+  virtual bool IsInternalOnly() { return false; }
+  virtual bool IsCaptureCommand() { return false; }
+  virtual bool Parse(cmdline::parser &parser, GlobalEnvironment &)
+  {
+    infile = parser.get<std::string>("filename");
+    outfile = parser.get<std::string>("output");
+    store = parser.get<std::string>("store");
+
+    if(m_Pack)
+      min_size = parser.get<uint32_t>("min-size");
+
+    return true;
+  }
+  virtual int Execute(const CaptureOptions &)
+  {
+    ICaptureFile *capfile = RENDERDOC_OpenCaptureFile();
+
+    ReplayStatus st = capfile->OpenFile(infile.c_str(), "", NULL);
+
+    if(st != ReplayStatus::Succeeded)
+    {
+      capfile->Shutdown();
+      std::cerr << "Couldn't load '" << infile << "': " << ToStr(st) << std::endl;
+      return 1;
+    }
+
+    if(m_Pack)
+      st = capfile->PackSections(outfile.c_str(), store.c_str(), min_size);
+    else
+      st = capfile->UnpackSections(outfile.c_str(), store.c_str());
+
+    capfile->Shutdown();
+
+    if(st != ReplayStatus::Succeeded)
+    {
+      std::cerr << "Couldn't " << (m_Pack ? "pack" : "unpack") << " '" << infile << "' to '"
+                << outfile << "': " << ToStr(st) << std::endl;
+      return 1;
+    }
+
+    std::cout << (m_Pack ? "Packed '" : "Unpacked '") << infile << "' to '" << outfile << "'."
+              << std::endl;
+
+    return 0;
+  }
+};
+
 struct VulkanRegisterCommand : public Command
 {
 private:
@@ -1559,6 +1648,8 @@ int renderdoccmd(GlobalEnvironment &env, std::vector<std::string> &argv)
     add_command("convert", new ConvertCommand());
     add_command("embed", new EmbeddedSectionCommand(false));
     add_command("extract", new EmbeddedSectionCommand(true));
+    add_command("pack", new BlobStoreCommand(true));
+    add_command("unpack", new BlobStoreCommand(false));
 
     if(argv.size() <= 1)
     {
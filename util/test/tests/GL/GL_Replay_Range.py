@@ -0,0 +1,96 @@
+import rdtest
+import renderdoc as rd
+from typing import List, Tuple
+
+
+class GL_Replay_Range(rdtest.TestCase):
+    demos_test_name = 'GL_Shader_Editing'
+
+    def pick_values(self, eid: int):
+        self.controller.SetFrameEvent(eid, True)
+
+        ret: List[Tuple[float, float, float, float]] = []
+
+        for x, y in [(0.25, 0.25), (0.75, 0.25), (0.25, 0.75), (0.75, 0.75)]:
+            x = int((self.tex_details.width - 1) * x)
+            y = int((self.tex_details.height - 1) * y)
+
+            picked: rd.PixelValue = self.controller.PickPixel(self.tex, x, y, rd.Subresource(0, 0, 0),
+                                                              rd.CompType.Typeless)
+            ret.append(tuple(picked.floatValue))
+
+        return ret
+
+    def check_values(self, eid: int, expected, desc: str):
+        values = self.pick_values(eid)
+
+        for v, e in zip(values, expected):
+            if not rdtest.value_compare(v, e):
+                raise rdtest.TestFailureException("{} at event {}: got {} but expected {}"
+                                                  .format(desc, eid, values, expected))
+
+    def check_capture(self):
+        # the uniforms are changed between these draws, so a range starting part-way through has to
+        # restore the programs' uniform values as they were at its first event
+        eids = [self.find_draw("fixedprog").eventId, self.find_draw("dynamicprog").eventId,
+                self.find_draw("sepprog").eventId, self.get_last_draw().eventId]
+
+        self.controller.SetFrameEvent(eids[1], False)
+
+        pipe: rd.PipeState = self.controller.GetPipelineState()
+
+        refl: rd.ShaderReflection = pipe.GetShaderReflection(rd.ShaderStage.Fragment)
+
+        self.tex = pipe.GetOutputTargets()[0].resourceId
+        self.tex_details = self.get_texture(self.tex)
+
+        full = {}
+        for eid in eids:
+            full[eid] = self.pick_values(eid)
+
+        self.controller.SetReplayRange(eids[1], eids[-1])
+
+        for eid in eids[1:]:
+            self.check_values(eid, full[eid], "Replaying from the range")
+
+        # seeking outside the range, and back in, still works
+        self.check_values(eids[0], full[eids[0]], "Replaying outside the range")
+        self.check_values(eids[-1], full[eids[-1]], "Replaying back into the range")
+
+        rdtest.log.success("Range replays match full replays")
+
+        source: bytes = refl.rawBytes.replace(b'.rgba', b'.rgga').replace(b'#if 1', b'#if 0')
+
+        newShader: Tuple[rd.ResourceId, str] = self.controller.BuildTargetShader(refl.entryPoint,
+                                                                                 refl.encoding, source,
+                                                                                 rd.ShaderCompileFlags(),
+                                                                                 rd.ShaderStage.Fragment)
+
+        if len(newShader[1]) != 0:
+            raise rdtest.TestFailureException("Failed to compile edited shader: {}".format(newShader[1]))
+
+        editedFS = newShader[0]
+
+        # replacing the shader while the range is set must not leave the stale snapshot in place
+        self.controller.ReplaceResource(refl.resourceId, editedFS)
+
+        edited = self.pick_values(eids[-1])
+
+        self.controller.SetReplayRange(0, 0)
+
+        self.check_values(eids[-1], edited, "Replaying with an edit inside the range")
+
+        if edited == full[eids[-1]]:
+            raise rdtest.TestFailureException("Shader edit had no visible effect")
+
+        self.controller.SetReplayRange(eids[1], eids[-1])
+
+        self.controller.RemoveReplacement(refl.resourceId)
+
+        self.check_values(eids[-1], full[eids[-1]], "Replaying after removing the edit")
+
+        self.controller.SetReplayRange(0, 0)
+
+        self.controller.FreeTargetResource(editedFS)
+
+        rdtest.log.success("Range replays match full replays after editing")